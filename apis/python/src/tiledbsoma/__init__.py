@@ -17,6 +17,7 @@ from ._general_utilities import (
 from ._measurement import Measurement
 from ._sparse_nd_array import SparseNDArray
 from .libtiledbsoma import (
+    IntIndexer,
     tiledbsoma_stats_disable,
     tiledbsoma_stats_dump,
     tiledbsoma_stats_enable,
@@ -39,6 +40,7 @@ __all__ = [
     "get_implementation",
     "get_SOMA_version",
     "get_storage_engine",
+    "IntIndexer",
     "Measurement",
     "open",
     "show_package_versions",
@@ -1,5 +1,6 @@
 from typing import Optional
 
+import numpy as np
 import pyarrow as pa
 import somacore
 from somacore import options
@@ -50,14 +51,12 @@ class DenseNDArray(NDArray, somacore.DenseNDArray):
 
         self._set_reader_coords(sr, coords)
 
-        sr.submit()
-
-        arrow_tables = []
-        while True:
-            arrow_table_piece = sr.read_next()
-            if not arrow_table_piece:
-                break
-            arrow_tables.append(arrow_table_piece)
+        # The shape of the result is known from the coordinates, so the values
+        # are read with a single submit into a buffer holding all cells
+        data = np.empty(
+            int(np.prod(target_shape)), dtype=schema.attr("soma_data").dtype
+        )
+        num_cells = sr.read_into("soma_data", data)
 
         # For dense arrays there is no zero-output case: attempting to make a test case
         # to do that, say by indexing a 10x20 array by positions 888 and 999, results
@@ -65,15 +64,12 @@ class DenseNDArray(NDArray, somacore.DenseNDArray):
         #
         # [TileDB::Subarray] Error: Cannot add range to dimension 'soma_dim_0'; Range [888, 888] is
         # out of domain bounds [0, 9]
-        if not arrow_tables:
+        if num_cells != data.size:
             raise SOMAError(
-                "internal error: at least one table-piece should have been returned"
+                f"internal error: read {num_cells} cells, expected {data.size}"
             )
 
-        arrow_table = pa.concat_tables(arrow_tables)
-        return pa.Tensor.from_numpy(
-            arrow_table.column("soma_data").to_numpy().reshape(target_shape)
-        )
+        return pa.Tensor.from_numpy(data.reshape(target_shape))
 
     def write(
         self,
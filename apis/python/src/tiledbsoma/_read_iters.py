@@ -3,13 +3,11 @@ from typing import TypeVar
 
 import numpy as np
 import pyarrow as pa
-import scipy.sparse as sp
 import somacore
 
 # This package's pybind11 code
 import tiledbsoma.libtiledbsoma as clib
 
-from ._exception import SOMAError
 from ._types import NTuple
 
 
@@ -18,17 +16,19 @@ class TableReadIter(somacore.ReadIter[pa.Table]):
 
     def __init__(self, sr: clib.SOMAReader):
         self.sr = sr
+        # Batches are read through an Arrow C stream exported by the reader,
+        # without a pybind11 call per batch
+        self.reader = sr.read_arrow_stream()
 
     def __next__(self) -> pa.Table:
-        arrow_table = self.sr.read_next()
-        if arrow_table is None:
-            raise StopIteration
-
-        return arrow_table
+        batch = self.reader.read_next_batch()  # raises StopIteration at the end
+        return pa.Table.from_batches([batch])
 
     def concat(self) -> pa.Table:
         """Concatenate remainder of iterator, and return as a single Arrow Table"""
-        return pa.concat_tables(self)
+        # All batches of the stream share one schema, so the batches are
+        # combined without comparing schemas
+        return self.reader.read_all()
 
 
 RT = TypeVar("RT")
@@ -40,17 +40,14 @@ class SparseTensorReadIterBase(somacore.ReadIter[RT], metaclass=abc.ABCMeta):
     def __init__(self, sr: clib.SOMAReader, shape: NTuple):
         self.sr = sr
         self.shape = shape
+        self.tables = TableReadIter(sr)
 
     @abc.abstractmethod
     def _from_table(self, arrow_table: pa.Table) -> RT:
         raise NotImplementedError()
 
     def __next__(self) -> RT:
-        arrow_table = self.sr.read_next()
-        if arrow_table is None:
-            raise StopIteration
-
-        return self._from_table(arrow_table)
+        return self._from_table(next(self.tables))
 
     def concat(self) -> RT:
         """Returns all the requested data in a single operation.
@@ -58,8 +55,7 @@ class SparseTensorReadIterBase(somacore.ReadIter[RT], metaclass=abc.ABCMeta):
         If some data has already been retrieved using ``next``, this will return
         the rest of the data after that is already returned.
         """
-        arrow_tables = pa.concat_tables(TableReadIter(self.sr))
-        return self._from_table(arrow_tables)
+        return self._from_table(self.tables.concat())
 
 
 class SparseCOOTensorReadIter(SparseTensorReadIterBase[pa.SparseCOOTensor]):
@@ -76,39 +72,59 @@ class SparseCOOTensorReadIter(SparseTensorReadIterBase[pa.SparseCOOTensor]):
         return pa.SparseCOOTensor.from_numpy(coo_data, coo_coords, shape=self.shape)
 
 
-class SparseCSRMatrixReadIter(SparseTensorReadIterBase[pa.SparseCSRMatrix]):
-    """Iterator over Arrow SparseCSRMatrix elements"""
+class _CompressedMatrixReadIter(somacore.ReadIter[RT], metaclass=abc.ABCMeta):
+    """Private implementation class. The compressed matrices are assembled
+    in C++ directly from the results of the reader."""
+
+    _format: str
 
     def __init__(self, sr: clib.SOMAReader, shape: NTuple):
         if len(shape) != 2:
-            raise ValueError("CSR matrix format only supported for 2D SparseNDArray")
-        super().__init__(sr, shape)
+            raise ValueError(
+                f"{self._format.upper()} matrix format only supported for 2D SparseNDArray"
+            )
+        self.sr = sr
+        self.shape = shape
+        self.builder = clib.CompressedMatrixBuilder(self._format, tuple(shape))
+
+    @abc.abstractmethod
+    def _from_buffers(
+        self, data: np.ndarray, indices: np.ndarray, indptr: np.ndarray
+    ) -> RT:
+        raise NotImplementedError()
+
+    def __next__(self) -> RT:
+        if self.builder.read(self.sr, 1) == 0:
+            raise StopIteration
+        return self._from_buffers(*self.builder.finish())
+
+    def concat(self) -> RT:
+        """Returns all the requested data in a single operation.
+
+        If some data has already been retrieved using ``next``, this will return
+        the rest of the data after that is already returned.
+        """
+        self.builder.read(self.sr)
+        return self._from_buffers(*self.builder.finish())
 
-    def _from_table(self, arrow_table: pa.Table) -> pa.SparseCSRMatrix:
-        if len(self.shape) != 2:
-            raise SOMAError(f"internal error: expected shape == 2; got {self.shape}")
-        data = arrow_table.column("soma_data").to_numpy()
-        row = arrow_table.column("soma_dim_0").to_numpy()
-        col = arrow_table.column("soma_dim_1").to_numpy()
-        return pa.SparseCSRMatrix.from_scipy(
-            sp.csr_matrix((data, (row, col)), shape=self.shape)
-        )
+
+class SparseCSRMatrixReadIter(_CompressedMatrixReadIter[pa.SparseCSRMatrix]):
+    """Iterator over Arrow SparseCSRMatrix elements"""
+
+    _format = "csr"
+
+    def _from_buffers(
+        self, data: np.ndarray, indices: np.ndarray, indptr: np.ndarray
+    ) -> pa.SparseCSRMatrix:
+        return pa.SparseCSRMatrix.from_numpy(data, indptr, indices, shape=self.shape)
 
 
-class SparseCSCMatrixReadIter(SparseTensorReadIterBase[pa.SparseCSCMatrix]):
+class SparseCSCMatrixReadIter(_CompressedMatrixReadIter[pa.SparseCSCMatrix]):
     """Iterator over Arrow SparseCSCMatrix elements"""
 
-    def __init__(self, sr: clib.SOMAReader, shape: NTuple):
-        if len(shape) != 2:
-            raise ValueError("CSC matrix format only supported for 2D SparseNDArray")
-        super().__init__(sr, shape)
-
-    def _from_table(self, arrow_table: pa.Table) -> pa.SparseCSCMatrix:
-        if len(self.shape) != 2:
-            raise SOMAError(f"internal error: expected shape == 2; got {self.shape}")
-        data = arrow_table.column("soma_data").to_numpy()
-        row = arrow_table.column("soma_dim_0").to_numpy()
-        col = arrow_table.column("soma_dim_1").to_numpy()
-        return pa.SparseCSCMatrix.from_scipy(
-            sp.csc_matrix((data, (row, col)), shape=self.shape)
-        )
+    _format = "csc"
+
+    def _from_buffers(
+        self, data: np.ndarray, indices: np.ndarray, indptr: np.ndarray
+    ) -> pa.SparseCSCMatrix:
+        return pa.SparseCSCMatrix.from_numpy(data, indptr, indices, shape=self.shape)
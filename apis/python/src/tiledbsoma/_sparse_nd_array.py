@@ -118,6 +118,16 @@ class SparseNDArray(NDArray, somacore.SparseNDArray):
 
         arr = self._handle.writer
 
+        if isinstance(values, pa.Table):
+            # Write the record batches from C++, casting the columns to the
+            # types of the array
+            schema = self.schema
+            table = values.select(schema.names).cast(schema)
+            writer = self._soma_writer()
+            writer.write(table)
+            writer.close()
+            return self
+
         if isinstance(values, pa.SparseCOOTensor):
             data, coords = values.to_numpy()
             arr[tuple(c for c in coords.T)] = data
@@ -133,16 +143,6 @@ class SparseNDArray(NDArray, somacore.SparseNDArray):
             arr[sp.row, sp.col] = sp.data
             return self
 
-        if isinstance(values, pa.Table):
-            data = values.column("soma_data").to_numpy()
-            coord_tbl = values.drop(["soma_data"])
-            coords = tuple(
-                coord_tbl.column(f"soma_dim_{n}").to_numpy()
-                for n in range(coord_tbl.num_columns)
-            )
-            arr[coords] = data
-            return self
-
         raise TypeError(
             f"Unsupported Arrow type or non-arrow type for values argument: {type(values)}"
         )
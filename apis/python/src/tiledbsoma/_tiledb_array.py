@@ -88,6 +88,18 @@ class TileDBArray(TileDBObject[_tdb_handles.ArrayWrapper]):
             kwargs["result_order"] = result_order
         return clib.SOMAReader(self.uri, **kwargs)
 
+    def _soma_writer(self, *, layout: Optional[str] = None) -> clib.SOMAWriter:
+        """
+        Construct a C++ SOMAWriter using appropriate context/config/etc.
+        """
+        kwargs = {
+            "platform_config": self._ctx.config().dict(),
+            "timestamp": self.context.write_timestamp,
+        }
+        if layout:
+            kwargs["layout"] = layout
+        return clib.SOMAWriter(self.uri, **kwargs)
+
     def _set_reader_coords(self, sr: clib.SOMAReader, coords: Sequence[object]) -> None:
         """Parses the given coords and sets them on the SOMA Reader."""
         if not is_nonstringy_sequence(coords):
@@ -234,6 +234,29 @@ def test_DataFrame_read_column_names(simple_data_frame, ids, col_names):
     )
 
 
+@pytest.mark.parametrize(
+    "col_names,value_filter,expected",
+    [
+        (["soma_joinid"], "A > 11", {"soma_joinid": [12, 13]}),
+        (
+            ["soma_joinid", "A"],
+            "B < 300 and C != 'this'",
+            {"soma_joinid": [11], "A": [11]},
+        ),
+        (["B"], "A == 10", {"B": [100.1]}),
+        (["A"], "A >= 12", {"A": [12, 13]}),
+    ],
+)
+def test_DataFrame_read_predicate_only_columns(
+    simple_data_frame, col_names, value_filter, expected
+):
+    """Columns referenced only by the value filter are not returned."""
+    _, sdf, _, _ = simple_data_frame
+    tbl = sdf.read(column_names=col_names, value_filter=value_filter).concat()
+    assert tbl.column_names == col_names
+    assert tbl.to_pydict() == expected
+
+
 def test_empty_dataframe(tmp_path):
     soma.DataFrame.create(
         (tmp_path / "A").as_posix(),
@@ -9,6 +9,7 @@ from scipy import sparse
 
 import tiledbsoma as soma
 from tiledbsoma import _factory
+from tiledbsoma import libtiledbsoma as clib
 from tiledbsoma._collection import CollectionBase
 from tiledbsoma.experiment_query import X_as_series
 
@@ -690,6 +691,29 @@ Fixture support & utility functions below.
 """
 
 
+@pytest.mark.parametrize("n_obs,n_vars", [(101, 11)])
+def test_experiment_query_clib(soma_experiment):
+    """The C++ ExperimentQuery reads obs and var concurrently, then X."""
+    query = clib.ExperimentQuery(soma_experiment.uri, X_layer="raw")
+    query.obs().set_dim_ranges("soma_joinid", [(10, 29)])
+    query.var().set_dim_points("soma_joinid", [1, 3, 5])
+    query.submit()
+
+    obs_joinids = query.obs_joinids()
+    var_joinids = query.var_joinids()
+    assert np.array_equal(np.sort(obs_joinids), np.arange(10, 30))
+    assert np.array_equal(np.sort(var_joinids), [1, 3, 5])
+    assert sum(len(t) for t in query.obs_tables()) == 20
+    assert sum(len(t) for t in query.var_tables()) == 3
+
+    # One row per obs joinid and one column per var joinid, in result order
+    data, indices, indptr = query.read_X()
+    X = sparse.csr_matrix((data, indices, indptr), shape=(20, 3))
+    raw = soma_experiment.ms["RNA"].X["raw"].read().coos().concat()
+    expected = raw.to_scipy().tocsr()[obs_joinids][:, var_joinids]
+    assert (X != expected).nnz == 0
+
+
 def add_dataframe(coll: CollectionBase, key: str, sz: int) -> None:
     df = coll.add_new_dataframe(
         key,
@@ -0,0 +1,33 @@
+import numpy as np
+import pyarrow as pa
+import pytest
+
+import tiledbsoma
+
+
+def test_int_indexer():
+    keys = np.array([10, -3, 7, 2**40], dtype=np.int64)
+    indexer = tiledbsoma.IntIndexer(keys)
+    assert len(indexer) == 4
+
+    lookups = np.array([7, 8, 2**40, -3, 10], dtype=np.int64)
+    expected = np.array([2, -1, 3, 1, 0], dtype=np.int64)
+    assert np.array_equal(indexer.get_indexer(lookups), expected)
+
+    # Arrow arrays, sliced and chunked, are read without copying
+    assert np.array_equal(indexer.get_indexer(pa.array(lookups)), expected)
+    assert np.array_equal(
+        indexer.get_indexer(pa.array(np.concatenate([[0], lookups]))[1:]), expected
+    )
+    chunked = pa.chunked_array([lookups[:2], lookups[2:]])
+    assert np.array_equal(indexer.get_indexer(chunked), expected)
+    assert len(tiledbsoma.IntIndexer(pa.chunked_array([keys[:1], keys[1:]]))) == 4
+
+
+def test_int_indexer_errors():
+    with pytest.raises(RuntimeError):
+        tiledbsoma.IntIndexer(np.array([1, 2, 1], dtype=np.int64))
+
+    indexer = tiledbsoma.IntIndexer(np.arange(3, dtype=np.int64))
+    with pytest.raises(RuntimeError):
+        indexer.get_indexer(pa.array([1, None], type=pa.int64()))
@@ -0,0 +1,70 @@
+import pyarrow as pa
+import pytest
+
+import tiledbsoma as soma
+from tiledbsoma import libtiledbsoma as clib
+
+
+@pytest.fixture
+def dataframe_uri(tmp_path):
+    uri = tmp_path.as_posix()
+    schema = pa.schema(
+        [
+            ("n_genes", pa.int32()),
+            ("percent_mito", pa.float64()),
+            ("louvain", pa.string()),
+        ]
+    )
+    with soma.DataFrame.create(uri, schema=schema) as sdf:
+        sdf.write(
+            pa.table(
+                {
+                    "soma_joinid": pa.array(range(6), type=pa.int64()),
+                    "n_genes": pa.array([100, 800, 1500, 2200, 90, 3000], pa.int32()),
+                    "percent_mito": [0.01, 0.02, 0.10, 0.05, 0.30, 0.01],
+                    "louvain": ["B", "NK", "B", "T", "NK", "B"],
+                }
+            )
+        )
+    return uri
+
+
+def _read_joinids(uri, predicate):
+    reader = clib.SOMAReader(uri, column_names=["soma_joinid"])
+    reader.set_predicate(predicate)
+    reader.submit()
+    joinids = []
+    while True:
+        table = reader.read_next()
+        if table is None:
+            return sorted(joinids)
+        joinids.extend(table["soma_joinid"].to_pylist())
+
+
+def test_query_predicate(dataframe_uri):
+    QP = clib.QueryPredicate
+    assert _read_joinids(dataframe_uri, QP.compare("n_genes", ">", 1000)) == [2, 3, 5]
+    assert _read_joinids(dataframe_uri, QP.is_in("louvain", ["NK", "T"])) == [1, 3, 4]
+    assert _read_joinids(dataframe_uri, QP.is_in("louvain", [])) == []
+
+    predicate = QP.compare("n_genes", ">", 1000) & QP.compare("louvain", "==", "B")
+    assert _read_joinids(dataframe_uri, predicate) == [2, 5]
+    predicate = QP.compare("percent_mito", ">=", 0.1) | ~QP.compare("n_genes", ">", 99)
+    assert _read_joinids(dataframe_uri, predicate) == [2, 4]
+    assert (
+        repr(QP.compare("n_genes", "<", 5).combine(QP.is_in("louvain", ["B"]), "or"))
+        == "QueryPredicate((n_genes < 5 OR louvain IN ('B')))"
+    )
+
+
+def test_query_predicate_errors(dataframe_uri):
+    QP = clib.QueryPredicate
+    reader = clib.SOMAReader(dataframe_uri)
+    with pytest.raises(RuntimeError):
+        QP.compare("n_genes", "=>", 1)
+    with pytest.raises(RuntimeError):
+        reader.set_predicate(QP.compare("n_genes", "==", "many"))
+    with pytest.raises(RuntimeError):
+        reader.set_predicate(QP.compare("soma_joinid", "==", 1))
+    with pytest.raises(RuntimeError):
+        reader.set_predicate(QP.is_null("n_genes"))
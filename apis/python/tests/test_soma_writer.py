@@ -0,0 +1,53 @@
+import numpy as np
+import pyarrow as pa
+import pytest
+
+import tiledbsoma as soma
+from tiledbsoma import libtiledbsoma as clib
+
+
+def _coo_table(start: int, length: int) -> pa.Table:
+    dim = np.arange(start, start + length, dtype=np.int64)
+    return pa.table(
+        {
+            "soma_dim_0": dim,
+            "soma_dim_1": dim % 7,
+            "soma_data": dim.astype(np.float32),
+        }
+    )
+
+
+@pytest.mark.parametrize("layout", ["unordered", "global-order"])
+def test_soma_writer(tmp_path, layout):
+    uri = tmp_path.as_posix()
+    soma.SparseNDArray.create(uri, type=pa.float32(), shape=(1000, 7)).close()
+
+    writer = clib.SOMAWriter(uri, layout=layout)
+    # Several record batches, written in global order
+    writer.write(pa.concat_tables([_coo_table(0, 100), _coo_table(100, 200)]))
+    writer.write(_coo_table(300, 50).to_batches()[0])
+    writer.close()
+    assert writer.num_cells() == 350
+
+    with soma.SparseNDArray.open(uri) as a:
+        assert a.nnz == 350
+        t = a.read().tables().concat().sort_by("soma_dim_0")
+        assert t.to_pydict() == _coo_table(0, 350).to_pydict()
+
+
+def test_soma_writer_errors(tmp_path):
+    uri = tmp_path.as_posix()
+    soma.SparseNDArray.create(uri, type=pa.float32(), shape=(1000, 7)).close()
+
+    with pytest.raises(RuntimeError):
+        clib.SOMAWriter(uri, layout="row-major")
+
+    writer = clib.SOMAWriter(uri)
+    with pytest.raises(RuntimeError):
+        writer.write(_coo_table(0, 10).drop(["soma_data"]))
+    with pytest.raises(RuntimeError):
+        # float64 data for a float32 attribute
+        data = pa.array(np.zeros(10))
+        writer.write(_coo_table(0, 10).set_column(2, "soma_data", data))
+    writer.close()
+    assert writer.num_cells() == 0
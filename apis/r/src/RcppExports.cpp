@@ -62,9 +62,18 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// clear_stats_cache
+void clear_stats_cache();
+RcppExport SEXP _tiledbsoma_clear_stats_cache() {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    clear_stats_cache();
+    return R_NilValue;
+END_RCPP
+}
 // sr_setup
-Rcpp::XPtr<tdbs::SOMAReader> sr_setup(Rcpp::XPtr<tiledb::Context> ctx, const std::string& uri, Rcpp::Nullable<Rcpp::CharacterVector> colnames, Rcpp::Nullable<Rcpp::XPtr<tiledb::QueryCondition>> qc, Rcpp::Nullable<Rcpp::List> dim_points, Rcpp::Nullable<Rcpp::List> dim_ranges, Rcpp::Nullable<Rcpp::CharacterVector> config, const std::string& loglevel);
-RcppExport SEXP _tiledbsoma_sr_setup(SEXP ctxSEXP, SEXP uriSEXP, SEXP colnamesSEXP, SEXP qcSEXP, SEXP dim_pointsSEXP, SEXP dim_rangesSEXP, SEXP configSEXP, SEXP loglevelSEXP) {
+Rcpp::XPtr<tdbs::SOMAReader> sr_setup(Rcpp::XPtr<tiledb::Context> ctx, const std::string& uri, Rcpp::Nullable<Rcpp::CharacterVector> colnames, Rcpp::Nullable<Rcpp::XPtr<tiledb::QueryCondition>> qc, Rcpp::Nullable<Rcpp::List> dim_points, Rcpp::Nullable<Rcpp::List> dim_ranges, Rcpp::Nullable<Rcpp::CharacterVector> config, const std::string& loglevel, Rcpp::Nullable<Rcpp::XPtr<tdbs::QueryPredicate>> predicate);
+RcppExport SEXP _tiledbsoma_sr_setup(SEXP ctxSEXP, SEXP uriSEXP, SEXP colnamesSEXP, SEXP qcSEXP, SEXP dim_pointsSEXP, SEXP dim_rangesSEXP, SEXP configSEXP, SEXP loglevelSEXP, SEXP predicateSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -76,7 +85,8 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::List> >::type dim_ranges(dim_rangesSEXP);
     Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::CharacterVector> >::type config(configSEXP);
     Rcpp::traits::input_parameter< const std::string& >::type loglevel(loglevelSEXP);
-    rcpp_result_gen = Rcpp::wrap(sr_setup(ctx, uri, colnames, qc, dim_points, dim_ranges, config, loglevel));
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::XPtr<tdbs::QueryPredicate>> >::type predicate(predicateSEXP);
+    rcpp_result_gen = Rcpp::wrap(sr_setup(ctx, uri, colnames, qc, dim_points, dim_ranges, config, loglevel, predicate));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -102,6 +112,139 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// sr_next_df
+SEXP sr_next_df(Rcpp::XPtr<tdbs::SOMAReader> sr, const std::string& int64_as);
+RcppExport SEXP _tiledbsoma_sr_next_df(SEXP srSEXP, SEXP int64_asSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<tdbs::SOMAReader> >::type sr(srSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type int64_as(int64_asSEXP);
+    rcpp_result_gen = Rcpp::wrap(sr_next_df(sr, int64_as));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sr_dgcmatrix
+Rcpp::S4 sr_dgcmatrix(Rcpp::XPtr<tdbs::SOMAReader> sr, Rcpp::Nullable<Rcpp::NumericVector> dim, Rcpp::Nullable<Rcpp::NumericVector> row_joinids, Rcpp::Nullable<Rcpp::NumericVector> col_joinids, double max_batches);
+RcppExport SEXP _tiledbsoma_sr_dgcmatrix(SEXP srSEXP, SEXP dimSEXP, SEXP row_joinidsSEXP, SEXP col_joinidsSEXP, SEXP max_batchesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<tdbs::SOMAReader> >::type sr(srSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type dim(dimSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type row_joinids(row_joinidsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::Nullable<Rcpp::NumericVector> >::type col_joinids(col_joinidsSEXP);
+    Rcpp::traits::input_parameter< double >::type max_batches(max_batchesSEXP);
+    rcpp_result_gen = Rcpp::wrap(sr_dgcmatrix(sr, dim, row_joinids, col_joinids, max_batches));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sr_metrics
+std::string sr_metrics(Rcpp::XPtr<tdbs::SOMAReader> sr);
+RcppExport SEXP _tiledbsoma_sr_metrics(SEXP srSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<tdbs::SOMAReader> >::type sr(srSEXP);
+    rcpp_result_gen = Rcpp::wrap(sr_metrics(sr));
+    return rcpp_result_gen;
+END_RCPP
+}
+// int_indexer_setup
+Rcpp::XPtr<tdbs::IntIndexer> int_indexer_setup(Rcpp::NumericVector keys);
+RcppExport SEXP _tiledbsoma_int_indexer_setup(SEXP keysSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type keys(keysSEXP);
+    rcpp_result_gen = Rcpp::wrap(int_indexer_setup(keys));
+    return rcpp_result_gen;
+END_RCPP
+}
+// int_indexer_get
+Rcpp::NumericVector int_indexer_get(Rcpp::XPtr<tdbs::IntIndexer> indexer, Rcpp::NumericVector keys);
+RcppExport SEXP _tiledbsoma_int_indexer_get(SEXP indexerSEXP, SEXP keysSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<tdbs::IntIndexer> >::type indexer(indexerSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type keys(keysSEXP);
+    rcpp_result_gen = Rcpp::wrap(int_indexer_get(indexer, keys));
+    return rcpp_result_gen;
+END_RCPP
+}
+// predicate_compare
+Rcpp::XPtr<tdbs::QueryPredicate> predicate_compare(const std::string& name, const std::string& op, SEXP value);
+RcppExport SEXP _tiledbsoma_predicate_compare(SEXP nameSEXP, SEXP opSEXP, SEXP valueSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type name(nameSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type op(opSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type value(valueSEXP);
+    rcpp_result_gen = Rcpp::wrap(predicate_compare(name, op, value));
+    return rcpp_result_gen;
+END_RCPP
+}
+// predicate_in
+Rcpp::XPtr<tdbs::QueryPredicate> predicate_in(const std::string& name, SEXP values);
+RcppExport SEXP _tiledbsoma_predicate_in(SEXP nameSEXP, SEXP valuesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type name(nameSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type values(valuesSEXP);
+    rcpp_result_gen = Rcpp::wrap(predicate_in(name, values));
+    return rcpp_result_gen;
+END_RCPP
+}
+// predicate_is_null
+Rcpp::XPtr<tdbs::QueryPredicate> predicate_is_null(const std::string& name, bool is_null);
+RcppExport SEXP _tiledbsoma_predicate_is_null(SEXP nameSEXP, SEXP is_nullSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type name(nameSEXP);
+    Rcpp::traits::input_parameter< bool >::type is_null(is_nullSEXP);
+    rcpp_result_gen = Rcpp::wrap(predicate_is_null(name, is_null));
+    return rcpp_result_gen;
+END_RCPP
+}
+// predicate_combine
+Rcpp::XPtr<tdbs::QueryPredicate> predicate_combine(Rcpp::XPtr<tdbs::QueryPredicate> lhs, Rcpp::XPtr<tdbs::QueryPredicate> rhs, const std::string& op);
+RcppExport SEXP _tiledbsoma_predicate_combine(SEXP lhsSEXP, SEXP rhsSEXP, SEXP opSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<tdbs::QueryPredicate> >::type lhs(lhsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::XPtr<tdbs::QueryPredicate> >::type rhs(rhsSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type op(opSEXP);
+    rcpp_result_gen = Rcpp::wrap(predicate_combine(lhs, rhs, op));
+    return rcpp_result_gen;
+END_RCPP
+}
+// predicate_negate
+Rcpp::XPtr<tdbs::QueryPredicate> predicate_negate(Rcpp::XPtr<tdbs::QueryPredicate> predicate);
+RcppExport SEXP _tiledbsoma_predicate_negate(SEXP predicateSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<tdbs::QueryPredicate> >::type predicate(predicateSEXP);
+    rcpp_result_gen = Rcpp::wrap(predicate_negate(predicate));
+    return rcpp_result_gen;
+END_RCPP
+}
+// predicate_string
+std::string predicate_string(Rcpp::XPtr<tdbs::QueryPredicate> predicate);
+RcppExport SEXP _tiledbsoma_predicate_string(SEXP predicateSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<tdbs::QueryPredicate> >::type predicate(predicateSEXP);
+    rcpp_result_gen = Rcpp::wrap(predicate_string(predicate));
+    return rcpp_result_gen;
+END_RCPP
+}
 // tiledbsoma_stats_enable
 void tiledbsoma_stats_enable();
 RcppExport SEXP _tiledbsoma_stats_enable() {
@@ -145,9 +288,21 @@ static const R_CallMethodDef CallEntries[] = {
     {"_tiledbsoma_set_log_level", (DL_FUNC) &_tiledbsoma_set_log_level, 1},
     {"_tiledbsoma_get_column_types", (DL_FUNC) &_tiledbsoma_get_column_types, 2},
     {"_tiledbsoma_nnz", (DL_FUNC) &_tiledbsoma_nnz, 1},
-    {"_tiledbsoma_sr_setup", (DL_FUNC) &_tiledbsoma_sr_setup, 8},
+    {"_tiledbsoma_clear_stats_cache", (DL_FUNC) &_tiledbsoma_clear_stats_cache, 0},
+    {"_tiledbsoma_sr_setup", (DL_FUNC) &_tiledbsoma_sr_setup, 9},
     {"_tiledbsoma_sr_complete", (DL_FUNC) &_tiledbsoma_sr_complete, 1},
     {"_tiledbsoma_sr_next", (DL_FUNC) &_tiledbsoma_sr_next, 1},
+    {"_tiledbsoma_sr_next_df", (DL_FUNC) &_tiledbsoma_sr_next_df, 2},
+    {"_tiledbsoma_sr_dgcmatrix", (DL_FUNC) &_tiledbsoma_sr_dgcmatrix, 5},
+    {"_tiledbsoma_sr_metrics", (DL_FUNC) &_tiledbsoma_sr_metrics, 1},
+    {"_tiledbsoma_int_indexer_setup", (DL_FUNC) &_tiledbsoma_int_indexer_setup, 1},
+    {"_tiledbsoma_int_indexer_get", (DL_FUNC) &_tiledbsoma_int_indexer_get, 2},
+    {"_tiledbsoma_predicate_compare", (DL_FUNC) &_tiledbsoma_predicate_compare, 3},
+    {"_tiledbsoma_predicate_in", (DL_FUNC) &_tiledbsoma_predicate_in, 2},
+    {"_tiledbsoma_predicate_is_null", (DL_FUNC) &_tiledbsoma_predicate_is_null, 2},
+    {"_tiledbsoma_predicate_combine", (DL_FUNC) &_tiledbsoma_predicate_combine, 3},
+    {"_tiledbsoma_predicate_negate", (DL_FUNC) &_tiledbsoma_predicate_negate, 1},
+    {"_tiledbsoma_predicate_string", (DL_FUNC) &_tiledbsoma_predicate_string, 1},
     {"_tiledbsoma_stats_enable", (DL_FUNC) &_tiledbsoma_stats_enable, 0},
     {"_tiledbsoma_stats_disable", (DL_FUNC) &_tiledbsoma_stats_disable, 0},
     {"_tiledbsoma_stats_reset", (DL_FUNC) &_tiledbsoma_stats_reset, 0},
@@ -155,7 +310,9 @@ static const R_CallMethodDef CallEntries[] = {
     {NULL, NULL, 0}
 };
 
+void tiledbsoma_altrep_init(DllInfo* dll);
 RcppExport void R_init_tiledbsoma(DllInfo *dll) {
     R_registerRoutines(dll, NULL, CallEntries, NULL, NULL);
     R_useDynamicSymbols(dll, FALSE);
+    tiledbsoma_altrep_init(dll);
 }
@@ -0,0 +1,167 @@
+#include "raltrep.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef TILEDBSOMA_ALTREP
+#include <R_ext/Altrep.h>
+#endif
+
+namespace {
+
+// Memory viewed by an ALTREP vector, held by its first data slot
+struct View {
+    std::shared_ptr<const void> owner;
+    const void* data;
+    R_xlen_t length;
+};
+
+// Copy the viewed memory into a standard vector
+template <typename T, int RTYPE>
+SEXP copy_view(const View& view) {
+    Rcpp::Vector<RTYPE> vec(Rcpp::no_init(view.length));
+    if (view.length > 0) {
+        std::memcpy(vec.begin(), view.data, view.length * sizeof(T));
+    }
+    return vec;
+}
+
+#ifdef TILEDBSOMA_ALTREP
+
+void finalize_view(SEXP xp) {
+    delete static_cast<View*>(R_ExternalPtrAddr(xp));
+    R_ClearExternalPtr(xp);
+}
+
+SEXP wrap_view(std::shared_ptr<const void> owner, const void* data, R_xlen_t length) {
+    SEXP xp = PROTECT(R_MakeExternalPtr(new View{std::move(owner), data, length},
+                                        R_NilValue, R_NilValue));
+    R_RegisterCFinalizerEx(xp, finalize_view, TRUE);
+    UNPROTECT(1);
+    return xp;
+}
+
+R_altrep_class_t real_class;
+R_altrep_class_t integer_class;
+
+// Methods of the ALTREP classes, for values of type T in vectors of RTYPE.
+// The second data slot holds a copy of the memory once materialized.
+template <typename T, int RTYPE>
+struct ViewMethods {
+    static const View& view(SEXP x) {
+        return *static_cast<View*>(R_ExternalPtrAddr(R_altrep_data1(x)));
+    }
+
+    static SEXP materialize(SEXP x) {
+        SEXP copy = R_altrep_data2(x);
+        if (copy == R_NilValue) {
+            copy = PROTECT(copy_view<T, RTYPE>(view(x)));
+            R_set_altrep_data2(x, copy);
+            UNPROTECT(1);
+        }
+        return copy;
+    }
+
+    static R_xlen_t length(SEXP x) {
+        return view(x).length;
+    }
+
+    static const void* dataptr_or_null(SEXP x) {
+        SEXP copy = R_altrep_data2(x);
+        if (copy != R_NilValue) {
+            return Rcpp::internal::r_vector_start<RTYPE>(copy);
+        }
+        return view(x).data;
+    }
+
+    static void* dataptr(SEXP x, Rboolean writeable) {
+        if (writeable) {
+            return Rcpp::internal::r_vector_start<RTYPE>(materialize(x));
+        }
+        return const_cast<void*>(dataptr_or_null(x));
+    }
+
+    static T elt(SEXP x, R_xlen_t i) {
+        return static_cast<const T*>(dataptr_or_null(x))[i];
+    }
+
+    static R_xlen_t get_region(SEXP x, R_xlen_t i, R_xlen_t n, T* buf) {
+        R_xlen_t count = std::min(n, length(x) - i);
+        std::memcpy(buf, static_cast<const T*>(dataptr_or_null(x)) + i, count * sizeof(T));
+        return count;
+    }
+
+    // Serialize as a standard vector, which unserializes without the package
+    static SEXP serialized_state(SEXP x) {
+        return materialize(x);
+    }
+
+    static SEXP unserialize(SEXP, SEXP state) {
+        return state;
+    }
+
+    static Rboolean inspect(SEXP x, int, int, int, void (*)(SEXP, int, int, int)) {
+        Rprintf("tiledbsoma buffer view (len=%lld, materialized=%s)\n",
+                (long long) length(x), R_altrep_data2(x) == R_NilValue ? "F" : "T");
+        return TRUE;
+    }
+
+    static void set_methods(R_altrep_class_t cls) {
+        R_set_altrep_Length_method(cls, length);
+        R_set_altrep_Inspect_method(cls, inspect);
+        R_set_altrep_Serialized_state_method(cls, serialized_state);
+        R_set_altrep_Unserialize_method(cls, unserialize);
+        R_set_altvec_Dataptr_method(cls, dataptr);
+        R_set_altvec_Dataptr_or_null_method(cls, dataptr_or_null);
+    }
+};
+
+using RealMethods = ViewMethods<double, REALSXP>;
+using IntegerMethods = ViewMethods<int, INTSXP>;
+
+#endif
+
+}  // namespace
+
+// [[Rcpp::init]]
+void tiledbsoma_altrep_init(DllInfo* dll) {
+#ifdef TILEDBSOMA_ALTREP
+    real_class = R_make_altreal_class("tiledbsoma_real", "tiledbsoma", dll);
+    RealMethods::set_methods(real_class);
+    R_set_altreal_Elt_method(real_class, RealMethods::elt);
+    R_set_altreal_Get_region_method(real_class, RealMethods::get_region);
+
+    integer_class = R_make_altinteger_class("tiledbsoma_integer", "tiledbsoma", dll);
+    IntegerMethods::set_methods(integer_class);
+    R_set_altinteger_Elt_method(integer_class, IntegerMethods::elt);
+    R_set_altinteger_Get_region_method(integer_class, IntegerMethods::get_region);
+#else
+    (void) dll;
+#endif
+}
+
+SEXP make_altrep_real(std::shared_ptr<const void> owner,
+                      const double* data,
+                      R_xlen_t length) {
+#ifdef TILEDBSOMA_ALTREP
+    SEXP xp = PROTECT(wrap_view(std::move(owner), data, length));
+    SEXP vec = R_new_altrep(real_class, xp, R_NilValue);
+    UNPROTECT(1);
+    return vec;
+#else
+    return copy_view<double, REALSXP>(View{std::move(owner), data, length});
+#endif
+}
+
+SEXP make_altrep_integer(std::shared_ptr<const void> owner,
+                         const int* data,
+                         R_xlen_t length) {
+#ifdef TILEDBSOMA_ALTREP
+    SEXP xp = PROTECT(wrap_view(std::move(owner), data, length));
+    SEXP vec = R_new_altrep(integer_class, xp, R_NilValue);
+    UNPROTECT(1);
+    return vec;
+#else
+    return copy_view<int, INTSXP>(View{std::move(owner), data, length});
+#endif
+}
@@ -0,0 +1,28 @@
+// ALTREP vectors viewing memory owned by libtiledbsoma buffers
+
+#pragma once
+
+#include <Rcpp.h>
+#include <Rversion.h>
+
+#include <memory>
+
+// ALTREP classes are available to C++ code from R 4.0 onwards, earlier
+// versions copy the memory into standard vectors
+#if R_VERSION >= R_Version(4, 0, 0)
+#define TILEDBSOMA_ALTREP 1
+#endif
+
+// Return a numeric vector of the `length` doubles at `data`, without copying
+// them. `owner` keeps the memory alive until the vector is garbage collected.
+// The memory is copied when R asks for a writeable pointer or serializes the
+// vector, so the buffer itself is never modified.
+SEXP make_altrep_real(std::shared_ptr<const void> owner,
+                      const double* data,
+                      R_xlen_t length);
+
+// Return an integer vector of the `length` ints at `data`, without copying
+// them, as for make_altrep_real
+SEXP make_altrep_integer(std::shared_ptr<const void> owner,
+                         const int* data,
+                         R_xlen_t length);
@@ -185,3 +185,10 @@ double nnz(const std::string& uri) {
     auto sr = tdbs::SOMAReader::open(uri);
     return static_cast<double>(sr->nnz());
 }
+
+//' @rdname soma_reader
+//' @export
+// [[Rcpp::export]]
+void clear_stats_cache() {
+    tdbs::StatsCache::instance().clear();
+}
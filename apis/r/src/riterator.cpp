@@ -10,6 +10,7 @@
 #include <tiledbsoma/tiledbsoma>
 #include <archAPI.h>
 #include "rutilities.h"
+#include "raltrep.h"
 
 namespace tdbs = tiledbsoma;
 
@@ -38,6 +39,8 @@ const tiledb_xptr_object tiledb_xptr_query_buf_t                 { 190 };
 
 // the definitions above are internal to tiledb-r but we need a new value here if we want tag the external pointer
 const tiledb_xptr_object tiledb_soma_reader_t                    { 500 };
+const tiledb_xptr_object tiledb_soma_int_indexer_t               { 510 };
+const tiledb_xptr_object tiledb_soma_query_predicate_t           { 520 };
 
 // templated checkers for external pointer tags
 template <typename T> const int32_t XPtrTagType                            = tiledb_xptr_default; // clang++ wants a value
@@ -63,6 +66,8 @@ template <> inline const int32_t XPtrTagType<tiledb::VFS>                  = til
 // template <> inline const int32_t XPtrTagType<query_buf_t>                  = tiledb_xptr_query_buf_t;
 
 template <> inline const int32_t XPtrTagType<tdbs::SOMAReader>             = tiledb_xptr_query_buf_t;
+template <> inline const int32_t XPtrTagType<tdbs::IntIndexer>             = tiledb_soma_int_indexer_t;
+template <> inline const int32_t XPtrTagType<tdbs::QueryPredicate>         = tiledb_soma_query_predicate_t;
 
 template <typename T> Rcpp::XPtr<T> make_xptr(T* p) {
     return Rcpp::XPtr<T>(p, true, Rcpp::wrap(XPtrTagType<T>), R_NilValue);
@@ -92,8 +97,16 @@ template<typename T> void check_xptr_tag(Rcpp::XPtr<T> ptr) {
 //'   \item{\code{sr_setup}}{instantiates and by default also submits a query}
 //'   \item{\code{sr_complete}}{checks if more data is available}
 //'   \item{\code{sr_next}}{returns the next chunk}
+//'   \item{\code{sr_metrics}}{returns the latency and throughput metrics of the reader}
+//'   \item{\code{sr_next_df}}{returns the next chunk as a \code{data.frame} of R vectors}
+//'   \item{\code{sr_dgcmatrix}}{reads the remaining chunks into a \code{dgCMatrix}}
 //' }
 //'
+//' \code{sr_next_df} and \code{sr_dgcmatrix} build R objects directly from the read buffers,
+//' without going through Arrow. Double, integer and \code{integer64} columns without nulls, and
+//' double matrix values, are ALTREP views of the buffers that are only copied if R needs to
+//' modify or serialize them. Other types are converted in a single pass.
+//'
 //' @param ctx An external pointer to a TileDB Context object
 //' @param uri Character value with URI path to a SOMA data set
 //' @param colnames Optional vector of character value with the name of the columns to retrieve
@@ -108,9 +121,23 @@ template<typename T> void check_xptr_tag(Rcpp::XPtr<T> ptr) {
 //' @param loglevel Character value with the desired logging level, defaults to \sQuote{auto}
 //' which lets prior setting prevail, any other value is set as new logging level.
 //' @param sr An external pointer to a TileDB SOMAReader object
+//' @param predicate Optional external pointer to a QueryPredicate object, see
+//' \code{\link{predicate_compare}}, compiled to a query condition against the schema and context
+//' of the SOMAReader. It replaces \code{qc} if both are set.
+//' @param int64_as Character value selecting the R type of \code{int64} columns, one of
+//' \sQuote{integer64} (the default), \sQuote{double} or \sQuote{integer}, which fails for values
+//' outside of the integer range
+//' @param dim Optional vector with the number of rows and columns of the matrix, defaults to the
+//' non-empty domain of the array
+//' @param row_joinids,col_joinids Optional \code{integer64} vectors of joinids which are mapped
+//' to the rows and columns of the matrix in their order, as by \code{int_indexer_setup}
+//' @param max_batches Optional maximum number of chunks to read, 0 reads all remaining chunks
 //'
 //' @return \code{sr_setup} returns an external pointer to a SOMAReader. \code{sr_complete}
-//' returns a boolean, and \code{sr_next} returns an Arrow array helper object.
+//' returns a boolean, \code{sr_next} returns an Arrow array helper object,
+//' \code{sr_metrics} returns a JSON character value, \code{sr_next_df} returns a
+//' \code{data.frame} or \code{NULL} once the reader is complete, and \code{sr_dgcmatrix} returns
+//' a \code{Matrix::dgCMatrix}.
 //'
 //' @examples
 //' \dontrun{
@@ -139,7 +166,8 @@ Rcpp::XPtr<tdbs::SOMAReader> sr_setup(Rcpp::XPtr<tiledb::Context> ctx,
                                       Rcpp::Nullable<Rcpp::List> dim_points = R_NilValue,
                                       Rcpp::Nullable<Rcpp::List> dim_ranges = R_NilValue,
                                       Rcpp::Nullable<Rcpp::CharacterVector> config = R_NilValue,
-                                      const std::string& loglevel = "auto") {
+                                      const std::string& loglevel = "auto",
+                                      Rcpp::Nullable<Rcpp::XPtr<tdbs::QueryPredicate>> predicate = R_NilValue) {
     check_xptr_tag<tiledb::Context>(ctx);
     if (loglevel != "auto") {
         spdl::set_level(loglevel);
@@ -197,6 +225,14 @@ Rcpp::XPtr<tdbs::SOMAReader> sr_setup(Rcpp::XPtr<tiledb::Context> ctx,
         ptr->set_condition(*qcxp);
     }
 
+    // If we have a predicate, compile it against the reader's schema and context
+    if (!predicate.isNull()) {
+        Rcpp::XPtr<tdbs::QueryPredicate> qpxp(predicate);
+        check_xptr_tag<tdbs::QueryPredicate>(qpxp);
+        spdl::info("[soma_reader] Applying predicate {}", qpxp->to_string());
+        ptr->set_predicate(*qpxp);
+    }
+
     // If we have dimension points, apply them
     // The interface is named list, where each (named) list elements is one (named) dimesion
     // The List element is a simple vector of points and each point is applied to the named dimension
@@ -240,6 +276,7 @@ Rcpp::List sr_next(Rcpp::XPtr<tdbs::SOMAReader> sr) {
    const std::vector<std::string> names = sr_data->get()->names();
    auto ncol = names.size();
    Rcpp::List schlst(ncol), arrlst(ncol);
+   auto start = std::chrono::steady_clock::now();
 
    for (size_t i=0; i<ncol; i++) {
        // this allocates, and properly wraps as external pointers controlling lifetime
@@ -260,6 +297,8 @@ Rcpp::List sr_next(Rcpp::XPtr<tdbs::SOMAReader> sr) {
        schlst[i] = schemaxp;
        arrlst[i] = arrayxp;
    }
+   std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+   sr->record_arrow_export(elapsed.count());
 
    struct ArrowArray* array_data_tmp = (struct ArrowArray*) R_ExternalPtrAddr(arrlst[0]);
    int rows = static_cast<int>(array_data_tmp->length);
@@ -280,3 +319,450 @@ Rcpp::List sr_next(Rcpp::XPtr<tdbs::SOMAReader> sr) {
    as.attr("class") = "arch_array";
    return as;
 }
+
+// Convert the values of a column to an R vector of RTYPE in one pass
+template <typename T, int RTYPE>
+static SEXP convert_column(tdbs::ColumnBuffer& buf) {
+    using R = typename Rcpp::traits::storage_type<RTYPE>::type;
+    auto data = buf.data<T>();
+    Rcpp::Vector<RTYPE> vec(Rcpp::no_init(data.size()));
+    std::transform(data.begin(), data.end(), vec.begin(),
+                   [](T value) { return static_cast<R>(value); });
+    return vec;
+}
+
+// Convert (or view, when possible) a column of a batch as an R vector: see sr_next_df
+static SEXP column_to_vector(std::shared_ptr<tdbs::ColumnBuffer> buf, const std::string& int64_as) {
+    auto& col = *buf;
+    R_xlen_t n = col.size();
+    bool nullable = col.is_nullable();
+    tiledb_datatype_t type = col.type();
+    if (tiledb::impl::type_size(type) == 8 && type != TILEDB_FLOAT64 && type != TILEDB_UINT64 &&
+        !col.is_var()) {
+        type = TILEDB_INT64;  // datetime and time types
+    }
+
+    SEXP vec = R_NilValue;
+    bool integer64 = false;
+    switch (type) {
+        case TILEDB_STRING_ASCII:
+        case TILEDB_STRING_UTF8:
+        case TILEDB_CHAR: {
+            Rcpp::CharacterVector strings(n);
+            for (R_xlen_t i = 0; i < n; i++) {
+                auto sv = col.string_view(i);
+                strings[i] = Rf_mkCharLenCE(sv.data(), sv.size(), CE_UTF8);
+            }
+            vec = strings;
+            break;
+        }
+        case TILEDB_FLOAT64:
+            vec = nullable ? convert_column<double, REALSXP>(col) :
+                             make_altrep_real(buf, col.data<double>().data(), n);
+            break;
+        case TILEDB_FLOAT32:
+            vec = convert_column<float, REALSXP>(col);
+            break;
+        case TILEDB_INT32:
+            vec = nullable ? convert_column<int32_t, INTSXP>(col) :
+                             make_altrep_integer(buf, col.data<int32_t>().data(), n);
+            break;
+        case TILEDB_INT16:
+            vec = convert_column<int16_t, INTSXP>(col);
+            break;
+        case TILEDB_INT8:
+            vec = convert_column<int8_t, INTSXP>(col);
+            break;
+        case TILEDB_UINT16:
+            vec = convert_column<uint16_t, INTSXP>(col);
+            break;
+        case TILEDB_UINT8:
+            vec = convert_column<uint8_t, INTSXP>(col);
+            break;
+        case TILEDB_BOOL:
+            vec = convert_column<uint8_t, LGLSXP>(col);
+            break;
+        case TILEDB_UINT32:
+            vec = convert_column<uint32_t, REALSXP>(col);
+            break;
+        case TILEDB_UINT64:
+            vec = convert_column<uint64_t, REALSXP>(col);
+            break;
+        case TILEDB_INT64: {
+            if (int64_as == "double") {
+                vec = convert_column<int64_t, REALSXP>(col);
+            } else if (int64_as == "integer") {
+                auto data = col.data<int64_t>();
+                auto [lo, hi] = std::minmax_element(data.begin(), data.end());
+                if (n > 0 && (*lo <= std::numeric_limits<int>::min() ||
+                              *hi > std::numeric_limits<int>::max())) {
+                    Rcpp::stop("Column '%s' has values outside of the integer range",
+                               std::string(col.name()));
+                }
+                vec = convert_column<int64_t, INTSXP>(col);
+            } else {
+                // integer64 vectors hold the bits of the int64 values
+                auto data = reinterpret_cast<const double*>(col.data<int64_t>().data());
+                if (nullable) {
+                    Rcpp::NumericVector copy(Rcpp::no_init(n));
+                    std::copy(data, data + n, copy.begin());
+                    vec = copy;
+                } else {
+                    vec = make_altrep_real(buf, data, n);
+                }
+                integer64 = true;
+            }
+            break;
+        }
+        default:
+            Rcpp::stop("Column '%s' has unsupported type '%s'", std::string(col.name()),
+                       tiledb::impl::type_to_str(type));
+    }
+
+    PROTECT(vec);
+    if (integer64) {
+        Rf_setAttrib(vec, R_ClassSymbol, Rf_mkString("integer64"));
+    }
+
+    // Null cells are NA, with NA of integer64 stored as the smallest int64
+    if (nullable) {
+        auto validity = col.validity();
+        for (R_xlen_t i = 0; i < n; i++) {
+            if (validity[i]) {
+                continue;
+            }
+            switch (TYPEOF(vec)) {
+                case STRSXP:
+                    SET_STRING_ELT(vec, i, NA_STRING);
+                    break;
+                case REALSXP:
+                    if (integer64) {
+                        int64_t na = std::numeric_limits<int64_t>::min();
+                        std::memcpy(&REAL(vec)[i], &na, sizeof(na));
+                    } else {
+                        REAL(vec)[i] = NA_REAL;
+                    }
+                    break;
+                case LGLSXP:
+                    LOGICAL(vec)[i] = NA_LOGICAL;
+                    break;
+                default:
+                    INTEGER(vec)[i] = NA_INTEGER;
+            }
+        }
+    }
+    UNPROTECT(1);
+    return vec;
+}
+
+//' @rdname sr_setup
+//' @export
+// [[Rcpp::export]]
+SEXP sr_next_df(Rcpp::XPtr<tdbs::SOMAReader> sr, const std::string& int64_as = "integer64") {
+    check_xptr_tag<tdbs::SOMAReader>(sr);
+    if (int64_as != "integer64" && int64_as != "double" && int64_as != "integer") {
+        Rcpp::stop("int64_as must be one of 'integer64', 'double' or 'integer'");
+    }
+
+    auto sr_data = sr->read_next();
+    if (!sr_data) {
+        return R_NilValue;
+    }
+    auto& batch = *sr_data->get();
+    spdl::info("[sr_next_df] Read {} rows and {} cols", batch.num_rows(), batch.names().size());
+
+    auto start = std::chrono::steady_clock::now();
+    const std::vector<std::string> names = batch.names();
+    Rcpp::List df(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        df[i] = column_to_vector(batch.at(names[i]), int64_as);
+    }
+    df.attr("names") = names;
+    df.attr("row.names") = Rcpp::IntegerVector::create(NA_INTEGER, -static_cast<int>(batch.num_rows()));
+    df.attr("class") = "data.frame";
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    sr->record_arrow_export(elapsed.count());
+    return df;
+}
+
+//' @rdname sr_setup
+//' @export
+// [[Rcpp::export]]
+Rcpp::S4 sr_dgcmatrix(Rcpp::XPtr<tdbs::SOMAReader> sr,
+                      Rcpp::Nullable<Rcpp::NumericVector> dim = R_NilValue,
+                      Rcpp::Nullable<Rcpp::NumericVector> row_joinids = R_NilValue,
+                      Rcpp::Nullable<Rcpp::NumericVector> col_joinids = R_NilValue,
+                      double max_batches = 0) {
+    check_xptr_tag<tdbs::SOMAReader>(sr);
+
+    // Without a shape, the matrix spans the non-empty domain of the array
+    std::array<uint64_t, 2> shape;
+    if (dim.isNotNull()) {
+        Rcpp::NumericVector dv(dim);
+        if (dv.size() != 2) {
+            Rcpp::stop("dim must have two elements");
+        }
+        shape = {static_cast<uint64_t>(dv[0]), static_cast<uint64_t>(dv[1])};
+    } else {
+        auto dims = sr->schema()->domain().dimensions();
+        if (dims.size() != 2) {
+            Rcpp::stop("Array must have two dimensions");
+        }
+        for (size_t i = 0; i < 2; i++) {
+            shape[i] = sr->non_empty_domain<int64_t>(dims[i].name()).second + 1;
+        }
+    }
+
+    tdbs::CompressedMatrixBuilder builder(tdbs::CompressedFormat::CSC, shape[0], shape[1]);
+    if (row_joinids.isNotNull()) {
+        builder.set_joinids(0, getInt64Vector(Rcpp::NumericVector(row_joinids)));
+    }
+    if (col_joinids.isNotNull()) {
+        builder.set_joinids(1, getInt64Vector(Rcpp::NumericVector(col_joinids)));
+    }
+    builder.read(*sr, static_cast<uint64_t>(max_batches));
+    std::shared_ptr<tdbs::CompressedMatrix> matrix = builder.finish();
+    auto start = std::chrono::steady_clock::now();
+
+    auto max_int = static_cast<uint64_t>(std::numeric_limits<int>::max());
+    if (matrix->num_rows > max_int || matrix->num_cols > max_int || matrix->nnz() > max_int) {
+        Rcpp::stop("Matrix of %.0f x %.0f with %.0f values is too large for a dgCMatrix",
+                   static_cast<double>(matrix->num_rows), static_cast<double>(matrix->num_cols),
+                   static_cast<double>(matrix->nnz()));
+    }
+
+    // The indices fit in an int, so they are narrowed in one pass
+    Rcpp::IntegerVector i(Rcpp::no_init(matrix->indices.size()));
+    std::copy(matrix->indices.begin(), matrix->indices.end(), i.begin());
+    Rcpp::IntegerVector p(Rcpp::no_init(matrix->indptr.size()));
+    std::copy(matrix->indptr.begin(), matrix->indptr.end(), p.begin());
+
+    // Float64 values are viewed without copying, other types are converted
+    SEXP x;
+    auto nnz = static_cast<R_xlen_t>(matrix->nnz());
+    auto convert = [&](auto values) {
+        Rcpp::NumericVector xv(Rcpp::no_init(nnz));
+        std::copy(values.begin(), values.end(), xv.begin());
+        return SEXP(xv);
+    };
+    switch (matrix->type) {
+        case TILEDB_FLOAT64:
+            x = make_altrep_real(matrix, matrix->values<double>().data(), nnz);
+            break;
+        case TILEDB_FLOAT32:
+            x = convert(matrix->values<float>());
+            break;
+        case TILEDB_INT64:
+            x = convert(matrix->values<int64_t>());
+            break;
+        case TILEDB_UINT64:
+            x = convert(matrix->values<uint64_t>());
+            break;
+        case TILEDB_INT32:
+            x = convert(matrix->values<int32_t>());
+            break;
+        case TILEDB_UINT32:
+            x = convert(matrix->values<uint32_t>());
+            break;
+        case TILEDB_INT16:
+            x = convert(matrix->values<int16_t>());
+            break;
+        case TILEDB_UINT16:
+            x = convert(matrix->values<uint16_t>());
+            break;
+        case TILEDB_INT8:
+            x = convert(matrix->values<int8_t>());
+            break;
+        case TILEDB_UINT8:
+            x = convert(matrix->values<uint8_t>());
+            break;
+        default:
+            Rcpp::stop("Column 'soma_data' has unsupported type '%s'",
+                       tiledb::impl::type_to_str(matrix->type));
+    }
+    PROTECT(x);
+
+    Rcpp::S4 m("dgCMatrix");
+    m.slot("i") = i;
+    m.slot("p") = p;
+    m.slot("x") = x;
+    m.slot("Dim") = Rcpp::IntegerVector::create(static_cast<int>(matrix->num_rows),
+                                                static_cast<int>(matrix->num_cols));
+    UNPROTECT(1);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    sr->record_arrow_export(elapsed.count());
+    return m;
+}
+
+//' @rdname sr_setup
+//' @export
+// [[Rcpp::export]]
+std::string sr_metrics(Rcpp::XPtr<tdbs::SOMAReader> sr) {
+   check_xptr_tag<tdbs::SOMAReader>(sr);
+   return sr->metrics().to_json();
+}
+
+//' Map SOMA Joinids to Positions via IntIndexer
+//'
+//' The `int_indexer_*` functions map 64-bit integer keys such as \code{soma_joinid}
+//' values to their positions in a vector of unique keys, similar to \code{match()}
+//' but using a hash table built once in C++.
+//' \describe{
+//'   \item{\code{int_indexer_setup}}{builds the indexer from a vector of unique keys}
+//'   \item{\code{int_indexer_get}}{returns the positions of the given keys}
+//' }
+//'
+//' @param keys An \code{integer64} vector of keys
+//' @param indexer An external pointer to a TileDB IntIndexer object
+//'
+//' @return \code{int_indexer_setup} returns an external pointer to an IntIndexer.
+//' \code{int_indexer_get} returns an \code{integer64} vector with the one-based position
+//' of each key, or \code{NA} for keys that are not in the indexer.
+//'
+//' @examples
+//' \dontrun{
+//' idx <- int_indexer_setup(bit64::as.integer64(c(10, 20, 30)))
+//' int_indexer_get(idx, bit64::as.integer64(c(30, 40)))
+//' }
+//' @export
+// [[Rcpp::export]]
+Rcpp::XPtr<tdbs::IntIndexer> int_indexer_setup(Rcpp::NumericVector keys) {
+    std::vector<int64_t> iv = getInt64Vector(keys);
+    return make_xptr<tdbs::IntIndexer>(new tdbs::IntIndexer(iv));
+}
+
+//' @rdname int_indexer_setup
+//' @export
+// [[Rcpp::export]]
+Rcpp::NumericVector int_indexer_get(Rcpp::XPtr<tdbs::IntIndexer> indexer,
+                                    Rcpp::NumericVector keys) {
+    check_xptr_tag<tdbs::IntIndexer>(indexer);
+    std::vector<int64_t> positions = indexer->get_indexer(getInt64Vector(keys));
+
+    // integer64 values are one-based, with NA stored as the smallest int64
+    for (auto& pos : positions) {
+        pos = pos == tdbs::IntIndexer::NOT_FOUND ? std::numeric_limits<int64_t>::min() : pos + 1;
+    }
+    Rcpp::NumericVector result(positions.size());
+    std::memcpy(&(result[0]), positions.data(), positions.size() * sizeof(int64_t));
+    result.attr("class") = "integer64";
+    return result;
+}
+
+// Convert an R vector to predicate values: character, logical, integer, integer64 and
+// numeric vectors are supported
+static std::vector<tdbs::QueryPredicate::Value> getPredicateValues(SEXP vec) {
+    std::vector<tdbs::QueryPredicate::Value> values;
+    if (TYPEOF(vec) == STRSXP) {
+        for (auto& v : Rcpp::as<std::vector<std::string>>(vec)) {
+            values.emplace_back(v);
+        }
+    } else if (TYPEOF(vec) == LGLSXP) {
+        for (bool v : Rcpp::as<std::vector<bool>>(vec)) {
+            values.emplace_back(v);
+        }
+    } else if (TYPEOF(vec) == INTSXP) {
+        for (auto v : Rcpp::as<std::vector<int>>(vec)) {
+            values.emplace_back(int64_t{v});
+        }
+    } else if (TYPEOF(vec) == REALSXP && Rf_inherits(vec, "integer64")) {
+        for (auto v : getInt64Vector(Rcpp::NumericVector(vec))) {
+            values.emplace_back(v);
+        }
+    } else if (TYPEOF(vec) == REALSXP) {
+        for (auto v : Rcpp::as<std::vector<double>>(vec)) {
+            values.emplace_back(v);
+        }
+    } else {
+        Rcpp::stop("Unsupported predicate value type '%s'", Rf_type2char(TYPEOF(vec)));
+    }
+    return values;
+}
+
+//' Build Value Filters via QueryPredicate
+//'
+//' The `predicate_*` functions build a value filter on the attributes of an array. The filter
+//' is passed to \code{sr_setup}, which compiles it to a TileDB query condition against the
+//' schema and context of the SOMAReader so that cells are filtered while they are read.
+//' \describe{
+//'   \item{\code{predicate_compare}}{compares an attribute to a value}
+//'   \item{\code{predicate_in}}{selects cells where an attribute equals one of the values}
+//'   \item{\code{predicate_is_null}}{selects the null (or non-null) cells of a nullable attribute}
+//'   \item{\code{predicate_combine}}{combines two predicates with \sQuote{and} or \sQuote{or}}
+//'   \item{\code{predicate_negate}}{negates a predicate}
+//'   \item{\code{predicate_string}}{returns a readable representation of a predicate}
+//' }
+//'
+//' @param name Character value with the name of an attribute
+//' @param op Character value with a comparison operator (one of \code{==}, \code{!=}, \code{<},
+//' \code{<=}, \code{>}, \code{>=}) or, for \code{predicate_combine}, \sQuote{and} or \sQuote{or}
+//' @param value A character, logical, integer, \code{integer64} or numeric scalar
+//' @param values A character, logical, integer, \code{integer64} or numeric vector
+//' @param is_null Logical value, if false the non-null cells are selected
+//' @param lhs,rhs,predicate External pointers to QueryPredicate objects
+//'
+//' @return \code{predicate_string} returns a character value, the other functions return an
+//' external pointer to a QueryPredicate.
+//'
+//' @examples
+//' \dontrun{
+//' qp <- predicate_combine(predicate_compare("n_genes", ">", 1000),
+//'                         predicate_in("louvain", c("B cells", "NK cells")))
+//' sr <- sr_setup(ctx@ptr, uri, predicate = qp)
+//' }
+//' @export
+// [[Rcpp::export]]
+Rcpp::XPtr<tdbs::QueryPredicate> predicate_compare(const std::string& name,
+                                                   const std::string& op,
+                                                   SEXP value) {
+    auto values = getPredicateValues(value);
+    if (values.size() != 1) {
+        Rcpp::stop("Predicate value must be a scalar");
+    }
+    auto qp = tdbs::QueryPredicate::compare(name, tdbs::QueryPredicate::to_op(op), values[0]);
+    return make_xptr<tdbs::QueryPredicate>(new tdbs::QueryPredicate(qp));
+}
+
+//' @rdname predicate_compare
+//' @export
+// [[Rcpp::export]]
+Rcpp::XPtr<tdbs::QueryPredicate> predicate_in(const std::string& name, SEXP values) {
+    auto qp = tdbs::QueryPredicate::is_in(name, getPredicateValues(values));
+    return make_xptr<tdbs::QueryPredicate>(new tdbs::QueryPredicate(qp));
+}
+
+//' @rdname predicate_compare
+//' @export
+// [[Rcpp::export]]
+Rcpp::XPtr<tdbs::QueryPredicate> predicate_is_null(const std::string& name, bool is_null = true) {
+    auto qp = tdbs::QueryPredicate::is_null(name, is_null);
+    return make_xptr<tdbs::QueryPredicate>(new tdbs::QueryPredicate(qp));
+}
+
+//' @rdname predicate_compare
+//' @export
+// [[Rcpp::export]]
+Rcpp::XPtr<tdbs::QueryPredicate> predicate_combine(Rcpp::XPtr<tdbs::QueryPredicate> lhs,
+                                                   Rcpp::XPtr<tdbs::QueryPredicate> rhs,
+                                                   const std::string& op = "and") {
+    check_xptr_tag<tdbs::QueryPredicate>(lhs);
+    check_xptr_tag<tdbs::QueryPredicate>(rhs);
+    auto qp = lhs->combine(*rhs, tdbs::QueryPredicate::to_combination_op(op));
+    return make_xptr<tdbs::QueryPredicate>(new tdbs::QueryPredicate(qp));
+}
+
+//' @rdname predicate_compare
+//' @export
+// [[Rcpp::export]]
+Rcpp::XPtr<tdbs::QueryPredicate> predicate_negate(Rcpp::XPtr<tdbs::QueryPredicate> predicate) {
+    check_xptr_tag<tdbs::QueryPredicate>(predicate);
+    return make_xptr<tdbs::QueryPredicate>(new tdbs::QueryPredicate(predicate->negate()));
+}
+
+//' @rdname predicate_compare
+//' @export
+// [[Rcpp::export]]
+std::string predicate_string(Rcpp::XPtr<tdbs::QueryPredicate> predicate) {
+    check_xptr_tag<tdbs::QueryPredicate>(predicate);
+    return predicate->to_string();
+}
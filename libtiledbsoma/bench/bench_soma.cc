@@ -0,0 +1,437 @@
+/**
+ * @file   bench_soma.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines benchmarks of the libtiledbsoma read paths. The arrays
+ *   are generated in a local temporary directory on first use.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <numeric>
+#include <random>
+
+#include <tiledb/tiledb>
+#include <tiledbsoma/tiledbsoma>
+#include <tiledbsoma/util.h>
+
+using namespace tiledb;
+using namespace tiledbsoma;
+
+namespace {
+
+// Shape and density of the synthetic X array. Each row holds every
+// `X_STRIDE`-th column, so the cells of a row are unique.
+const int64_t N_OBS = 20000;
+const int64_t N_VAR = 2000;
+const int64_t X_STRIDE = 20;
+const int X_FRAGMENTS = 8;
+
+// Number of columns of each type in the wide obs array
+const int OBS_FLOAT_COLUMNS = 16;
+const int OBS_INT_COLUMNS = 16;
+const int OBS_STRING_COLUMNS = 8;
+
+/**
+ * @brief Synthetic arrays shared by all benchmarks, created on first use and
+ * removed at exit.
+ */
+class Dataset {
+   public:
+    Dataset()
+        : ctx_(std::make_shared<Context>())
+        , dir_((std::filesystem::temp_directory_path() / "tiledbsoma_bench")
+                   .string()) {
+        VFS vfs(*ctx_);
+        if (vfs.is_dir(dir_)) {
+            vfs.remove_dir(dir_);
+        }
+        vfs.create_dir(dir_);
+
+        create_x(x_uri(), false);
+        create_x(x_overlap_uri(), true);
+        create_obs(obs_uri());
+    }
+
+    ~Dataset() {
+        VFS vfs(*ctx_);
+        if (vfs.is_dir(dir_)) {
+            vfs.remove_dir(dir_);
+        }
+    }
+
+    std::shared_ptr<Context> ctx() const {
+        return ctx_;
+    }
+
+    // Sparse X array with one fragment per block of rows. The non-empty
+    // domains of the fragments do not overlap.
+    std::string x_uri() const {
+        return dir_ + "/X";
+    }
+
+    // Sparse X array with the rows interleaved across the fragments. The
+    // non-empty domains of all fragments overlap.
+    std::string x_overlap_uri() const {
+        return dir_ + "/X_overlap";
+    }
+
+    // Sparse obs dataframe with many columns of mixed types
+    std::string obs_uri() const {
+        return dir_ + "/obs";
+    }
+
+    static uint64_t x_nnz() {
+        return N_OBS * (N_VAR / X_STRIDE);
+    }
+
+   private:
+    void create_x(const std::string& uri, bool overlap) {
+        ArraySchema schema(*ctx_, TILEDB_SPARSE);
+        Domain domain(*ctx_);
+        domain.add_dimension(Dimension::create<int64_t>(
+            *ctx_, "soma_dim_0", {0, N_OBS - 1}, 2048));
+        domain.add_dimension(Dimension::create<int64_t>(
+            *ctx_, "soma_dim_1", {0, N_VAR - 1}, 2048));
+        schema.set_domain(domain);
+        schema.add_attribute(Attribute::create<float>(*ctx_, "soma_data"));
+        schema.set_capacity(100000);
+        schema.check();
+        Array::create(uri, schema);
+
+        Array array(*ctx_, uri, TILEDB_WRITE);
+        for (int f = 0; f < X_FRAGMENTS; f++) {
+            std::vector<int64_t> dim_0, dim_1;
+            std::vector<float> data;
+            for (int64_t row = 0; row < N_OBS; row++) {
+                bool in_fragment = overlap ?
+                                       row % X_FRAGMENTS == f :
+                                       row * X_FRAGMENTS / N_OBS == f;
+                if (!in_fragment) {
+                    continue;
+                }
+                for (int64_t col = row % X_STRIDE; col < N_VAR;
+                     col += X_STRIDE) {
+                    dim_0.push_back(row);
+                    dim_1.push_back(col);
+                    data.push_back(row + col * 0.5f);
+                }
+            }
+
+            Query query(*ctx_, array);
+            query.set_layout(TILEDB_UNORDERED)
+                .set_data_buffer("soma_dim_0", dim_0)
+                .set_data_buffer("soma_dim_1", dim_1)
+                .set_data_buffer("soma_data", data);
+            query.submit();
+        }
+        array.close();
+    }
+
+    void create_obs(const std::string& uri) {
+        ArraySchema schema(*ctx_, TILEDB_SPARSE);
+        Domain domain(*ctx_);
+        domain.add_dimension(Dimension::create<int64_t>(
+            *ctx_,
+            "soma_joinid",
+            {0, std::numeric_limits<int32_t>::max()},
+            N_OBS));
+        schema.set_domain(domain);
+        for (int i = 0; i < OBS_FLOAT_COLUMNS; i++) {
+            schema.add_attribute(
+                Attribute::create<double>(*ctx_, fmt::format("f{}", i)));
+        }
+        for (int i = 0; i < OBS_INT_COLUMNS; i++) {
+            schema.add_attribute(
+                Attribute::create<int32_t>(*ctx_, fmt::format("i{}", i)));
+        }
+        for (int i = 0; i < OBS_STRING_COLUMNS; i++) {
+            auto attr = Attribute::create<std::string>(
+                *ctx_, fmt::format("s{}", i));
+            // Half of the string columns are nullable
+            attr.set_nullable(i % 2 == 1);
+            schema.add_attribute(attr);
+        }
+        schema.check();
+        Array::create(uri, schema);
+
+        std::vector<int64_t> joinids(N_OBS);
+        std::iota(joinids.begin(), joinids.end(), 0);
+        std::vector<double> floats(N_OBS);
+        std::vector<int32_t> ints(N_OBS);
+        std::vector<std::string> strings(N_OBS);
+        std::vector<uint8_t> validity(N_OBS);
+        for (int64_t i = 0; i < N_OBS; i++) {
+            floats[i] = i * 0.25;
+            ints[i] = i % 1000;
+            strings[i] = fmt::format("cell_type_{}", i % 37);
+            validity[i] = i % 10 != 0;
+        }
+        auto [string_data, string_offsets] = util::to_varlen_buffers(
+            strings, false);
+
+        Array array(*ctx_, uri, TILEDB_WRITE);
+        Query query(*ctx_, array);
+        query.set_layout(TILEDB_UNORDERED)
+            .set_data_buffer("soma_joinid", joinids);
+        for (int i = 0; i < OBS_FLOAT_COLUMNS; i++) {
+            query.set_data_buffer(fmt::format("f{}", i), floats);
+        }
+        for (int i = 0; i < OBS_INT_COLUMNS; i++) {
+            query.set_data_buffer(fmt::format("i{}", i), ints);
+        }
+        for (int i = 0; i < OBS_STRING_COLUMNS; i++) {
+            auto name = fmt::format("s{}", i);
+            query.set_data_buffer(name, string_data)
+                .set_offsets_buffer(name, string_offsets);
+            if (i % 2 == 1) {
+                query.set_validity_buffer(name, validity);
+            }
+        }
+        query.submit();
+        array.close();
+    }
+
+    std::shared_ptr<Context> ctx_;
+    std::string dir_;
+};
+
+Dataset& dataset() {
+    static Dataset dataset;
+    return dataset;
+}
+
+/**
+ * @brief Read all cells of an array with `read_next`, returning the number of
+ * cells and batches read.
+ */
+std::pair<uint64_t, uint64_t> read_all(
+    const std::string& uri, std::map<std::string, std::string> config) {
+    auto sr = SOMAReader::open(uri, "bench", config);
+    sr->submit();
+    uint64_t num_cells = 0;
+    uint64_t num_batches = 0;
+    while (auto batch = sr->read_next()) {
+        num_cells += (*batch)->num_rows();
+        num_batches++;
+    }
+    return {num_cells, num_batches};
+}
+
+}  // namespace
+
+//===================================================================
+//= SOMAReader::read_next
+//===================================================================
+
+// Scan the X array with buffers of `init_buffer_bytes` per column
+void BM_ReadNextX(benchmark::State& state) {
+    auto& data = dataset();
+    std::map<std::string, std::string> config = {
+        {"soma.init_buffer_bytes", std::to_string(state.range(0))}};
+
+    uint64_t num_cells = 0;
+    uint64_t num_batches = 0;
+    for (auto _ : state) {
+        auto [cells, batches] = read_all(data.x_uri(), config);
+        num_cells += cells;
+        num_batches = batches;
+    }
+    state.SetItemsProcessed(num_cells);
+    state.SetBytesProcessed(
+        num_cells * (2 * sizeof(int64_t) + sizeof(float)));
+    state.counters["batches"] = num_batches;
+}
+BENCHMARK(BM_ReadNextX)
+    ->ArgName("init_buffer_bytes")
+    ->RangeMultiplier(8)
+    ->Range(1 << 20, 64 << 20)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Scan all columns of the wide obs array with buffers of `init_buffer_bytes`
+// per column
+void BM_ReadNextObs(benchmark::State& state) {
+    auto& data = dataset();
+    std::map<std::string, std::string> config = {
+        {"soma.init_buffer_bytes", std::to_string(state.range(0))}};
+
+    uint64_t num_cells = 0;
+    uint64_t num_batches = 0;
+    for (auto _ : state) {
+        auto [cells, batches] = read_all(data.obs_uri(), config);
+        num_cells += cells;
+        num_batches = batches;
+    }
+    state.SetItemsProcessed(num_cells);
+    state.counters["batches"] = num_batches;
+}
+BENCHMARK(BM_ReadNextObs)
+    ->ArgName("init_buffer_bytes")
+    ->RangeMultiplier(8)
+    ->Range(1 << 16, 4 << 20)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+//===================================================================
+//= ColumnBuffer::to_bitmap
+//===================================================================
+
+// Convert a bytemap of `num_cells` random validity values to a bitmap
+void BM_ToBitmap(benchmark::State& state) {
+    size_t num_cells = state.range(0);
+    std::mt19937 rng(0);
+    std::vector<uint8_t> bytemap(num_cells);
+    for (auto& byte : bytemap) {
+        byte = rng() % 10 != 0;
+    }
+    std::vector<uint8_t> bitmap((num_cells + 7) / 8);
+
+    for (auto _ : state) {
+        auto num_valid = ColumnBuffer::to_bitmap(
+            tcb::span<const uint8_t>(bytemap), bitmap.data());
+        benchmark::DoNotOptimize(num_valid);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * num_cells);
+}
+BENCHMARK(BM_ToBitmap)->ArgName("num_cells")->Range(1 << 10, 1 << 24);
+
+//===================================================================
+//= ArrowAdapter::to_arrow
+//===================================================================
+
+// Export one column of the obs array to Arrow: a float64 column, a string
+// column and a nullable string column
+void BM_ToArrow(benchmark::State& state) {
+    const std::vector<std::string> names = {"f0", "s0", "s1"};
+    auto& name = names.at(state.range(0));
+
+    auto sr = SOMAReader::open(dataset().obs_uri(), "bench", {}, {name});
+    sr->submit();
+    auto batch = sr->read_next();
+    auto column = (*batch)->at(name);
+
+    for (auto _ : state) {
+        auto [array, schema] = ArrowAdapter::to_arrow(column);
+        benchmark::DoNotOptimize(array->buffers);
+        array->release(array.get());
+        schema->release(schema.get());
+    }
+    state.SetItemsProcessed(state.iterations() * column->size());
+    state.SetLabel(name);
+}
+BENCHMARK(BM_ToArrow)->ArgName("column")->DenseRange(0, 2);
+
+//===================================================================
+//= SOMAReader::set_dim_points
+//===================================================================
+
+// Select `num_points` sorted random points on the obs joinids, with or
+// without coalescing the points into ranges
+void BM_SetDimPoints(benchmark::State& state) {
+    size_t num_points = state.range(0);
+    bool coalesce = state.range(1);
+    std::map<std::string, std::string> config = {
+        {ManagedQuery::CONFIG_KEY_COALESCE_POINTS,
+         coalesce ? "true" : "false"}};
+
+    // About half of the points are adjacent to the previous point
+    std::mt19937_64 rng(0);
+    std::vector<int64_t> points(num_points);
+    int64_t point = 0;
+    for (auto& p : points) {
+        point += 1 + rng() % 3;
+        p = point;
+    }
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto sr = SOMAReader::open(dataset().obs_uri(), "bench", config);
+        state.ResumeTiming();
+
+        sr->set_dim_points("soma_joinid", points);
+
+        state.PauseTiming();
+        sr.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * num_points);
+}
+BENCHMARK(BM_SetDimPoints)
+    ->ArgNames({"num_points", "coalesce"})
+    ->ArgsProduct({benchmark::CreateRange(1, 1 << 20, 32), {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+//===================================================================
+//= SOMAReader::nnz
+//===================================================================
+
+// Compute nnz from the fragment metadata when the fragments do not overlap
+// (fast path), or by counting the cells of overlapping fragments (slow path).
+// The stats cache is disabled to measure the computation.
+void BM_Nnz(benchmark::State& state) {
+    bool overlap = state.range(0);
+    auto& data = dataset();
+    auto sr = SOMAReader::open(
+        overlap ? data.x_overlap_uri() : data.x_uri(),
+        "bench",
+        {{StatsCache::CONFIG_KEY_CACHE_STATS, "false"}});
+
+    for (auto _ : state) {
+        auto nnz = sr->nnz();
+        if (nnz != Dataset::x_nnz()) {
+            state.SkipWithError("unexpected nnz");
+            break;
+        }
+    }
+    state.SetLabel(overlap ? "slow" : "fast");
+}
+BENCHMARK(BM_Nnz)
+    ->ArgName("overlap")
+    ->DenseRange(0, 1)
+    ->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    int major, minor, patch;
+    tiledb_version(&major, &minor, &patch);
+    benchmark::AddCustomContext(
+        "tiledb_version", fmt::format("{}.{}.{}", major, minor, patch));
+    benchmark::AddCustomContext("x_nnz", std::to_string(Dataset::x_nnz()));
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -63,6 +63,7 @@ set(INHERITED_CMAKE_ARGS
   -DOVERRIDE_INSTALL_PREFIX=${OVERRIDE_INSTALL_PREFIX}
   -DTILEDBSOMA_BUILD_R=${TILEDBSOMA_BUILD_R}
   -DTILEDBSOMA_BUILD_STATIC=${TILEDBSOMA_BUILD_STATIC}
+  -DTILEDBSOMA_ENABLE_BENCHMARKS=${TILEDBSOMA_ENABLE_BENCHMARKS}
 )
 
 ############################################################
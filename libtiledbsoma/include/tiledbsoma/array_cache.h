@@ -0,0 +1,327 @@
+/**
+ * @file   array_cache.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the array cache API
+ */
+
+#ifndef ARRAY_CACHE_H
+#define ARRAY_CACHE_H
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+
+#include <tiledb/tiledb>
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+/**
+ * @brief A least recently used (LRU) cache. The cache is not thread-safe.
+ *
+ * @tparam Key Key type
+ * @tparam Value Value type
+ */
+template <typename Key, typename Value>
+class LRUCache {
+   public:
+    /**
+     * @brief Construct a new LRUCache object.
+     *
+     * @param capacity Maximum number of entries
+     */
+    LRUCache(size_t capacity)
+        : capacity_(capacity) {
+    }
+
+    /**
+     * @brief Return the value for the key and mark it as most recently used.
+     *
+     * @param key Key
+     * @return std::optional<Value> Value, or std::nullopt if not cached
+     */
+    std::optional<Value> get(const Key& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return std::nullopt;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->second;
+    }
+
+    /**
+     * @brief Insert the value for the key, unless the key is already cached,
+     * and evict the least recently used entries beyond the capacity.
+     *
+     * @param key Key
+     * @param value Value
+     * @return Value The cached value for the key
+     */
+    Value insert(const Key& key, Value value) {
+        if (auto cached = get(key)) {
+            return *cached;
+        }
+        entries_.emplace_front(key, std::move(value));
+        index_[key] = entries_.begin();
+        evict();
+        return entries_.front().second;
+    }
+
+    /**
+     * @brief Set the maximum number of entries.
+     *
+     * @param capacity Maximum number of entries
+     */
+    void set_capacity(size_t capacity) {
+        capacity_ = capacity;
+        evict();
+    }
+
+    /**
+     * @brief Remove all entries.
+     */
+    void clear() {
+        index_.clear();
+        entries_.clear();
+    }
+
+    /**
+     * @brief Return the number of entries.
+     *
+     * @return size_t
+     */
+    size_t size() const {
+        return entries_.size();
+    }
+
+   private:
+    void evict() {
+        while (entries_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+    }
+
+    // Maximum number of entries
+    size_t capacity_;
+
+    // Entries, from most to least recently used
+    std::list<std::pair<Key, Value>> entries_;
+
+    // Map: key -> entry
+    std::map<Key, typename std::list<std::pair<Key, Value>>::iterator> index_;
+};
+
+/**
+ * @brief A process-wide, thread-safe cache of TileDB Contexts and open
+ * arrays, so readers of the same arrays share the VFS setup and the loaded
+ * schemas and fragment metadata.
+ *
+ * Contexts are keyed by their config. Arrays are keyed by the Context, URI
+ * and timestamp range. Fragment info is keyed by the Context, URI and the
+ * timestamp range the array was opened at, so an array reopened after a
+ * write loads the fragment info again. Entries are evicted in least recently
+ * used order.
+ *
+ * Note: a cached array is opened once, so it does not see fragments written
+ * after it was opened. SOMAReader, SOMAWriter and ExperimentQuery share the
+ * Contexts and arrays only if the "soma.cache_arrays" config parameter is
+ * "true".
+ */
+class ArrayCache {
+   public:
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    // Config key to read from cached arrays ("true" or "false")
+    inline static const std::string
+        CONFIG_KEY_CACHE_ARRAYS = "soma.cache_arrays";
+
+    // Default maximum number of entries of each kind
+    inline static const size_t DEFAULT_CAPACITY = 32;
+
+    using Timestamp = std::optional<std::pair<uint64_t, uint64_t>>;
+
+    // Fingerprint: (number of fragments, URI of the last fragment)
+    using Fingerprint = std::pair<uint64_t, std::string>;
+
+    /**
+     * @brief Return the process-wide cache.
+     *
+     * @return ArrayCache&
+     */
+    static ArrayCache& instance();
+
+    /**
+     * @brief Return a Context with the config. The Context is shared with
+     * other callers using the same config if the "soma.cache_arrays" config
+     * parameter is "true", and created otherwise.
+     *
+     * @param config Config parameters
+     * @return std::shared_ptr<Context> Context
+     */
+    static std::shared_ptr<Context> open_context(
+        const std::map<std::string, std::string>& config);
+
+    /**
+     * @brief Open an array for reading at the timestamp range, if provided.
+     *
+     * @param ctx TileDB context
+     * @param uri Array URI
+     * @param timestamp Optional timestamp range (start, end)
+     * @return std::shared_ptr<Array> Array
+     */
+    static std::shared_ptr<Array> open_array(
+        std::shared_ptr<Context> ctx,
+        const std::string& uri,
+        Timestamp timestamp = std::nullopt);
+
+    /**
+     * @brief Return a fingerprint of the fragments overlapping the timestamp
+     * range the array was opened at. A fragment written or consolidated in
+     * the range changes the fingerprint.
+     *
+     * @param array Open array
+     * @param fragment_info Loaded fragment info of the array
+     * @return Fingerprint Fingerprint
+     */
+    static Fingerprint fingerprint(
+        const Array& array, const FragmentInfo& fragment_info);
+
+    //===================================================================
+    //= public non-static
+    //===================================================================
+
+    /**
+     * @brief Construct a new ArrayCache object.
+     *
+     * @param capacity Maximum number of entries of each kind
+     */
+    ArrayCache(size_t capacity = DEFAULT_CAPACITY);
+
+    ArrayCache(const ArrayCache&) = delete;
+    ArrayCache(ArrayCache&&) = delete;
+    ~ArrayCache() = default;
+
+    /**
+     * @brief Return a Context with the config, shared with other callers
+     * using the same config.
+     *
+     * @param config Config parameters
+     * @return std::shared_ptr<Context> Context
+     */
+    std::shared_ptr<Context> context(
+        const std::map<std::string, std::string>& config);
+
+    /**
+     * @brief Return an array opened for reading with the Context at the
+     * timestamp range, shared with other callers.
+     *
+     * @param ctx TileDB context
+     * @param uri Array URI
+     * @param timestamp Optional timestamp range (start, end)
+     * @return std::shared_ptr<Array> Array
+     */
+    std::shared_ptr<Array> array(
+        std::shared_ptr<Context> ctx,
+        const std::string& uri,
+        Timestamp timestamp = std::nullopt);
+
+    /**
+     * @brief Return the loaded fragment info of an array, shared with other
+     * callers reading the array opened at the same timestamp range.
+     *
+     * @param ctx TileDB context
+     * @param uri Array URI
+     * @param array Open array
+     * @return std::shared_ptr<FragmentInfo> Fragment info
+     */
+    std::shared_ptr<FragmentInfo> fragment_info(
+        std::shared_ptr<Context> ctx,
+        const std::string& uri,
+        const Array& array);
+
+    /**
+     * @brief Set the maximum number of entries of each kind.
+     *
+     * @param capacity Maximum number of entries
+     */
+    void set_capacity(size_t capacity);
+
+    /**
+     * @brief Remove all entries.
+     */
+    void clear();
+
+    /**
+     * @brief Return the number of cached Contexts, arrays and fragment info.
+     *
+     * @return size_t
+     */
+    size_t size();
+
+   private:
+    //===================================================================
+    //= private non-static
+    //===================================================================
+
+    // Cached values hold the Context they were created with, because TileDB
+    // arrays and fragment info reference the Context without owning it. This
+    // also keeps the Context address in the cache keys unique.
+    template <typename T>
+    using Entry = std::pair<std::shared_ptr<Context>, std::shared_ptr<T>>;
+
+    using ArrayKey =
+        std::tuple<const Context*, std::string, bool, uint64_t, uint64_t>;
+
+    using FragmentInfoKey =
+        std::tuple<const Context*, std::string, uint64_t, uint64_t>;
+
+    // Map: config -> Context
+    LRUCache<std::string, std::shared_ptr<Context>> contexts_;
+
+    // Map: (Context, URI, timestamp range) -> array
+    LRUCache<ArrayKey, Entry<Array>> arrays_;
+
+    // Map: (Context, URI, open timestamp range) -> fragment info
+    LRUCache<FragmentInfoKey, Entry<FragmentInfo>> fragment_infos_;
+
+    // Mutex protecting the caches
+    std::mutex mtx_;
+};
+
+}  // namespace tiledbsoma
+#endif
@@ -1,8 +1,14 @@
 #ifndef ARROW_ADAPTER_H
 #define ARROW_ADAPTER_H
 
+#include <cerrno>
+#include <chrono>
+#include <limits>
+#include <unordered_map>
+
 #include <tiledbsoma/tiledbsoma>
 #include "carrow.h"
+#include "tiledbsoma/soma_reader.h"
 
 // https://arrow.apache.org/docs/format/CDataInterface.html
 // https://arrow.apache.org/docs/format/Columnar.html#buffer-listing-for-each-layout
@@ -17,15 +23,133 @@ namespace tiledbsoma {
  * The ArrowArray.release callback will delete the ArrowBuffer, and
  * automatically decrement the use count of the ColumnBuffer's shared pointer.
  *
+ * The ArrowBuffer also owns the bitmaps converted from the ColumnBuffer
+ * bytemaps, so the ColumnBuffer is not modified by the export, the 32-bit
+ * offsets of a column exported with small offsets, and the indices and
+ * values of a dictionary encoded column.
+ *
  */
 struct ArrowBuffer {
     ArrowBuffer(std::shared_ptr<ColumnBuffer> buffer)
-        : buffer_(buffer){};
+        : buffer_(buffer)
+        , validity_(PoolAllocator<uint8_t>(buffer->pool()))
+        , data_(PoolAllocator<uint8_t>(buffer->pool()))
+        , small_offsets_(PoolAllocator<int32_t>(buffer->pool()))
+        , indices_(PoolAllocator<int32_t>(buffer->pool()))
+        , dictionary_offsets_(PoolAllocator<int64_t>(buffer->pool()))
+        , dictionary_data_(PoolAllocator<char>(buffer->pool())){};
 
     std::shared_ptr<ColumnBuffer> buffer_;
+
+    // Validity bitmap
+    std::vector<uint8_t, PoolAllocator<uint8_t>> validity_;
+
+    // Data bitmap for TILEDB_BOOL
+    std::vector<uint8_t, PoolAllocator<uint8_t>> data_;
+
+    // 32-bit offsets narrowed from the ColumnBuffer offsets
+    std::vector<int32_t, PoolAllocator<int32_t>> small_offsets_;
+
+    // Dictionary indices of a dictionary encoded column
+    std::vector<int32_t, PoolAllocator<int32_t>> indices_;
+
+    // Offsets and data of the dictionary values
+    std::vector<int64_t, PoolAllocator<int64_t>> dictionary_offsets_;
+    std::vector<char, PoolAllocator<char>> dictionary_data_;
+
+    // Dictionary array, released with the parent array
+    struct ArrowArray dictionary_ {};
+
+    // Buffers of the Arrow array (validity, [offsets,] data), stored with
+    // the ArrowBuffer to avoid a separate allocation
+    const void* buffers_[3] = {nullptr, nullptr, nullptr};
+
+    // Buffers of the dictionary array (validity, offsets, data)
+    const void* dictionary_buffers_[3] = {nullptr, nullptr, nullptr};
+};
+
+/**
+ * @brief The ArrowStructBuffer owns the children of an Arrow struct array
+ * exported from ArrayBuffers. The ArrowArray.release callback releases and
+ * deletes the children.
+ */
+struct ArrowStructBuffer {
+    // Child arrays, one per column, allocated together
+    std::vector<ArrowArray> children;
+
+    // Pointers to the child arrays
+    std::vector<ArrowArray*> child_ptrs;
+
+    // Buffers of the struct array, with no validity bitmap
+    const void* buffers[1] = {nullptr};
+};
+
+/**
+ * @brief The ArrowSchemaTemplate holds the format, name and flags of an
+ * Arrow schema and its children. A template is built once per query and
+ * shared by all schemas exported from it, so the exported strings remain
+ * valid after the ColumnBuffers are deleted and are not copied per batch.
+ */
+struct ArrowSchemaTemplate {
+    std::string format;
+    std::string name;
+    int64_t flags = 0;
+    std::vector<ArrowSchemaTemplate> children;
+
+    // Value type of a dictionary encoded column, empty or one element
+    std::vector<ArrowSchemaTemplate> dictionary;
+};
+
+/**
+ * @brief The ArrowSchemaBuffer holds the template of an exported Arrow
+ * schema and owns its children. The ArrowSchema.release callback releases
+ * the children, which also hold the template, so a child moved out by the
+ * consumer remains valid.
+ */
+struct ArrowSchemaBuffer {
+    ArrowSchemaBuffer(std::shared_ptr<const ArrowSchemaTemplate> root)
+        : root(root){};
+
+    std::shared_ptr<const ArrowSchemaTemplate> root;
+
+    // Child schemas, allocated together
+    std::vector<ArrowSchema> children;
+
+    // Pointers to the child schemas
+    std::vector<ArrowSchema*> child_ptrs;
+
+    // Dictionary schema of a dictionary encoded column, if any
+    struct ArrowSchema dictionary {};
+};
+
+/**
+ * @brief The ArrowStreamBuffer holds the SOMAReader backing an
+ * ArrowArrayStream and the state of the stream.
+ */
+struct ArrowStreamBuffer {
+    ArrowStreamBuffer(std::shared_ptr<SOMAReader> reader)
+        : reader(reader){};
+
+    std::shared_ptr<SOMAReader> reader;
+
+    // Schema of the stream, set from the first batch
+    std::shared_ptr<const ArrowSchemaTemplate> schema;
+
+    // First batch, read to find the columns before the first `get_next`
+    std::optional<std::shared_ptr<ArrayBuffers>> pending;
+
+    // The reader returned all batches
+    bool done = false;
+
+    // Message of the last error
+    std::string error;
 };
 
 class ArrowAdapter {
+    // Bytes initially reserved for the values of a dictionary, so the data
+    // buffer of an empty dictionary is not null
+    inline static const size_t DICTIONARY_INIT_BYTES = 64;
+
    public:
     static void release_schema(struct ArrowSchema* schema) {
         schema->release = nullptr;
@@ -34,20 +158,27 @@ class ArrowAdapter {
 
     static void release_array(struct ArrowArray* array) {
         auto arrow_buffer = static_cast<ArrowBuffer*>(array->private_data);
+        TraceSpan span("release", "{}", arrow_buffer->buffer_->name());
 
-        LOG_TRACE(fmt::format(
+        LOG_TRACE(
             "[ArrowAdapter] release_array {} use_count={}",
             arrow_buffer->buffer_->name(),
-            arrow_buffer->buffer_.use_count()));
+            arrow_buffer->buffer_.use_count());
+
+        if (arrow_buffer->dictionary_.release != nullptr) {
+            arrow_buffer->dictionary_.release(&arrow_buffer->dictionary_);
+        }
 
         // Delete the ArrowBuffer, which was allocated with new.
         // If the ArrowBuffer.buffer_ shared_ptr is the last reference to the
         // underlying ColumnBuffer, the ColumnBuffer will be deleted.
         delete arrow_buffer;
 
-        if (array->buffers != nullptr) {
-            free(array->buffers);
-        }
+        array->release = nullptr;
+    }
+
+    static void release_dictionary(struct ArrowArray* array) {
+        // The buffers are owned by the ArrowBuffer of the parent array
         array->release = nullptr;
     }
 
@@ -60,17 +191,26 @@ class ArrowAdapter {
         std::unique_ptr<ArrowSchema> schema = std::make_unique<ArrowSchema>();
         std::unique_ptr<ArrowArray> array = std::make_unique<ArrowArray>();
 
-        schema->format = to_arrow_format(column->type()).data();  // mandatory
-        schema->name = column->name().data();                     // optional
-        schema->metadata = nullptr;                               // optional
-        schema->flags = 0;                                        // optional
-        schema->n_children = 0;                                   // mandatory
-        schema->children = nullptr;                               // optional
-        schema->dictionary = nullptr;                             // optional
-        schema->release = &release_schema;                        // mandatory
-        schema->private_data = nullptr;                           // optional
+        to_arrow(column, array.get());
+        to_arrow_schema(schema_template(column), schema.get());
 
-        int n_buffers = column->is_var() ? 3 : 2;
+        return std::pair(std::move(array), std::move(schema));
+    }
+
+    /**
+     * @brief Export a ColumnBuffer to an Arrow array allocated by the caller.
+     * The Arrow array shares the ColumnBuffer data, unless the column is
+     * dictionary encoded: the distinct values are then copied to a
+     * dictionary array and each cell is exported as an int32 index.
+     *
+     * @param column ColumnBuffer
+     * @param array Arrow array, released by the consumer
+     */
+    static void to_arrow(
+        std::shared_ptr<ColumnBuffer> column, struct ArrowArray* array) {
+        TraceSpan span("export", "{}", column->name());
+        bool is_dictionary = column->is_dictionary_encoded();
+        int n_buffers = column->is_var() && !is_dictionary ? 3 : 2;
 
         // Create an ArrowBuffer to manage the lifetime of `column`.
         // - `arrow_buffer` holds a shared_ptr to `column`, which increments
@@ -81,65 +221,226 @@ class ArrowAdapter {
         //   reaches 0, the ColumnBuffer data will be deleted.
         auto arrow_buffer = new ArrowBuffer(column);
 
-        array->length = column->size();             // mandatory
-        array->null_count = 0;                      // mandatory
-        array->offset = 0;                          // mandatory
-        array->n_buffers = n_buffers;               // mandatory
-        array->n_children = 0;                      // mandatory
-        array->buffers = nullptr;                   // mandatory
-        array->children = nullptr;                  // optional
-        array->dictionary = nullptr;                // optional
-        array->release = &release_array;            // mandatory
-        array->private_data = (void*)arrow_buffer;  // mandatory
-
-        LOG_TRACE(fmt::format(
+        array->length = column->size();                // mandatory
+        array->null_count = 0;                         // mandatory
+        array->offset = 0;                             // mandatory
+        array->n_buffers = n_buffers;                  // mandatory
+        array->n_children = 0;                         // mandatory
+        array->buffers = arrow_buffer->buffers_;       // mandatory
+        array->children = nullptr;                     // optional
+        array->dictionary = nullptr;                   // optional
+        array->release = &release_array;               // mandatory
+        array->private_data = (void*)arrow_buffer;     // mandatory
+
+        LOG_TRACE(
             "[ArrowAdapter] create array name='{}' use_count={}",
             column->name(),
-            column.use_count()));
+            column.use_count());
 
-        array->buffers = (const void**)malloc(sizeof(void*) * n_buffers);
-        assert(array->buffers != nullptr);
         array->buffers[0] = nullptr;  // validity
         array->buffers[n_buffers - 1] = column->data<void*>().data();  // data
-        if (n_buffers == 3) {
+        if (n_buffers == 3 && column->has_small_offsets()) {
+            to_small_offsets(*column, *arrow_buffer);
+            array->buffers[1] = arrow_buffer->small_offsets_.data();
+        } else if (n_buffers == 3) {
             array->buffers[1] = column->offsets().data();  // offsets
         }
 
+        size_t bitmap_bytes = (column->size() + 7) / 8;
+
         if (column->is_nullable()) {
-            schema->flags |= ARROW_FLAG_NULLABLE;
+            // Convert validity bytemap to a bitmap and count nulls
+            arrow_buffer->validity_.resize(bitmap_bytes);
+            auto num_valid = column->validity_to_bitmap(
+                arrow_buffer->validity_.data());
+            array->null_count = column->size() - num_valid;
+            array->buffers[0] = arrow_buffer->validity_.data();
+        }
+
+        /* Workaround to cast TILEDB_BOOL from uint8 to 1-bit Arrow boolean. */
+        if (column->type() == TILEDB_BOOL) {
+            arrow_buffer->data_.resize(bitmap_bytes);
+            column->data_to_bitmap(arrow_buffer->data_.data());
+            array->buffers[n_buffers - 1] = arrow_buffer->data_.data();
+        }
 
-            // Count nulls
-            for (auto v : column->validity()) {
-                array->null_count += v == 0;
+        if (is_dictionary) {
+            to_arrow_dictionary(*column, *arrow_buffer);
+            array->buffers[1] = arrow_buffer->indices_.data();
+            array->dictionary = &arrow_buffer->dictionary_;
+        }
+    }
+
+    /**
+     * @brief Build the Arrow schema template of a ColumnBuffer.
+     *
+     * @param column ColumnBuffer
+     * @return std::shared_ptr<const ArrowSchemaTemplate>
+     */
+    static std::shared_ptr<const ArrowSchemaTemplate> schema_template(
+        std::shared_ptr<ColumnBuffer> column) {
+        return std::make_shared<const ArrowSchemaTemplate>(
+            column_template(*column));
+    }
+
+    /**
+     * @brief Build the Arrow struct schema template of ArrayBuffers, with one
+     * child per column, matching the arrays exported by `to_arrow_struct`.
+     *
+     * @param array_buffers ArrayBuffers
+     * @return std::shared_ptr<const ArrowSchemaTemplate>
+     */
+    static std::shared_ptr<const ArrowSchemaTemplate> schema_template(
+        std::shared_ptr<ArrayBuffers> array_buffers) {
+        ArrowSchemaTemplate root{"+s", "", 0, {}, {}};
+        for (auto& name : array_buffers->names()) {
+            root.children.push_back(column_template(*array_buffers->at(name)));
+        }
+        return std::make_shared<const ArrowSchemaTemplate>(std::move(root));
+    }
+
+    /**
+     * @brief Return `cached` if it is the struct schema template of
+     * ArrayBuffers, or build a new template, so successive batches of a
+     * read share one template.
+     *
+     * @param array_buffers ArrayBuffers
+     * @param cached Template of a previous batch, or nullptr
+     * @return std::shared_ptr<const ArrowSchemaTemplate>
+     */
+    static std::shared_ptr<const ArrowSchemaTemplate> schema_template(
+        std::shared_ptr<ArrayBuffers> array_buffers,
+        std::shared_ptr<const ArrowSchemaTemplate> cached) {
+        if (cached && matches(*cached, *array_buffers)) {
+            return cached;
+        }
+        return schema_template(array_buffers);
+    }
+
+    static void release_struct_array(struct ArrowArray* array) {
+        auto struct_buffer = static_cast<ArrowStructBuffer*>(
+            array->private_data);
+        for (auto& child : struct_buffer->children) {
+            if (child.release != nullptr) {
+                child.release(&child);
             }
+        }
+        delete struct_buffer;
+        array->release = nullptr;
+    }
 
-            // Convert validity bytemap to a bitmap in place
-            column->validity_to_bitmap();
-            array->buffers[0] = column->validity().data();
+    static void release_owned_schema(struct ArrowSchema* schema) {
+        auto schema_buffer = static_cast<ArrowSchemaBuffer*>(
+            schema->private_data);
+        for (auto& child : schema_buffer->children) {
+            if (child.release != nullptr) {
+                child.release(&child);
+            }
         }
+        if (schema_buffer->dictionary.release != nullptr) {
+            schema_buffer->dictionary.release(&schema_buffer->dictionary);
+        }
+        delete schema_buffer;
+        schema->release = nullptr;
+    }
 
-        /* Workaround to cast TILEDB_BOOL from uint8 to 1-bit Arrow boolean. */
-        if (column->type() == TILEDB_BOOL) {
-            column->data_to_bitmap();
+    /**
+     * @brief Export ArrayBuffers to an Arrow struct array with one child
+     * array per column. The children share the ColumnBuffers, as in
+     * `to_arrow`.
+     *
+     * @param array_buffers ArrayBuffers
+     * @param out Arrow array, released by the consumer
+     */
+    static void to_arrow_struct(
+        std::shared_ptr<ArrayBuffers> array_buffers, struct ArrowArray* out) {
+        auto& names = array_buffers->names();
+        auto struct_buffer = new ArrowStructBuffer();
+        struct_buffer->children.resize(names.size());
+        for (size_t i = 0; i < names.size(); i++) {
+            auto& child = struct_buffer->children[i];
+            to_arrow(array_buffers->at(names[i]), &child);
+            struct_buffer->child_ptrs.push_back(&child);
         }
 
-        return std::pair(std::move(array), std::move(schema));
+        out->length = array_buffers->names().empty() ?
+                          0 :
+                          array_buffers->num_rows();
+        out->null_count = 0;
+        out->offset = 0;
+        out->n_buffers = 1;
+        out->n_children = struct_buffer->children.size();
+        out->buffers = struct_buffer->buffers;
+        out->children = struct_buffer->child_ptrs.data();
+        out->dictionary = nullptr;
+        out->release = &release_struct_array;
+        out->private_data = (void*)struct_buffer;
+    }
+
+    /**
+     * @brief Export an Arrow schema from a template. The exported schema
+     * shares the strings of the template.
+     *
+     * @param root Schema template
+     * @param out Arrow schema, released by the consumer
+     */
+    static void to_arrow_schema(
+        std::shared_ptr<const ArrowSchemaTemplate> root,
+        struct ArrowSchema* out) {
+        to_arrow_schema(root, *root, out);
+    }
+
+    /**
+     * @brief Export the Arrow struct schema of ArrayBuffers, matching the
+     * array exported by `to_arrow_struct`.
+     *
+     * @param array_buffers ArrayBuffers
+     * @param out Arrow schema, released by the consumer
+     */
+    static void to_arrow_schema(
+        std::shared_ptr<ArrayBuffers> array_buffers, struct ArrowSchema* out) {
+        to_arrow_schema(schema_template(array_buffers), out);
+    }
+
+    /**
+     * @brief Export the results of a SOMAReader to an ArrowArrayStream. Each
+     * call to `get_next` reads the next batch with `read_next` and returns
+     * it as a struct array with one child per column. The stream holds the
+     * reader until the stream is released.
+     *
+     * The query must be submitted before the stream is consumed. The schema
+     * is taken from the first batch, which is read by `get_schema` if needed.
+     *
+     * @param reader SOMAReader
+     * @param out Arrow array stream, released by the consumer
+     */
+    static void to_arrow_stream(
+        std::shared_ptr<SOMAReader> reader, struct ArrowArrayStream* out) {
+        out->get_schema = &stream_get_schema;
+        out->get_next = &stream_get_next;
+        out->get_last_error = &stream_get_last_error;
+        out->release = &stream_release;
+        out->private_data = (void*)new ArrowStreamBuffer(reader);
     }
 
     /**
      * @brief Get Arrow format string from TileDB datatype.
      *
      * @param datatype TileDB datatype.
+     * @param small_offsets True for a variable length type exported with
+     * 32-bit offsets
      * @return std::string_view Arrow format string.
      */
-    static std::string_view to_arrow_format(tiledb_datatype_t datatype) {
+    static std::string_view to_arrow_format(
+        tiledb_datatype_t datatype, bool small_offsets = false) {
         switch (datatype) {
             case TILEDB_STRING_ASCII:
             case TILEDB_STRING_UTF8:
-                return "U";  // large because TileDB uses 64bit offsets
+                // large unless narrowed, because TileDB uses 64bit offsets
+                return small_offsets ? "u" : "U";
             case TILEDB_CHAR:
             case TILEDB_BLOB:
-                return "Z";  // large because TileDB uses 64bit offsets
+                return small_offsets ? "z" : "Z";
             case TILEDB_BOOL:
                 return "b";
             case TILEDB_INT32:
@@ -185,6 +486,258 @@ class ArrowAdapter {
             "ArrowAdapter: Unsupported TileDB datatype: {} ",
             tiledb::impl::type_to_str(datatype)));
     }
+
+   private:
+    // Build the schema template of a column. A dictionary encoded column
+    // has int32 indices and a dictionary of the column type, which keeps
+    // 64-bit offsets.
+    static ArrowSchemaTemplate column_template(ColumnBuffer& column) {
+        auto format = std::string(to_arrow_format(
+            column.type(),
+            column.has_small_offsets() && !column.is_dictionary_encoded()));
+        std::vector<ArrowSchemaTemplate> dictionary;
+        if (column.is_dictionary_encoded()) {
+            dictionary.push_back({format, "", 0, {}, {}});
+            format = "i";
+        }
+        return {
+            format,
+            std::string(column.name()),
+            column.is_nullable() ? ARROW_FLAG_NULLABLE : 0,
+            {},
+            std::move(dictionary)};
+    }
+
+    // Return true if the struct schema template matches the columns of
+    // ArrayBuffers, without building the templates of the columns
+    static bool matches(
+        const ArrowSchemaTemplate& root, ArrayBuffers& array_buffers) {
+        auto& names = array_buffers.names();
+        if (root.children.size() != names.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < names.size(); i++) {
+            auto& child = root.children[i];
+            auto& column = *array_buffers.at(names[i]);
+            bool dictionary = column.is_dictionary_encoded();
+            auto format = to_arrow_format(
+                column.type(), column.has_small_offsets() && !dictionary);
+            int64_t flags = column.is_nullable() ? ARROW_FLAG_NULLABLE : 0;
+            if (child.name != names[i] || child.flags != flags ||
+                child.dictionary.size() != (dictionary ? 1 : 0) ||
+                (dictionary ? child.dictionary[0].format : child.format) !=
+                    format) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Narrow the 64-bit offsets of a variable length column to the
+     * 32-bit offsets of a regular Arrow string or binary array.
+     *
+     * @param column ColumnBuffer
+     * @param arrow_buffer ArrowBuffer holding the 32-bit offsets
+     */
+    static void to_small_offsets(
+        ColumnBuffer& column, ArrowBuffer& arrow_buffer) {
+        if (column.data_size() > ColumnBuffer::MAX_SMALL_OFFSETS_BYTES) {
+            throw TileDBSOMAError(fmt::format(
+                "[ArrowAdapter] Data of '{}' too large for 32-bit offsets: {} "
+                "bytes",
+                column.name(),
+                column.data_size()));
+        }
+
+        // The offsets have an extra element, the data size, for arrow
+        auto offsets = column.offsets().data();
+        auto num_offsets = column.size() + 1;
+        auto& small_offsets = arrow_buffer.small_offsets_;
+        small_offsets.resize(num_offsets);
+        for (size_t i = 0; i < num_offsets; i++) {
+            small_offsets[i] = (int32_t)offsets[i];
+        }
+    }
+
+    /**
+     * @brief Build the dictionary of a variable length column, hashing the
+     * values while the ColumnBuffer is hot in cache. The values are stored
+     * in the order of their first cell. Null cells have index 0.
+     *
+     * @param column ColumnBuffer
+     * @param arrow_buffer ArrowBuffer holding the indices and the dictionary
+     */
+    static void to_arrow_dictionary(
+        ColumnBuffer& column, ArrowBuffer& arrow_buffer) {
+        auto num_cells = column.size();
+        if (num_cells > (size_t)std::numeric_limits<int32_t>::max()) {
+            throw TileDBSOMAError(fmt::format(
+                "[ArrowAdapter] Too many cells to dictionary encode '{}': {}",
+                column.name(),
+                num_cells));
+        }
+
+        const uint8_t* validity = column.is_nullable() ?
+                                      column.validity().data() :
+                                      nullptr;
+        auto& indices = arrow_buffer.indices_;
+        auto& offsets = arrow_buffer.dictionary_offsets_;
+        auto& data = arrow_buffer.dictionary_data_;
+        indices.resize(num_cells);
+        offsets.assign(1, 0);
+        data.reserve(DICTIONARY_INIT_BYTES);
+
+        // Map: value -> index. The keys are views of the ColumnBuffer data.
+        std::unordered_map<std::string_view, int32_t> index;
+        for (size_t i = 0; i < num_cells; i++) {
+            if (validity != nullptr && !validity[i]) {
+                indices[i] = 0;
+                continue;
+            }
+            auto value = column.string_view(i);
+            auto [it, inserted] = index.try_emplace(
+                value, (int32_t)(offsets.size() - 1));
+            if (inserted) {
+                data.insert(data.end(), value.begin(), value.end());
+                offsets.push_back(data.size());
+            }
+            indices[i] = it->second;
+        }
+
+        LOG_DEBUG(
+            "[ArrowAdapter] dictionary encoded '{}' cells={} values={}",
+            column.name(),
+            num_cells,
+            offsets.size() - 1);
+
+        auto& buffers = arrow_buffer.dictionary_buffers_;
+        buffers[0] = nullptr;
+        buffers[1] = offsets.data();
+        buffers[2] = data.data();
+
+        auto& dictionary = arrow_buffer.dictionary_;
+        dictionary.length = offsets.size() - 1;
+        dictionary.null_count = 0;
+        dictionary.offset = 0;
+        dictionary.n_buffers = 3;
+        dictionary.n_children = 0;
+        dictionary.buffers = buffers;
+        dictionary.children = nullptr;
+        dictionary.dictionary = nullptr;
+        dictionary.release = &release_dictionary;
+        dictionary.private_data = nullptr;
+    }
+
+    // Export the schema of a template node, holding the template root
+    static void to_arrow_schema(
+        std::shared_ptr<const ArrowSchemaTemplate> root,
+        const ArrowSchemaTemplate& node,
+        struct ArrowSchema* out) {
+        auto schema_buffer = new ArrowSchemaBuffer(root);
+        schema_buffer->children.resize(node.children.size());
+        for (size_t i = 0; i < node.children.size(); i++) {
+            auto& child = schema_buffer->children[i];
+            to_arrow_schema(root, node.children[i], &child);
+            schema_buffer->child_ptrs.push_back(&child);
+        }
+
+        out->format = node.format.c_str();                   // mandatory
+        out->name = node.name.c_str();                       // optional
+        out->metadata = nullptr;                             // optional
+        out->flags = node.flags;                             // optional
+        out->n_children = node.children.size();              // mandatory
+        out->children = schema_buffer->child_ptrs.data();    // optional
+        out->dictionary = nullptr;                           // optional
+        if (!node.dictionary.empty()) {
+            to_arrow_schema(
+                root, node.dictionary[0], &schema_buffer->dictionary);
+            out->dictionary = &schema_buffer->dictionary;
+        }
+        out->release = &release_owned_schema;                // mandatory
+        out->private_data = (void*)schema_buffer;            // optional
+    }
+
+    /**
+     * @brief Read the first batch of a stream, if not read yet, and set the
+     * schema of the stream from the batch.
+     *
+     * @param stream_buffer Stream state
+     */
+    static void read_stream_schema(ArrowStreamBuffer& stream_buffer) {
+        if (stream_buffer.schema) {
+            return;
+        }
+        stream_buffer.pending = stream_buffer.reader->read_next();
+        stream_buffer.done = !stream_buffer.pending.has_value();
+
+        if (stream_buffer.pending) {
+            stream_buffer.schema = schema_template(
+                *stream_buffer.pending, stream_buffer.reader->arrow_schema());
+            stream_buffer.reader->set_arrow_schema(stream_buffer.schema);
+        } else {
+            stream_buffer.schema = std::make_shared<const ArrowSchemaTemplate>(
+                ArrowSchemaTemplate{"+s", "", 0, {}, {}});
+        }
+    }
+
+    static int stream_get_schema(
+        struct ArrowArrayStream* stream, struct ArrowSchema* out) {
+        auto& stream_buffer = *static_cast<ArrowStreamBuffer*>(
+            stream->private_data);
+        try {
+            read_stream_schema(stream_buffer);
+            to_arrow_schema(stream_buffer.schema, out);
+        } catch (const std::exception& e) {
+            stream_buffer.error = e.what();
+            return EIO;
+        }
+        return 0;
+    }
+
+    static int stream_get_next(
+        struct ArrowArrayStream* stream, struct ArrowArray* out) {
+        auto& stream_buffer = *static_cast<ArrowStreamBuffer*>(
+            stream->private_data);
+        try {
+            read_stream_schema(stream_buffer);
+
+            std::optional<std::shared_ptr<ArrayBuffers>> batch;
+            if (stream_buffer.pending) {
+                batch.swap(stream_buffer.pending);
+            } else if (!stream_buffer.done) {
+                batch = stream_buffer.reader->read_next();
+                stream_buffer.done = !batch.has_value();
+            }
+
+            // A released array marks the end of the stream
+            if (!batch) {
+                out->release = nullptr;
+                return 0;
+            }
+            auto start = std::chrono::steady_clock::now();
+            to_arrow_struct(*batch, out);
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+            stream_buffer.reader->record_arrow_export(elapsed.count());
+        } catch (const std::exception& e) {
+            stream_buffer.error = e.what();
+            return EIO;
+        }
+        return 0;
+    }
+
+    static const char* stream_get_last_error(struct ArrowArrayStream* stream) {
+        auto& stream_buffer = *static_cast<ArrowStreamBuffer*>(
+            stream->private_data);
+        return stream_buffer.error.c_str();
+    }
+
+    static void stream_release(struct ArrowArrayStream* stream) {
+        LOG_TRACE("[ArrowAdapter] release_stream");
+        delete static_cast<ArrowStreamBuffer*>(stream->private_data);
+        stream->release = nullptr;
+    }
 };
 
 };  // namespace tiledbsoma
@@ -0,0 +1,229 @@
+/**
+ * @file   axis_aggregator.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the per-row and per-column aggregation of sparse matrices.
+ */
+
+#ifndef AXIS_AGGREGATOR_H
+#define AXIS_AGGREGATOR_H
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <span/span.hpp>
+#include <tiledb/tiledb>
+
+#include "tiledbsoma/array_buffers.h"
+#include "tiledbsoma/common.h"
+#include "tiledbsoma/int_indexer.h"
+#include "tiledbsoma/soma_reader.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+/**
+ * @brief Aggregates of the values of a sparse matrix along one axis, with
+ * one entry per row (axis 0) or per column (axis 1).
+ */
+struct AxisAggregates {
+    // Number of stored values
+    std::vector<uint64_t> nnz;
+
+    // Sum of the values
+    std::vector<double> sum;
+
+    // Sum of the squared deviations of the stored values from their mean,
+    // accumulated with Welford's algorithm, which does not lose precision to
+    // cancellation when the mean is large
+    std::vector<double> m2;
+
+    /**
+     * @brief Return the mean of each entry over `n` values, counting the
+     * values that are not stored as zeros.
+     *
+     * @param n Length of the other axis
+     * @return std::vector<double>
+     */
+    std::vector<double> mean(uint64_t n) const;
+
+    /**
+     * @brief Return the variance of each entry over `n` values, counting
+     * the values that are not stored as zeros.
+     *
+     * @param n Length of the other axis
+     * @param ddof Delta degrees of freedom, the divisor is `n - ddof`
+     * @return std::vector<double>
+     */
+    std::vector<double> variance(uint64_t n, uint64_t ddof = 1) const;
+};
+
+/**
+ * @brief Compute the per-row or per-column number of stored values, sum and
+ * sum of squared deviations of a SOMA SparseNDArray from batches of COO
+ * results.
+ *
+ * Each batch is reduced in place, from the "soma_dim_0" or "soma_dim_1" and
+ * "soma_data" ColumnBuffers, and released, so only the aggregates are held.
+ * Large batches are split across threads, each accumulating into its own
+ * partial aggregates, which are then merged.
+ *
+ * An example use model, for the total counts of each cell:
+ *
+ *   auto reader = SOMAReader::open(uri, "X", {}, {"soma_dim_0", "soma_data"});
+ *   reader->submit();
+ *   AxisAggregator aggregator(0, n_obs);
+ *   aggregator.read(*reader);
+ *   auto totals = aggregator.aggregates().sum;
+ */
+class AxisAggregator {
+   public:
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    // Names of the row, column and value columns
+    inline static const std::string ROW_DIM = "soma_dim_0";
+    inline static const std::string COL_DIM = "soma_dim_1";
+    inline static const std::string DATA = "soma_data";
+
+    //===================================================================
+    //= public non-static
+    //===================================================================
+
+    /**
+     * @brief Construct a new AxisAggregator object.
+     *
+     * @param axis Axis of the aggregates, 0 for rows or 1 for columns
+     * @param size Number of rows or columns
+     * @param num_threads Number of threads reducing each batch, or 0 to use
+     *   the hardware concurrency
+     */
+    AxisAggregator(int axis, uint64_t size, unsigned num_threads = 0);
+
+    AxisAggregator(const AxisAggregator&) = delete;
+    AxisAggregator(AxisAggregator&&) = default;
+    ~AxisAggregator() = default;
+
+    /**
+     * @brief Remap the joinids of the axis to their positions in `joinids`.
+     * The size becomes the number of joinids, and a cell with a joinid not
+     * in `joinids` is an error. The aggregates are reset.
+     *
+     * @param joinids Unique joinids
+     */
+    void set_joinids(tcb::span<const int64_t> joinids);
+
+    /**
+     * @brief Add the values of a batch of results to the aggregates.
+     *
+     * @param batch Results with the axis dimension and value columns
+     */
+    void add(std::shared_ptr<ArrayBuffers> batch);
+
+    /**
+     * @brief Read batches from a submitted reader and add them.
+     *
+     * @param reader SOMAReader
+     * @param max_batches Maximum number of batches to read, or 0 to read all
+     *   remaining batches
+     * @return uint64_t Number of batches read
+     */
+    uint64_t read(SOMAReader& reader, uint64_t max_batches = 0);
+
+    /**
+     * @brief Return the number of cells added.
+     *
+     * @return uint64_t
+     */
+    uint64_t num_cells() const {
+        return num_cells_;
+    }
+
+    /**
+     * @brief Return the aggregates of the cells added.
+     *
+     * @return const AxisAggregates&
+     */
+    const AxisAggregates& aggregates() const {
+        return aggregates_;
+    }
+
+   private:
+    //===================================================================
+    //= private non-static
+    //===================================================================
+
+    // Name of the dimension of the axis
+    std::string dim_;
+
+    // Number of rows or columns
+    uint64_t size_;
+
+    // Optional joinid remap of the axis
+    std::optional<IntIndexer> remap_;
+
+    // Number of threads
+    unsigned num_threads_;
+
+    // Thread pool reducing the batches, created by the first large batch
+    std::unique_ptr<ThreadPool> pool_;
+
+    // Partial aggregates of each thread but the first, reused by each batch
+    std::vector<AxisAggregates> partials_;
+
+    // Aggregates of all batches
+    AxisAggregates aggregates_;
+
+    // Number of cells added
+    uint64_t num_cells_ = 0;
+
+    /**
+     * @brief Add the values of some cells of a batch to `out`.
+     *
+     * @tparam T Value type
+     * @param joinids Axis joinids of the cells
+     * @param positions Axis positions of the cells
+     * @param values Values of the cells
+     * @param out Aggregates
+     */
+    template <typename T>
+    void reduce(
+        tcb::span<const int64_t> joinids,
+        tcb::span<const int64_t> positions,
+        tcb::span<const T> values,
+        AxisAggregates& out);
+};
+
+}  // namespace tiledbsoma
+
+#endif
@@ -0,0 +1,304 @@
+/**
+ * @file   buffer_pool.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the buffer pool API
+ */
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <tiledb/tiledb>
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+/**
+ * @brief A pool of memory blocks reused by ColumnBuffers across batches.
+ *
+ * Blocks are grouped by size class: a power of two, or one, two or three
+ * quarters above it, so a block wastes at most a fifth of its bytes, and
+ * offsets buffers of (2^n + 1) cells are not rounded up to (2^(n+1)) cells.
+ * A deallocated block is retained in the pool, up to a limit on the bytes
+ * retained by the pool and a process-wide limit on the bytes retained by
+ * all pools, and returned by a later allocation in the same size class. This
+ * avoids repeatedly allocating, page faulting and freeing large buffers when
+ * a query is read in many batches.
+ *
+ * The queries of a Context share one pool (see `shared`). The pool is
+ * thread-safe, because buffers exported to Arrow may be released on a
+ * different thread than the thread reading the query.
+ */
+class BufferPool {
+   public:
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    // Config key for the maximum number of bytes retained by the pool of a
+    // Context. A value of 0 disables the pool.
+    inline static const std::string
+        CONFIG_KEY_POOL_BYTES = "soma.buffer_pool_bytes";
+
+    // Smallest default maximum number of bytes retained by a pool
+    inline static const size_t DEFAULT_MAX_BYTES = 64UL << 20;  // 64 MiB
+
+    // Number of initial column buffers ("soma.init_buffer_bytes") retained by
+    // default, enough for a batch and a prefetched batch of four columns.
+    // Wider reads should raise "soma.buffer_pool_bytes" and
+    // `set_total_max_bytes` to retain all the buffers of their batches.
+    inline static const size_t DEFAULT_NUM_BUFFERS = 8;
+
+    // Default maximum number of bytes retained by all pools in the process
+    inline static const size_t DEFAULT_TOTAL_MAX_BYTES = 256UL << 20;
+
+    // Smallest size class
+    inline static const size_t MIN_BLOCK_BYTES = 1 << 12;  // 4 KiB
+
+    // Alignment of the blocks, allowing vectorized access to the buffers
+    inline static const size_t ALIGNMENT = 64;
+
+    /**
+     * @brief Create a BufferPool configured by the "soma.buffer_pool_bytes"
+     * config parameter. By default, the pool retains `DEFAULT_NUM_BUFFERS`
+     * initial column buffers, and at least `DEFAULT_MAX_BYTES`.
+     *
+     * @param config TileDB config
+     * @return std::shared_ptr<BufferPool> BufferPool, or nullptr if the pool
+     * is disabled
+     */
+    static std::shared_ptr<BufferPool> create(const Config& config);
+
+    /**
+     * @brief Return the pool shared by the queries of a Context and its
+     * copies, creating it from the config of the Context if no query holds
+     * it. A pool is never returned for another Context, even one allocated
+     * at the address of a deleted Context.
+     *
+     * @param ctx TileDB context
+     * @return std::shared_ptr<BufferPool> BufferPool, or nullptr if the pool
+     * is disabled
+     */
+    static std::shared_ptr<BufferPool> shared(const Context& ctx);
+
+    /**
+     * @brief Set the maximum number of bytes retained by all pools in the
+     * process. Blocks already retained are not freed.
+     *
+     * @param max_bytes Maximum number of bytes
+     */
+    static void set_total_max_bytes(size_t max_bytes);
+
+    /**
+     * @brief Return the number of bytes retained by all pools in the
+     * process.
+     *
+     * @return size_t
+     */
+    static size_t total_retained_bytes();
+
+    //===================================================================
+    //= public non-static
+    //===================================================================
+
+    /**
+     * @brief Construct a new BufferPool object.
+     *
+     * @param max_bytes Maximum number of bytes retained by the pool
+     */
+    BufferPool(size_t max_bytes = DEFAULT_MAX_BYTES);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool(BufferPool&&) = delete;
+    ~BufferPool();
+
+    /**
+     * @brief Allocate a block of at least `num_bytes`, reusing a retained
+     * block if possible.
+     *
+     * @param num_bytes Number of bytes
+     * @return void* Block
+     */
+    void* allocate(size_t num_bytes);
+
+    /**
+     * @brief Return a block to the pool. The block is freed if the pool
+     * would exceed its maximum number of retained bytes.
+     *
+     * @param block Block returned by `allocate`
+     * @param num_bytes Number of bytes passed to `allocate`
+     */
+    void deallocate(void* block, size_t num_bytes);
+
+    /**
+     * @brief Free all blocks retained by the pool.
+     */
+    void clear();
+
+    /**
+     * @brief Return the number of bytes retained by the pool.
+     *
+     * @return size_t
+     */
+    size_t retained_bytes() const;
+
+    /**
+     * @brief Return the maximum number of bytes retained by the pool.
+     *
+     * @return size_t
+     */
+    size_t max_bytes() const {
+        return max_bytes_;
+    }
+
+    /**
+     * @brief Return the number of allocations that allocated a new block.
+     *
+     * @return size_t
+     */
+    size_t num_new_blocks() const;
+
+    /**
+     * @brief Return the number of allocations that reused a retained block.
+     *
+     * @return size_t
+     */
+    size_t num_reused_blocks() const;
+
+   private:
+    //===================================================================
+    //= private static
+    //===================================================================
+
+    /**
+     * @brief Return the size class of a block holding `num_bytes`.
+     *
+     * @param num_bytes Number of bytes
+     * @return size_t Size class in bytes
+     */
+    static size_t size_class(size_t num_bytes);
+
+    // Maximum number of bytes retained by all pools
+    inline static std::atomic<size_t> total_max_bytes_{
+        DEFAULT_TOTAL_MAX_BYTES};
+
+    // Number of bytes retained by all pools
+    inline static std::atomic<size_t> total_retained_bytes_{0};
+
+    //===================================================================
+    //= private non-static
+    //===================================================================
+
+    // Maximum number of bytes retained by the pool
+    size_t max_bytes_;
+
+    // Number of bytes retained by the pool
+    size_t retained_bytes_ = 0;
+
+    // Number of allocations that allocated a new block
+    size_t num_new_blocks_ = 0;
+
+    // Number of allocations that reused a retained block
+    size_t num_reused_blocks_ = 0;
+
+    // Map: size class -> retained blocks
+    std::unordered_map<size_t, std::vector<void*>> blocks_;
+
+    // Mutex protecting the pool
+    mutable std::mutex mtx_;
+};
+
+/**
+ * @brief An allocator for std::vector that allocates from a BufferPool. If
+ * the pool is null, memory is allocated directly with the same alignment as
+ * the pool blocks.
+ *
+ * The allocator holds a shared pointer to the pool, so the pool outlives all
+ * buffers allocated from it.
+ */
+template <typename T>
+class PoolAllocator {
+   public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+
+    PoolAllocator(std::shared_ptr<BufferPool> pool) noexcept
+        : pool_(std::move(pool)) {
+    }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept
+        : pool_(other.pool()) {
+    }
+
+    T* allocate(size_t n) {
+        if (pool_) {
+            return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+        }
+        return static_cast<T*>(::operator new(
+            n * sizeof(T), std::align_val_t(BufferPool::ALIGNMENT)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (pool_) {
+            pool_->deallocate(p, n * sizeof(T));
+        } else {
+            ::operator delete(p, std::align_val_t(BufferPool::ALIGNMENT));
+        }
+    }
+
+    const std::shared_ptr<BufferPool>& pool() const noexcept {
+        return pool_;
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const noexcept {
+        return pool_ == other.pool();
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const noexcept {
+        return pool_ != other.pool();
+    }
+
+   private:
+    std::shared_ptr<BufferPool> pool_;
+};
+
+}  // namespace tiledbsoma
+#endif
@@ -9,6 +9,11 @@
 
 #include <cinttypes>
 
+// The guards allow other copies of the Arrow C interfaces in the same
+// translation unit, as recommended by the Arrow documentation
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
 #define ARROW_FLAG_DICTIONARY_ORDERED 1
 #define ARROW_FLAG_NULLABLE 2
 #define ARROW_FLAG_MAP_KEYS_SORTED 4
@@ -45,6 +50,59 @@ struct ArrowArray {
     // Opaque producer-specific data
     void* private_data;
 };
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+/*
+ * Arrow C Stream Interface
+ * Apache License 2.0
+ * source: https://arrow.apache.org/docs/format/CStreamInterface.html
+ */
+
+#ifndef ARROW_C_STREAM_INTERFACE
+#define ARROW_C_STREAM_INTERFACE
+
+struct ArrowArrayStream {
+    // Callback to get the stream type
+    // (will be the same for all arrays in the stream).
+    //
+    // Return value: 0 if successful, an `errno`-compatible error code
+    // otherwise.
+    //
+    // If successful, the ArrowSchema must be released independently from the
+    // stream.
+    int (*get_schema)(struct ArrowArrayStream*, struct ArrowSchema* out);
+
+    // Callback to get the next array
+    // (if no error and the array is released, the stream has ended)
+    //
+    // Return value: 0 if successful, an `errno`-compatible error code
+    // otherwise.
+    //
+    // If successful, the ArrowArray must be released independently from the
+    // stream.
+    int (*get_next)(struct ArrowArrayStream*, struct ArrowArray* out);
+
+    // Callback to get optional detailed error information.
+    // This must only be called if the last stream operation failed
+    // with a non-0 return code.
+    //
+    // Return value: pointer to a null-terminated character array describing
+    // the last error, or NULL if no description is available.
+    //
+    // The returned pointer is only valid until the next operation on this
+    // stream (including release).
+    const char* (*get_last_error)(struct ArrowArrayStream*);
+
+    // Release callback: release the stream's own resources.
+    // Note that arrays returned by `get_next` must be individually released.
+    void (*release)(struct ArrowArrayStream*);
+
+    // Opaque producer-specific data
+    void* private_data;
+};
+
+#endif  // ARROW_C_STREAM_INTERFACE
 /* End Arrow C API */
 /* ************************************************************************ */
 #endif  // TILEDBSOMA_CARROW_H
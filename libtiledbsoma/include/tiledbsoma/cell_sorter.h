@@ -0,0 +1,90 @@
+/**
+ * @file   cell_sorter.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the sort of result batches by their coordinates.
+ */
+
+#ifndef CELL_SORTER_H
+#define CELL_SORTER_H
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tiledbsoma/array_buffers.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+/**
+ * @brief Sort the cells of result batches by their int64 coordinates.
+ *
+ * The batches are read from the same query or from queries of disjoint
+ * ranges of the first dimension. The cells of all batches are merged into
+ * one batch, sorted by the dimensions in order, so a sparse array read
+ * unordered is returned in row-major order without a client-side sort.
+ */
+class CellSorter {
+   public:
+    /**
+     * @brief Return one batch holding the cells of `batches`, sorted by the
+     * `dims` columns. Cells with equal coordinates keep the order of the
+     * batches and of the cells in each batch.
+     *
+     * @param batches Result batches with the same columns
+     * @param dims Dimension columns to sort by, which must be int64 columns
+     * of the batches
+     * @param names Columns of the sorted batch, or all columns of the
+     * batches if empty
+     * @return std::shared_ptr<ArrayBuffers> Sorted batch
+     */
+    static std::shared_ptr<ArrayBuffers> sort(
+        const std::vector<std::shared_ptr<ArrayBuffers>>& batches,
+        const std::vector<std::string>& dims,
+        const std::vector<std::string>& names = {});
+
+    /**
+     * @brief Return the cells of `batches` in sorted order, as (batch index,
+     * cell index) pairs.
+     *
+     * @param batches Result batches
+     * @param dims Dimension columns to sort by
+     * @return std::vector<ColumnBuffer::CellRef> Sorted cells
+     */
+    static std::vector<ColumnBuffer::CellRef> sort_cells(
+        const std::vector<std::shared_ptr<ArrayBuffers>>& batches,
+        const std::vector<std::string>& dims);
+};
+
+}  // namespace tiledbsoma
+
+#endif
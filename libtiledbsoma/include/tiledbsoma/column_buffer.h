@@ -33,13 +33,16 @@
 #ifndef COLUMN_BUFFER_H
 #define COLUMN_BUFFER_H
 
+#include <limits>
 #include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
 
 #include <span/span.hpp>
 #include <tiledb/tiledb>
 
+#include "tiledbsoma/buffer_pool.h"
 #include "tiledbsoma/common.h"
 #include "tiledbsoma/logger_public.h"
+#include "tiledbsoma/memory_governor.h"
 
 namespace tiledbsoma {
 
@@ -55,6 +58,14 @@ class ColumnBuffer {
         CONFIG_KEY_INIT_BYTES = "soma.init_buffer_bytes";
 
    public:
+    // Largest data size (bytes) of a variable length buffer exported with
+    // 32-bit Arrow offsets
+    inline static const size_t MAX_SMALL_OFFSETS_BYTES =
+        std::numeric_limits<int32_t>::max();
+
+    // A cell of one of several ColumnBuffers: (buffer index, cell index)
+    using CellRef = std::pair<uint32_t, uint32_t>;
+
     //===================================================================
     //= public static
     //===================================================================
@@ -64,10 +75,59 @@ class ColumnBuffer {
      *
      * @param array TileDB array
      * @param name TileDB dimension or attribute name
+     * @param num_bytes Optional number of bytes to allocate for data,
+     *   overriding the "soma.init_buffer_bytes" config parameter
+     * @param num_cells Optional number of cells to allocate for offsets and
+     *   validity, overriding the number of cells computed from `num_bytes`
+     * @param pool Optional pool to allocate the buffers from
      * @return ColumnBuffer
      */
     static std::shared_ptr<ColumnBuffer> create(
-        std::shared_ptr<Array> array, std::string_view name);
+        std::shared_ptr<Array> array,
+        std::string_view name,
+        std::optional<size_t> num_bytes = std::nullopt,
+        std::optional<size_t> num_cells = std::nullopt,
+        std::shared_ptr<BufferPool> pool = nullptr);
+
+    /**
+     * @brief Return the number of bytes `create` allocates for the data,
+     * offsets and validity of a column, without allocating them.
+     *
+     * @param array TileDB array
+     * @param name TileDB dimension or attribute name
+     * @param num_bytes Optional number of bytes to allocate for data
+     * @param num_cells Optional number of cells to allocate for offsets and
+     *   validity
+     * @return size_t Number of bytes
+     */
+    static size_t alloc_bytes(
+        std::shared_ptr<Array> array,
+        std::string_view name,
+        std::optional<size_t> num_bytes = std::nullopt,
+        std::optional<size_t> num_cells = std::nullopt);
+
+    /**
+     * @brief Return the number of bytes allocated for the data of a column,
+     * from the "soma.init_buffer_bytes" config parameter or the default.
+     *
+     * @param config TileDB config
+     * @return size_t Number of bytes
+     */
+    static size_t init_bytes(const Config& config);
+
+    /**
+     * @brief Return a new ColumnBuffer holding cells copied from buffers of
+     * the same column, in the order of `cells`. The new buffer is allocated
+     * from the pool of the first buffer and exported like it, except that
+     * data too large for 32-bit offsets is exported with 64-bit offsets.
+     *
+     * @param parts ColumnBuffers of the same column
+     * @param cells Cells to copy, as (index in `parts`, cell index) pairs
+     * @return std::shared_ptr<ColumnBuffer> ColumnBuffer
+     */
+    static std::shared_ptr<ColumnBuffer> gather(
+        const std::vector<std::shared_ptr<ColumnBuffer>>& parts,
+        tcb::span<const CellRef> cells);
 
     /**
      * @brief Convert a bytemap to a bitmap in place.
@@ -75,6 +135,18 @@ class ColumnBuffer {
      */
     static void to_bitmap(tcb::span<uint8_t> bytemap);
 
+    /**
+     * @brief Convert a bytemap to an Arrow bitmap, where a bit is set if the
+     * corresponding byte is not zero. The conversion is vectorized with
+     * AVX2, SSE2 or NEON when available. The bitmap may alias the bytemap.
+     *
+     * @param bytemap Bytemap to convert
+     * @param bitmap Bitmap with space for at least (bytemap.size() + 7) / 8
+     *   bytes
+     * @return size_t Number of bits set in the bitmap
+     */
+    static size_t to_bitmap(tcb::span<const uint8_t> bytemap, uint8_t* bitmap);
+
     //===================================================================
     //= public non-static
     //===================================================================
@@ -88,6 +160,8 @@ class ColumnBuffer {
      * @param num_bytes Number of bytes to allocate for data
      * @param is_var Column type is variable length
      * @param is_nullable Column can contain null values
+     * @param pool Optional pool to allocate the buffers from. The buffers are
+     *   returned to the pool when the ColumnBuffer is deleted.
      */
     ColumnBuffer(
         std::string_view name,
@@ -95,14 +169,15 @@ class ColumnBuffer {
         size_t num_cells,
         size_t num_bytes,
         bool is_var = false,
-        bool is_nullable = false);
+        bool is_nullable = false,
+        std::shared_ptr<BufferPool> pool = nullptr);
 
     ColumnBuffer() = delete;
     ColumnBuffer(const ColumnBuffer&) = delete;
     ColumnBuffer(ColumnBuffer&&) = default;
 
     ~ColumnBuffer() {
-        LOG_TRACE(fmt::format("[ColumnBuffer] release '{}'", name_));
+        LOG_TRACE("[ColumnBuffer] release '{}'", name_);
     }
 
     /**
@@ -112,6 +187,14 @@ class ColumnBuffer {
      */
     void attach(Query& query);
 
+    /**
+     * @brief Reallocate the buffers to hold `num_bytes` of data. The contents
+     * of the buffers are discarded.
+     *
+     * @param num_bytes Number of bytes to allocate for data
+     */
+    void grow(size_t num_bytes);
+
     /**
      * @brief Size num_cells_ to match the read query results.
      *
@@ -128,6 +211,47 @@ class ColumnBuffer {
         return num_cells_;
     }
 
+    /**
+     * @brief Return the number of bytes allocated for data.
+     *
+     * @return size_t
+     */
+    size_t capacity() const {
+        return data_.capacity();
+    }
+
+    /**
+     * @brief Return the number of bytes allocated for the data, offsets and
+     * validity buffers.
+     *
+     * @return size_t
+     */
+    size_t allocated_bytes() const {
+        return data_.capacity() + offsets_.capacity() * sizeof(uint64_t) +
+               validity_.capacity();
+    }
+
+    /**
+     * @brief Return the number of data bytes in the buffer.
+     *
+     * @return size_t
+     */
+    size_t data_size() const {
+        return is_var_ ? offsets_.data()[num_cells_] * type_size_ :
+                         num_cells_ * type_size_;
+    }
+
+    /**
+     * @brief Return the number of cells the buffer can hold. A variable length
+     * column can hold fewer cells, if the cells do not fit in the data buffer.
+     *
+     * @return size_t
+     */
+    size_t max_num_cells() const {
+        return is_var_ ? offsets_.capacity() - 1 :
+                         data_.capacity() / type_size_;
+    }
+
     /**
      * @brief Return a view of the ColumnBuffer data.
      *
@@ -213,6 +337,55 @@ class ColumnBuffer {
         return is_nullable_;
     }
 
+    /**
+     * @brief Export the buffer as an Arrow dictionary array. Only variable
+     * length columns can be dictionary encoded.
+     *
+     * @param dictionary_encoded True to export a dictionary array
+     */
+    void set_dictionary_encoded(bool dictionary_encoded) {
+        if (dictionary_encoded && !is_var_) {
+            throw TileDBSOMAError(
+                "[ColumnBuffer] Dictionary encoding requires a variable "
+                "length column: " +
+                name_);
+        }
+        is_dictionary_encoded_ = dictionary_encoded;
+    }
+
+    /**
+     * @brief Return true if the buffer is exported as an Arrow dictionary
+     * array.
+     */
+    bool is_dictionary_encoded() const {
+        return is_dictionary_encoded_;
+    }
+
+    /**
+     * @brief Export the buffer as a regular Arrow string or binary array,
+     * with 32-bit offsets, instead of a large array. The data of the buffer
+     * must not exceed `MAX_SMALL_OFFSETS_BYTES`. Only variable length
+     * columns have offsets.
+     *
+     * @param small_offsets True to export 32-bit offsets
+     */
+    void set_small_offsets(bool small_offsets) {
+        if (small_offsets && !is_var_) {
+            throw TileDBSOMAError(
+                "[ColumnBuffer] Small offsets require a variable length "
+                "column: " +
+                name_);
+        }
+        small_offsets_ = small_offsets;
+    }
+
+    /**
+     * @brief Return true if the buffer is exported with 32-bit offsets.
+     */
+    bool has_small_offsets() const {
+        return small_offsets_;
+    }
+
     /**
      * @brief Convert the data bytemap to a bitmap in place.
      *
@@ -229,6 +402,49 @@ class ColumnBuffer {
         ColumnBuffer::to_bitmap(validity());
     }
 
+    /**
+     * @brief Write the data bytemap to a separate bitmap, leaving the data
+     * unchanged.
+     *
+     * @param bitmap Bitmap with space for at least (size() + 7) / 8 bytes
+     * @return size_t Number of bits set in the bitmap
+     */
+    size_t data_to_bitmap(uint8_t* bitmap) {
+        return ColumnBuffer::to_bitmap(data<uint8_t>(), bitmap);
+    }
+
+    /**
+     * @brief Write the validity bytemap to a separate bitmap, leaving the
+     * validity unchanged.
+     *
+     * @param bitmap Bitmap with space for at least (size() + 7) / 8 bytes
+     * @return size_t Number of valid cells
+     */
+    size_t validity_to_bitmap(uint8_t* bitmap) {
+        return ColumnBuffer::to_bitmap(validity(), bitmap);
+    }
+
+    /**
+     * @brief Return the pool the buffers are allocated from, or nullptr.
+     *
+     * @return std::shared_ptr<BufferPool>
+     */
+    std::shared_ptr<BufferPool> pool() const {
+        return data_.get_allocator().pool();
+    }
+
+    /**
+     * @brief Hold a memory reservation until the ColumnBuffer is deleted.
+     * The ColumnBuffers of a batch share one reservation, which is returned
+     * to the MemoryGovernor when the last of them is deleted.
+     *
+     * @param reservation Memory reservation
+     */
+    void set_reservation(
+        std::shared_ptr<MemoryGovernor::Reservation> reservation) {
+        reservation_ = std::move(reservation);
+    }
+
    private:
     //===================================================================
     //= private static
@@ -242,6 +458,9 @@ class ColumnBuffer {
      * @param type TileDB datatype
      * @param is_var True if variable length data
      * @param is_nullable True if nullable data
+     * @param num_bytes Optional number of bytes to allocate for data
+     * @param num_cells Optional number of cells to allocate
+     * @param pool Optional pool to allocate the buffers from
      * @return ColumnBuffer
      */
     static std::shared_ptr<ColumnBuffer> alloc(
@@ -249,7 +468,21 @@ class ColumnBuffer {
         std::string_view name,
         tiledb_datatype_t type,
         bool is_var,
-        bool is_nullable);
+        bool is_nullable,
+        std::optional<size_t> num_bytes,
+        std::optional<size_t> num_cells,
+        std::shared_ptr<BufferPool> pool);
+
+    /**
+     * @brief Return the number of cells held by a data buffer of `num_bytes`.
+     *
+     * @param num_bytes Number of bytes allocated for data
+     * @param type TileDB datatype
+     * @param is_var True if variable length data
+     * @return size_t Number of cells
+     */
+    static size_t num_cells_for(
+        size_t num_bytes, tiledb_datatype_t type, bool is_var);
 
     //===================================================================
     //= private non-static
@@ -273,14 +506,24 @@ class ColumnBuffer {
     // If true, the data is nullable
     bool is_nullable_;
 
+    // If true, the data is exported as an Arrow dictionary array
+    bool is_dictionary_encoded_ = false;
+
+    // If true, the offsets are exported as 32-bit Arrow offsets
+    bool small_offsets_ = false;
+
+    // Memory reservation (optional), declared before the buffers so that it
+    // is released after the buffers are freed.
+    std::shared_ptr<MemoryGovernor::Reservation> reservation_;
+
     // Data buffer.
-    std::vector<std::byte> data_;
+    std::vector<std::byte, PoolAllocator<std::byte>> data_;
 
     // Offsets buffer (optional).
-    std::vector<uint64_t> offsets_;
+    std::vector<uint64_t, PoolAllocator<uint64_t>> offsets_;
 
     // Validity buffer (optional).
-    std::vector<uint8_t> validity_;
+    std::vector<uint8_t, PoolAllocator<uint8_t>> validity_;
 };
 
 }  // namespace tiledbsoma
@@ -0,0 +1,246 @@
+/**
+ * @file   compressed_matrix.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the compressed sparse matrix builder API
+ */
+
+#ifndef COMPRESSED_MATRIX_H
+#define COMPRESSED_MATRIX_H
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <span/span.hpp>
+#include <tiledb/tiledb>
+
+#include "tiledbsoma/array_buffers.h"
+#include "tiledbsoma/common.h"
+#include "tiledbsoma/int_indexer.h"
+#include "tiledbsoma/soma_reader.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+/**
+ * @brief Compressed sparse matrix formats.
+ */
+enum class CompressedFormat {
+    // Compressed sparse row
+    CSR,
+    // Compressed sparse column
+    CSC
+};
+
+/**
+ * @brief A sparse matrix in compressed sparse row (CSR) or column (CSC)
+ * format. The major axis is the row axis for CSR and the column axis for
+ * CSC.
+ */
+struct CompressedMatrix {
+    CompressedFormat format;
+
+    // Number of rows
+    uint64_t num_rows = 0;
+
+    // Number of columns
+    uint64_t num_cols = 0;
+
+    // Offset of the first value of each major index, followed by the number
+    // of values
+    std::vector<int64_t> indptr;
+
+    // Minor index of each value, sorted within each major index
+    std::vector<int64_t> indices;
+
+    // Values, stored as the bytes of `type`
+    std::vector<std::byte> data;
+
+    // TileDB datatype of the values, float64 for a matrix built without
+    // batches
+    tiledb_datatype_t type = TILEDB_FLOAT64;
+
+    /**
+     * @brief Return the number of stored values.
+     *
+     * @return uint64_t
+     */
+    uint64_t nnz() const {
+        return indices.size();
+    }
+
+    /**
+     * @brief Return the values as a span of T.
+     *
+     * @tparam T Value type
+     * @return tcb::span<T>
+     */
+    template <typename T>
+    tcb::span<T> values() {
+        if (data.size() != nnz() * sizeof(T)) {
+            throw TileDBSOMAError(
+                "[CompressedMatrix] values: type size mismatch");
+        }
+        return tcb::span<T>((T*)data.data(), nnz());
+    }
+};
+
+/**
+ * @brief Build a CSR or CSC matrix from batches of COO results.
+ *
+ * The batches are read from the "soma_dim_0", "soma_dim_1" and "soma_data"
+ * columns of a SOMA SparseNDArray. The matrix is assembled with a parallel,
+ * stable counting sort on the major dimension, after which the minor indices
+ * of each major index are sorted, so the results of unordered reads are
+ * supported.
+ *
+ * The joinids of a dimension may be remapped to dense positions with
+ * `set_joinids`, so a selection of rows or columns is assembled into a
+ * matrix with one row or column per selected joinid.
+ *
+ * An example use model:
+ *
+ *   auto reader = SOMAReader::open(uri);
+ *   reader->submit();
+ *   CompressedMatrixBuilder builder(CompressedFormat::CSR, n_obs, n_var);
+ *   builder.read(*reader);
+ *   auto matrix = builder.finish();
+ */
+class CompressedMatrixBuilder {
+   public:
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    // Names of the row, column and value columns
+    inline static const std::string ROW_DIM = "soma_dim_0";
+    inline static const std::string COL_DIM = "soma_dim_1";
+    inline static const std::string DATA = "soma_data";
+
+    //===================================================================
+    //= public non-static
+    //===================================================================
+
+    /**
+     * @brief Construct a new CompressedMatrixBuilder object.
+     *
+     * @param format Matrix format
+     * @param num_rows Number of rows
+     * @param num_cols Number of columns
+     * @param num_threads Number of threads assembling the matrix, or 0 to
+     *   use the hardware concurrency
+     */
+    CompressedMatrixBuilder(
+        CompressedFormat format,
+        uint64_t num_rows,
+        uint64_t num_cols,
+        unsigned num_threads = 0);
+
+    CompressedMatrixBuilder(const CompressedMatrixBuilder&) = delete;
+    CompressedMatrixBuilder(CompressedMatrixBuilder&&) = default;
+    ~CompressedMatrixBuilder() = default;
+
+    /**
+     * @brief Remap the joinids of a dimension to their positions in
+     * `joinids`. The number of rows or columns becomes the number of
+     * joinids, and a cell with a joinid not in `joinids` is an error.
+     *
+     * @param dim Dimension index, 0 for rows or 1 for columns
+     * @param joinids Unique joinids
+     */
+    void set_joinids(int dim, tcb::span<const int64_t> joinids);
+
+    /**
+     * @brief Add a batch of results. The batch is held until `finish`.
+     *
+     * @param batch Results with the row, column and value columns
+     */
+    void add(std::shared_ptr<ArrayBuffers> batch);
+
+    /**
+     * @brief Read batches from a submitted reader and add them.
+     *
+     * @param reader SOMAReader
+     * @param max_batches Maximum number of batches to read, or 0 to read all
+     *   remaining batches
+     * @return uint64_t Number of batches read
+     */
+    uint64_t read(SOMAReader& reader, uint64_t max_batches = 0);
+
+    /**
+     * @brief Return the number of cells added since the last `finish`.
+     *
+     * @return uint64_t
+     */
+    uint64_t nnz() const {
+        return nnz_;
+    }
+
+    /**
+     * @brief Assemble the matrix from the added batches and remove the
+     * batches, so the builder can assemble another matrix.
+     *
+     * @return std::shared_ptr<CompressedMatrix>
+     */
+    std::shared_ptr<CompressedMatrix> finish();
+
+   private:
+    //===================================================================
+    //= private non-static
+    //===================================================================
+
+    // Matrix format
+    CompressedFormat format_;
+
+    // Number of rows and columns
+    uint64_t shape_[2];
+
+    // Optional joinid remap of each dimension
+    std::optional<IntIndexer> remaps_[2];
+
+    // Number of threads
+    unsigned num_threads_;
+
+    // Batches added since the last `finish`
+    std::vector<std::shared_ptr<ArrayBuffers>> batches_;
+
+    // Number of cells in the batches
+    uint64_t nnz_ = 0;
+
+    // TileDB datatype of the values, set by the first batch
+    std::optional<tiledb_datatype_t> type_;
+};
+
+}  // namespace tiledbsoma
+
+#endif
@@ -0,0 +1,273 @@
+/**
+ * @file   experiment_query.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the ExperimentQuery
+ */
+
+#ifndef EXPERIMENT_QUERY_H
+#define EXPERIMENT_QUERY_H
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <tiledb/tiledb>
+
+#include "thread_pool/thread_pool.h"
+#include "tiledbsoma/array_buffers.h"
+#include "tiledbsoma/compressed_matrix.h"
+#include "tiledbsoma/soma_reader.h"
+
+namespace tiledbsoma {
+using namespace tiledb;
+
+/**
+ * @brief Query the obs, var and X arrays of a SOMA experiment.
+ *
+ * The obs and var dataframes are read concurrently on a thread pool, with
+ * the coordinates and value filters set on their readers. The joinids of
+ * the selected obs and var rows are then selected on the "soma_dim_0" and
+ * "soma_dim_1" dimensions of the X layer, which is read like any other
+ * SOMAReader.
+ *
+ * The arrays are opened at "obs", "ms/<measurement>/var" and
+ * "ms/<measurement>/X/<layer>" relative to the experiment URI.
+ *
+ * An example use model:
+ *
+ *   auto query = ExperimentQuery::open(uri, "RNA");
+ *   query->obs().set_condition(qc);
+ *   query->submit();
+ *   while (auto batch = query->X().read_next()) {
+ *       ... process batch ...
+ *   }
+ */
+class ExperimentQuery {
+   public:
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    // Name of the joinid column of the obs and var dataframes
+    inline static const std::string SOMA_JOINID = "soma_joinid";
+
+    /**
+     * @brief Open the arrays of an experiment and return an ExperimentQuery.
+     *
+     * @param uri URI of the experiment
+     * @param measurement_name Name of the measurement
+     * @param X_layer Name of the X layer
+     * @param platform_config Config parameter dictionary
+     * @param timestamp Optional read timestamp range (start, end)
+     * @return std::unique_ptr<ExperimentQuery> ExperimentQuery
+     */
+    static std::unique_ptr<ExperimentQuery> open(
+        std::string_view uri,
+        std::string_view measurement_name = "RNA",
+        std::string_view X_layer = "data",
+        std::map<std::string, std::string> platform_config = {},
+        std::optional<std::pair<uint64_t, uint64_t>> timestamp = std::nullopt);
+
+    /**
+     * @brief Open the arrays of an experiment and return an ExperimentQuery.
+     *
+     * @param ctx TileDB context
+     * @param uri URI of the experiment
+     * @param measurement_name Name of the measurement
+     * @param X_layer Name of the X layer
+     * @param timestamp Optional read timestamp range (start, end)
+     * @return std::unique_ptr<ExperimentQuery> ExperimentQuery
+     */
+    static std::unique_ptr<ExperimentQuery> open(
+        std::shared_ptr<Context> ctx,
+        std::string_view uri,
+        std::string_view measurement_name = "RNA",
+        std::string_view X_layer = "data",
+        std::optional<std::pair<uint64_t, uint64_t>> timestamp = std::nullopt);
+
+    //===================================================================
+    //= public non-static
+    //===================================================================
+
+    /**
+     * @brief Construct a new ExperimentQuery object, opening the obs, var
+     * and X arrays concurrently.
+     *
+     * @param uri URI of the experiment
+     * @param ctx TileDB context
+     * @param measurement_name Name of the measurement
+     * @param X_layer Name of the X layer
+     * @param timestamp Optional read timestamp range (start, end)
+     */
+    ExperimentQuery(
+        std::string_view uri,
+        std::shared_ptr<Context> ctx,
+        std::string_view measurement_name = "RNA",
+        std::string_view X_layer = "data",
+        std::optional<std::pair<uint64_t, uint64_t>> timestamp = std::nullopt);
+
+    ExperimentQuery() = delete;
+    ExperimentQuery(const ExperimentQuery&) = delete;
+    ExperimentQuery(ExperimentQuery&&) = delete;
+    ~ExperimentQuery() = default;
+
+    /**
+     * @brief Return the reader of the obs dataframe, to set its coordinates,
+     * value filter and columns before `submit`.
+     *
+     * @return SOMAReader&
+     */
+    SOMAReader& obs() {
+        return *obs_.reader;
+    }
+
+    /**
+     * @brief Return the reader of the var dataframe, to set its coordinates,
+     * value filter and columns before `submit`.
+     *
+     * @return SOMAReader&
+     */
+    SOMAReader& var() {
+        return *var_.reader;
+    }
+
+    /**
+     * @brief Return the reader of the X layer. The joinids of the obs and
+     * var results are selected by `submit`, after which the X results are
+     * read with `read_next`.
+     *
+     * @return SOMAReader&
+     */
+    SOMAReader& X() {
+        return *x_;
+    }
+
+    /**
+     * @brief Read the obs and var dataframes concurrently, select their
+     * joinids on the X layer, and submit the X query.
+     */
+    void submit();
+
+    /**
+     * @brief Return the results read from the obs dataframe.
+     *
+     * @return const std::vector<std::shared_ptr<ArrayBuffers>>&
+     */
+    const std::vector<std::shared_ptr<ArrayBuffers>>& obs_results() const {
+        return obs_.results;
+    }
+
+    /**
+     * @brief Return the results read from the var dataframe.
+     *
+     * @return const std::vector<std::shared_ptr<ArrayBuffers>>&
+     */
+    const std::vector<std::shared_ptr<ArrayBuffers>>& var_results() const {
+        return var_.results;
+    }
+
+    /**
+     * @brief Return the joinids of the obs results, in result order.
+     *
+     * @return const std::vector<int64_t>&
+     */
+    const std::vector<int64_t>& obs_joinids() const {
+        return obs_.joinids;
+    }
+
+    /**
+     * @brief Return the joinids of the var results, in result order.
+     *
+     * @return const std::vector<int64_t>&
+     */
+    const std::vector<int64_t>& var_joinids() const {
+        return var_.joinids;
+    }
+
+    /**
+     * @brief Read the X results into a CSR or CSC matrix with one row per
+     * obs joinid and one column per var joinid, in result order.
+     *
+     * @param format Matrix format
+     * @param num_threads Number of threads assembling the matrix, or 0 to
+     *   use the hardware concurrency
+     * @return std::shared_ptr<CompressedMatrix>
+     */
+    std::shared_ptr<CompressedMatrix> read_X(
+        CompressedFormat format = CompressedFormat::CSR,
+        unsigned num_threads = 0);
+
+   private:
+    //===================================================================
+    //= private non-static
+    //===================================================================
+
+    // An axis dataframe and the results read from it
+    struct Axis {
+        // Reader of the dataframe
+        std::unique_ptr<SOMAReader> reader;
+
+        // Results read from the dataframe
+        std::vector<std::shared_ptr<ArrayBuffers>> results;
+
+        // Joinids of the results
+        std::vector<int64_t> joinids;
+    };
+
+    // Experiment URI
+    std::string uri_;
+
+    // Obs and var dataframes
+    Axis obs_;
+    Axis var_;
+
+    // Reader of the X layer
+    std::unique_ptr<SOMAReader> x_;
+
+    // True if the query was submitted
+    bool submitted_ = false;
+
+    // Thread pool opening the arrays and reading the dataframes, declared
+    // after the readers so its threads are joined first
+    std::unique_ptr<ThreadPool> pool_;
+
+    /**
+     * @brief Read all results and joinids of an axis dataframe.
+     *
+     * @param axis Axis
+     */
+    static void read_axis(Axis& axis);
+};
+
+}  // namespace tiledbsoma
+
+#endif
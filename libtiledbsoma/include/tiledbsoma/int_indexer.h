@@ -0,0 +1,179 @@
+/**
+ * @file   int_indexer.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the int64 joinid indexer API
+ */
+
+#ifndef INT_INDEXER_H
+#define INT_INDEXER_H
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <span/span.hpp>
+
+#include "thread_pool/thread_pool.h"
+#include "tiledbsoma/common.h"
+
+namespace tiledbsoma {
+
+/**
+ * @brief Map int64 keys, such as soma_joinids, to their positions 0..N-1 in
+ * the array of keys the indexer was built from.
+ *
+ * The keys are stored in an open-addressing hash table with linear probing,
+ * which holds 16 bytes per slot and at least two slots per key. Bulk lookups
+ * with `get_indexer` are split across the threads of a pool owned by the
+ * indexer, which is created with the indexer if it uses more than one thread.
+ *
+ * An example use model:
+ *
+ *   IntIndexer indexer(obs_joinids);
+ *   auto positions = indexer.get_indexer(dim_0);
+ */
+class IntIndexer {
+   public:
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    // Position of a key that is not in the indexer
+    inline static const int64_t NOT_FOUND = -1;
+
+    //===================================================================
+    //= public non-static
+    //===================================================================
+
+    /**
+     * @brief Construct an empty IntIndexer object.
+     *
+     * @param num_threads Number of threads used by `get_indexer`, or 0 to
+     *   use the hardware concurrency
+     */
+    IntIndexer(unsigned num_threads = 0);
+
+    /**
+     * @brief Construct a new IntIndexer object mapping the keys.
+     *
+     * @param keys Unique keys
+     * @param num_threads Number of threads used by `get_indexer`, or 0 to
+     *   use the hardware concurrency
+     */
+    IntIndexer(tcb::span<const int64_t> keys, unsigned num_threads = 0);
+
+    /**
+     * @brief Map the keys to their positions, replacing the current keys.
+     * Duplicate keys are an error.
+     *
+     * @param keys Unique keys
+     */
+    void map_locations(tcb::span<const int64_t> keys);
+
+    /**
+     * @brief Return the position of a key.
+     *
+     * @param key Key
+     * @return int64_t Position, or NOT_FOUND
+     */
+    int64_t lookup(int64_t key) const {
+        for (uint64_t slot = hash(key);; slot = (slot + 1) & mask_) {
+            auto& entry = slots_[slot];
+            if (entry.position == NOT_FOUND || entry.key == key) {
+                return entry.position;
+            }
+        }
+    }
+
+    /**
+     * @brief Look up the position of each key.
+     *
+     * @param keys Keys
+     * @param positions Positions of the keys, or NOT_FOUND, with the size of
+     *   `keys`
+     */
+    void get_indexer(
+        tcb::span<const int64_t> keys, tcb::span<int64_t> positions) const;
+
+    /**
+     * @brief Look up the position of each key.
+     *
+     * @param keys Keys
+     * @return std::vector<int64_t> Positions of the keys, or NOT_FOUND
+     */
+    std::vector<int64_t> get_indexer(tcb::span<const int64_t> keys) const;
+
+    /**
+     * @brief Return the number of keys.
+     *
+     * @return size_t
+     */
+    size_t size() const {
+        return size_;
+    }
+
+   private:
+    //===================================================================
+    //= private non-static
+    //===================================================================
+
+    struct Slot {
+        int64_t key;
+        int64_t position;
+    };
+
+    // Return the first slot probed for a key, with Fibonacci hashing
+    uint64_t hash(int64_t key) const {
+        return ((uint64_t)key * 0x9E3779B97F4A7C15ull) >> shift_;
+    }
+
+    // Hash table, with a power of two number of slots
+    std::vector<Slot> slots_;
+
+    // Mask of a slot index
+    uint64_t mask_ = 0;
+
+    // Shift of a hash to a slot index
+    int shift_ = 64;
+
+    // Number of keys
+    size_t size_ = 0;
+
+    // Number of threads used by `get_indexer`
+    unsigned num_threads_;
+
+    // Thread pool of the bulk lookups, if `num_threads_` is greater than 1
+    std::unique_ptr<ThreadPool> pool_;
+};
+
+}  // namespace tiledbsoma
+
+#endif
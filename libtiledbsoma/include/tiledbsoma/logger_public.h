@@ -58,6 +58,9 @@ void LOG_SET_FILE(const std::string& logfile);
 /** Check if global logger is logging debug messages. */
 bool LOG_DEBUG_ENABLED();
 
+/** Check if global logger is logging messages of the level. */
+bool LOG_ENABLED(spdlog::level::level_enum level);
+
 /** Logs a trace message. */
 void LOG_TRACE(const std::string& msg);
 
@@ -76,6 +79,136 @@ void LOG_ERROR(const std::string& msg);
 /** Logs a critical error and exits with a non-zero status. */
 void LOG_FATAL(const std::string& msg);
 
+/**
+ * Logs a trace message formatted from the arguments. The message is only
+ * formatted if trace messages are logged.
+ */
+template <typename... Args>
+void LOG_TRACE(fmt::format_string<Args...> format, Args&&... args) {
+    if (LOG_ENABLED(spdlog::level::trace)) {
+        LOG_TRACE(fmt::format(format, std::forward<Args>(args)...));
+    }
+}
+
+/**
+ * Logs a debug message formatted from the arguments. The message is only
+ * formatted if debug messages are logged.
+ */
+template <typename... Args>
+void LOG_DEBUG(fmt::format_string<Args...> format, Args&&... args) {
+    if (LOG_ENABLED(spdlog::level::debug)) {
+        LOG_DEBUG(fmt::format(format, std::forward<Args>(args)...));
+    }
+}
+
+/**
+ * Logs an info message formatted from the arguments. The message is only
+ * formatted if info messages are logged.
+ */
+template <typename... Args>
+void LOG_INFO(fmt::format_string<Args...> format, Args&&... args) {
+    if (LOG_ENABLED(spdlog::level::info)) {
+        LOG_INFO(fmt::format(format, std::forward<Args>(args)...));
+    }
+}
+
+/**
+ * Logs a warning formatted from the arguments. The message is only formatted
+ * if warnings are logged.
+ */
+template <typename... Args>
+void LOG_WARN(fmt::format_string<Args...> format, Args&&... args) {
+    if (LOG_ENABLED(spdlog::level::warn)) {
+        LOG_WARN(fmt::format(format, std::forward<Args>(args)...));
+    }
+}
+
+/**
+ * Logs an error formatted from the arguments. The message is only formatted
+ * if errors are logged.
+ */
+template <typename... Args>
+void LOG_ERROR(fmt::format_string<Args...> format, Args&&... args) {
+    if (LOG_ENABLED(spdlog::level::err)) {
+        LOG_ERROR(fmt::format(format, std::forward<Args>(args)...));
+    }
+}
+
+/**
+ * Start recording trace spans to a trace file, in the Chrome trace event
+ * format viewed with Perfetto (https://ui.perfetto.dev) or chrome://tracing.
+ */
+void TRACE_START(const std::string& tracefile);
+
+/** Stop recording trace spans and close the trace file. */
+void TRACE_STOP();
+
+/** Check if trace spans are recorded. */
+bool TRACE_ENABLED();
+
+/**
+ * @brief A span of time recorded in the trace file, from construction to
+ * destruction, for example the submit of a query. The span is only timed, and
+ * its detail formatted, if trace spans are recorded.
+ */
+class TraceSpan {
+   public:
+    /**
+     * @brief Start a span.
+     *
+     * @param name Name of the span, a string literal
+     */
+    TraceSpan(const char* name)
+        : name_(name) {
+        if (TRACE_ENABLED()) {
+            start();
+        }
+    }
+
+    /**
+     * @brief Start a span with a detail formatted from the arguments, such as
+     * the name of the array or column.
+     *
+     * @param name Name of the span, a string literal
+     * @param format Format string of the detail
+     * @param args Arguments of the detail
+     */
+    template <typename... Args>
+    TraceSpan(
+        const char* name, fmt::format_string<Args...> format, Args&&... args)
+        : name_(name) {
+        if (TRACE_ENABLED()) {
+            detail_ = fmt::format(format, std::forward<Args>(args)...);
+            start();
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    ~TraceSpan() {
+        if (start_us_ >= 0) {
+            end();
+        }
+    }
+
+   private:
+    // Record the start time
+    void start();
+
+    // Write the span to the trace file
+    void end();
+
+    // Name of the span
+    const char* name_;
+
+    // Detail of the span, empty if none
+    std::string detail_;
+
+    // Start time in microseconds, or -1 if the span is not recorded
+    int64_t start_us_ = -1;
+};
+
 /** Convert TileDB timestamp (in ms) to human readable timestamp. */
 std::string asc_timestamp(uint64_t timestamp_ms);
 
@@ -34,20 +34,114 @@
 #define MANAGED_QUERY_H
 
 #include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <tiledb/tiledb>
+#if TILEDB_VERSION_MAJOR > 2 || \
+    (TILEDB_VERSION_MAJOR == 2 && TILEDB_VERSION_MINOR >= 15)
+#include <tiledb/tiledb_experimental>
+#endif
 
+#include "thread_pool/thread_pool.h"
 #include "tiledbsoma/array_buffers.h"
 #include "tiledbsoma/column_buffer.h"
 #include "tiledbsoma/common.h"
+#include "tiledbsoma/memory_governor.h"
+#include "tiledbsoma/query_metrics.h"
 
 namespace tiledbsoma {
 
 using namespace tiledb;
 
 class ManagedQuery {
+    // Maximum number of times the buffers are grown and the query is
+    // resubmitted when the buffers cannot hold a single cell
+    inline static const int MAX_BUFFER_GROWTH_RETRIES = 8;
+
+    // Average size (bytes) of a variable length cell, used when the size
+    // cannot be estimated from the fragment metadata
+    inline static const size_t DEFAULT_VAR_CELL_BYTES = 16;
+
    public:
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    // Config key for the total number of bytes allocated for the buffers of
+    // each submit. If set, the budget is split across the columns to
+    // maximize the number of cells read by each submit.
+    inline static const std::string
+        CONFIG_KEY_BUDGET_BYTES = "soma.read_budget_bytes";
+
+    // Config key to enable coalescing integral points into ranges in
+    // `select_points` (default: "false"). Coalescing sorts and deduplicates
+    // the points, so a point selected more than once is read once, which
+    // callers that rely on the multiplicity of the points must not enable.
+    inline static const std::string
+        CONFIG_KEY_COALESCE_POINTS = "soma.coalesce_points";
+
+    // Config key to enable or disable sizing the buffers of fixed size
+    // columns of dense arrays to hold the exact number of cells in the
+    // subarray, so the query completes in a single submit (default: "true")
+    inline static const std::string
+        CONFIG_KEY_DENSE_EXACT = "soma.read_dense_exact";
+
+    // Config key to export variable length columns as regular Arrow string
+    // and binary arrays, with 32-bit offsets, instead of large arrays
+    // (default: "false"). The data buffers of these columns are capped at
+    // `ColumnBuffer::MAX_SMALL_OFFSETS_BYTES`, so every batch fits.
+    inline static const std::string
+        CONFIG_KEY_SMALL_OFFSETS = "soma.arrow_small_offsets";
+
+    /**
+     * @brief Coalesce integral points into inclusive ranges. The points are
+     * sorted and deduplicated, then runs of consecutive points are merged
+     * into one range. The ranges select exactly the given points.
+     *
+     * @tparam T Integral dimension type
+     * @param points Dimension points, in any order
+     * @return std::vector<std::pair<T, T>> Sorted, disjoint ranges
+     */
+    template <typename T>
+    static std::vector<std::pair<T, T>> coalesce_points(
+        tcb::span<const T> points) {
+        static_assert(std::is_integral_v<T>);
+        std::vector<std::pair<T, T>> ranges;
+        if (points.empty()) {
+            return ranges;
+        }
+
+        // Copy and sort the points, unless they are already sorted
+        std::vector<T> sorted;
+        if (!std::is_sorted(points.begin(), points.end())) {
+            sorted.assign(points.begin(), points.end());
+            std::sort(sorted.begin(), sorted.end());
+            points = sorted;
+        }
+
+        ranges.emplace_back(points[0], points[0]);
+        for (size_t i = 1; i < points.size(); i++) {
+            auto& range = ranges.back();
+            // Distance between the points, computed without overflow
+            uint64_t distance = static_cast<uint64_t>(points[i]) -
+                                static_cast<uint64_t>(range.second);
+            if (distance == 0) {
+                continue;
+            }
+            if (distance == 1) {
+                range.second = points[i];
+            } else {
+                ranges.emplace_back(points[i], points[i]);
+            }
+        }
+        return ranges;
+    }
+
     //===================================================================
     //= public non-static
     //===================================================================
@@ -63,16 +157,29 @@ class ManagedQuery {
 
     ManagedQuery() = delete;
     ManagedQuery(const ManagedQuery&) = delete;
-    ManagedQuery(ManagedQuery&&) = default;
+    // Not movable: the in-flight query task holds a pointer to this object
+    ManagedQuery(ManagedQuery&&) = delete;
+    ManagedQuery& operator=(const ManagedQuery&) = delete;
+    ManagedQuery& operator=(ManagedQuery&&) = delete;
     ~ManagedQuery() = default;
 
     /**
      * @brief Reset the state of this ManagedQuery object to prepare for a new
-     * query, while holding the array open.
+     * query, while holding the array open. An in-flight query is completed
+     * and its results are discarded.
      *
      */
     void reset();
 
+    /**
+     * @brief Replace the array being queried, for example with the array
+     * reopened at another timestamp, and reset the query. The config and the
+     * pooled buffers are kept. An in-flight query is completed first.
+     *
+     * @param array TileDB array
+     */
+    void set_array(std::shared_ptr<Array> array);
+
     /**
      * @brief Select columns names to query (dim and attr). If the
      * `if_not_empty` parameter is `true`, the column will be selected iff the
@@ -96,9 +203,20 @@ class ManagedQuery {
     void select_ranges(
         const std::string& dim, const std::vector<std::pair<T, T>>& ranges) {
         subarray_range_set_ = true;
-        for (auto& [start, stop] : ranges) {
-            subarray_->add_range(dim, start, stop);
-            subarray_range_empty_ = false;
+        if constexpr (std::is_arithmetic_v<T>) {
+            if (!ranges.empty()) {
+                add_ranges(
+                    dim,
+                    &ranges[0].first,
+                    &ranges[0].second,
+                    ranges.size(),
+                    sizeof(ranges[0]));
+            }
+        } else {
+            for (auto& [start, stop] : ranges) {
+                subarray_->add_range(dim, start, stop);
+                subarray_range_empty_ = false;
+            }
         }
     }
 
@@ -111,11 +229,7 @@ class ManagedQuery {
      */
     template <typename T>
     void select_points(const std::string& dim, const std::vector<T>& points) {
-        subarray_range_set_ = true;
-        for (auto& point : points) {
-            subarray_->add_range(dim, point, point);
-            subarray_range_empty_ = false;
-        }
+        select_points(dim, tcb::span<const T>(points));
     }
 
     /**
@@ -128,12 +242,42 @@ class ManagedQuery {
     template <typename T>
     void select_points(const std::string& dim, const tcb::span<T> points) {
         subarray_range_set_ = true;
-        for (auto& point : points) {
-            subarray_->add_range(dim, point, point);
-            subarray_range_empty_ = false;
+        if constexpr (std::is_integral_v<T>) {
+            if (coalesce_points_) {
+                auto ranges = coalesce_points(
+                    tcb::span<const T>(points.data(), points.size()));
+                LOG_DEBUG(
+                    "[ManagedQuery] [{}] select_points: dim={} coalesced {} "
+                    "points into {} ranges",
+                    name_,
+                    dim,
+                    points.size(),
+                    ranges.size());
+                select_ranges(dim, ranges);
+                return;
+            }
+        }
+        if constexpr (std::is_arithmetic_v<T>) {
+            add_ranges<std::remove_const_t<T>>(
+                dim, points.data(), nullptr, points.size(), sizeof(T));
+        } else {
+            for (auto& point : points) {
+                subarray_->add_range(dim, point, point);
+                subarray_range_empty_ = false;
+            }
         }
     }
 
+    /**
+     * @brief Select string dimension points to query. The points are added
+     * to the subarray without copying them to std::string.
+     *
+     * @param dim Dimension name
+     * @param points Span of dimension points
+     */
+    void select_points(
+        const std::string& dim, tcb::span<const std::string_view> points);
+
     /**
      * @brief Select dimension point to query.
      *
@@ -157,6 +301,16 @@ class ManagedQuery {
         query_->set_condition(qc);
     }
 
+    /**
+     * @brief Select variable length columns to export as Arrow dictionary
+     * arrays, with int32 indices into the distinct values of each batch.
+     * This suits low cardinality string columns, whose values are hashed
+     * and copied once per batch instead of once per cell.
+     *
+     * @param names Vector of column names
+     */
+    void set_dictionary_columns(const std::vector<std::string>& names);
+
     /**
      * @brief Set query result order (layout).
      *
@@ -167,21 +321,64 @@ class ManagedQuery {
     }
 
     /**
-     * @brief Submit the query.
+     * @brief Submit the query. The query runs in the background and this call
+     * returns without waiting for the query to complete. Call `results` to
+     * wait for the query and access the results.
      *
      */
     void submit();
 
     /**
-     * @brief Check if the query is complete.
+     * @brief Read a fixed size, non-nullable column of a dense array into a
+     * caller-provided buffer, with a single submit and no ColumnBuffer. The
+     * buffer must hold all cells of the subarray, which is the product of
+     * the number of values selected on each dimension.
+     *
+     * This call replaces `submit` and `results` for the first and only read
+     * of the query.
+     *
+     * @param name Column name
+     * @param data Buffer
+     * @param num_bytes Size of the buffer (bytes)
+     * @return uint64_t Number of cells read
+     */
+    uint64_t read_into(const std::string& name, void* data, uint64_t num_bytes);
+
+    /**
+     * @brief Return the number of cells in the subarray of a dense array with
+     * integral dimensions, which is the number of cells read by the query.
+     * Call after selecting the ranges, since the default range of a dense
+     * query is added if no ranges were selected.
+     *
+     * @return std::optional<uint64_t> Number of cells, or std::nullopt if the
+     * array is sparse or the number of cells cannot be computed
+     */
+    std::optional<uint64_t> dense_num_cells();
+
+    /**
+     * @brief Check if the query is complete. If the query is in flight, wait
+     * for the query to complete before checking the status.
      *
      * @return true Query status is COMPLETE
      */
     bool is_complete() {
+        if (query_future_.valid()) {
+            query_future_.wait();
+        }
         return query_->query_status() == Query::Status::COMPLETE ||
                is_empty_query();
     }
 
+    /**
+     * @brief Return true if the query has been submitted and the results have
+     * not been read.
+     *
+     * @return true The query is submitted
+     */
+    bool is_submitted() const {
+        return query_submitted_;
+    }
+
     /**
      * @brief Return true if the query result buffers hold all results from the
      * query. The return value is false if the query was incomplete.
@@ -251,7 +448,8 @@ class ManagedQuery {
     }
 
     /**
-     * @brief Return results from the query.
+     * @brief Wait for the submitted query to complete and return results from
+     * the query.
      *
      * @return std::shared_ptr<ArrayBuffers>
      */
@@ -266,6 +464,26 @@ class ManagedQuery {
         return schema_;
     }
 
+    /**
+     * @brief Return the selected columns, or an empty vector if all columns
+     * are selected.
+     *
+     * @return const std::vector<std::string>& Column names
+     */
+    const std::vector<std::string>& column_names() const {
+        return columns_;
+    }
+
+    /**
+     * @brief Return true if a range or point was selected, or the default
+     * range of a dense array was added by `submit`.
+     *
+     * @return true if the subarray has a range
+     */
+    bool has_ranges() const {
+        return subarray_range_set_;
+    }
+
     /**
      * @brief Return true if the only ranges selected were empty.
      *
@@ -275,11 +493,164 @@ class ManagedQuery {
         return subarray_range_set_ && subarray_range_empty_;
     }
 
+    /**
+     * @brief Return the latency and throughput metrics of the query. The
+     * metrics are cumulative across `reset`, so they describe all reads by
+     * this ManagedQuery.
+     *
+     * @return QueryMetrics Metrics
+     */
+    QueryMetrics metrics() const {
+        std::lock_guard<std::mutex> lock(metrics_mtx_);
+        return metrics_;
+    }
+
    private:
+    //===================================================================
+    //= private static
+    //===================================================================
+
+    /**
+     * @brief Return the process-wide pool of threads running the TileDB
+     * submits of all queries, so a submit does not start a new thread. The
+     * submit tasks do not wait on other tasks, so callers may wait for them
+     * from the threads of another pool, such as the SOMAReader partitions.
+     *
+     * @return ThreadPool&
+     */
+    static ThreadPool& submit_pool();
+
     //===================================================================
     //= private non-static
     //===================================================================
 
+    /**
+     * @brief If the array is dense and no ranges have been set, add a range
+     * for the array's entire non-empty domain on dimension 0. A dense array
+     * must have a subarray set.
+     */
+    void set_dense_default_range();
+
+    /**
+     * @brief Return the number of bytes of a fixed size column cell.
+     *
+     * @param name Column name
+     * @return std::optional<size_t> Cell size, or std::nullopt for variable
+     * length columns
+     */
+    std::optional<size_t> fixed_cell_bytes(const std::string& name);
+
+    /**
+     * @brief Split the buffer budget across the selected columns. Each column
+     * is sized to hold the same number of cells, using the type size, the
+     * offsets for variable length columns, the validity for nullable columns
+     * and the average variable length cell size estimated from the fragment
+     * metadata.
+     *
+     * @param budget_bytes Total number of bytes for all buffers
+     */
+    void plan_buffers(size_t budget_bytes);
+
+    /**
+     * @brief Update the size of each ColumnBuffer to match the query results.
+     *
+     * @return size_t Number of cells read by the last submit
+     */
+    size_t update_buffer_sizes();
+
+    /**
+     * @brief Double the size of the ColumnBuffers that may not hold a single
+     * cell and attach them to the query. Fixed length columns hold many cells
+     * for the same number of bytes, so only variable length columns are grown
+     * unless the query has no variable length columns. The new sizes are
+     * saved and used when buffers are allocated for the next submit. Columns
+     * exported with 32-bit offsets do not grow past
+     * `ColumnBuffer::MAX_SMALL_OFFSETS_BYTES`.
+     */
+    void grow_buffers();
+
+    /**
+     * @brief Resize the memory reservation of the buffers, if any, to the
+     * number of bytes allocated for them.
+     *
+     * @param wait If false, over-commit the budget without waiting
+     */
+    void update_reservation(bool wait = true);
+
+    /**
+     * @brief Add the latency of the last submit and the number of cells, the
+     * data bytes and the buffer capacity of each column to the metrics.
+     *
+     * @param num_cells Number of cells read by the last submit
+     * @param seconds Time from submit to the completion of the results
+     */
+    void record_metrics(size_t num_cells, double seconds);
+
+    /**
+     * @brief Return the index and datatype of a dimension.
+     *
+     * @param dim Dimension name
+     * @return std::pair<uint32_t, tiledb_datatype_t> Index and datatype
+     */
+    std::pair<uint32_t, tiledb_datatype_t> dimension_info(
+        const std::string& dim);
+
+    /**
+     * @brief Add ranges of a fixed-size dimension to the subarray. Unlike
+     * `Subarray::add_range`, which looks up and type checks the dimension by
+     * name for every range, the dimension is resolved once and the ranges
+     * are added with the C API. Points are added with a single call to the
+     * bulk point ranges API of TileDB 2.15 and later. With older versions,
+     * including the TileDB 2.14 this library builds against, every point is
+     * added as a range.
+     *
+     * @tparam T Dimension type
+     * @param dim Dimension name
+     * @param starts Start of the first range
+     * @param ends End of the first range, or nullptr to add points
+     * @param count Number of ranges
+     * @param stride Number of bytes between consecutive starts and ends
+     */
+    template <typename T>
+    void add_ranges(
+        const std::string& dim,
+        const T* starts,
+        const T* ends,
+        size_t count,
+        size_t stride) {
+        if (count == 0) {
+            return;
+        }
+        auto [index, type] = dimension_info(dim);
+        impl::type_check<T>(type);
+
+        auto& ctx = schema_->context();
+        subarray_range_empty_ = false;
+#if TILEDB_VERSION_MAJOR > 2 || \
+    (TILEDB_VERSION_MAJOR == 2 && TILEDB_VERSION_MINOR >= 15)
+        if (ends == nullptr && stride == sizeof(T)) {
+            ctx.handle_error(tiledb_subarray_add_point_ranges(
+                ctx.ptr().get(),
+                subarray_->ptr().get(),
+                index,
+                starts,
+                count));
+            return;
+        }
+#endif
+        auto start = reinterpret_cast<const std::byte*>(starts);
+        auto end = ends ? reinterpret_cast<const std::byte*>(ends) : start;
+        for (size_t i = 0; i < count; i++) {
+            ctx.handle_error(tiledb_subarray_add_range(
+                ctx.ptr().get(),
+                subarray_->ptr().get(),
+                index,
+                start + i * stride,
+                end + i * stride,
+                nullptr));
+        }
+    }
+
     /**
      * @brief Check if column name is contained in the query results.
      *
@@ -318,6 +689,9 @@ class ManagedQuery {
     // Set of column names to read (dim and attr). If empty, query all columns.
     std::vector<std::string> columns_;
 
+    // Set of column names exported as Arrow dictionary arrays
+    std::unordered_set<std::string> dictionary_columns_;
+
     // Results in the buffers are complete (the query was never incomplete)
     bool results_complete_ = true;
 
@@ -327,8 +701,58 @@ class ManagedQuery {
     // A collection of ColumnBuffers attached to the query
     std::shared_ptr<ArrayBuffers> buffers_;
 
+    // Total bytes allocated for the buffers of each submit, if set by the
+    // config
+    std::optional<size_t> budget_bytes_;
+
+    // Map: column name -> (num_cells, num_bytes) planned for the column by
+    // splitting the budget
+    std::unordered_map<std::string, std::pair<size_t, size_t>> buffer_plan_;
+
+    // Budget (bytes) the buffer plan was computed for
+    size_t planned_bytes_ = 0;
+
+    // Bytes allocated for the data of each column when neither the budget
+    // nor the memory governor sizes the buffers
+    size_t init_bytes_ = 0;
+
+    // Memory reserved from the memory governor for the current buffers,
+    // shared with the ColumnBuffers
+    std::shared_ptr<MemoryGovernor::Reservation> reservation_;
+
+    // Coalesce integral points into ranges in `select_points`
+    bool coalesce_points_ = false;
+
+    // Size the buffers of dense arrays to hold all cells in the subarray
+    bool dense_exact_ = true;
+
+    // Export variable length columns with 32-bit Arrow offsets
+    bool small_offsets_ = false;
+
+    // Pool of buffers reused by the ColumnBuffers of each submit, shared by
+    // the queries of the Context
+    std::shared_ptr<BufferPool> pool_;
+
+    // Map: column name -> data buffer size (bytes) learned by growing the
+    // buffers of a previous submit
+    std::unordered_map<std::string, size_t> column_bytes_;
+
     // True if the query has been submitted and the results have not been read
     bool query_submitted_ = false;
+
+    // Latency and throughput metrics, cumulative across resets
+    QueryMetrics metrics_;
+
+    // Mutex protecting the metrics, which may be read by another thread
+    mutable std::mutex metrics_mtx_;
+
+    // Seconds spent in TileDB submits for the current results, written by the
+    // submit task and read after the task's future is joined
+    double submit_seconds_ = 0;
+
+    // Completion of the in-flight query, declared last so that an in-flight
+    // query completes before the other members are destroyed
+    ThreadPool::Task query_future_;
 };
 
 };  // namespace tiledbsoma
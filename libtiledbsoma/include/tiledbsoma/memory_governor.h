@@ -0,0 +1,294 @@
+/**
+ * @file   memory_governor.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the process-wide memory governor.
+ */
+
+#ifndef MEMORY_GOVERNOR_H
+#define MEMORY_GOVERNOR_H
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#include <tiledb/tiledb>
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+/**
+ * @brief A process-wide, thread-safe budget for the buffers of all readers.
+ *
+ * Each ManagedQuery submit reserves the bytes of its ColumnBuffers before
+ * allocating them. The reservation is shared by the ColumnBuffers of the
+ * batch and returned to the budget when the last of them is deleted, which
+ * includes the buffers of prefetched batches and of batches exported to
+ * Arrow. When the budget is exhausted, a submit first shrinks its buffers,
+ * so it reads fewer cells per batch, then waits for other readers to release
+ * memory.
+ *
+ * The reservation covers the data, offsets and validity of the buffers.
+ * A submit waiting longer than the "soma.mem.wait_ms" config parameter
+ * over-commits the budget with its smallest reservation and logs a warning,
+ * rather than deadlocking when the batches holding the budget are not
+ * released while it waits. A submit whose previous batch is still held by
+ * the caller, as when prefetching, over-commits without waiting, both when
+ * reserving and when sizing its buffers to the reservation. Buffers
+ * grown to hold a large cell wait for the budget, and fail if it cannot hold
+ * them within the maximum wait. Blocks retained by buffer pools are bounded
+ * separately, by the "soma.buffer_pool_bytes" config parameter and
+ * BufferPool::set_total_max_bytes.
+ *
+ * The governor is process-wide, so it is configured once by the application
+ * with `configure` or `set_budget`, not by the configs of the readers. It is
+ * disabled until the budget is set to a non-zero number of bytes.
+ */
+class MemoryGovernor {
+   public:
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    // Config key for the total number of bytes of the buffers of all readers.
+    // A value of 0 disables the governor.
+    inline static const std::string
+        CONFIG_KEY_TOTAL_BUDGET = "soma.mem.total_budget";
+
+    // Config key for the maximum time (milliseconds) a submit waits for
+    // memory before over-committing the budget
+    inline static const std::string CONFIG_KEY_WAIT_MS = "soma.mem.wait_ms";
+
+    // Default maximum wait (milliseconds)
+    inline static const uint64_t DEFAULT_WAIT_MS = 10000;
+
+    // Smallest reservation of a submit when the budget is exhausted
+    inline static const size_t MIN_RESERVATION_BYTES = 1 << 20;  // 1 MiB
+
+    /**
+     * @brief Bytes reserved from a MemoryGovernor, returned to the governor
+     * when the reservation is deleted.
+     */
+    class Reservation {
+       public:
+        /**
+         * @brief Construct a new Reservation object for bytes already added
+         * to the reserved bytes of the governor.
+         *
+         * @param governor MemoryGovernor
+         * @param num_bytes Number of reserved bytes
+         */
+        Reservation(MemoryGovernor& governor, size_t num_bytes)
+            : governor_(governor)
+            , num_bytes_(num_bytes) {
+        }
+
+        Reservation(const Reservation&) = delete;
+        Reservation(Reservation&&) = delete;
+
+        ~Reservation() {
+            governor_.release(num_bytes_);
+        }
+
+        /**
+         * @brief Return the number of reserved bytes.
+         *
+         * @return size_t
+         */
+        size_t bytes() const {
+            return num_bytes_;
+        }
+
+        /**
+         * @brief Change the number of reserved bytes, to account for the
+         * bytes actually allocated. Growing the reservation waits for the
+         * budget to hold the additional bytes, and throws if it cannot hold
+         * them within the maximum wait.
+         *
+         * @param num_bytes Number of reserved bytes
+         * @param wait If false, over-commit the budget without waiting, as
+         *   in `MemoryGovernor::reserve`
+         */
+        void resize(size_t num_bytes, bool wait = true);
+
+       private:
+        // Governor the bytes are reserved from
+        MemoryGovernor& governor_;
+
+        // Number of reserved bytes
+        size_t num_bytes_;
+    };
+
+    /**
+     * @brief Statistics of the governor.
+     */
+    struct Stats {
+        // Total budget in bytes, 0 if the governor is disabled
+        size_t budget = 0;
+
+        // Number of bytes currently reserved
+        size_t reserved_bytes = 0;
+
+        // Largest number of bytes reserved at once
+        size_t peak_bytes = 0;
+
+        // Number of reservations granted fewer bytes than requested
+        size_t num_shrinks = 0;
+
+        // Number of reservations that waited for memory
+        size_t num_waits = 0;
+
+        // Number of reservations that over-committed the budget
+        size_t num_overcommits = 0;
+    };
+
+    /**
+     * @brief Return the process-wide governor.
+     *
+     * @return MemoryGovernor&
+     */
+    static MemoryGovernor& instance();
+
+    //===================================================================
+    //= public non-static
+    //===================================================================
+
+    /**
+     * @brief Construct a new MemoryGovernor object.
+     *
+     * @param budget Total budget in bytes, 0 to disable the governor
+     * @param wait_ms Maximum wait (milliseconds) for memory
+     */
+    MemoryGovernor(size_t budget = 0, uint64_t wait_ms = DEFAULT_WAIT_MS)
+        : budget_(budget)
+        , wait_ms_(wait_ms) {
+    }
+
+    MemoryGovernor(const MemoryGovernor&) = delete;
+    MemoryGovernor(MemoryGovernor&&) = delete;
+
+    /**
+     * @brief Set the budget and the maximum wait from the
+     * "soma.mem.total_budget" and "soma.mem.wait_ms" config parameters, if
+     * present. A config without the parameters leaves the governor unchanged.
+     *
+     * @param config TileDB config
+     */
+    void configure(const Config& config);
+
+    /**
+     * @brief Set the total budget. Reservations above the new budget are
+     * not revoked, but new reservations wait until the reserved bytes fall
+     * below the budget.
+     *
+     * @param budget Total budget in bytes, 0 to disable the governor
+     */
+    void set_budget(size_t budget);
+
+    /**
+     * @brief Set the maximum wait for memory.
+     *
+     * @param wait_ms Maximum wait (milliseconds)
+     */
+    void set_wait_ms(uint64_t wait_ms);
+
+    /**
+     * @brief Return true if the governor has a budget.
+     */
+    bool enabled() const;
+
+    /**
+     * @brief Reserve up to `num_bytes`. If the budget cannot hold
+     * `num_bytes`, the remaining budget is reserved, if it holds at least
+     * `min_bytes`. Otherwise, wait until other reservations are released
+     * or the maximum wait elapses, then over-commit the budget with
+     * `min_bytes`.
+     *
+     * A disabled governor reserves `num_bytes` without waiting.
+     *
+     * @param num_bytes Number of bytes requested
+     * @param min_bytes Smallest number of bytes accepted, at most `num_bytes`
+     * @param wait If false, over-commit the budget with `min_bytes` without
+     *   waiting, for a caller that itself holds reservations which would not
+     *   be released while it waits
+     * @return std::shared_ptr<Reservation> Reservation
+     */
+    std::shared_ptr<Reservation> reserve(
+        size_t num_bytes, size_t min_bytes, bool wait = true);
+
+    /**
+     * @brief Return the statistics of the governor.
+     *
+     * @return Stats
+     */
+    Stats stats() const;
+
+   private:
+    //===================================================================
+    //= private non-static
+    //===================================================================
+
+    /**
+     * @brief Add bytes to the reserved bytes, waiting until the budget holds
+     * them, or over-committing the budget if `wait` is false.
+     *
+     * @param num_bytes Number of bytes
+     * @param wait If false, over-commit the budget without waiting
+     * @throws TileDBSOMAError if the budget does not hold the bytes within
+     *   the maximum wait
+     */
+    void add(size_t num_bytes, bool wait);
+
+    /**
+     * @brief Return bytes to the budget and wake the waiting reservations.
+     *
+     * @param num_bytes Number of bytes
+     */
+    void release(size_t num_bytes);
+
+    // Total budget in bytes, 0 if the governor is disabled
+    size_t budget_;
+
+    // Maximum wait (milliseconds) for memory
+    uint64_t wait_ms_;
+
+    // Statistics, including the number of reserved bytes
+    Stats stats_;
+
+    // Mutex protecting the budget and the statistics
+    mutable std::mutex mtx_;
+
+    // Signaled when bytes are released or the budget changes
+    std::condition_variable cv_;
+};
+
+}  // namespace tiledbsoma
+#endif
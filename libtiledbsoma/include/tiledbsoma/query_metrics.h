@@ -0,0 +1,122 @@
+/**
+ * @file   query_metrics.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the query metrics API
+ */
+
+#ifndef QUERY_METRICS_H
+#define QUERY_METRICS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace tiledbsoma {
+
+/**
+ * @brief Metrics of the buffers of one column, summed over all submits.
+ */
+struct ColumnMetrics {
+    // Number of cells read
+    uint64_t cells = 0;
+
+    // Number of data bytes read
+    uint64_t bytes = 0;
+
+    // Number of cells the data buffers could hold
+    uint64_t capacity_cells = 0;
+
+    // Number of bytes allocated for the data buffers
+    uint64_t capacity_bytes = 0;
+
+    /**
+     * @brief Return the fraction of the allocated data bytes holding results.
+     *
+     * @return double Buffer utilization, or 0 if no buffer was allocated
+     */
+    double utilization() const {
+        return capacity_bytes ? (double)bytes / capacity_bytes : 0;
+    }
+};
+
+/**
+ * @brief Latency and throughput metrics of a query, cumulative over the life
+ * of the query.
+ */
+struct QueryMetrics {
+    // Number of calls to `Query::submit`, including resubmits
+    uint64_t num_submits = 0;
+
+    // Number of submits returning an INCOMPLETE status
+    uint64_t num_incomplete = 0;
+
+    // Number of resubmits with larger buffers, when the buffers could not
+    // hold a single cell
+    uint64_t num_resubmits = 0;
+
+    // Number of submits with smaller buffers, because the memory governor
+    // could not reserve the requested bytes
+    uint64_t num_memory_shrinks = 0;
+
+    // Number of result batches returned
+    uint64_t num_batches = 0;
+
+    // Number of cells returned
+    uint64_t num_cells = 0;
+
+    // Time from submit to the completion of the results (seconds)
+    double submit_seconds = 0;
+
+    // Time spent exporting results to Arrow (seconds)
+    double arrow_export_seconds = 0;
+
+    // Time spent holding the Python GIL to convert results (seconds)
+    double gil_seconds = 0;
+
+    // Map: column name -> column metrics
+    std::map<std::string, ColumnMetrics> columns;
+
+    /**
+     * @brief Add the metrics of another query to these metrics.
+     *
+     * @param other Query metrics
+     */
+    void merge(const QueryMetrics& other);
+
+    /**
+     * @brief Return the metrics as a JSON object.
+     *
+     * @return std::string JSON
+     */
+    std::string to_json() const;
+};
+
+}  // namespace tiledbsoma
+
+#endif
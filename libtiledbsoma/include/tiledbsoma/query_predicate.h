@@ -0,0 +1,222 @@
+/**
+ * @file   query_predicate.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the query predicate API
+ */
+
+#ifndef QUERY_PREDICATE_H
+#define QUERY_PREDICATE_H
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <tiledb/tiledb>
+
+#include "tiledbsoma/common.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+/**
+ * @brief A value filter on the attributes of an array, built independently of
+ * an array and compiled to a TileDB QueryCondition against the schema and
+ * Context of the reader that applies it.
+ *
+ * Predicates are immutable and cheap to copy. Values are converted to the
+ * type of the attribute when the predicate is compiled, so the bindings can
+ * pass loosely typed values.
+ *
+ * An example use model:
+ *
+ *   auto predicate = QueryPredicate::compare("n_genes", TILEDB_GT, 1000)
+ *       .combine(QueryPredicate::is_in("louvain", {"B cells", "NK cells"}),
+ *                TILEDB_AND);
+ *   reader->set_predicate(predicate);
+ */
+class QueryPredicate {
+   public:
+    // A comparison value
+    using Value = std::variant<bool, int64_t, uint64_t, double, std::string>;
+
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    /**
+     * @brief Return a predicate comparing an attribute to a value.
+     *
+     * @param name Attribute name
+     * @param op Comparison operator
+     * @param value Value
+     * @return QueryPredicate Predicate
+     */
+    static QueryPredicate compare(
+        const std::string& name, tiledb_query_condition_op_t op, Value value);
+
+    /**
+     * @brief Return a predicate selecting the cells where the attribute
+     * equals one of the values. An empty set selects no cells.
+     *
+     * @param name Attribute name
+     * @param values Values
+     * @return QueryPredicate Predicate
+     */
+    static QueryPredicate is_in(
+        const std::string& name, std::vector<Value> values);
+
+    /**
+     * @brief Return a predicate selecting the null (or non-null) cells of a
+     * nullable attribute.
+     *
+     * @param name Attribute name
+     * @param is_null If false, select the non-null cells
+     * @return QueryPredicate Predicate
+     */
+    static QueryPredicate is_null(const std::string& name, bool is_null = true);
+
+    /**
+     * @brief Parse a comparison operator: "==", "!=", "<", "<=", ">" or ">=".
+     *
+     * @param op Operator
+     * @return tiledb_query_condition_op_t TileDB operator
+     */
+    static tiledb_query_condition_op_t to_op(std::string_view op);
+
+    /**
+     * @brief Parse a combination operator: "and" or "or", in any case.
+     *
+     * @param op Operator
+     * @return tiledb_query_condition_combination_op_t TileDB operator
+     */
+    static tiledb_query_condition_combination_op_t to_combination_op(
+        std::string_view op);
+
+    //===================================================================
+    //= public non-static
+    //===================================================================
+
+    /**
+     * @brief Return the combination of this predicate and another predicate.
+     *
+     * @param rhs Predicate
+     * @param op TILEDB_AND or TILEDB_OR
+     * @return QueryPredicate Predicate
+     */
+    QueryPredicate combine(
+        const QueryPredicate& rhs,
+        tiledb_query_condition_combination_op_t op) const;
+
+    /**
+     * @brief Return the negation of this predicate.
+     *
+     * @return QueryPredicate Predicate
+     */
+    QueryPredicate negate() const;
+
+    /**
+     * @brief Compile the predicate to a QueryCondition. Throws if a column is
+     * not an attribute of the schema or a value cannot be converted to the
+     * type of its attribute.
+     *
+     * @param ctx TileDB context of the query
+     * @param schema Schema of the queried array
+     * @return QueryCondition Query condition
+     */
+    QueryCondition to_condition(
+        const Context& ctx, const ArraySchema& schema) const;
+
+    /**
+     * @brief Return a readable representation of the predicate, such as
+     * `(n_genes > 1000 AND louvain IN ('B cells', 'NK cells'))`.
+     *
+     * @return std::string Representation
+     */
+    std::string to_string() const;
+
+   private:
+    // Kind of a predicate node
+    enum class Kind { COMPARE, IN, NULL_CHECK, COMBINE, NEGATE };
+
+    // A node of the predicate tree
+    struct Node {
+        Kind kind;
+
+        // Attribute name, for COMPARE, IN and NULL_CHECK nodes
+        std::string name;
+
+        // Comparison operator, for COMPARE nodes, or TILEDB_EQ / TILEDB_NE
+        // for NULL_CHECK nodes
+        tiledb_query_condition_op_t op = TILEDB_EQ;
+
+        // Combination operator, for COMBINE nodes
+        tiledb_query_condition_combination_op_t combination_op = TILEDB_AND;
+
+        // Values, one for COMPARE nodes
+        std::vector<Value> values;
+
+        // Operands, for COMBINE and NEGATE nodes
+        std::vector<std::shared_ptr<const Node>> children;
+    };
+
+    QueryPredicate(std::shared_ptr<const Node> node)
+        : node_(node) {
+    }
+
+    /**
+     * @brief Compile a comparison of an attribute to a value.
+     */
+    static QueryCondition compare_condition(
+        const Context& ctx,
+        const Attribute& attr,
+        tiledb_query_condition_op_t op,
+        const Value& value);
+
+    /**
+     * @brief Compile a node of the predicate tree.
+     */
+    static QueryCondition to_condition(
+        const Node& node, const Context& ctx, const ArraySchema& schema);
+
+    /**
+     * @brief Return the representation of a node of the predicate tree.
+     */
+    static std::string to_string(const Node& node);
+
+    // Root of the predicate tree
+    std::shared_ptr<const Node> node_;
+};
+
+}  // namespace tiledbsoma
+
+#endif
@@ -0,0 +1,258 @@
+/**
+ * @file   result_cache.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the cache of read results API
+ */
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+#include <tiledb/tiledb>
+
+#include "tiledbsoma/array_buffers.h"
+#include "tiledbsoma/array_cache.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+/**
+ * @brief A process-wide, thread-safe cache of the results of reads, holding
+ * the ArrayBuffers of each batch so repeated reads of the same dataframe,
+ * such as the obs and var dataframes of an experiment, are served from
+ * memory without reading or decoding the array again.
+ *
+ * Results are keyed by the Context, the array URI, the timestamp range the
+ * array was opened at and the fingerprint of its fragments (see StatsCache)
+ * and a description of the read, such as the selected columns, result order
+ * and value filter. A write after an array was opened is not visible in its
+ * results, and readers that open the array later, or at a pinned timestamp
+ * range a fragment was written in, have a different key, so stale results
+ * are not returned to them. Readers share results when they open the array
+ * at the same timestamp range, or share the array through the ArrayCache.
+ * Entries are evicted in least recently used order when the cached bytes
+ * exceed the capacity.
+ *
+ * Note: cached batches are shared with every reader of the key, so they must
+ * not be modified. SOMAReader uses the cache only if the "soma.cache_results"
+ * config parameter is "true", and only for reads without coordinate
+ * selections or query conditions other than a QueryPredicate. The capacity
+ * is process-wide, so it is set by the application with `set_capacity` or
+ * `configure`, not by the configs of the readers.
+ */
+class ResultCache {
+   public:
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    // Config key to cache read results ("true" or "false")
+    inline static const std::string
+        CONFIG_KEY_CACHE_RESULTS = "soma.cache_results";
+
+    // Config key to set the capacity of the cache in bytes, read by
+    // `configure`
+    inline static const std::string
+        CONFIG_KEY_CAPACITY_BYTES = "soma.result_cache_bytes";
+
+    // Default capacity in bytes
+    inline static const size_t DEFAULT_CAPACITY_BYTES = 1ULL << 30;
+
+    // Key: (Context, URI, open timestamp start, open timestamp end, fragment
+    // fingerprint, read description)
+    using Key = std::tuple<
+        const Context*,
+        std::string,
+        uint64_t,
+        uint64_t,
+        ArrayCache::Fingerprint,
+        std::string>;
+
+    // Batches of a read, in result order
+    using Batches = std::vector<std::shared_ptr<ArrayBuffers>>;
+
+    /**
+     * @brief Return the process-wide cache.
+     *
+     * @return ResultCache&
+     */
+    static ResultCache& instance();
+
+    /**
+     * @brief Return the cache key of a read of an open array.
+     *
+     * @param ctx TileDB context
+     * @param uri Array URI
+     * @param array Open array
+     * @param fingerprint Fingerprint of the fragments the array was opened at,
+     * see `ArrayCache::fingerprint`
+     * @param read Description of the read
+     * @return Key Cache key
+     */
+    static Key key(
+        const Context& ctx,
+        const std::string& uri,
+        const Array& array,
+        const ArrayCache::Fingerprint& fingerprint,
+        const std::string& read);
+
+    /**
+     * @brief Return the number of bytes allocated by the batches.
+     *
+     * @param batches Batches
+     * @return size_t
+     */
+    static size_t num_bytes(const Batches& batches);
+
+    //===================================================================
+    //= public non-static
+    //===================================================================
+
+    /**
+     * @brief Construct a new ResultCache object.
+     *
+     * @param capacity_bytes Maximum number of cached bytes
+     */
+    ResultCache(size_t capacity_bytes = DEFAULT_CAPACITY_BYTES);
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache(ResultCache&&) = delete;
+    ~ResultCache() = default;
+
+    /**
+     * @brief Set the capacity from the "soma.result_cache_bytes" config
+     * parameter, if present. The capacity applies to all readers in the
+     * process.
+     *
+     * @param config TileDB config
+     */
+    void configure(const Config& config);
+
+    /**
+     * @brief Return the batches for the key and mark them as most recently
+     * used.
+     *
+     * @param key Cache key
+     * @return std::optional<Batches> Batches, or std::nullopt if not cached
+     */
+    std::optional<Batches> get(const Key& key);
+
+    /**
+     * @brief Insert the batches for the key, replacing cached batches, and
+     * evict the least recently used entries beyond the capacity. Batches
+     * larger than the capacity are not cached.
+     *
+     * @param key Cache key
+     * @param ctx TileDB context of the key, held while the entry is cached
+     * @param batches Batches
+     * @return true if the batches were cached
+     */
+    bool insert(const Key& key, std::shared_ptr<Context> ctx, Batches batches);
+
+    /**
+     * @brief Set the maximum number of cached bytes.
+     *
+     * @param capacity_bytes Maximum number of cached bytes
+     */
+    void set_capacity(size_t capacity_bytes);
+
+    /**
+     * @brief Return the maximum number of cached bytes.
+     *
+     * @return size_t
+     */
+    size_t capacity();
+
+    /**
+     * @brief Remove all entries.
+     */
+    void clear();
+
+    /**
+     * @brief Return the number of entries.
+     *
+     * @return size_t
+     */
+    size_t size();
+
+    /**
+     * @brief Return the number of cached bytes.
+     *
+     * @return size_t
+     */
+    size_t bytes();
+
+   private:
+    //===================================================================
+    //= private non-static
+    //===================================================================
+
+    // A cached read
+    struct Entry {
+        // Context of the key, held so its address is not reused
+        std::shared_ptr<Context> ctx;
+
+        // Batches of the read
+        Batches batches;
+
+        // Bytes allocated by the batches
+        size_t num_bytes;
+    };
+
+    // Evict the least recently used entries beyond the capacity
+    void evict();
+
+    // Maximum number of cached bytes
+    size_t capacity_bytes_;
+
+    // Number of cached bytes
+    size_t num_bytes_ = 0;
+
+    // Entries, from most to least recently used
+    std::list<std::pair<Key, Entry>> entries_;
+
+    // Map: key -> entry
+    std::map<Key, std::list<std::pair<Key, Entry>>::iterator> index_;
+
+    // Mutex protecting the cache
+    std::mutex mtx_;
+};
+
+}  // namespace tiledbsoma
+#endif
@@ -35,16 +35,53 @@
 
 #include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
 
+#include <cstring>
+#include <functional>
 #include <future>
+#include <mutex>
+#include <set>
 
 #include <tiledb/tiledb>
 
+#include "thread_pool/producer_consumer_queue.h"
+#include "thread_pool/thread_pool.h"
 #include "tiledbsoma/managed_query.h"
+#include "tiledbsoma/query_predicate.h"
+#include "tiledbsoma/result_cache.h"
+#include "tiledbsoma/stats_cache.h"
 
 namespace tiledbsoma {
 using namespace tiledb;
 
+struct ArrowSchemaTemplate;
+
 class SOMAReader {
+    inline static const std::string CONFIG_KEY_PREFETCH = "soma.read_prefetch";
+
+    // Config key for the number of partitions read in parallel. The
+    // selection on the first dimension is split across the partitions.
+    inline static const std::string
+        CONFIG_KEY_PARTITIONS = "soma.read_partitions";
+
+    // Config key to return the partition results in partition order. By
+    // default, the results are returned as the partitions complete.
+    inline static const std::string
+        CONFIG_KEY_PARTITIONS_ORDERED = "soma.read_partitions_ordered";
+
+    // Config key for the largest number of cells sorted in memory by a read
+    // with the "sorted" result order. The selection on the first dimension
+    // is split into slabs of about this many cells: a slab read exceeding
+    // the limit before it completes is split in two, unless the slab has a
+    // single value of the first dimension.
+    inline static const std::string
+        CONFIG_KEY_SORT_MAX_CELLS = "soma.read_sort_max_cells";
+
+    inline static const uint64_t DEFAULT_SORT_MAX_CELLS = 1 << 22;
+
+    // Largest number of overlap regions counted by `nnz` with one query per
+    // region. With more regions, all cells of the array are counted.
+    inline static const size_t MAX_NNZ_REGIONS = 256;
+
    public:
     //===================================================================
     //= public static
@@ -90,6 +127,97 @@ class SOMAReader {
         std::string_view result_order = "auto",
         std::optional<std::pair<uint64_t, uint64_t>> timestamp = std::nullopt);
 
+    /**
+     * @brief Return one of `partition_count` contiguous partitions of the
+     * values. The last partition holds the remaining values.
+     *
+     * @tparam T Value type
+     * @param values Values to partition
+     * @param partition_index Partition index
+     * @param partition_count Partition count
+     * @return tcb::span<T> Values in the partition
+     */
+    template <typename T>
+    static tcb::span<T> partition_values(
+        tcb::span<T> values, int partition_index, int partition_count) {
+        auto partition_size = values.size() / partition_count;
+        auto start = partition_index * partition_size;
+
+        // If this is the last partition, cover the rest of the values.
+        if (partition_index == partition_count - 1) {
+            partition_size = values.size() - start;
+        }
+        return values.subspan(start, partition_size);
+    }
+
+    /**
+     * @brief Return one of `partition_count` partitions of the ranges. Ranges
+     * of an integral type are split so that each partition covers the same
+     * number of values. Other ranges are partitioned like
+     * `partition_values`.
+     *
+     * @tparam T Range type
+     * @param ranges Ranges to partition
+     * @param partition_index Partition index
+     * @param partition_count Partition count
+     * @return std::vector<std::pair<T, T>> Ranges in the partition
+     */
+    template <typename T>
+    static std::vector<std::pair<T, T>> partition_ranges(
+        const std::vector<std::pair<T, T>>& ranges,
+        int partition_index,
+        int partition_count) {
+        if constexpr (std::is_integral_v<T>) {
+            // Count the values covered by the ranges, with wrap-around
+            // arithmetic so the width of signed ranges is exact
+            auto width = [](const std::pair<T, T>& range) -> uint64_t {
+                return (uint64_t)range.second - (uint64_t)range.first + 1;
+            };
+            uint64_t total = 0;
+            bool valid = true;
+            for (auto& range : ranges) {
+                auto w = width(range);
+                if (range.second < range.first || w == 0 ||
+                    total + w < total) {
+                    valid = false;
+                    break;
+                }
+                total += w;
+            }
+
+            if (valid) {
+                // Partition boundaries, as offsets into the covered values
+                auto offset = [&](int index) -> uint64_t {
+                    return total / partition_count * index +
+                           std::min<uint64_t>(index, total % partition_count);
+                };
+                auto begin = offset(partition_index);
+                auto end = offset(partition_index + 1);
+
+                std::vector<std::pair<T, T>> result;
+                uint64_t pos = 0;
+                for (auto& range : ranges) {
+                    auto w = width(range);
+                    auto start = std::max(pos, begin);
+                    auto stop = std::min(pos + w, end);
+                    if (start < stop) {
+                        auto first = (uint64_t)range.first - pos;
+                        result.emplace_back(
+                            (T)(first + start), (T)(first + stop - 1));
+                    }
+                    pos += w;
+                }
+                return result;
+            }
+        }
+
+        auto partition = partition_values(
+            tcb::span<const std::pair<T, T>>(ranges),
+            partition_index,
+            partition_count);
+        return {partition.begin(), partition.end()};
+    }
+
     //===================================================================
     //= public non-static
     //===================================================================
@@ -111,13 +239,25 @@ class SOMAReader {
 
     SOMAReader() = delete;
     SOMAReader(const SOMAReader&) = delete;
-    SOMAReader(SOMAReader&&) = default;
-    ~SOMAReader() = default;
+    // Not movable: the partition tasks hold a pointer to this object
+    SOMAReader(SOMAReader&&) = delete;
+    SOMAReader& operator=(const SOMAReader&) = delete;
+    SOMAReader& operator=(SOMAReader&&) = delete;
+
+    ~SOMAReader() {
+        reset_partitions();
+    }
 
     /**
      * @brief Reset the state of this SOMAReader object to prepare for a new
      * query, while holding the array open.
      *
+     * The result order is "auto", "row-major", "column-major" or "sorted".
+     * A "sorted" read of a sparse array returns the cells sorted by their
+     * coordinates, from unordered reads of successive slabs of the first
+     * dimension, each sorted in memory. A "sorted" read of a dense array is
+     * a row-major read.
+     *
      * @param column_names
      * @param batch_size
      * @param result_order
@@ -127,6 +267,27 @@ class SOMAReader {
         std::string_view batch_size = "auto",
         std::string_view result_order = "auto");
 
+    /**
+     * @brief Reopen the array at another timestamp range and reset the state
+     * of this SOMAReader object to prepare for a new query. The Context, the
+     * config and the pooled buffers are reused, and the array is reopened in
+     * place unless it is shared through the ArrayCache.
+     *
+     * Statistics such as nnz are cached per timestamp range, so they are
+     * recomputed or looked up for the new timestamp range.
+     *
+     * @param timestamp Timestamp range (start, end), or std::nullopt to read
+     * the latest fragments
+     * @param column_names
+     * @param batch_size
+     * @param result_order
+     */
+    void reopen_at(
+        std::optional<std::pair<uint64_t, uint64_t>> timestamp,
+        std::vector<std::string> column_names = {},
+        std::string_view batch_size = "auto",
+        std::string_view result_order = "auto");
+
     /**
      * @brief Set the dimension slice using one point
      *
@@ -139,6 +300,9 @@ class SOMAReader {
     template <typename T>
     void set_dim_point(const std::string& dim, const T& point) {
         mq_->select_point(dim, point);
+        if (records_selections()) {
+            add_partition_points(dim, std::vector<T>{point});
+        }
     }
 
     /**
@@ -155,25 +319,14 @@ class SOMAReader {
         const tcb::span<T> points,
         int partition_index,
         int partition_count) {
-        // Validate partition inputs
-        if (partition_index >= partition_count) {
-            throw TileDBSOMAError(fmt::format(
-                "[SOMAReader] partition_index ({}) must be < partition_count "
-                "({})",
-                partition_index,
-                partition_count));
-        }
+        check_partition(partition_index, partition_count);
 
         if (partition_count > 1) {
-            auto partition_size = points.size() / partition_count;
-            auto start = partition_index * partition_size;
-
-            // If this is the last partition, cover the rest of the points.
-            if (partition_index == partition_count - 1) {
-                partition_size = points.size() - start;
-            }
+            auto partition = partition_values(
+                points, partition_index, partition_count);
+            auto start = partition.data() - points.data();
 
-            LOG_DEBUG(fmt::format(
+            LOG_DEBUG(
                 "[SOMAReader] set_dim_points partitioning: dim={} index={} "
                 "count={} "
                 "range=[{}, {}] of {} points",
@@ -181,16 +334,40 @@ class SOMAReader {
                 partition_index,
                 partition_count,
                 start,
-                start + partition_size - 1,
-                points.size()));
+                start + partition.size() - 1,
+                points.size());
 
-            mq_->select_points(
-                dim, tcb::span<T>{&points[start], partition_size});
+            mq_->select_points(dim, partition);
+            if (records_selections()) {
+                add_partition_points(
+                    dim, std::vector<T>(partition.begin(), partition.end()));
+            }
         } else {
             mq_->select_points(dim, points);
+            if (records_selections()) {
+                add_partition_points(
+                    dim, std::vector<T>(points.begin(), points.end()));
+            }
         }
     }
 
+    /**
+     * @brief Set the dimension slice using multiple string points, with
+     * support for partitioning. The points are sorted and duplicate points are
+     * removed before partitioning, so each partition selects a contiguous
+     * range of the sorted points. The points are not copied.
+     *
+     * @param dim Dimension name
+     * @param points String points, which are reordered
+     * @param partition_index Partition index
+     * @param partition_count Partition count
+     */
+    void set_dim_points(
+        const std::string& dim,
+        std::vector<std::string_view>& points,
+        int partition_index,
+        int partition_count);
+
     /**
      * @brief Set the dimension slice using multiple points
      *
@@ -203,6 +380,9 @@ class SOMAReader {
     template <typename T>
     void set_dim_points(const std::string& dim, const std::vector<T>& points) {
         mq_->select_points(dim, points);
+        if (records_selections()) {
+            add_partition_points(dim, points);
+        }
     }
 
     /**
@@ -218,17 +398,80 @@ class SOMAReader {
     void set_dim_ranges(
         const std::string& dim, const std::vector<std::pair<T, T>>& ranges) {
         mq_->select_ranges(dim, ranges);
+        if (records_selections()) {
+            add_partition_ranges(dim, ranges);
+        }
     }
 
     /**
-     * @brief Set a query condition.
+     * @brief Set dimension ranges from the starts and ends of the ranges,
+     * for example the columns of a numpy array, without materializing each
+     * range by the caller.
+     *
+     * @tparam T Dimension type
+     * @param dim Dimension name
+     * @param starts Start of each range
+     * @param ends Inclusive end of each range
+     */
+    template <typename T>
+    void set_dim_ranges(
+        const std::string& dim,
+        tcb::span<const T> starts,
+        tcb::span<const T> ends) {
+        if (starts.size() != ends.size()) {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] set_dim_ranges: {} starts and {} ends",
+                starts.size(),
+                ends.size()));
+        }
+        std::vector<std::pair<T, T>> ranges(starts.size());
+        for (size_t i = 0; i < ranges.size(); i++) {
+            ranges[i] = {starts[i], ends[i]};
+        }
+        set_dim_ranges(dim, ranges);
+    }
+
+    /**
+     * @brief Set a query condition. The attributes in the condition need not
+     * be selected: TileDB loads them to filter the cells and returns only the
+     * selected columns of the cells that pass the condition, so the
+     * predicate-only columns are neither buffered nor exported.
      *
      * @param qc Query condition
      */
     void set_condition(QueryCondition& qc) {
+        // The condition is opaque, so the results are not cached
+        cacheable_ = false;
         mq_->set_condition(qc);
+        add_selection([qc](ManagedQuery& mq, int, int) {
+            mq.set_condition(qc);
+        });
+    }
+
+    /**
+     * @brief Export variable length columns as Arrow dictionary arrays, with
+     * int32 indices into the distinct values of each batch, instead of one
+     * string per cell. This suits low cardinality string columns, such as
+     * cell types. Each batch has its own dictionary.
+     *
+     * @param names Vector of column names
+     */
+    void set_dictionary_columns(const std::vector<std::string>& names) {
+        mq_->set_dictionary_columns(names);
+        dictionary_columns_.insert(names.begin(), names.end());
+        add_selection([names](ManagedQuery& mq, int, int) {
+            mq.set_dictionary_columns(names);
+        });
     }
 
+    /**
+     * @brief Set a value filter, compiled to a query condition against the
+     * schema and Context of the reader. Replaces a previous condition.
+     *
+     * @param predicate Query predicate
+     */
+    void set_predicate(const QueryPredicate& predicate);
+
     /**
      * @brief Select columns names to query (dim and attr). If the
      * `if_not_empty` parameter is `true`, the column will be selected iff the
@@ -241,10 +484,19 @@ class SOMAReader {
     void select_columns(
         const std::vector<std::string>& names, bool if_not_empty = false) {
         mq_->select_columns(names, if_not_empty);
+        add_selection([names, if_not_empty](ManagedQuery& mq, int, int) {
+            mq.select_columns(names, if_not_empty);
+        });
     }
 
     /**
-     * @brief Submit the query
+     * @brief Submit the query.
+     *
+     * If the "soma.read_partitions" config parameter is greater than 1, the
+     * points or ranges selected on the first dimension are split across that
+     * many partitions, which are read in parallel on a thread pool. If the
+     * first dimension has no selection and is an int64 dimension, its
+     * non-empty domain is split across the partitions.
      *
      */
     void submit();
@@ -253,6 +505,23 @@ class SOMAReader {
      * @brief Read the next chunk of results from the query. If all results have
      * already been read, std::nullopt is returned.
      *
+     * If prefetch is enabled with the "soma.read_prefetch" config parameter,
+     * the next chunk of results is read in the background while the caller
+     * processes the chunk returned by this call. Each chunk is read into a new
+     * set of ColumnBuffers, so the returned results remain valid while the
+     * next chunk is in flight.
+     *
+     * If the query is partitioned, each partition reads one chunk ahead, and
+     * the chunks are returned as the partitions complete, in no particular
+     * order. If the "soma.read_partitions_ordered" config parameter is
+     * "true", all chunks of a partition are returned before the chunks of the
+     * next partition.
+     *
+     * If the result order is "sorted", each chunk holds the sorted cells of a
+     * slab of the first dimension, and the chunks are returned in slab order,
+     * so the cells of all chunks are sorted. Sorted reads are not
+     * partitioned or prefetched.
+     *
      * An example use model:
      *
      *   auto reader = SOMAReader::open(uri);
@@ -265,12 +534,55 @@ class SOMAReader {
      */
     std::optional<std::shared_ptr<ArrayBuffers>> read_next();
 
+    /**
+     * @brief Read a fixed size, non-nullable column of a dense array into a
+     * caller-provided buffer with a single submit, instead of calling
+     * `submit` and `read_next`. The buffer must hold all cells of the
+     * selected subarray, in the result order of the reader. The query is not
+     * partitioned.
+     *
+     * @param name Column name
+     * @param data Buffer
+     * @param num_bytes Size of the buffer (bytes)
+     * @return uint64_t Number of cells read
+     */
+    uint64_t read_into(
+        const std::string& name, void* data, uint64_t num_bytes) {
+        if (submitted_) {
+            throw TileDBSOMAError(
+                "[SOMAReader] read_into cannot be called after submit");
+        }
+        return mq_->read_into(name, data, num_bytes);
+    }
+
+    /**
+     * @brief Return the number of cells in the selected subarray of a dense
+     * array.
+     *
+     * @return std::optional<uint64_t> Number of cells, or std::nullopt if the
+     * array is sparse or the number of cells cannot be computed
+     */
+    std::optional<uint64_t> dense_num_cells() {
+        return mq_->dense_num_cells();
+    }
+
     /**
      * @brief Check if the query is complete.
      *
      * @return true Query status is COMPLETE
      */
     bool is_complete() {
+        if (sorted_) {
+            return slabs_.empty() && !first_read_next_;
+        }
+        if (!partitions_.empty()) {
+            return num_in_flight_ == 0;
+        }
+
+        // A prefetched chunk has not been returned by `read_next` yet
+        if (prefetched_) {
+            return false;
+        }
         return mq_->is_complete();
     }
 
@@ -282,6 +594,27 @@ class SOMAReader {
      * query
      */
     bool results_complete() {
+        // A sorted read returns complete results in one chunk of one slab
+        if (sorted_) {
+            return slabs_.empty() && num_sorted_batches_ <= 1;
+        }
+
+        // The results of a partitioned query are complete only if they were
+        // returned in one chunk
+        if (!partitions_.empty()) {
+            return num_in_flight_ == 0 && num_partition_batches_ <= 1;
+        }
+
+        // Cached results are complete if they are one chunk
+        if (cached_) {
+            return cached_batches_.size() <= 1 &&
+                   next_cached_batch_ == cached_batches_.size();
+        }
+
+        // A chunk is prefetched only if the previous query was incomplete
+        if (prefetched_) {
+            return false;
+        }
         return mq_->results_complete();
     }
 
@@ -292,6 +625,101 @@ class SOMAReader {
      */
     uint64_t nnz();
 
+    /**
+     * @brief Get lower and upper bounds on the total number of unique cells
+     * in the array, computed from the fragment metadata without reading any
+     * cells. The bounds are equal when the fragments do not overlap.
+     *
+     * @return std::pair<uint64_t, uint64_t> Lower and upper bounds
+     */
+    std::pair<uint64_t, uint64_t> nnz_bounds();
+
+    /**
+     * @brief A chunk of a chunk plan: the cells in a set of ranges of
+     * dimension 0, with an estimate of their number.
+     */
+    struct Chunk {
+        // Sorted, disjoint, inclusive ranges of dimension 0
+        std::vector<std::pair<int64_t, int64_t>> ranges;
+
+        // Estimated number of cells in the ranges
+        uint64_t num_cells;
+    };
+
+    /**
+     * @brief Partition dimension 0 into chunks of roughly `target_cells`
+     * cells each, estimated from the MBRs in the fragment metadata without
+     * reading any cells. The chunks cover `ranges`, or the non-empty domain
+     * of dimension 0 if not provided, so that reading every chunk reads
+     * every cell exactly once, whatever the accuracy of the estimates.
+     *
+     * The plan depends only on the fragments in the read timestamp range,
+     * so a reader opened at a fixed timestamp computes the same plan, and the
+     * chunks can be shuffled, distributed and checkpointed by index, then
+     * read in any order with `select_chunk`.
+     *
+     * @note Dimension 0 must be int64 and the array must be sparse
+     *
+     * @param target_cells Target number of cells per chunk
+     * @param ranges Inclusive ranges of dimension 0 to cover
+     * @return std::vector<Chunk> Chunks, in order of dimension 0
+     */
+    std::vector<Chunk> plan_chunks(
+        uint64_t target_cells,
+        std::optional<std::vector<std::pair<int64_t, int64_t>>> ranges =
+            std::nullopt);
+
+    /**
+     * @brief Select the ranges of a chunk on dimension 0, to read the chunk
+     * after submit. Other selections are applied as usual.
+     *
+     * @param chunk Chunk returned by `plan_chunks`
+     */
+    void select_chunk(const Chunk& chunk) {
+        auto dim = mq_->schema()->domain().dimension(0).name();
+        set_dim_ranges(dim, chunk.ranges);
+    }
+
+    /**
+     * @brief Get the non-empty domain of a fixed-size dimension.
+     *
+     * @tparam T Dimension type
+     * @param dim Dimension name
+     * @return std::pair<T, T> Non-empty domain (start, end)
+     */
+    template <typename T>
+    std::pair<T, T> non_empty_domain(const std::string& dim) {
+        auto [start, end] = cached_non_empty_domain(dim, [&]() {
+            auto [start, end] = array_->non_empty_domain<T>(dim);
+            return std::pair(
+                std::string((const char*)&start, sizeof(T)),
+                std::string((const char*)&end, sizeof(T)));
+        });
+        if (start.size() != sizeof(T) || end.size() != sizeof(T)) {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] non_empty_domain: type size mismatch for "
+                "dimension '{}'",
+                dim));
+        }
+        std::pair<T, T> domain;
+        std::memcpy(&domain.first, start.data(), sizeof(T));
+        std::memcpy(&domain.second, end.data(), sizeof(T));
+        return domain;
+    }
+
+    /**
+     * @brief Get the non-empty domain of a variable-size dimension.
+     *
+     * @param dim Dimension name
+     * @return std::pair<std::string, std::string> Non-empty domain
+     * (start, end)
+     */
+    std::pair<std::string, std::string> non_empty_domain_var(
+        const std::string& dim) {
+        return cached_non_empty_domain(
+            dim, [&]() { return array_->non_empty_domain_var(dim); });
+    }
+
     /**
      * @brief Get the schema of the array.
      *
@@ -301,14 +729,108 @@ class SOMAReader {
         return mq_->schema();
     }
 
+    /**
+     * @brief Return the latency and throughput metrics of all queries of the
+     * reader, including the partitions and the export of the results.
+     *
+     * @return QueryMetrics Metrics
+     */
+    QueryMetrics metrics() const;
+
+    /**
+     * @brief Add the time spent exporting results to Arrow to the metrics.
+     *
+     * @param seconds Export time
+     */
+    void record_arrow_export(double seconds) {
+        std::lock_guard<std::mutex> lock(metrics_mtx_);
+        metrics_.arrow_export_seconds += seconds;
+    }
+
+    /**
+     * @brief Add the time spent holding the Python GIL to the metrics.
+     *
+     * @param seconds GIL time
+     */
+    void record_gil(double seconds) {
+        std::lock_guard<std::mutex> lock(metrics_mtx_);
+        metrics_.gil_seconds += seconds;
+    }
+
+    /**
+     * @brief Return the Arrow schema template of the last batch exported
+     * from the reader, if any, which is reused by batches with the same
+     * columns.
+     *
+     * @return std::shared_ptr<const ArrowSchemaTemplate> Schema template
+     */
+    std::shared_ptr<const ArrowSchemaTemplate> arrow_schema() const {
+        return arrow_schema_;
+    }
+
+    /**
+     * @brief Set the Arrow schema template of the last exported batch.
+     *
+     * @param schema Schema template
+     */
+    void set_arrow_schema(std::shared_ptr<const ArrowSchemaTemplate> schema) {
+        arrow_schema_ = schema;
+    }
+
    private:
     //===================================================================
     //= private non-static
     //===================================================================
 
+    // Selection applied to the ManagedQuery of each partition, called with
+    // the partition index and partition count
+    using Selection = std::function<void(ManagedQuery&, int, int)>;
+
+    // A partition of the query, read on the thread pool
+    struct Partition {
+        // Managed query for the partition
+        std::unique_ptr<ManagedQuery> mq;
+
+        // Task reading the next chunk of results, valid while in flight
+        ThreadPool::Task task;
+
+        // Results of the last chunk read
+        std::shared_ptr<ArrayBuffers> results;
+
+        // Error raised while reading the last chunk
+        std::exception_ptr error;
+    };
+
+    // Bounding box of cells, with one inclusive range per dimension. Ranges
+    // of integral dimensions are mapped to int64 preserving order, and other
+    // dimensions span the full int64 range.
+    using Box = std::vector<std::pair<int64_t, int64_t>>;
+
+    // A tile of a fragment, described by its minimum bounding rectangle
+    struct NnzTile {
+        // Index of the fragment in the fragment info
+        uint32_t fragment;
+
+        // Number of cells in the tile
+        uint64_t num_cells;
+
+        // Minimum bounding rectangle of the tile
+        Box mbr;
+
+        // The fragment is within the read timestamp range and has no
+        // duplicate cells
+        bool unique;
+    };
+
     // TileDB context
     std::shared_ptr<Context> ctx_;
 
+    // Array opened for reading
+    std::shared_ptr<Array> array_;
+
+    // Name of the array
+    std::string name_;
+
     // SOMAReader URI
     std::string uri_;
 
@@ -330,8 +852,418 @@ class SOMAReader {
     // True if the query was submitted
     bool submitted_ = false;
 
-    // Unoptimized method for computing nnz() (issue `count_cells` query)
-    uint64_t nnz_slow();
+    // If true, share open arrays and fragment info through the ArrayCache
+    bool cache_arrays_ = false;
+
+    // If true, share nnz and non-empty domains through the StatsCache
+    bool cache_stats_ = true;
+
+    // Fingerprint of the fragments the array was opened at, part of the
+    // StatsCache and ResultCache keys, loaded on first use
+    std::optional<ArrayCache::Fingerprint> fingerprint_;
+
+    // If true, share the results of reads through the ResultCache
+    bool cache_results_ = false;
+
+    // False if a selection that is not part of the ResultCache key was set,
+    // such as a dimension range or an opaque query condition
+    bool cacheable_ = true;
+
+    // Representation of the predicate, part of the ResultCache key
+    std::string predicate_;
+
+    // Columns exported as Arrow dictionary arrays, part of the ResultCache
+    // key
+    std::set<std::string> dictionary_columns_;
+
+    // Key of the read in the ResultCache, while the results of a cacheable
+    // read are collected
+    std::optional<ResultCache::Key> result_key_;
+
+    // Results collected to insert into the ResultCache
+    ResultCache::Batches result_batches_;
+
+    // Bytes allocated by the collected results
+    size_t result_bytes_ = 0;
+
+    // True if the results are read from the ResultCache
+    bool cached_ = false;
+
+    // Results read from the ResultCache
+    ResultCache::Batches cached_batches_;
+
+    // Index of the next result read from the ResultCache
+    size_t next_cached_batch_ = 0;
+
+    // If true, read the next chunk of results in the background
+    bool prefetch_ = false;
+
+    // True if the query for the next chunk was submitted by `read_next`
+    bool prefetched_ = false;
+
+    // Number of partitions read in parallel
+    int num_partitions_ = 1;
+
+    // If true, return the partition results in partition order
+    bool partitions_ordered_ = false;
+
+    // Selections recorded to be applied to each partition
+    std::vector<Selection> selections_;
+
+    // True if a selection was recorded on the first dimension
+    bool partition_dim_selected_ = false;
+
+    // Partitions of the query
+    std::vector<Partition> partitions_;
+
+    // Number of partitions with a chunk in flight
+    size_t num_in_flight_ = 0;
+
+    // Index of the partition returning results, if ordered
+    size_t next_partition_ = 0;
+
+    // Number of chunks returned from the partitions
+    size_t num_partition_batches_ = 0;
+
+    // If true, return the cells sorted by their coordinates
+    bool sorted_ = false;
+
+    // Largest number of cells sorted in memory
+    uint64_t sort_max_cells_ = DEFAULT_SORT_MAX_CELLS;
+
+    // Ranges selected on the first dimension of a sorted read, if any
+    std::optional<std::vector<std::pair<int64_t, int64_t>>> sorted_ranges_;
+
+    // Slabs of the first dimension to read, the next slab last
+    std::vector<std::vector<std::pair<int64_t, int64_t>>> slabs_;
+
+    // Number of chunks returned from the slabs
+    size_t num_sorted_batches_ = 0;
+
+    // Metrics recorded by the reader and the partitions that were reset
+    QueryMetrics metrics_;
+
+    // Mutex protecting the metrics, which may be recorded by another thread
+    mutable std::mutex metrics_mtx_;
+
+    // Arrow schema template of the last exported batch
+    std::shared_ptr<const ArrowSchemaTemplate> arrow_schema_;
+
+    // Indexes of the partitions that completed a chunk, if unordered
+    std::unique_ptr<ProducerConsumerQueue<size_t>> completed_;
+
+    // Thread pool reading the partitions, declared after the partitions so
+    // its threads are joined first
+    std::unique_ptr<ThreadPool> pool_;
+
+    /**
+     * @brief If prefetch is enabled and the query is not complete, submit the
+     * query for the next chunk of results in the background.
+     */
+    void prefetch_next();
+
+    /**
+     * @brief Return the next chunk of results of the submitted query,
+     * without the ResultCache.
+     *
+     * @return std::optional<std::shared_ptr<ArrayBuffers>>
+     */
+    std::optional<std::shared_ptr<ArrayBuffers>> read_next_uncached();
+
+    /**
+     * @brief Return the ResultCache key of the read, if its results can be
+     * cached: the ResultCache is enabled, and the selection is described by
+     * the key.
+     *
+     * @return std::optional<ResultCache::Key>
+     */
+    std::optional<ResultCache::Key> result_cache_key();
+
+    /**
+     * @brief Throw an error if the partition index is not valid.
+     *
+     * @param partition_index Partition index
+     * @param partition_count Partition count
+     */
+    static void check_partition(int partition_index, int partition_count) {
+        if (partition_index >= partition_count) {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] partition_index ({}) must be < partition_count "
+                "({})",
+                partition_index,
+                partition_count));
+        }
+    }
+
+    /**
+     * @brief Return true if the selections are recorded, to be applied to
+     * the partitions or to the slabs of a sorted read. Callers check it
+     * before copying a selection to record it.
+     */
+    bool records_selections() const {
+        return num_partitions_ > 1 || sorted_;
+    }
+
+    /**
+     * @brief Record a selection to apply to each partition, if the query is
+     * partitioned, or to each slab, if the read is sorted.
+     *
+     * @param selection Selection
+     */
+    void add_selection(Selection selection) {
+        if (records_selections()) {
+            selections_.push_back(std::move(selection));
+        }
+    }
+
+    /**
+     * @brief Record a points selection, split across the partitions if the
+     * dimension is the first dimension. The points on the first dimension of
+     * a sorted read are recorded as ranges, which are split into slabs.
+     * Callers check `records_selections` before copying the points.
+     *
+     * @tparam T Dimension type
+     * @param dim Dimension name
+     * @param points Points
+     */
+    template <typename T>
+    void add_partition_points(const std::string& dim, std::vector<T> points) {
+        if (!records_selections()) {
+            return;
+        }
+        bool split = dim == mq_->schema()->domain().dimension(0).name();
+        if (sorted_ && split) {
+            // Submit rejects sorted reads of other types
+            if constexpr (std::is_integral_v<T>) {
+                auto& ranges = sorted_ranges_ ? *sorted_ranges_ :
+                                                sorted_ranges_.emplace();
+                for (auto& point : points) {
+                    ranges.emplace_back(point, point);
+                }
+            }
+            return;
+        }
+        partition_dim_selected_ |= split;
+        add_selection([dim, points = std::move(points), split](
+                          ManagedQuery& mq, int index, int count) {
+            if (split) {
+                mq.select_points(
+                    dim,
+                    partition_values(tcb::span<const T>(points), index, count));
+            } else {
+                mq.select_points(dim, points);
+            }
+        });
+    }
+
+    /**
+     * @brief Record a ranges selection, split across the partitions if the
+     * dimension is the first dimension.
+     *
+     * @tparam T Dimension type
+     * @param dim Dimension name
+     * @param ranges Ranges
+     */
+    template <typename T>
+    void add_partition_ranges(
+        const std::string& dim, std::vector<std::pair<T, T>> ranges) {
+        if (!records_selections()) {
+            return;
+        }
+        bool split = dim == mq_->schema()->domain().dimension(0).name();
+        if (sorted_ && split) {
+            if constexpr (std::is_integral_v<T>) {
+                auto& sorted_ranges = sorted_ranges_ ? *sorted_ranges_ :
+                                                       sorted_ranges_.emplace();
+                for (auto& [start, end] : ranges) {
+                    sorted_ranges.emplace_back(start, end);
+                }
+            }
+            return;
+        }
+        partition_dim_selected_ |= split;
+        add_selection([dim, ranges = std::move(ranges), split](
+                          ManagedQuery& mq, int index, int count) {
+            if (split) {
+                mq.select_ranges(dim, partition_ranges(ranges, index, count));
+            } else {
+                mq.select_ranges(dim, ranges);
+            }
+        });
+    }
+
+    /**
+     * @brief Create the partitions and submit their first chunk.
+     *
+     * @return true if the query was partitioned
+     */
+    bool submit_partitions();
+
+    /**
+     * @brief Read the next chunk of a partition on the thread pool.
+     *
+     * @param index Partition index
+     */
+    void schedule_partition(size_t index);
+
+    /**
+     * @brief Return the next chunk of results from the partitions.
+     *
+     * @return std::optional<std::shared_ptr<ArrayBuffers>>
+     */
+    std::optional<std::shared_ptr<ArrayBuffers>> read_next_partition();
+
+    /**
+     * @brief Split the selection on the first dimension of a sorted read into
+     * slabs, each estimated to hold at most "soma.read_sort_max_cells" cells.
+     */
+    void submit_sorted();
+
+    /**
+     * @brief Read all cells of the next slab of a sorted read, unordered, and
+     * return them sorted. A slab holding more cells than the limit is split
+     * in two halves, which are read instead.
+     *
+     * @return std::optional<std::shared_ptr<ArrayBuffers>>
+     */
+    std::optional<std::shared_ptr<ArrayBuffers>> read_next_sorted();
+
+    /**
+     * @brief Wait for the partitions in flight and remove the partitions.
+     */
+    void reset_partitions();
+
+    /**
+     * @brief Return a statistic from the StatsCache, or compute it and add it
+     * to the cache. The statistic is computed without the cache if caching
+     * is disabled.
+     *
+     * @tparam T Statistic type
+     * @param stat Statistic member of ArrayStats
+     * @param compute Function computing the statistic
+     * @return T Statistic
+     */
+    template <typename T>
+    T cached_stat(
+        std::optional<T> ArrayStats::*stat, const std::function<T()>& compute) {
+        if (!cache_stats_) {
+            return compute();
+        }
+        auto key = stats_key();
+        if (auto value = StatsCache::instance().get(key).*stat) {
+            return *value;
+        }
+        T value = compute();
+        StatsCache::instance().update(
+            key, [&](ArrayStats& stats) { stats.*stat = value; });
+        return value;
+    }
+
+    /**
+     * @brief Return the non-empty domain of a dimension from the StatsCache,
+     * or compute it and add it to the cache.
+     *
+     * @param dim Dimension name
+     * @param compute Function computing the non-empty domain
+     * @return std::pair<std::string, std::string> Non-empty domain
+     */
+    std::pair<std::string, std::string> cached_non_empty_domain(
+        const std::string& dim,
+        const std::function<std::pair<std::string, std::string>()>& compute);
+
+    /**
+     * @brief Return the fingerprint of the fragments the array was opened
+     * at, loading the fragment info on first use after the array is opened.
+     *
+     * @return const ArrayCache::Fingerprint& Fingerprint
+     */
+    const ArrayCache::Fingerprint& fingerprint();
+
+    /**
+     * @brief Return the StatsCache key of the array.
+     *
+     * @return StatsCache::Key
+     */
+    StatsCache::Key stats_key();
+
+    /**
+     * @brief Load the fragment info of the array, or share the cached
+     * fragment info.
+     *
+     * @return std::shared_ptr<FragmentInfo> Fragment info
+     */
+    std::shared_ptr<FragmentInfo> load_fragment_info();
+
+    /**
+     * @brief Find the fragments in the timestamp range the array was opened
+     * at.
+     *
+     * @param fragment_info Fragment info of the array
+     * @return std::vector<std::pair<uint32_t, bool>> Index of each fragment,
+     * and whether it has unique cells in the timestamp range
+     */
+    std::vector<std::pair<uint32_t, bool>> find_relevant_fragments(
+        const FragmentInfo& fragment_info);
+
+    /**
+     * @brief Count the unique cells from the tile MBRs of the fragments.
+     * Cells in tiles that do not overlap a tile of another fragment are
+     * counted from the metadata. Cells in the overlap regions are counted by
+     * reading the regions when `exact` is true, otherwise they are bounded.
+     *
+     * @param exact Read the overlap regions to compute an exact count
+     * @return std::pair<uint64_t, uint64_t> Lower and upper bounds, which are
+     * equal if `exact` is true
+     */
+    std::pair<uint64_t, uint64_t> nnz_metadata(bool exact);
+
+    /**
+     * @brief Load the tiles of a fragment. If `use_mbrs` is false or the
+     * MBRs are not available, the fragment is described by one tile covering
+     * its non-empty domain.
+     *
+     * @param fragment_info Fragment info of the array
+     * @param fid Fragment index
+     * @param unique The fragment has unique cells in the timestamp range
+     * @param types Datatype of each dimension
+     * @param capacity Number of cells in each tile, except the last tile
+     * @param use_mbrs Read the MBRs, or only the non-empty domain
+     * @return std::vector<NnzTile> Tiles of the fragment
+     */
+    static std::vector<NnzTile> load_tiles(
+        const FragmentInfo& fragment_info,
+        uint32_t fid,
+        bool unique,
+        const std::vector<tiledb_datatype_t>& types,
+        uint64_t capacity,
+        bool use_mbrs);
+
+    /**
+     * @brief Group the tiles that may contain the same cells into disjoint
+     * regions. A tile is added to a region if it overlaps a tile of another
+     * fragment, belongs to a fragment without unique cells, or overlaps
+     * another region.
+     *
+     * @param tiles Tiles of all fragments
+     * @return std::pair<std::vector<int64_t>, std::vector<Box>> Region index
+     * of each tile (-1 for tiles outside of all regions) and the bounding box
+     * of each region
+     */
+    static std::pair<std::vector<int64_t>, std::vector<Box>> overlap_regions(
+        const std::vector<NnzTile>& tiles);
+
+    /**
+     * @brief Count the unique cells in a region by reading dimension 0.
+     *
+     * @param region Bounding box of the region
+     * @param names Name of each dimension
+     * @param types Datatype of each dimension
+     * @return uint64_t Number of cells in the region
+     */
+    uint64_t count_cells(
+        const Box& region,
+        const std::vector<std::string>& names,
+        const std::vector<tiledb_datatype_t>& types);
 };
 
 }  // namespace tiledbsoma
@@ -0,0 +1,344 @@
+/**
+ * @file   soma_writer.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the SOMAWriter
+ */
+
+#ifndef SOMA_WRITER
+#define SOMA_WRITER
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <tiledb/tiledb>
+
+#include "thread_pool/thread_pool.h"
+#include "tiledbsoma/carrow.h"
+#include "tiledbsoma/common.h"
+
+namespace tiledbsoma {
+using namespace tiledb;
+
+/**
+ * @brief Write Arrow record batches to a sparse TileDB array.
+ *
+ * Each batch is bound to a TileDB write query without copying the fixed-size
+ * data. Offsets are rebased to uint64 and validity bitmaps are expanded to
+ * bytemaps in buffers that are reused across batches. The queries are
+ * submitted on a thread pool while the caller builds the next batch.
+ *
+ * With the "unordered" layout, each batch is written as a separate fragment.
+ * With the "global-order" layout, the batches must be sorted in the global
+ * order of the array and are streamed into a single fragment, which is
+ * completed by `close`.
+ */
+class SOMAWriter {
+    // Config key for the number of batches submitted in the background. With
+    // 0, each batch is submitted by `write` on the calling thread.
+    inline static const std::string
+        CONFIG_KEY_IN_FLIGHT = "soma.write_in_flight";
+
+    inline static const size_t DEFAULT_IN_FLIGHT = 2;
+
+   public:
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    /**
+     * @brief Open an array at the specified URI for writing.
+     *
+     * @param uri URI of the array
+     * @param platform_config Config parameter dictionary
+     * @param layout Write layout, "unordered" or "global-order"
+     * @param timestamp Optional timestamp of the written fragments
+     * @return std::unique_ptr<SOMAWriter> SOMAWriter
+     */
+    static std::unique_ptr<SOMAWriter> open(
+        std::string_view uri,
+        std::map<std::string, std::string> platform_config = {},
+        std::string_view layout = "unordered",
+        std::optional<uint64_t> timestamp = std::nullopt);
+
+    /**
+     * @brief Open an array at the specified URI for writing.
+     *
+     * @param ctx TileDB context
+     * @param uri URI of the array
+     * @param layout Write layout, "unordered" or "global-order"
+     * @param timestamp Optional timestamp of the written fragments
+     * @return std::unique_ptr<SOMAWriter> SOMAWriter
+     */
+    static std::unique_ptr<SOMAWriter> open(
+        std::shared_ptr<Context> ctx,
+        std::string_view uri,
+        std::string_view layout = "unordered",
+        std::optional<uint64_t> timestamp = std::nullopt);
+
+    //===================================================================
+    //= public non-static
+    //===================================================================
+
+    /**
+     * @brief Construct a new SOMAWriter object
+     *
+     * @param uri URI of the array
+     * @param ctx TileDB context
+     * @param layout Write layout, "unordered" or "global-order"
+     * @param timestamp Optional timestamp of the written fragments
+     */
+    SOMAWriter(
+        std::string_view uri,
+        std::shared_ptr<Context> ctx,
+        std::string_view layout = "unordered",
+        std::optional<uint64_t> timestamp = std::nullopt);
+
+    SOMAWriter() = delete;
+    SOMAWriter(const SOMAWriter&) = delete;
+    SOMAWriter(SOMAWriter&&) = delete;
+
+    /**
+     * @brief Wait for the batches in flight and close the array. Errors are
+     * logged, call `close` to handle them.
+     */
+    ~SOMAWriter();
+
+    /**
+     * @brief Write a record batch, exported as an Arrow struct array with one
+     * child per dimension and attribute of the array.
+     *
+     * The writer takes ownership of the array, leaving it released, and
+     * releases it once the batch is written. The schema is only used during
+     * the call. An error writing an earlier batch in the background is
+     * raised by the next call to `write`, `flush` or `close`.
+     *
+     * @param array Arrow struct array
+     * @param schema Arrow schema of the array
+     */
+    void write(ArrowArray* array, const ArrowSchema* schema);
+
+    /**
+     * @brief Wait for the batches in flight to be written.
+     */
+    void flush();
+
+    /**
+     * @brief Flush the batches in flight, complete the fragment written in
+     * global order, and close the array.
+     */
+    void close();
+
+    /**
+     * @brief Return the number of cells written.
+     *
+     * @return uint64_t Number of cells
+     */
+    uint64_t num_cells() const {
+        return num_cells_;
+    }
+
+    /**
+     * @brief Return the URI of the array.
+     *
+     * @return std::string_view URI
+     */
+    std::string_view uri() const {
+        return uri_;
+    }
+
+   private:
+    //===================================================================
+    //= private non-static
+    //===================================================================
+
+    // A dimension or attribute of the array
+    struct Column {
+        // TileDB datatype
+        tiledb_datatype_t type;
+
+        // True if the column is variable length
+        bool is_var;
+
+        // True if the column is nullable
+        bool is_nullable;
+    };
+
+    // Buffers of a column bound to a write query. The data points into the
+    // Arrow array where possible, and into the owned buffers otherwise.
+    struct WriteBuffer {
+        // Column name
+        std::string name;
+
+        // Data and number of data elements
+        void* data = nullptr;
+        uint64_t data_size = 0;
+
+        // Offsets, if variable length
+        uint64_t* offsets = nullptr;
+
+        // Validity bytemap, if nullable
+        uint8_t* validity = nullptr;
+
+        // Number of cells
+        uint64_t num_cells = 0;
+
+        // Buffers for the converted data, offsets and validity, reused for
+        // the next batch bound to this buffer
+        std::vector<uint8_t> data_buffer;
+        std::vector<uint64_t> offsets_buffer;
+        std::vector<uint8_t> validity_buffer;
+
+        /**
+         * @brief Set the buffers on a write query.
+         *
+         * @param query TileDB query
+         */
+        void attach(Query& query);
+    };
+
+    // A record batch being written
+    struct Batch {
+        // Arrow array owned by the batch
+        ArrowArray array = {};
+
+        // Buffers bound to the array
+        std::vector<WriteBuffer> buffers;
+
+        // Number of cells in the batch
+        uint64_t num_cells = 0;
+
+        // Task writing the batch, valid while in flight
+        ThreadPool::Task task;
+
+        // Error raised while writing the batch
+        std::exception_ptr error;
+
+        ~Batch() {
+            release();
+        }
+
+        // Release the Arrow array
+        void release() {
+            if (array.release != nullptr) {
+                array.release(&array);
+            }
+        }
+    };
+
+    // TileDB context
+    std::shared_ptr<Context> ctx_;
+
+    // SOMAWriter URI
+    std::string uri_;
+
+    // Array opened for writing
+    std::shared_ptr<Array> array_;
+
+    // Columns of the array by name
+    std::map<std::string, Column> columns_;
+
+    // Write layout
+    tiledb_layout_t layout_ = TILEDB_UNORDERED;
+
+    // Query writing all batches, if the layout is global order
+    std::unique_ptr<Query> query_;
+
+    // Number of batches submitted in the background
+    size_t max_in_flight_ = DEFAULT_IN_FLIGHT;
+
+    // Batches in flight, in submission order
+    std::deque<std::unique_ptr<Batch>> in_flight_;
+
+    // Written batches, kept to reuse their buffers
+    std::vector<std::unique_ptr<Batch>> free_;
+
+    // Number of cells written
+    uint64_t num_cells_ = 0;
+
+    // True if the array was closed
+    bool closed_ = false;
+
+    // Thread pool submitting the batches, declared after the batches so its
+    // threads are joined first
+    std::unique_ptr<ThreadPool> pool_;
+
+    /**
+     * @brief Bind the columns of the batch Arrow array to write buffers.
+     *
+     * @param batch Batch
+     * @param schema Arrow schema of the batch array
+     */
+    void bind(Batch& batch, const ArrowSchema& schema);
+
+    /**
+     * @brief Bind an Arrow array to the write buffer of a column.
+     *
+     * @param buffer Write buffer
+     * @param schema Arrow schema of the column
+     * @param array Arrow array of the column
+     * @param offset Offset of the parent struct array
+     * @param length Number of cells
+     */
+    void bind_column(
+        WriteBuffer& buffer,
+        const ArrowSchema& schema,
+        const ArrowArray& array,
+        int64_t offset,
+        int64_t length);
+
+    /**
+     * @brief Submit the batch to a write query.
+     *
+     * @param batch Batch
+     */
+    void submit(Batch& batch);
+
+    /**
+     * @brief Wait for the oldest batch in flight, keep it for reuse, and
+     * rethrow its error.
+     */
+    void complete_oldest();
+
+    /**
+     * @brief Keep a written batch to reuse its buffers, releasing its Arrow
+     * array, and rethrow its error.
+     *
+     * @param batch Batch
+     */
+    void recycle(std::unique_ptr<Batch> batch);
+};
+
+}  // namespace tiledbsoma
+
+#endif
@@ -0,0 +1,206 @@
+/**
+ * @file   stats_cache.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This declares the array statistics cache API
+ */
+
+#ifndef STATS_CACHE_H
+#define STATS_CACHE_H
+
+#include <stdexcept>  // for windows: error C2039: 'runtime_error': is not a member of 'std'
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <tuple>
+
+#include <tiledb/tiledb>
+
+#include "tiledbsoma/array_cache.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+/**
+ * @brief Statistics of an array at a timestamp range, computed from the
+ * fragment metadata.
+ */
+struct ArrayStats {
+    // Total number of unique cells
+    std::optional<uint64_t> nnz;
+
+    // Lower and upper bounds on the number of unique cells
+    std::optional<std::pair<uint64_t, uint64_t>> nnz_bounds;
+
+    // Map: dimension name -> non-empty domain. The values of fixed-size
+    // dimensions are stored as their raw bytes.
+    std::map<std::string, std::pair<std::string, std::string>>
+        non_empty_domains;
+};
+
+/**
+ * @brief A process-wide, thread-safe cache of array statistics.
+ *
+ * Statistics are keyed by the array URI, the timestamp range the array was
+ * opened at, which TileDB resolves to the open time for arrays opened
+ * without a timestamp, and a fingerprint of the fragments in that range.
+ * Readers compute the statistics from the fragments visible in that range,
+ * so a write after an array was opened is neither returned to that reader
+ * nor hidden from readers that open the array later. The fingerprint also
+ * invalidates the statistics of a pinned timestamp range when a fragment is
+ * written inside it, such as at a fixed write timestamp.
+ *
+ * Note: TileDB timestamps have millisecond resolution, so a write in the
+ * millisecond an array was opened may be visible to some readers opened in
+ * that millisecond but not others. SOMAReader uses the cache unless the
+ * "soma.cache_stats" config parameter is "false".
+ */
+class StatsCache {
+   public:
+    //===================================================================
+    //= public static
+    //===================================================================
+
+    // Config key to cache array statistics ("true" or "false")
+    inline static const std::string CONFIG_KEY_CACHE_STATS = "soma.cache_stats";
+
+    // Default maximum number of cached statistics
+    inline static const size_t DEFAULT_CAPACITY = 256;
+
+    using Timestamp = ArrayCache::Timestamp;
+
+    using Fingerprint = ArrayCache::Fingerprint;
+
+    // Key: (URI, open timestamp start, open timestamp end, fragment
+    // fingerprint)
+    using Key = std::tuple<std::string, uint64_t, uint64_t, Fingerprint>;
+
+    /**
+     * @brief Return the process-wide cache.
+     *
+     * @return StatsCache&
+     */
+    static StatsCache& instance();
+
+    /**
+     * @brief Return the cache key of an array opened at the timestamp range.
+     *
+     * @param uri Array URI
+     * @param timestamp_start Open timestamp start
+     * @param timestamp_end Open timestamp end
+     * @param fingerprint Fingerprint of the fragments in the range
+     * @return Key Cache key
+     */
+    static Key key(
+        const std::string& uri,
+        uint64_t timestamp_start,
+        uint64_t timestamp_end,
+        const Fingerprint& fingerprint);
+
+    /**
+     * @brief Return the cache key of an open array.
+     *
+     * @param uri Array URI
+     * @param array Open array
+     * @param fingerprint Fingerprint of the fragments the array was opened at,
+     * see `ArrayCache::fingerprint`
+     * @return Key Cache key
+     */
+    static Key key(
+        const std::string& uri,
+        const Array& array,
+        const Fingerprint& fingerprint);
+
+    //===================================================================
+    //= public non-static
+    //===================================================================
+
+    /**
+     * @brief Construct a new StatsCache object.
+     *
+     * @param capacity Maximum number of cached statistics
+     */
+    StatsCache(size_t capacity = DEFAULT_CAPACITY);
+
+    StatsCache(const StatsCache&) = delete;
+    StatsCache(StatsCache&&) = delete;
+    ~StatsCache() = default;
+
+    /**
+     * @brief Return a copy of the statistics for the key.
+     *
+     * @param key Cache key
+     * @return ArrayStats Statistics, empty if not cached
+     */
+    ArrayStats get(const Key& key);
+
+    /**
+     * @brief Update the statistics for the key.
+     *
+     * @param key Cache key
+     * @param update Function updating the cached statistics
+     */
+    void update(const Key& key, const std::function<void(ArrayStats&)>& update);
+
+    /**
+     * @brief Set the maximum number of cached statistics.
+     *
+     * @param capacity Maximum number of cached statistics
+     */
+    void set_capacity(size_t capacity);
+
+    /**
+     * @brief Remove all statistics.
+     */
+    void clear();
+
+    /**
+     * @brief Return the number of cached statistics.
+     *
+     * @return size_t
+     */
+    size_t size();
+
+   private:
+    //===================================================================
+    //= private non-static
+    //===================================================================
+
+    // Map: key -> statistics
+    LRUCache<Key, std::shared_ptr<ArrayStats>> stats_;
+
+    // Mutex protecting the cache and the cached statistics
+    std::mutex mtx_;
+};
+
+}  // namespace tiledbsoma
+#endif
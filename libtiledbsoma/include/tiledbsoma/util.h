@@ -68,6 +68,17 @@ bool is_tiledb_uri(std::string_view uri);
  */
 std::string rstrip_uri(std::string_view uri);
 
+/**
+ * @brief Call `fn(i)` for each i in [0, n) on the thread pool and rethrow the
+ * first exception thrown by `fn`. A single call runs on the calling thread.
+ *
+ * @param pool Thread pool
+ * @param n Number of calls
+ * @param fn Function called with the index of each call
+ */
+void parallel_for(
+    ThreadPool& pool, size_t n, const std::function<void(size_t)>& fn);
+
 }  // namespace tiledbsoma::util
 
 #endif
@@ -0,0 +1,189 @@
+/**
+ * @file   array_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines the array cache.
+ */
+
+#include "tiledbsoma/array_cache.h"
+#include "tiledbsoma/common.h"
+#include "tiledbsoma/logger_public.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+//===================================================================
+//= public static
+//===================================================================
+
+ArrayCache& ArrayCache::instance() {
+    static ArrayCache cache;
+    return cache;
+}
+
+std::shared_ptr<Context> ArrayCache::open_context(
+    const std::map<std::string, std::string>& config) {
+    auto it = config.find(CONFIG_KEY_CACHE_ARRAYS);
+    if (it != config.end() && it->second == "true") {
+        return instance().context(config);
+    }
+    return std::make_shared<Context>(Config(config));
+}
+
+std::shared_ptr<Array> ArrayCache::open_array(
+    std::shared_ptr<Context> ctx, const std::string& uri, Timestamp timestamp) {
+    auto array = std::make_shared<Array>(*ctx, uri, TILEDB_READ);
+    if (timestamp) {
+        array->set_open_timestamp_start(timestamp->first);
+        array->set_open_timestamp_end(timestamp->second);
+        array->reopen();
+    }
+    return array;
+}
+
+ArrayCache::Fingerprint ArrayCache::fingerprint(
+    const Array& array, const FragmentInfo& fragment_info) {
+    auto open_start = array.open_timestamp_start();
+    auto open_end = array.open_timestamp_end();
+    Fingerprint result = {0, ""};
+    for (uint32_t fid = 0; fid < fragment_info.fragment_num(); fid++) {
+        auto frag_ts = fragment_info.timestamp_range(fid);
+        if (frag_ts.first > open_end || frag_ts.second < open_start) {
+            continue;
+        }
+        result.first++;
+        result.second = fragment_info.fragment_uri(fid);
+    }
+    return result;
+}
+
+//===================================================================
+//= public non-static
+//===================================================================
+
+ArrayCache::ArrayCache(size_t capacity)
+    : contexts_(capacity)
+    , arrays_(capacity)
+    , fragment_infos_(capacity) {
+}
+
+std::shared_ptr<Context> ArrayCache::context(
+    const std::map<std::string, std::string>& config) {
+    // The map is ordered, so equal configs have equal keys
+    std::string key;
+    for (auto& [param, value] : config) {
+        key += fmt::format("{}={}\n", param, value);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (auto ctx = contexts_.get(key)) {
+            return *ctx;
+        }
+    }
+
+    // Create the Context without holding the lock. If another thread cached
+    // a Context for the same config meanwhile, the cached Context is used.
+    LOG_DEBUG("[ArrayCache] Create context");
+    auto ctx = std::make_shared<Context>(Config(config));
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    return contexts_.insert(key, ctx);
+}
+
+std::shared_ptr<Array> ArrayCache::array(
+    std::shared_ptr<Context> ctx, const std::string& uri, Timestamp timestamp) {
+    ArrayKey key = {
+        ctx.get(),
+        uri,
+        timestamp.has_value(),
+        timestamp ? timestamp->first : 0,
+        timestamp ? timestamp->second : 0};
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (auto entry = arrays_.get(key)) {
+            return entry->second;
+        }
+    }
+
+    // Open the array without holding the lock, as in `context`
+    LOG_DEBUG("[ArrayCache] Open array '{}'", uri);
+    auto array = open_array(ctx, uri, timestamp);
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    return arrays_.insert(key, {ctx, array}).second;
+}
+
+std::shared_ptr<FragmentInfo> ArrayCache::fragment_info(
+    std::shared_ptr<Context> ctx,
+    const std::string& uri,
+    const Array& array) {
+    FragmentInfoKey key = {
+        ctx.get(),
+        uri,
+        array.open_timestamp_start(),
+        array.open_timestamp_end()};
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (auto entry = fragment_infos_.get(key)) {
+            return entry->second;
+        }
+    }
+
+    // Load the fragment info without holding the lock, as in `context`
+    LOG_DEBUG("[ArrayCache] Load fragment info '{}'", uri);
+    auto fragment_info = std::make_shared<FragmentInfo>(*ctx, uri);
+    fragment_info->load();
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    return fragment_infos_.insert(key, {ctx, fragment_info}).second;
+}
+
+void ArrayCache::set_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    contexts_.set_capacity(capacity);
+    arrays_.set_capacity(capacity);
+    fragment_infos_.set_capacity(capacity);
+}
+
+void ArrayCache::clear() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    contexts_.clear();
+    arrays_.clear();
+    fragment_infos_.clear();
+}
+
+size_t ArrayCache::size() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return contexts_.size() + arrays_.size() + fragment_infos_.size();
+}
+
+}  // namespace tiledbsoma
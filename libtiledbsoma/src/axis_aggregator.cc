@@ -0,0 +1,292 @@
+/**
+ * @file   axis_aggregator.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines the per-row and per-column aggregation of a sparse
+ *   matrix.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include "tiledbsoma/axis_aggregator.h"
+#include "tiledbsoma/logger_public.h"
+#include "tiledbsoma/util.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+namespace {
+
+// Minimum number of cells reduced by each thread
+const uint64_t MIN_CELLS_PER_THREAD = 1 << 16;
+
+// Call `fn` with a value of the C++ type of a numeric TileDB datatype
+template <typename Fn>
+void visit_numeric(tiledb_datatype_t type, Fn&& fn) {
+    switch (type) {
+        case TILEDB_FLOAT32:
+            return fn(float{});
+        case TILEDB_FLOAT64:
+            return fn(double{});
+        case TILEDB_INT8:
+            return fn(int8_t{});
+        case TILEDB_UINT8:
+            return fn(uint8_t{});
+        case TILEDB_INT16:
+            return fn(int16_t{});
+        case TILEDB_UINT16:
+            return fn(uint16_t{});
+        case TILEDB_INT32:
+            return fn(int32_t{});
+        case TILEDB_UINT32:
+            return fn(uint32_t{});
+        case TILEDB_INT64:
+            return fn(int64_t{});
+        case TILEDB_UINT64:
+            return fn(uint64_t{});
+        default:
+            throw TileDBSOMAError(fmt::format(
+                "[AxisAggregator] column '{}' type {} is not numeric",
+                AxisAggregator::DATA,
+                tiledb::impl::type_to_str(type)));
+    }
+}
+
+// Set `size` zero aggregates
+void assign_zeros(AxisAggregates& aggregates, uint64_t size) {
+    aggregates.nnz.assign(size, 0);
+    aggregates.sum.assign(size, 0);
+    aggregates.m2.assign(size, 0);
+}
+
+// Merge entry `i` of `partial` into `out` and clear it, combining the
+// squared deviations of the two groups of values (Chan et al.)
+void merge(AxisAggregates& out, AxisAggregates& partial, uint64_t i) {
+    auto n_a = out.nnz[i];
+    auto n_b = std::exchange(partial.nnz[i], 0);
+    auto sum_b = std::exchange(partial.sum[i], 0);
+    auto m2_b = std::exchange(partial.m2[i], 0);
+    if (n_b == 0) {
+        return;
+    }
+    if (n_a == 0) {
+        out.m2[i] = m2_b;
+    } else {
+        double delta = sum_b / n_b - out.sum[i] / n_a;
+        out.m2[i] += m2_b + delta * delta * n_a * n_b / (n_a + n_b);
+    }
+    out.nnz[i] += n_b;
+    out.sum[i] += sum_b;
+}
+
+}  // namespace
+
+//===================================================================
+//= AxisAggregates
+//===================================================================
+
+std::vector<double> AxisAggregates::mean(uint64_t n) const {
+    std::vector<double> result(sum.size());
+    for (size_t i = 0; i < sum.size(); i++) {
+        result[i] = n == 0 ? std::numeric_limits<double>::quiet_NaN() :
+                             sum[i] / n;
+    }
+    return result;
+}
+
+std::vector<double> AxisAggregates::variance(uint64_t n, uint64_t ddof) const {
+    std::vector<double> result(sum.size());
+    for (size_t i = 0; i < sum.size(); i++) {
+        if (n <= ddof) {
+            result[i] = std::numeric_limits<double>::quiet_NaN();
+            continue;
+        }
+        // Merge the stored values with the implicit zeros, which have a
+        // mean and squared deviations of 0
+        double k = nnz[i];
+        double mean_stored = nnz[i] == 0 ? 0 : sum[i] / k;
+        double squares = m2[i] + mean_stored * mean_stored * k * (n - k) / n;
+        result[i] = squares / (n - ddof);
+    }
+    return result;
+}
+
+//===================================================================
+//= public non-static
+//===================================================================
+
+AxisAggregator::AxisAggregator(int axis, uint64_t size, unsigned num_threads)
+    : size_(size)
+    , num_threads_(num_threads) {
+    if (axis != 0 && axis != 1) {
+        throw TileDBSOMAError(
+            fmt::format("[AxisAggregator] invalid axis {}", axis));
+    }
+    dim_ = axis == 0 ? ROW_DIM : COL_DIM;
+    if (num_threads_ == 0) {
+        num_threads_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+    assign_zeros(aggregates_, size_);
+}
+
+void AxisAggregator::set_joinids(tcb::span<const int64_t> joinids) {
+    remap_ = IntIndexer(joinids, 1);
+    size_ = joinids.size();
+    assign_zeros(aggregates_, size_);
+    partials_.clear();
+    num_cells_ = 0;
+}
+
+void AxisAggregator::add(std::shared_ptr<ArrayBuffers> batch) {
+    if (batch->names().empty() || batch->num_rows() == 0) {
+        return;
+    }
+
+    auto dim = batch->at(dim_);
+    if (dim->type() != TILEDB_INT64) {
+        throw TileDBSOMAError(
+            fmt::format("[AxisAggregator] column '{}' must be int64", dim_));
+    }
+    auto data = batch->at(DATA);
+    if (data->is_var() || data->is_nullable()) {
+        throw TileDBSOMAError(fmt::format(
+            "[AxisAggregator] column '{}' must be fixed-size and not nullable",
+            DATA));
+    }
+
+    uint64_t n = batch->num_rows();
+    tcb::span<const int64_t> joinids = dim->data<int64_t>();
+    std::vector<int64_t> remapped;
+    auto positions = joinids;
+    if (remap_) {
+        remapped = remap_->get_indexer(joinids);
+        positions = remapped;
+    }
+
+    // Split the cells into one chunk per thread. Each chunk but the first
+    // reduces into partial aggregates of every position, so the number of
+    // chunks is also limited by the ratio of cells to positions.
+    uint64_t num_chunks = std::min<uint64_t>(
+        {num_threads_,
+         n / MIN_CELLS_PER_THREAD,
+         n / std::max<uint64_t>(size_, 1)});
+    num_chunks = std::max<uint64_t>(num_chunks, 1);
+    uint64_t chunk_cells = (n + num_chunks - 1) / num_chunks;
+
+    visit_numeric(data->type(), [&](auto value) {
+        using T = decltype(value);
+        tcb::span<const T> values = data->data<T>();
+        if (num_chunks == 1) {
+            reduce<T>(joinids, positions, values, aggregates_);
+            return;
+        }
+
+        if (!pool_) {
+            pool_ = std::make_unique<ThreadPool>(num_threads_);
+        }
+        while (partials_.size() < num_chunks - 1) {
+            assign_zeros(partials_.emplace_back(), size_);
+        }
+        util::parallel_for(*pool_, num_chunks, [&](size_t c) {
+            auto begin = c * chunk_cells;
+            auto count = std::min(chunk_cells, n - begin);
+            reduce<T>(
+                joinids.subspan(begin, count),
+                positions.subspan(begin, count),
+                values.subspan(begin, count),
+                c == 0 ? aggregates_ : partials_[c - 1]);
+        });
+    });
+
+    // Merge the partial aggregates, clearing them for the next batch
+    if (num_chunks > 1) {
+        util::parallel_for(*pool_, num_chunks, [&](size_t r) {
+            auto begin = size_ * r / num_chunks;
+            auto end = size_ * (r + 1) / num_chunks;
+            for (uint64_t c = 0; c < num_chunks - 1; c++) {
+                for (auto i = begin; i < end; i++) {
+                    merge(aggregates_, partials_[c], i);
+                }
+            }
+        });
+    }
+
+    LOG_TRACE(
+        "[AxisAggregator] reduced {} cells of '{}' in {} chunks",
+        n,
+        dim_,
+        num_chunks);
+    num_cells_ += n;
+}
+
+uint64_t AxisAggregator::read(SOMAReader& reader, uint64_t max_batches) {
+    uint64_t num_batches = 0;
+    while (max_batches == 0 || num_batches < max_batches) {
+        auto batch = reader.read_next();
+        if (!batch) {
+            break;
+        }
+        add(*batch);
+        num_batches++;
+    }
+    return num_batches;
+}
+
+//===================================================================
+//= private non-static
+//===================================================================
+
+template <typename T>
+void AxisAggregator::reduce(
+    tcb::span<const int64_t> joinids,
+    tcb::span<const int64_t> positions,
+    tcb::span<const T> values,
+    AxisAggregates& out) {
+    auto nnz = out.nnz.data();
+    auto sum = out.sum.data();
+    auto m2 = out.m2.data();
+    for (size_t i = 0; i < values.size(); i++) {
+        auto pos = (uint64_t)positions[i];
+        if (pos >= size_) {
+            throw TileDBSOMAError(fmt::format(
+                "[AxisAggregator] {} {} is out of bounds", dim_, joinids[i]));
+        }
+        // Welford's update of the squared deviations from the mean
+        double value = values[i];
+        auto count = ++nnz[pos];
+        double delta = value - (count > 1 ? sum[pos] / (count - 1) : 0.0);
+        sum[pos] += value;
+        m2[pos] += delta * (value - sum[pos] / count);
+    }
+}
+
+}  // namespace tiledbsoma
@@ -0,0 +1,214 @@
+/**
+ * @file   buffer_pool.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file defines the buffer pool.
+ */
+
+#include <algorithm>
+
+#include "tiledbsoma/buffer_pool.h"
+#include "tiledbsoma/column_buffer.h"
+#include "tiledbsoma/common.h"
+#include "tiledbsoma/logger_public.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+//===================================================================
+//= public static
+//===================================================================
+
+std::shared_ptr<BufferPool> BufferPool::create(const Config& config) {
+    auto max_bytes = std::max(
+        DEFAULT_MAX_BYTES,
+        DEFAULT_NUM_BUFFERS * ColumnBuffer::init_bytes(config));
+    if (config.contains(CONFIG_KEY_POOL_BYTES)) {
+        auto value_str = config.get(CONFIG_KEY_POOL_BYTES);
+        try {
+            max_bytes = std::stoull(value_str);
+        } catch (const std::exception& e) {
+            throw TileDBSOMAError(fmt::format(
+                "[BufferPool] Error parsing {}: '{}' ({})",
+                CONFIG_KEY_POOL_BYTES,
+                value_str,
+                e.what()));
+        }
+    }
+
+    if (max_bytes == 0) {
+        return nullptr;
+    }
+    return std::make_shared<BufferPool>(max_bytes);
+}
+
+std::shared_ptr<BufferPool> BufferPool::shared(const Context& ctx) {
+    // Pools are held by the queries and buffers allocated from them, which
+    // may outlive their Context, so the map holds weak references to the
+    // pools and to the TileDB contexts they were created for. An entry
+    // whose context was deleted does not match a new context allocated at
+    // the same address.
+    struct Entry {
+        std::weak_ptr<tiledb_ctx_t> ctx;
+        std::weak_ptr<BufferPool> pool;
+    };
+    static std::mutex mtx;
+    static std::unordered_map<const tiledb_ctx_t*, Entry> pools;
+
+    auto ctx_ptr = ctx.ptr();
+    std::lock_guard<std::mutex> lock(mtx);
+    if (auto it = pools.find(ctx_ptr.get()); it != pools.end()) {
+        if (it->second.ctx.lock() == ctx_ptr) {
+            if (auto pool = it->second.pool.lock()) {
+                return pool;
+            }
+        }
+    }
+
+    // Remove the pools no longer held or whose context was deleted, then
+    // create the pool of the Context
+    for (auto it = pools.begin(); it != pools.end();) {
+        if (it->second.pool.expired() || it->second.ctx.expired()) {
+            it = pools.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    auto pool = create(ctx.config());
+    if (pool) {
+        pools[ctx_ptr.get()] = {ctx_ptr, pool};
+    }
+    return pool;
+}
+
+void BufferPool::set_total_max_bytes(size_t max_bytes) {
+    total_max_bytes_ = max_bytes;
+}
+
+size_t BufferPool::total_retained_bytes() {
+    return total_retained_bytes_;
+}
+
+//===================================================================
+//= public non-static
+//===================================================================
+
+BufferPool::BufferPool(size_t max_bytes)
+    : max_bytes_(max_bytes) {
+}
+
+BufferPool::~BufferPool() {
+    clear();
+}
+
+void* BufferPool::allocate(size_t num_bytes) {
+    auto block_bytes = size_class(num_bytes);
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto& blocks = blocks_[block_bytes];
+        if (!blocks.empty()) {
+            auto block = blocks.back();
+            blocks.pop_back();
+            retained_bytes_ -= block_bytes;
+            total_retained_bytes_ -= block_bytes;
+            num_reused_blocks_++;
+            return block;
+        }
+        num_new_blocks_++;
+    }
+
+    LOG_TRACE("[BufferPool] allocate {} bytes", block_bytes);
+    return ::operator new(block_bytes, std::align_val_t(ALIGNMENT));
+}
+
+void BufferPool::deallocate(void* block, size_t num_bytes) {
+    auto block_bytes = size_class(num_bytes);
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto total = total_retained_bytes_.fetch_add(block_bytes);
+        if (retained_bytes_ + block_bytes <= max_bytes_ &&
+            total + block_bytes <= total_max_bytes_) {
+            blocks_[block_bytes].push_back(block);
+            retained_bytes_ += block_bytes;
+            return;
+        }
+        total_retained_bytes_ -= block_bytes;
+    }
+
+    LOG_TRACE("[BufferPool] free {} bytes", block_bytes);
+    ::operator delete(block, std::align_val_t(ALIGNMENT));
+}
+
+void BufferPool::clear() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto& [_, blocks] : blocks_) {
+        for (auto block : blocks) {
+            ::operator delete(block, std::align_val_t(ALIGNMENT));
+        }
+    }
+    blocks_.clear();
+    total_retained_bytes_ -= retained_bytes_;
+    retained_bytes_ = 0;
+}
+
+size_t BufferPool::retained_bytes() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return retained_bytes_;
+}
+
+size_t BufferPool::num_new_blocks() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return num_new_blocks_;
+}
+
+size_t BufferPool::num_reused_blocks() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return num_reused_blocks_;
+}
+
+//===================================================================
+//= private static
+//===================================================================
+
+size_t BufferPool::size_class(size_t num_bytes) {
+    if (num_bytes <= MIN_BLOCK_BYTES) {
+        return MIN_BLOCK_BYTES;
+    }
+
+    // Round up to a multiple of a quarter of the largest power of two below
+    // `num_bytes`
+    size_t power = MIN_BLOCK_BYTES;
+    while (power <= num_bytes / 2) {
+        power <<= 1;
+    }
+    size_t step = power / 4;
+    return (num_bytes + step - 1) / step * step;
+}
+
+}  // namespace tiledbsoma
@@ -0,0 +1,160 @@
+/**
+ * @file   cell_sorter.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines the CellSorter class.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+#include "tiledbsoma/cell_sorter.h"
+#include "tiledbsoma/logger_public.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+namespace {
+
+// Sort key of a cell, holding the first two coordinates inline so most
+// comparisons do not read the dimension buffers
+struct Key {
+    int64_t d0;
+    int64_t d1;
+    uint32_t batch;
+    uint32_t cell;
+};
+
+}  // namespace
+
+std::vector<ColumnBuffer::CellRef> CellSorter::sort_cells(
+    const std::vector<std::shared_ptr<ArrayBuffers>>& batches,
+    const std::vector<std::string>& dims) {
+    if (dims.empty()) {
+        throw TileDBSOMAError("[CellSorter] No dimension to sort by");
+    }
+    if (batches.size() > std::numeric_limits<uint32_t>::max()) {
+        throw TileDBSOMAError(fmt::format(
+            "[CellSorter] Too many batches to sort: {}", batches.size()));
+    }
+
+    // Coordinates of each dimension of each batch
+    std::vector<std::vector<const int64_t*>> coords(batches.size());
+    size_t num_cells = 0;
+    for (size_t b = 0; b < batches.size(); b++) {
+        for (auto& dim : dims) {
+            auto buffer = batches[b]->at(dim);
+            if (buffer->type() != TILEDB_INT64 || buffer->is_var()) {
+                throw TileDBSOMAError(fmt::format(
+                    "[CellSorter] Cannot sort by column '{}': not an int64 "
+                    "dimension",
+                    dim));
+            }
+            coords[b].push_back(buffer->data<int64_t>().data());
+        }
+        auto size = batches[b]->at(dims[0])->size();
+        if (size > std::numeric_limits<uint32_t>::max()) {
+            throw TileDBSOMAError(fmt::format(
+                "[CellSorter] Too many cells to sort in one batch: {}", size));
+        }
+        num_cells += size;
+    }
+
+    std::vector<Key> keys;
+    keys.reserve(num_cells);
+    for (size_t b = 0; b < batches.size(); b++) {
+        auto size = batches[b]->at(dims[0])->size();
+        auto d0 = coords[b][0];
+        auto d1 = dims.size() > 1 ? coords[b][1] : nullptr;
+        for (size_t i = 0; i < size; i++) {
+            keys.push_back(
+                {d0[i], d1 ? d1[i] : 0, (uint32_t)b, (uint32_t)i});
+        }
+    }
+
+    // Compare the first two coordinates, then the other dimensions, then
+    // the position of the cells, so the order is deterministic
+    auto less = [&](const Key& a, const Key& b) {
+        if (a.d0 != b.d0) {
+            return a.d0 < b.d0;
+        }
+        if (a.d1 != b.d1) {
+            return a.d1 < b.d1;
+        }
+        for (size_t k = 2; k < dims.size(); k++) {
+            auto va = coords[a.batch][k][a.cell];
+            auto vb = coords[b.batch][k][b.cell];
+            if (va != vb) {
+                return va < vb;
+            }
+        }
+        return std::tie(a.batch, a.cell) < std::tie(b.batch, b.cell);
+    };
+
+    // Cells read from a single fragment are often already in order
+    if (!std::is_sorted(keys.begin(), keys.end(), less)) {
+        std::sort(keys.begin(), keys.end(), less);
+    }
+
+    std::vector<ColumnBuffer::CellRef> cells;
+    cells.reserve(keys.size());
+    for (auto& key : keys) {
+        cells.emplace_back(key.batch, key.cell);
+    }
+    return cells;
+}
+
+std::shared_ptr<ArrayBuffers> CellSorter::sort(
+    const std::vector<std::shared_ptr<ArrayBuffers>>& batches,
+    const std::vector<std::string>& dims,
+    const std::vector<std::string>& names) {
+    if (batches.empty()) {
+        throw TileDBSOMAError("[CellSorter] No batch to sort");
+    }
+    auto cells = sort_cells(batches, dims);
+
+    auto& columns = names.empty() ? batches[0]->names() : names;
+    auto result = std::make_shared<ArrayBuffers>();
+    for (auto& name : columns) {
+        std::vector<std::shared_ptr<ColumnBuffer>> parts;
+        for (auto& batch : batches) {
+            parts.push_back(batch->at(name));
+        }
+        result->emplace(name, ColumnBuffer::gather(parts, cells));
+    }
+
+    LOG_DEBUG(
+        "[CellSorter] Sorted {} cells of {} batches",
+        cells.size(),
+        batches.size());
+    return result;
+}
+
+}  // namespace tiledbsoma
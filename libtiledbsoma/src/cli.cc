@@ -27,9 +27,24 @@
  *
  * @section DESCRIPTION
  *
- * This file is currently a sandbox for C++ API experiments
+ * This file defines the tiledbsoma command line tool. The `scan` command
+ * benchmarks reads of an array, and the remaining code is a sandbox for C++
+ * API experiments.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
 #include <tiledbsoma/tiledbsoma>
 
 using namespace tiledbsoma;
@@ -71,8 +86,8 @@ void test_sdf(const std::string& uri) {
         total_num_rows += (*batch)->num_rows();
     }
 
-    LOG_INFO(fmt::format("X/data rows = {}", total_num_rows));
-    LOG_INFO(fmt::format("  batches = {}", batches));
+    LOG_INFO("X/data rows = {}", total_num_rows);
+    LOG_INFO("  batches = {}", batches);
 }
 
 namespace tdbs = tiledbsoma;
@@ -83,35 +98,404 @@ void test_arrow(const std::string& uri) {
     // Getting next batch:  std::optional<std::shared_ptr<ArrayBuffers>>
     auto obs_data = obs->read_next();
     if (!obs->results_complete()) {
-        tdbs::LOG_WARN(fmt::format("Read of '{}' incomplete", uri));
+        tdbs::LOG_WARN("Read of '{}' incomplete", uri);
 #if !defined(R_BUILD)
         exit(-1);
 #endif
     }
-    tdbs::LOG_INFO(fmt::format(
+    tdbs::LOG_INFO(
         "Read complete with {} obs and {} cols",
         obs_data->get()->num_rows(),
-        obs_data->get()->names().size()));
+        obs_data->get()->names().size());
     std::vector<std::string> names = obs_data->get()->names();
     for (auto nm : names) {
         auto buf = obs_data->get()->at(nm);
         auto pp = tdbs::ArrowAdapter::to_arrow(buf);
         ArrowSchema* schema = pp.second.get();
-        tdbs::LOG_INFO(fmt::format(
+        tdbs::LOG_INFO(
             "Accessing '{}', retrieved '{}', n_children {}",
             nm,
             schema->name,
-            schema->n_children));
+            schema->n_children);
+        pp.first->release(pp.first.get());
+        schema->release(schema);
     }
 }
 
 #if !defined(R_BUILD)
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* SCAN_USAGE = R"(Usage: %s scan <uri> [options]
+
+Read an array with SOMAReader and report its throughput and latency.
+
+Options:
+  --columns <a,b,...>         Columns to read (default: all)
+  --batch-size <size>         Batch size (default: auto)
+  --result-order <order>      auto, row-major, column-major or sorted
+  --points <dim>=<p,p,...>    Select int64 points of a dimension
+  --ranges <dim>=<a:b,...>    Select inclusive int64 ranges of a dimension
+  --partitions <n>            Read in n partitions (soma.read_partitions)
+  --threads <n>               TileDB compute and IO concurrency levels
+  --prefetch                  Read the next batch in the background
+  --memory-budget <bytes>     TileDB memory budget (sm.mem.total_budget)
+  --buffer-budget <bytes>     Budget of the buffers of all readers
+                              (soma.mem.total_budget)
+  --init-buffer-bytes <bytes> Initial buffer size (soma.init_buffer_bytes)
+  --config <key>=<value>      Set a config parameter, may be repeated
+  --export                    Export each batch to Arrow and release it
+  --repeat <n>                Scan n times (default: 1)
+  --metrics                   Print the query metrics as JSON
+  --tiledb-stats              Print the TileDB internal statistics
+  --trace <file>              Record trace spans to a Chrome trace file
+  --log-level <level>         Log level (default: warn)
+)";
+
+// A selection of points or ranges of an int64 dimension
+struct ScanSelection {
+    std::string dim;
+    std::vector<int64_t> points;
+    std::vector<std::pair<int64_t, int64_t>> ranges;
+};
+
+// Options of the scan command
+struct ScanOptions {
+    std::string uri;
+    std::vector<std::string> columns;
+    std::string batch_size = "auto";
+    std::string result_order = "auto";
+    std::vector<ScanSelection> selections;
+    std::map<std::string, std::string> config;
+    bool export_arrow = false;
+    int repeat = 1;
+    bool metrics = false;
+    bool tiledb_stats = false;
+    std::string tracefile;
+    std::string log_level = "warn";
+};
+
+// Latency samples of a phase of the scan, in seconds
+struct PhaseLatency {
+    std::string name;
+    std::vector<double> samples;
+
+    void add(Clock::time_point start) {
+        samples.push_back(
+            std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    double percentile(double p) const {
+        auto sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        auto index = (size_t)(p / 100 * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    }
+};
+
+std::vector<std::string> split(const std::string& value, char delimiter) {
+    std::vector<std::string> result;
+    size_t start = 0;
+    while (true) {
+        auto end = value.find(delimiter, start);
+        result.push_back(value.substr(start, end - start));
+        if (end == std::string::npos) {
+            return result;
+        }
+        start = end + 1;
+    }
+}
+
+int64_t parse_int(const std::string& option, const std::string& value) {
+    try {
+        size_t pos;
+        auto result = std::stoll(value, &pos);
+        if (pos == value.size()) {
+            return result;
+        }
+    } catch (const std::exception&) {
+    }
+    throw TileDBSOMAError(
+        fmt::format("[cli] {}: invalid integer '{}'", option, value));
+}
+
+// Split "<key>=<value>"
+std::pair<std::string, std::string> parse_assignment(
+    const std::string& option, const std::string& value) {
+    auto pos = value.find('=');
+    if (pos == std::string::npos || pos == 0) {
+        throw TileDBSOMAError(fmt::format(
+            "[cli] {}: expected <name>=<value>, got '{}'", option, value));
+    }
+    return {value.substr(0, pos), value.substr(pos + 1)};
+}
+
+ScanOptions parse_scan_options(int argc, char** argv) {
+    ScanOptions options;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw TileDBSOMAError(
+                    fmt::format("[cli] {}: missing value", arg));
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--columns") {
+            options.columns = split(value(), ',');
+        } else if (arg == "--batch-size") {
+            options.batch_size = value();
+        } else if (arg == "--result-order") {
+            options.result_order = value();
+        } else if (arg == "--points" || arg == "--ranges") {
+            auto [dim, list] = parse_assignment(arg, value());
+            ScanSelection selection{dim, {}, {}};
+            for (auto& item : split(list, ',')) {
+                if (arg == "--points") {
+                    selection.points.push_back(parse_int(arg, item));
+                    continue;
+                }
+                auto bounds = split(item, ':');
+                if (bounds.size() != 2) {
+                    throw TileDBSOMAError(fmt::format(
+                        "[cli] {}: expected <start>:<end>, got '{}'",
+                        arg,
+                        item));
+                }
+                selection.ranges.emplace_back(
+                    parse_int(arg, bounds[0]), parse_int(arg, bounds[1]));
+            }
+            options.selections.push_back(selection);
+        } else if (arg == "--partitions") {
+            options.config["soma.read_partitions"] = value();
+        } else if (arg == "--threads") {
+            auto threads = std::to_string(parse_int(arg, value()));
+            options.config["sm.compute_concurrency_level"] = threads;
+            options.config["sm.io_concurrency_level"] = threads;
+        } else if (arg == "--prefetch") {
+            options.config["soma.read_prefetch"] = "true";
+        } else if (arg == "--memory-budget") {
+            options.config["sm.mem.total_budget"] = value();
+        } else if (arg == "--buffer-budget") {
+            options.config["soma.mem.total_budget"] = value();
+        } else if (arg == "--init-buffer-bytes") {
+            options.config["soma.init_buffer_bytes"] = value();
+        } else if (arg == "--config") {
+            auto [key, config_value] = parse_assignment(arg, value());
+            options.config[key] = config_value;
+        } else if (arg == "--export") {
+            options.export_arrow = true;
+        } else if (arg == "--repeat") {
+            options.repeat = parse_int(arg, value());
+            if (options.repeat < 1) {
+                throw TileDBSOMAError("[cli] --repeat must be >= 1");
+            }
+        } else if (arg == "--metrics") {
+            options.metrics = true;
+        } else if (arg == "--tiledb-stats") {
+            options.tiledb_stats = true;
+        } else if (arg == "--trace") {
+            options.tracefile = value();
+        } else if (arg == "--log-level") {
+            options.log_level = value();
+        } else if (arg.rfind("--", 0) == 0) {
+            throw TileDBSOMAError(
+                fmt::format("[cli] Unknown option '{}'", arg));
+        } else if (options.uri.empty()) {
+            options.uri = arg;
+        } else {
+            throw TileDBSOMAError(
+                fmt::format("[cli] Unexpected argument '{}'", arg));
+        }
+    }
+    if (options.uri.empty()) {
+        throw TileDBSOMAError("[cli] scan: missing <uri>");
+    }
+    return options;
+}
+
+// Return the bytes of the data, offsets and validity of the cells read
+uint64_t result_bytes(ArrayBuffers& batch) {
+    uint64_t bytes = 0;
+    for (auto& name : batch.names()) {
+        auto column = batch.at(name);
+        bytes += column->data_size();
+        if (column->is_var()) {
+            bytes += (column->size() + 1) * sizeof(uint64_t);
+        }
+        if (column->is_nullable()) {
+            bytes += column->size();
+        }
+    }
+    return bytes;
+}
+
+// Return the peak resident set size of the process in bytes, or 0 if unknown
+uint64_t peak_rss_bytes() {
+#if defined(_WIN32)
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return usage.ru_maxrss;
+#else
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+int scan(const ScanOptions& options) {
+    LOG_CONFIG(options.log_level);
+    if (!options.tracefile.empty()) {
+        TRACE_START(options.tracefile);
+    }
+    if (options.tiledb_stats) {
+        tiledb::Stats::enable();
+    }
+
+    // The memory governor is process-wide, so it is configured once here
+    auto config = Config(options.config);
+    MemoryGovernor::instance().configure(config);
+    auto ctx = std::make_shared<Context>(config);
+    PhaseLatency open{"open", {}};
+    PhaseLatency first_batch{"first batch", {}};
+    PhaseLatency read{"read_next", {}};
+    PhaseLatency export_arrow{"arrow export", {}};
+    PhaseLatency total{"scan", {}};
+    QueryMetrics metrics;
+    uint64_t rows = 0;
+    uint64_t bytes = 0;
+    uint64_t batches = 0;
+
+    for (int i = 0; i < options.repeat; i++) {
+        auto scan_start = Clock::now();
+        auto sr = SOMAReader::open(
+            ctx,
+            options.uri,
+            "scan",
+            options.columns,
+            options.batch_size,
+            options.result_order);
+        open.add(scan_start);
+
+        for (auto& selection : options.selections) {
+            if (!selection.points.empty()) {
+                sr->set_dim_points(selection.dim, selection.points);
+            }
+            if (!selection.ranges.empty()) {
+                sr->set_dim_ranges(selection.dim, selection.ranges);
+            }
+        }
+
+        auto submit_start = Clock::now();
+        sr->submit();
+        bool first = true;
+        while (true) {
+            auto read_start = Clock::now();
+            auto batch = sr->read_next();
+            if (!batch) {
+                break;
+            }
+            read.add(read_start);
+            if (first) {
+                first_batch.add(submit_start);
+                first = false;
+            }
+            batches++;
+            rows += (*batch)->num_rows();
+            bytes += result_bytes(**batch);
+
+            if (options.export_arrow) {
+                auto export_start = Clock::now();
+                for (auto& name : (*batch)->names()) {
+                    auto [array, schema] =
+                        ArrowAdapter::to_arrow((*batch)->at(name));
+                    array->release(array.get());
+                    schema->release(schema.get());
+                }
+                export_arrow.add(export_start);
+            }
+        }
+        total.add(scan_start);
+        metrics.merge(sr->metrics());
+    }
+
+    double seconds = 0;
+    for (auto sample : total.samples) {
+        seconds += sample;
+    }
+    printf("uri:         %s\n", options.uri.c_str());
+    printf("scans:       %d\n", options.repeat);
+    printf(
+        "rows:        %llu in %llu batches\n",
+        (unsigned long long)rows,
+        (unsigned long long)batches);
+    printf("bytes:       %llu\n", (unsigned long long)bytes);
+    printf("seconds:     %.3f\n", seconds);
+    printf("rows/s:      %.0f\n", seconds > 0 ? rows / seconds : 0);
+    printf("MB/s:        %.1f\n", seconds > 0 ? bytes / seconds / 1e6 : 0);
+    printf("peak RSS:    %.1f MB\n", peak_rss_bytes() / 1e6);
+    printf(
+        "\n%-14s %8s %10s %10s %10s %10s\n",
+        "phase (ms)",
+        "count",
+        "p50",
+        "p90",
+        "p99",
+        "max");
+    for (auto* phase : {&open, &first_batch, &read, &export_arrow, &total}) {
+        if (phase->samples.empty()) {
+            continue;
+        }
+        printf(
+            "%-14s %8zu %10.3f %10.3f %10.3f %10.3f\n",
+            phase->name.c_str(),
+            phase->samples.size(),
+            phase->percentile(50) * 1e3,
+            phase->percentile(90) * 1e3,
+            phase->percentile(99) * 1e3,
+            phase->percentile(100) * 1e3);
+    }
+
+    if (options.metrics) {
+        printf("\nmetrics: %s\n", metrics.to_json().c_str());
+    }
+    if (options.tiledb_stats) {
+        std::string stats;
+        tiledb::Stats::dump(&stats);
+        printf("\n%s\n", stats.c_str());
+        tiledb::Stats::disable();
+    }
+    if (!options.tracefile.empty()) {
+        TRACE_STOP();
+    }
+    return 0;
+}
+
+}  // namespace
+
 int main(int argc, char** argv) {
+    if (argc >= 2 && std::string(argv[1]) == "scan") {
+        try {
+            return scan(parse_scan_options(argc, argv));
+        } catch (const std::exception& e) {
+            fprintf(stderr, "%s\n\n", e.what());
+            fprintf(stderr, SCAN_USAGE, argv[0]);
+            return 1;
+        }
+    }
+
     LOG_CONFIG("debug");
 
     if (argc < 2) {
         printf("Run with CI test SOMA:\n\n");
-        printf("  %s test/soco/pbmc3k_processed\n", argv[0]);
+        printf("  %s test/soco/pbmc3k_processed\n\n", argv[0]);
+        printf(SCAN_USAGE, argv[0]);
         return 0;
     }
 
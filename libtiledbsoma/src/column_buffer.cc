@@ -30,6 +30,15 @@
  * This file defines the a ColumBuffer class.
  */
 
+#include <bitset>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "tiledbsoma/column_buffer.h"
 #include "tiledbsoma/array_buffers.h"
 #include "tiledbsoma/common.h"
@@ -39,12 +48,27 @@ namespace tiledbsoma {
 
 using namespace tiledb;
 
+namespace {
+
+// Count the set bits of a bitmap word. std::bitset is portable, unlike
+// __builtin_popcount, and compiles to a popcount instruction where one is
+// available.
+size_t count_bits(uint32_t bits) {
+    return std::bitset<32>(bits).count();
+}
+
+}  // namespace
+
 //===================================================================
 //= public static
 //===================================================================
 
 std::shared_ptr<ColumnBuffer> ColumnBuffer::create(
-    std::shared_ptr<Array> array, std::string_view name) {
+    std::shared_ptr<Array> array,
+    std::string_view name,
+    std::optional<size_t> num_bytes,
+    std::optional<size_t> num_cells,
+    std::shared_ptr<BufferPool> pool) {
     auto name_str = std::string(name);  // string for TileDB API
     auto schema = array->schema();
 
@@ -60,7 +84,14 @@ std::shared_ptr<ColumnBuffer> ColumnBuffer::create(
         }
 
         return ColumnBuffer::alloc(
-            array, attr.name(), attr.type(), is_var, is_nullable);
+            array,
+            attr.name(),
+            attr.type(),
+            is_var,
+            is_nullable,
+            num_bytes,
+            num_cells,
+            pool);
 
     } else if (schema.domain().has_dimension(name_str)) {
         auto dim = schema.domain().dimension(name_str);
@@ -75,27 +106,213 @@ std::shared_ptr<ColumnBuffer> ColumnBuffer::create(
         }
 
         return ColumnBuffer::alloc(
-            array, dim.name(), dim.type(), is_var, false);
+            array,
+            dim.name(),
+            dim.type(),
+            is_var,
+            false,
+            num_bytes,
+            num_cells,
+            pool);
     }
 
     throw TileDBSOMAError("[ColumnBuffer] Column name not found: " + name_str);
 }
 
+size_t ColumnBuffer::alloc_bytes(
+    std::shared_ptr<Array> array,
+    std::string_view name,
+    std::optional<size_t> num_bytes,
+    std::optional<size_t> num_cells) {
+    auto name_str = std::string(name);  // string for TileDB API
+    auto schema = array->schema();
+
+    tiledb_datatype_t type;
+    bool is_var;
+    bool is_nullable = false;
+    if (schema.has_attribute(name_str)) {
+        auto attr = schema.attribute(name_str);
+        type = attr.type();
+        is_var = attr.cell_val_num() == TILEDB_VAR_NUM;
+        is_nullable = attr.nullable();
+    } else if (schema.domain().has_dimension(name_str)) {
+        auto dim = schema.domain().dimension(name_str);
+        type = dim.type();
+        is_var = dim.cell_val_num() == TILEDB_VAR_NUM ||
+                 dim.type() == TILEDB_STRING_ASCII ||
+                 dim.type() == TILEDB_STRING_UTF8;
+    } else {
+        throw TileDBSOMAError(
+            "[ColumnBuffer] Column name not found: " + name_str);
+    }
+
+    // Resolve the sizes as `alloc` does
+    auto data_bytes = num_bytes ? *num_bytes :
+                                  init_bytes(schema.context().config());
+    auto cells = num_cells ? *num_cells :
+                             num_cells_for(data_bytes, type, is_var);
+    return data_bytes + (is_var ? (cells + 1) * sizeof(uint64_t) : 0) +
+           (is_nullable ? cells : 0);
+}
+
+size_t ColumnBuffer::init_bytes(const Config& config) {
+    if (!config.contains(CONFIG_KEY_INIT_BYTES)) {
+        return DEFAULT_ALLOC_BYTES;
+    }
+    auto value_str = config.get(CONFIG_KEY_INIT_BYTES);
+    try {
+        return std::stoull(value_str);
+    } catch (const std::exception& e) {
+        throw TileDBSOMAError(fmt::format(
+            "[ColumnBuffer] Error parsing {}: '{}' ({})",
+            CONFIG_KEY_INIT_BYTES,
+            value_str,
+            e.what()));
+    }
+}
+
+std::shared_ptr<ColumnBuffer> ColumnBuffer::gather(
+    const std::vector<std::shared_ptr<ColumnBuffer>>& parts,
+    tcb::span<const CellRef> cells) {
+    if (parts.empty()) {
+        throw TileDBSOMAError("[ColumnBuffer] gather requires a buffer");
+    }
+    auto& first = *parts[0];
+    size_t num_bytes = 0;
+    for (auto& part : parts) {
+        if (part->type_ != first.type_ || part->is_var_ != first.is_var_ ||
+            part->is_nullable_ != first.is_nullable_) {
+            throw TileDBSOMAError(fmt::format(
+                "[ColumnBuffer] Cannot gather buffers of different columns: "
+                "'{}' and '{}'",
+                first.name_,
+                part->name_));
+        }
+        num_bytes += part->data_size();
+    }
+
+    auto result = std::make_shared<ColumnBuffer>(
+        first.name_,
+        first.type_,
+        cells.size(),
+        num_bytes,
+        first.is_var_,
+        first.is_nullable_,
+        first.pool());
+    result->is_dictionary_encoded_ = first.is_dictionary_encoded_;
+    result->small_offsets_ = first.small_offsets_;
+
+    auto type_size = first.type_size_;
+    auto dst = result->data_.data();
+    if (first.is_var_) {
+        auto offsets = result->offsets_.data();
+        offsets[0] = 0;
+        for (size_t i = 0; i < cells.size(); i++) {
+            auto& part = *parts[cells[i].first];
+            auto start = part.offsets_[cells[i].second];
+            auto len = part.offsets_[cells[i].second + 1] - start;
+            std::memcpy(
+                dst + offsets[i] * type_size,
+                part.data_.data() + start * type_size,
+                len * type_size);
+            offsets[i + 1] = offsets[i] + len;
+        }
+    } else {
+        for (size_t i = 0; i < cells.size(); i++) {
+            auto& part = *parts[cells[i].first];
+            std::memcpy(
+                dst + i * type_size,
+                part.data_.data() + cells[i].second * type_size,
+                type_size);
+        }
+    }
+    if (first.is_nullable_) {
+        auto validity = result->validity_.data();
+        for (size_t i = 0; i < cells.size(); i++) {
+            validity[i] = parts[cells[i].first]->validity_[cells[i].second];
+        }
+    }
+    result->num_cells_ = cells.size();
+
+    // Export data too large for 32-bit offsets with 64-bit offsets instead
+    if (result->small_offsets_ &&
+        result->data_size() > MAX_SMALL_OFFSETS_BYTES) {
+        LOG_WARN(
+            "[ColumnBuffer] Data of '{}' too large for 32-bit offsets: {} "
+            "bytes, exporting 64-bit offsets",
+            result->name_,
+            result->data_size());
+        result->small_offsets_ = false;
+    }
+    return result;
+}
+
 void ColumnBuffer::to_bitmap(tcb::span<uint8_t> bytemap) {
-    int i_dst = 0;
-    for (unsigned int i_src = 0; i_src < bytemap.size(); i_src++) {
-        // Overwrite every 8 bytes with a one-byte bitmap
-        if (i_src % 8 == 0) {
-            // Each bit in the bitmap corresponds to one byte in the bytemap
-            // Note: the bitmap must be byte-aligned (8 bits)
-            int bitmap = 0;
-            for (unsigned int i = i_src; i < i_src + 8 && i < bytemap.size();
-                 i++) {
-                bitmap |= bytemap[i] << (i % 8);
-            }
-            bytemap[i_dst++] = bitmap;
+    // The bitmap is written behind the bytemap values being read, so the
+    // conversion can be done in place.
+    to_bitmap(bytemap, bytemap.data());
+}
+
+size_t ColumnBuffer::to_bitmap(
+    tcb::span<const uint8_t> bytemap, uint8_t* bitmap) {
+    // Each bit in the bitmap corresponds to one byte in the bytemap, with
+    // the least significant bit first (Arrow bit order). A bit is set if the
+    // byte is not zero.
+    const uint8_t* src = bytemap.data();
+    size_t size = bytemap.size();
+    size_t count = 0;
+    size_t i_src = 0;
+
+#if defined(__AVX2__)
+    const __m256i zero256 = _mm256_setzero_si256();
+    for (; i_src + 32 <= size; i_src += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(src + i_src));
+        uint32_t bits = ~(uint32_t)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(bytes, zero256));
+        std::memcpy(bitmap + i_src / 8, &bits, sizeof(bits));
+        count += count_bits(bits);
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i zero128 = _mm_setzero_si128();
+    for (; i_src + 16 <= size; i_src += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(src + i_src));
+        uint16_t bits = ~(uint16_t)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(bytes, zero128));
+        std::memcpy(bitmap + i_src / 8, &bits, sizeof(bits));
+        count += count_bits(bits);
+    }
+#elif defined(__ARM_NEON)
+    // Select one bit per byte lane, then add the lanes of each 8 byte half
+    // to form the two bitmap bytes.
+    const uint8_t lane_bits[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t weights =
+        vcombine_u8(vld1_u8(lane_bits), vld1_u8(lane_bits));
+    for (; i_src + 16 <= size; i_src += 16) {
+        uint8x16_t bytes = vld1q_u8(src + i_src);
+        uint8x16_t masked = vandq_u8(vtstq_u8(bytes, bytes), weights);
+        uint8x8_t sums = vpadd_u8(vget_low_u8(masked), vget_high_u8(masked));
+        sums = vpadd_u8(sums, sums);
+        sums = vpadd_u8(sums, sums);
+        uint16_t bits = vget_lane_u16(vreinterpret_u16_u8(sums), 0);
+        std::memcpy(bitmap + i_src / 8, &bits, sizeof(bits));
+        count += count_bits(bits);
+    }
+#endif
+
+    // Convert the remaining bytes. Note: the bitmap must be byte-aligned
+    // (8 bits), so the last bitmap byte may be partially filled.
+    for (; i_src < size; i_src += 8) {
+        uint8_t bits = 0;
+        for (size_t i = i_src; i < i_src + 8 && i < size; i++) {
+            bits |= (src[i] != 0) << (i % 8);
         }
+        bitmap[i_src / 8] = bits;
+        count += count_bits(bits);
     }
+
+    return count;
 }
 
 //===================================================================
@@ -108,19 +325,23 @@ ColumnBuffer::ColumnBuffer(
     size_t num_cells,
     size_t num_bytes,
     bool is_var,
-    bool is_nullable)
+    bool is_nullable,
+    std::shared_ptr<BufferPool> pool)
     : name_(name)
     , type_(type)
     , type_size_(tiledb::impl::type_size(type))
     , num_cells_(0)
     , is_var_(is_var)
-    , is_nullable_(is_nullable) {
-    LOG_DEBUG(fmt::format(
+    , is_nullable_(is_nullable)
+    , data_(PoolAllocator<std::byte>(pool))
+    , offsets_(PoolAllocator<uint64_t>(pool))
+    , validity_(PoolAllocator<uint8_t>(pool)) {
+    LOG_DEBUG(
         "[ColumnBuffer] '{}' {} bytes is_var={} is_nullable={}",
         name,
         num_bytes,
         is_var_,
-        is_nullable_));
+        is_nullable_);
     // Call reserve() to allocate memory without initializing the contents.
     // This reduce the time to allocate the buffer and reduces the
     // resident memory footprint of the buffer.
@@ -133,6 +354,29 @@ ColumnBuffer::ColumnBuffer(
     }
 }
 
+void ColumnBuffer::grow(size_t num_bytes) {
+    auto num_cells = num_cells_for(num_bytes, type_, is_var_);
+    LOG_DEBUG(
+        "[ColumnBuffer] '{}' grow from {} to {} bytes",
+        name_,
+        data_.capacity(),
+        num_bytes);
+
+    // Swap with empty buffers to free the existing allocations before
+    // allocating the larger buffers.
+    num_cells_ = 0;
+    decltype(data_)(data_.get_allocator()).swap(data_);
+    data_.reserve(num_bytes);
+    if (is_var_) {
+        decltype(offsets_)(offsets_.get_allocator()).swap(offsets_);
+        offsets_.reserve(num_cells + 1);  // extra offset for arrow
+    }
+    if (is_nullable_) {
+        decltype(validity_)(validity_.get_allocator()).swap(validity_);
+        validity_.reserve(num_cells);
+    }
+}
+
 void ColumnBuffer::attach(Query& query) {
     // We cannot use:
     // `set_data_buffer(const std::string& name, std::vector<T>& buf)`
@@ -191,39 +435,35 @@ std::shared_ptr<ColumnBuffer> ColumnBuffer::alloc(
     std::string_view name,
     tiledb_datatype_t type,
     bool is_var,
-    bool is_nullable) {
+    bool is_nullable,
+    std::optional<size_t> num_bytes_in,
+    std::optional<size_t> num_cells_in,
+    std::shared_ptr<BufferPool> pool) {
     // Set number of bytes for the data buffer. Override with a value from
-    // the config if present.
-    auto num_bytes = DEFAULT_ALLOC_BYTES;
-    auto config = array->schema().context().config();
-    if (config.contains(CONFIG_KEY_INIT_BYTES)) {
-        auto value_str = config.get(CONFIG_KEY_INIT_BYTES);
-        try {
-            num_bytes = std::stoull(value_str);
-        } catch (const std::exception& e) {
-            throw TileDBSOMAError(fmt::format(
-                "[ColumnBuffer] Error parsing {}: '{}' ({})",
-                CONFIG_KEY_INIT_BYTES,
-                value_str,
-                e.what()));
-        }
-    }
+    // the config if present, or with the provided number of bytes.
+    auto num_bytes = num_bytes_in ?
+                         *num_bytes_in :
+                         init_bytes(array->schema().context().config());
 
-    bool is_dense = array->schema().array_type() == TILEDB_DENSE;
-    if (is_dense) {
-        // TODO: Handle dense arrays similar to tiledb python module
-    }
+    // Dense arrays are sized by ManagedQuery, which passes the number of
+    // cells in the subarray
 
+    size_t num_cells = num_cells_in ? *num_cells_in :
+                                      num_cells_for(num_bytes, type, is_var);
+
+    return std::make_shared<ColumnBuffer>(
+        name, type, num_cells, num_bytes, is_var, is_nullable, pool);
+}
+
+size_t ColumnBuffer::num_cells_for(
+    size_t num_bytes, tiledb_datatype_t type, bool is_var) {
     // For variable length column types, allocate an extra num_bytes to hold
     //   offset values. The number of cells is the set by the size of the
     //   offset type.
     // For non-variable length column types, the number of cells is computed
     //   from the type size.
-    size_t num_cells = is_var ? num_bytes / sizeof(uint64_t) :
-                                num_bytes / tiledb::impl::type_size(type);
-
-    return std::make_shared<ColumnBuffer>(
-        name, type, num_cells, num_bytes, is_var, is_nullable);
+    return is_var ? num_bytes / sizeof(uint64_t) :
+                    num_bytes / tiledb::impl::type_size(type);
 }
 
 }  // namespace tiledbsoma
@@ -0,0 +1,318 @@
+/**
+ * @file   compressed_matrix.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines the compressed sparse matrix builder.
+ */
+
+#include <algorithm>
+#include <numeric>
+#include <thread>
+
+#include "tiledbsoma/compressed_matrix.h"
+#include "tiledbsoma/logger_public.h"
+#include "tiledbsoma/util.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+namespace {
+
+// Minimum number of cells assembled by each thread
+const uint64_t MIN_CELLS_PER_THREAD = 1 << 16;
+
+// Call `fn` with a value of the unsigned type of `size` bytes, so values of
+// any fixed-size type are copied as words of the same size
+template <typename Fn>
+void visit_word(size_t size, Fn&& fn) {
+    switch (size) {
+        case 1:
+            return fn(uint8_t{});
+        case 2:
+            return fn(uint16_t{});
+        case 4:
+            return fn(uint32_t{});
+        case 8:
+            return fn(uint64_t{});
+        default:
+            throw TileDBSOMAError(fmt::format(
+                "[CompressedMatrixBuilder] values of {} bytes are not "
+                "supported",
+                size));
+    }
+}
+
+// A contiguous range of cells of one batch
+struct Chunk {
+    size_t batch;
+    uint64_t begin;
+    uint64_t end;
+
+    // Index of the first cell of the chunk in all batches
+    uint64_t offset;
+};
+
+}  // namespace
+
+//===================================================================
+//= public non-static
+//===================================================================
+
+CompressedMatrixBuilder::CompressedMatrixBuilder(
+    CompressedFormat format,
+    uint64_t num_rows,
+    uint64_t num_cols,
+    unsigned num_threads)
+    : format_(format)
+    , shape_{num_rows, num_cols}
+    , num_threads_(num_threads) {
+    if (num_threads_ == 0) {
+        num_threads_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+void CompressedMatrixBuilder::set_joinids(
+    int dim, tcb::span<const int64_t> joinids) {
+    if (dim != 0 && dim != 1) {
+        throw TileDBSOMAError(fmt::format(
+            "[CompressedMatrixBuilder] invalid dimension index {}", dim));
+    }
+
+    remaps_[dim] = IntIndexer(joinids, 1);
+    shape_[dim] = joinids.size();
+}
+
+void CompressedMatrixBuilder::add(std::shared_ptr<ArrayBuffers> batch) {
+    if (batch->names().empty() || batch->num_rows() == 0) {
+        return;
+    }
+
+    for (auto& name : {ROW_DIM, COL_DIM}) {
+        if (batch->at(name)->type() != TILEDB_INT64) {
+            throw TileDBSOMAError(fmt::format(
+                "[CompressedMatrixBuilder] column '{}' must be int64", name));
+        }
+    }
+
+    auto data = batch->at(DATA);
+    if (data->is_var()) {
+        throw TileDBSOMAError(fmt::format(
+            "[CompressedMatrixBuilder] column '{}' must be fixed-size", DATA));
+    }
+    if (type_ && *type_ != data->type()) {
+        throw TileDBSOMAError(fmt::format(
+            "[CompressedMatrixBuilder] column '{}' type changed from {} to {}",
+            DATA,
+            tiledb::impl::type_to_str(*type_),
+            tiledb::impl::type_to_str(data->type())));
+    }
+    type_ = data->type();
+
+    batches_.push_back(batch);
+    nnz_ += batch->num_rows();
+}
+
+uint64_t CompressedMatrixBuilder::read(
+    SOMAReader& reader, uint64_t max_batches) {
+    uint64_t num_batches = 0;
+    while (max_batches == 0 || num_batches < max_batches) {
+        auto batch = reader.read_next();
+        if (!batch) {
+            break;
+        }
+        add(*batch);
+        num_batches++;
+    }
+    return num_batches;
+}
+
+std::shared_ptr<CompressedMatrix> CompressedMatrixBuilder::finish() {
+    auto matrix = std::make_shared<CompressedMatrix>();
+    matrix->format = format_;
+    matrix->num_rows = shape_[0];
+    matrix->num_cols = shape_[1];
+    if (type_) {
+        matrix->type = *type_;
+    }
+
+    int major_dim = format_ == CompressedFormat::CSR ? 0 : 1;
+    int minor_dim = 1 - major_dim;
+    auto& major_name = major_dim == 0 ? ROW_DIM : COL_DIM;
+    auto& minor_name = minor_dim == 0 ? ROW_DIM : COL_DIM;
+    uint64_t num_major = shape_[major_dim];
+    size_t value_size = tiledb::impl::type_size(matrix->type);
+
+    matrix->indptr.assign(num_major + 1, 0);
+    matrix->indices.resize(nnz_);
+    matrix->data.resize(nnz_ * value_size);
+    if (nnz_ == 0) {
+        return matrix;
+    }
+
+    // Split the cells into one chunk per thread. Each chunk counts the cells
+    // of every major index, so the number of chunks is also limited by the
+    // ratio of cells to major indices.
+    uint64_t num_chunks = std::min<uint64_t>(
+        {num_threads_,
+         nnz_ / MIN_CELLS_PER_THREAD,
+         nnz_ / std::max<uint64_t>(num_major, 1)});
+    num_chunks = std::max<uint64_t>(num_chunks, 1);
+    uint64_t chunk_cells = (nnz_ + num_chunks - 1) / num_chunks;
+
+    std::vector<Chunk> chunks;
+    uint64_t offset = 0;
+    for (size_t b = 0; b < batches_.size(); b++) {
+        uint64_t num_cells = batches_[b]->num_rows();
+        for (uint64_t begin = 0; begin < num_cells; begin += chunk_cells) {
+            auto end = std::min(begin + chunk_cells, num_cells);
+            chunks.push_back({b, begin, end, offset});
+            offset += end - begin;
+        }
+    }
+
+    LOG_DEBUG(
+        "[CompressedMatrixBuilder] assembling {} cells of {} batches in {} "
+        "chunks",
+        nnz_,
+        batches_.size(),
+        chunks.size());
+
+    ThreadPool pool(std::min<size_t>(num_threads_, chunks.size()));
+
+    // Map a joinid of a dimension to its position, checking the bounds
+    auto position = [&](int dim, int64_t joinid) -> uint64_t {
+        int64_t pos = remaps_[dim] ? remaps_[dim]->lookup(joinid) : joinid;
+        if (pos < 0 || (uint64_t)pos >= shape_[dim]) {
+            throw TileDBSOMAError(fmt::format(
+                "[CompressedMatrixBuilder] {} {} is out of bounds",
+                dim == 0 ? ROW_DIM : COL_DIM,
+                joinid));
+        }
+        return pos;
+    };
+
+    // Count the cells of each major index in each chunk
+    std::vector<uint64_t> majors(nnz_);
+    std::vector<std::vector<uint64_t>> counts(chunks.size());
+    util::parallel_for(pool, chunks.size(), [&](size_t c) {
+        auto& chunk = chunks[c];
+        auto dim = batches_[chunk.batch]->at(major_name)->data<int64_t>();
+        counts[c].assign(num_major, 0);
+        for (auto i = chunk.begin; i < chunk.end; i++) {
+            auto pos = position(major_dim, dim[i]);
+            majors[chunk.offset + i - chunk.begin] = pos;
+            counts[c][pos]++;
+        }
+    });
+
+    // Compute the offsets, and replace the counts with the position of the
+    // next cell of each major index in each chunk
+    auto& indptr = matrix->indptr;
+    for (uint64_t m = 0; m < num_major; m++) {
+        uint64_t next = indptr[m];
+        for (auto& chunk_counts : counts) {
+            auto count = chunk_counts[m];
+            chunk_counts[m] = next;
+            next += count;
+        }
+        indptr[m + 1] = next;
+    }
+
+    // Scatter the minor indices and values. The chunks are in read order,
+    // so the sort is stable.
+    visit_word(value_size, [&](auto word) {
+        using T = decltype(word);
+        auto values = (T*)matrix->data.data();
+        util::parallel_for(pool, chunks.size(), [&](size_t c) {
+            auto& chunk = chunks[c];
+            auto& batch = batches_[chunk.batch];
+            auto dim = batch->at(minor_name)->data<int64_t>();
+            auto data = batch->at(DATA)->data<T>();
+            auto& next = counts[c];
+            for (auto i = chunk.begin; i < chunk.end; i++) {
+                auto dst = next[majors[chunk.offset + i - chunk.begin]]++;
+                matrix->indices[dst] = position(minor_dim, dim[i]);
+                values[dst] = data[i];
+            }
+        });
+    });
+    counts.clear();
+    majors.clear();
+    majors.shrink_to_fit();
+
+    // Sort the minor indices of each major index
+    uint64_t num_ranges = std::min<uint64_t>(chunks.size(), num_major);
+    visit_word(value_size, [&](auto word) {
+        using T = decltype(word);
+        auto values = (T*)matrix->data.data();
+        util::parallel_for(pool, num_ranges, [&](size_t r) {
+            std::vector<uint64_t> order;
+            std::vector<int64_t> sorted_indices;
+            std::vector<T> sorted_values;
+            auto begin_major = num_major * r / num_ranges;
+            auto end_major = num_major * (r + 1) / num_ranges;
+            for (auto m = begin_major; m < end_major; m++) {
+                auto begin = indptr[m];
+                auto n = indptr[m + 1] - begin;
+                auto indices = matrix->indices.data() + begin;
+                if (std::is_sorted(indices, indices + n)) {
+                    continue;
+                }
+
+                order.resize(n);
+                std::iota(order.begin(), order.end(), 0);
+                std::sort(order.begin(), order.end(), [&](auto a, auto b) {
+                    return indices[a] < indices[b];
+                });
+                sorted_indices.resize(n);
+                sorted_values.resize(n);
+                for (int64_t i = 0; i < n; i++) {
+                    sorted_indices[i] = indices[order[i]];
+                    sorted_values[i] = values[begin + order[i]];
+                }
+                std::copy(
+                    sorted_indices.begin(), sorted_indices.end(), indices);
+                std::copy(
+                    sorted_values.begin(), sorted_values.end(), values + begin);
+            }
+        });
+    });
+
+    LOG_DEBUG(
+        "[CompressedMatrixBuilder] assembled {}x{} matrix with {} values",
+        matrix->num_rows,
+        matrix->num_cols,
+        matrix->nnz());
+
+    batches_.clear();
+    nnz_ = 0;
+    return matrix;
+}
+
+}  // namespace tiledbsoma
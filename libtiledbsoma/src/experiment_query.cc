@@ -0,0 +1,148 @@
+/**
+ * @file   experiment_query.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines the ExperimentQuery class.
+ */
+
+#include "tiledbsoma/experiment_query.h"
+#include "tiledbsoma/array_cache.h"
+#include "tiledbsoma/logger_public.h"
+#include "tiledbsoma/util.h"
+
+namespace tiledbsoma {
+using namespace tiledb;
+
+//===================================================================
+//= public static
+//===================================================================
+
+std::unique_ptr<ExperimentQuery> ExperimentQuery::open(
+    std::string_view uri,
+    std::string_view measurement_name,
+    std::string_view X_layer,
+    std::map<std::string, std::string> platform_config,
+    std::optional<std::pair<uint64_t, uint64_t>> timestamp) {
+    return std::make_unique<ExperimentQuery>(
+        uri,
+        ArrayCache::open_context(platform_config),
+        measurement_name,
+        X_layer,
+        timestamp);
+}
+
+std::unique_ptr<ExperimentQuery> ExperimentQuery::open(
+    std::shared_ptr<Context> ctx,
+    std::string_view uri,
+    std::string_view measurement_name,
+    std::string_view X_layer,
+    std::optional<std::pair<uint64_t, uint64_t>> timestamp) {
+    return std::make_unique<ExperimentQuery>(
+        uri, ctx, measurement_name, X_layer, timestamp);
+}
+
+//===================================================================
+//= public non-static
+//===================================================================
+
+ExperimentQuery::ExperimentQuery(
+    std::string_view uri,
+    std::shared_ptr<Context> ctx,
+    std::string_view measurement_name,
+    std::string_view X_layer,
+    std::optional<std::pair<uint64_t, uint64_t>> timestamp)
+    : uri_(util::rstrip_uri(uri))
+    , pool_(std::make_unique<ThreadPool>(3)) {
+    auto ms_uri = fmt::format("{}/ms/{}", uri_, measurement_name);
+    const std::string uris[3] = {
+        uri_ + "/obs",
+        ms_uri + "/var",
+        fmt::format("{}/X/{}", ms_uri, X_layer)};
+    const std::string names[3] = {"obs", "var", fmt::format("X/{}", X_layer)};
+    std::unique_ptr<SOMAReader>* readers[3] = {
+        &obs_.reader, &var_.reader, &x_};
+
+    // The arrays are independent, so they are opened concurrently
+    util::parallel_for(*pool_, 3, [&](size_t i) {
+        *readers[i] = SOMAReader::open(
+            ctx, uris[i], names[i], {}, "auto", "auto", timestamp);
+    });
+}
+
+void ExperimentQuery::submit() {
+    if (submitted_) {
+        throw TileDBSOMAError(fmt::format(
+            "[ExperimentQuery] Query of '{}' was already submitted", uri_));
+    }
+    submitted_ = true;
+
+    Axis* axes[2] = {&obs_, &var_};
+    util::parallel_for(*pool_, 2, [&](size_t i) { read_axis(*axes[i]); });
+    LOG_DEBUG(
+        "[ExperimentQuery] '{}' selected {} obs and {} var",
+        uri_,
+        obs_.joinids.size(),
+        var_.joinids.size());
+
+    // An axis without results selects no cells of X
+    x_->set_dim_points(CompressedMatrixBuilder::ROW_DIM, obs_.joinids);
+    x_->set_dim_points(CompressedMatrixBuilder::COL_DIM, var_.joinids);
+    x_->submit();
+}
+
+std::shared_ptr<CompressedMatrix> ExperimentQuery::read_X(
+    CompressedFormat format, unsigned num_threads) {
+    if (!submitted_) {
+        throw TileDBSOMAError(fmt::format(
+            "[ExperimentQuery] read_X: query of '{}' was not submitted",
+            uri_));
+    }
+    CompressedMatrixBuilder builder(
+        format, obs_.joinids.size(), var_.joinids.size(), num_threads);
+    builder.set_joinids(0, obs_.joinids);
+    builder.set_joinids(1, var_.joinids);
+    builder.read(*x_);
+    return builder.finish();
+}
+
+//===================================================================
+//= private non-static
+//===================================================================
+
+void ExperimentQuery::read_axis(Axis& axis) {
+    // Read the joinids, along with the selected columns
+    axis.reader->select_columns({SOMA_JOINID}, true);
+    axis.reader->submit();
+    while (auto batch = axis.reader->read_next()) {
+        auto joinids = (*batch)->at(SOMA_JOINID)->data<int64_t>();
+        axis.joinids.insert(axis.joinids.end(), joinids.begin(), joinids.end());
+        axis.results.push_back(*batch);
+    }
+}
+
+}  // namespace tiledbsoma
@@ -0,0 +1,132 @@
+/**
+ * @file   int_indexer.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines the int64 joinid indexer.
+ */
+
+#include <algorithm>
+#include <thread>
+
+#include "tiledbsoma/int_indexer.h"
+#include "tiledbsoma/logger_public.h"
+#include "tiledbsoma/util.h"
+
+namespace tiledbsoma {
+
+namespace {
+
+// Minimum number of keys looked up by each thread
+const size_t MIN_KEYS_PER_THREAD = 1 << 16;
+
+}  // namespace
+
+//===================================================================
+//= public non-static
+//===================================================================
+
+IntIndexer::IntIndexer(unsigned num_threads)
+    : IntIndexer(tcb::span<const int64_t>(), num_threads) {
+}
+
+IntIndexer::IntIndexer(tcb::span<const int64_t> keys, unsigned num_threads)
+    : num_threads_(num_threads) {
+    if (num_threads_ == 0) {
+        num_threads_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (num_threads_ > 1) {
+        pool_ = std::make_unique<ThreadPool>(num_threads_);
+    }
+    map_locations(keys);
+}
+
+void IntIndexer::map_locations(tcb::span<const int64_t> keys) {
+    // Use at least two slots per key, so the probe sequences are short
+    int bits = 1;
+    while ((uint64_t(1) << bits) < 2 * keys.size()) {
+        bits++;
+    }
+    slots_.assign(uint64_t(1) << bits, Slot{0, NOT_FOUND});
+    mask_ = slots_.size() - 1;
+    shift_ = 64 - bits;
+    size_ = 0;
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        auto slot = hash(keys[i]);
+        while (slots_[slot].position != NOT_FOUND) {
+            if (slots_[slot].key == keys[i]) {
+                // Leave the indexer empty rather than partially mapped
+                map_locations({});
+                throw TileDBSOMAError(fmt::format(
+                    "[IntIndexer] duplicate key {} at position {}",
+                    keys[i],
+                    i));
+            }
+            slot = (slot + 1) & mask_;
+        }
+        slots_[slot] = {keys[i], (int64_t)i};
+    }
+    size_ = keys.size();
+
+    LOG_DEBUG("[IntIndexer] mapped {} keys in {} slots", size_, slots_.size());
+}
+
+void IntIndexer::get_indexer(
+    tcb::span<const int64_t> keys, tcb::span<int64_t> positions) const {
+    if (keys.size() != positions.size()) {
+        throw TileDBSOMAError(fmt::format(
+            "[IntIndexer] get_indexer: {} keys but {} positions",
+            keys.size(),
+            positions.size()));
+    }
+
+    size_t num_chunks = std::clamp<size_t>(
+        keys.size() / MIN_KEYS_PER_THREAD, 1, num_threads_);
+    auto lookup_chunk = [&](size_t c) {
+        auto begin = keys.size() * c / num_chunks;
+        auto end = keys.size() * (c + 1) / num_chunks;
+        for (auto i = begin; i < end; i++) {
+            positions[i] = lookup(keys[i]);
+        }
+    };
+
+    if (num_chunks == 1) {
+        lookup_chunk(0);
+        return;
+    }
+    util::parallel_for(*pool_, num_chunks, lookup_chunk);
+}
+
+std::vector<int64_t> IntIndexer::get_indexer(
+    tcb::span<const int64_t> keys) const {
+    std::vector<int64_t> positions(keys.size());
+    get_indexer(keys, positions);
+    return positions;
+}
+
+}  // namespace tiledbsoma
@@ -33,6 +33,11 @@
 
 #include "logger.h"
 
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+
 #include <spdlog/fmt/fmt.h>
 #include <spdlog/fmt/ostr.h>
 #include <spdlog/sinks/basic_file_sink.h>
@@ -165,6 +170,10 @@ bool Logger::debug_enabled() {
     return (level_ == spdlog::level::debug) || (level_ == spdlog::level::trace);
 }
 
+bool Logger::enabled(spdlog::level::level_enum level) {
+    return level >= level_;
+}
+
 /* ********************************* */
 /*              GLOBAL               */
 /* ********************************* */
@@ -199,6 +208,11 @@ bool LOG_DEBUG_ENABLED() {
     return global_logger().debug_enabled();
 }
 
+/** Check if global logger is logging messages of the level. */
+bool LOG_ENABLED(spdlog::level::level_enum level) {
+    return global_logger().enabled(level);
+}
+
 /** Logs a trace message. */
 void LOG_TRACE(const std::string& msg) {
     global_logger().trace(msg.c_str());
@@ -232,6 +246,119 @@ void LOG_FATAL(const std::string& msg) {
 #endif
 }
 
+/* ********************************* */
+/*              TRACING              */
+/* ********************************* */
+
+namespace {
+
+/** Trace file receiving the spans, in the Chrome trace event format. */
+struct Tracer {
+    // True while spans are recorded, checked without holding the lock
+    std::atomic<bool> enabled{false};
+
+    // Mutex protecting the trace file
+    std::mutex mtx;
+
+    // Trace file, a JSON array of complete ("X") events
+    std::ofstream file;
+
+    // Number of events written to the trace file
+    uint64_t num_events = 0;
+};
+
+Tracer& global_tracer() {
+    static Tracer t;
+    return t;
+}
+
+/** Return microseconds of a monotonic clock, the trace time base. */
+int64_t trace_now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/** Escape a string for a JSON string value. */
+std::string json_escape(std::string_view value) {
+    std::string result;
+    result.reserve(value.size());
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            result += fmt::format("\\u{:04x}", static_cast<int>(c));
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+/** Start recording trace spans to a trace file. */
+void TRACE_START(const std::string& tracefile) {
+    auto& tracer = global_tracer();
+    std::lock_guard<std::mutex> lock(tracer.mtx);
+    if (tracer.file.is_open()) {
+        LOG_WARN("Already recording trace spans to another file");
+        return;
+    }
+    tracer.file.open(tracefile, std::ios::out | std::ios::trunc);
+    if (!tracer.file) {
+        LOG_ERROR("Cannot open trace file '{}'", tracefile);
+        return;
+    }
+    tracer.file << "[\n";
+    tracer.num_events = 0;
+    tracer.enabled = true;
+}
+
+/** Stop recording trace spans and close the trace file. */
+void TRACE_STOP() {
+    auto& tracer = global_tracer();
+    std::lock_guard<std::mutex> lock(tracer.mtx);
+    tracer.enabled = false;
+    if (tracer.file.is_open()) {
+        tracer.file << "\n]\n";
+        tracer.file.close();
+    }
+}
+
+/** Check if trace spans are recorded. */
+bool TRACE_ENABLED() {
+    return global_tracer().enabled.load(std::memory_order_relaxed);
+}
+
+void TraceSpan::start() {
+    start_us_ = trace_now_us();
+}
+
+void TraceSpan::end() {
+    auto end_us = trace_now_us();
+    auto event = fmt::format(
+        R"({{"name":"{}","cat":"tiledbsoma","ph":"X","ts":{},"dur":{},)"
+        R"("pid":{},"tid":{},"args":{{"detail":"{}"}}}})",
+        json_escape(name_),
+        start_us_,
+        end_us - start_us_,
+        spdlog::details::os::pid(),
+        spdlog::details::os::thread_id(),
+        json_escape(detail_));
+
+    // Spans ending after TRACE_STOP are dropped
+    auto& tracer = global_tracer();
+    std::lock_guard<std::mutex> lock(tracer.mtx);
+    if (tracer.file.is_open()) {
+        if (tracer.num_events++ > 0) {
+            tracer.file << ",\n";
+        }
+        tracer.file << event;
+    }
+}
+
 /** Convert TileDB timestamp (in ms) to human readable timestamp. */
 std::string asc_timestamp(uint64_t timestamp_ms) {
     auto time_sec = static_cast<time_t>(timestamp_ms) / 1000;
@@ -224,6 +224,13 @@ class Logger {
      */
     bool debug_enabled();
 
+    /**
+     * Return true if messages of the level are enabled.
+     *
+     * @param level spdlog level
+     */
+    bool enabled(spdlog::level::level_enum level);
+
    private:
     /* ********************************* */
     /*         PRIVATE ATTRIBUTES        */
@@ -30,6 +30,8 @@
  * This file defines the performing TileDB queries.
  */
 
+#include <thread>
+
 #include "tiledbsoma/managed_query.h"
 #include "tiledbsoma/common.h"
 #include "tiledbsoma/logger_public.h"
@@ -46,10 +48,71 @@ ManagedQuery::ManagedQuery(std::shared_ptr<Array> array, std::string_view name)
     : array_(array)
     , name_(name)
     , schema_(std::make_shared<ArraySchema>(array->schema())) {
+    auto config = schema_->context().config();
+    if (config.contains(CONFIG_KEY_BUDGET_BYTES)) {
+        auto value_str = config.get(CONFIG_KEY_BUDGET_BYTES);
+        try {
+            budget_bytes_ = std::stoull(value_str);
+        } catch (const std::exception& e) {
+            throw TileDBSOMAError(fmt::format(
+                "[ManagedQuery] Error parsing {}: '{}' ({})",
+                CONFIG_KEY_BUDGET_BYTES,
+                value_str,
+                e.what()));
+        }
+    }
+
+    if (config.contains(CONFIG_KEY_COALESCE_POINTS)) {
+        auto value = config.get(CONFIG_KEY_COALESCE_POINTS);
+        if (value == "true") {
+            coalesce_points_ = true;
+        } else if (value != "false") {
+            throw TileDBSOMAError(fmt::format(
+                "[ManagedQuery] Error parsing {}: '{}' (expected 'true' or "
+                "'false')",
+                CONFIG_KEY_COALESCE_POINTS,
+                value));
+        }
+    }
+    if (config.contains(CONFIG_KEY_DENSE_EXACT)) {
+        auto value = config.get(CONFIG_KEY_DENSE_EXACT);
+        if (value == "false") {
+            dense_exact_ = false;
+        } else if (value != "true") {
+            throw TileDBSOMAError(fmt::format(
+                "[ManagedQuery] Error parsing {}: '{}' (expected 'true' or "
+                "'false')",
+                CONFIG_KEY_DENSE_EXACT,
+                value));
+        }
+    }
+
+    if (config.contains(CONFIG_KEY_SMALL_OFFSETS)) {
+        auto value = config.get(CONFIG_KEY_SMALL_OFFSETS);
+        if (value == "true") {
+            small_offsets_ = true;
+        } else if (value != "false") {
+            throw TileDBSOMAError(fmt::format(
+                "[ManagedQuery] Error parsing {}: '{}' (expected 'true' or "
+                "'false')",
+                CONFIG_KEY_SMALL_OFFSETS,
+                value));
+        }
+    }
+
+    pool_ = BufferPool::shared(schema_->context());
+    init_bytes_ = ColumnBuffer::init_bytes(config);
+
     reset();
 }
 
 void ManagedQuery::reset() {
+    // Wait for an in-flight query to complete before replacing it
+    if (query_future_.valid()) {
+        query_future_.wait();
+        query_future_ = {};
+    }
+
     query_ = std::make_unique<Query>(schema_->context(), *array_);
     subarray_ = std::make_unique<Subarray>(schema_->context(), *array_);
 
@@ -62,12 +125,28 @@ void ManagedQuery::reset() {
     subarray_range_set_ = false;
     subarray_range_empty_ = true;
     columns_.clear();
+    dictionary_columns_.clear();
     results_complete_ = true;
     total_num_cells_ = 0;
     buffers_.reset();
+    reservation_.reset();
+    buffer_plan_.clear();
     query_submitted_ = false;
 }
 
+void ManagedQuery::set_array(std::shared_ptr<Array> array) {
+    // Complete an in-flight query on the current array before replacing it
+    if (query_future_.valid()) {
+        query_future_.wait();
+        query_future_ = {};
+    }
+
+    // The schema may differ at the new timestamp
+    array_ = array;
+    schema_ = std::make_shared<ArraySchema>(array->schema());
+    reset();
+}
+
 void ManagedQuery::select_columns(
     const std::vector<std::string>& names, bool if_not_empty) {
     // Return if we are selecting all columns (columns_ is empty) and we want to
@@ -80,16 +159,61 @@ void ManagedQuery::select_columns(
         // Name is not an attribute or dimension.
         if (!schema_->has_attribute(name) &&
             !schema_->domain().has_dimension(name)) {
-            LOG_WARN(fmt::format(
+            LOG_WARN(
                 "[TileDB-SOMA::ManagedQuery] [{}] Invalid column selected: {}",
                 name_,
-                name));
+                name);
         } else {
             columns_.push_back(name);
         }
     }
 }
 
+void ManagedQuery::set_dictionary_columns(
+    const std::vector<std::string>& names) {
+    for (auto& name : names) {
+        bool is_var;
+        if (schema_->has_attribute(name)) {
+            is_var = schema_->attribute(name).cell_val_num() == TILEDB_VAR_NUM;
+        } else if (schema_->domain().has_dimension(name)) {
+            auto dim = schema_->domain().dimension(name);
+            is_var = dim.cell_val_num() == TILEDB_VAR_NUM ||
+                     dim.type() == TILEDB_STRING_ASCII ||
+                     dim.type() == TILEDB_STRING_UTF8;
+        } else {
+            throw TileDBSOMAError(fmt::format(
+                "[ManagedQuery] [{}] Invalid dictionary column: {}",
+                name_,
+                name));
+        }
+        if (!is_var) {
+            throw TileDBSOMAError(fmt::format(
+                "[ManagedQuery] [{}] Dictionary column is not variable "
+                "length: {}",
+                name_,
+                name));
+        }
+        dictionary_columns_.insert(name);
+    }
+}
+
+void ManagedQuery::select_points(
+    const std::string& dim, tcb::span<const std::string_view> points) {
+    subarray_range_set_ = true;
+    auto& ctx = schema_->context();
+    for (auto& point : points) {
+        ctx.handle_error(tiledb_subarray_add_range_var_by_name(
+            ctx.ptr().get(),
+            subarray_->ptr().get(),
+            dim.c_str(),
+            point.data(),
+            point.size(),
+            point.data(),
+            point.size()));
+        subarray_range_empty_ = false;
+    }
+}
+
 void ManagedQuery::submit() {
     // Throw error if submit is called again before reading the results
     if (query_submitted_) {
@@ -104,26 +228,19 @@ void ManagedQuery::submit() {
         return;
     }
 
-    // If the query is uninitialized, set the subarray for the query
+    // If the query is uninitialized, set the subarray for the query. The
+    // first submit of a dense query allocates buffers for all cells of the
+    // subarray.
+    std::optional<uint64_t> dense_cells;
     if (status == Query::Status::UNINITIALIZED) {
-        // Dense array must have a subarray set. If the array is dense and no
-        // ranges have been set, add a range for the array's entire non-empty
-        // domain on dimension 0.
-        if (array_->schema().array_type() == TILEDB_DENSE &&
-            !subarray_range_set_) {
-            auto non_empty_domain = array_->non_empty_domain<int64_t>(0);
-            subarray_->add_range(
-                0, non_empty_domain.first, non_empty_domain.second);
-
-            LOG_DEBUG(fmt::format(
-                "[ManagedQuery] Add full NED range to dense subarray = (0, {}, "
-                "{})",
-                non_empty_domain.first,
-                non_empty_domain.second));
-        }
+        set_dense_default_range();
 
         // Set the subarray for range slicing
         query_->set_subarray(*subarray_);
+
+        if (dense_exact_ && !is_empty_query()) {
+            dense_cells = dense_num_cells();
+        }
     }
 
     // If no columns were selected, select all columns.
@@ -138,26 +255,311 @@ void ManagedQuery::submit() {
         }
     }
 
+    // Size the fixed size columns of a dense query exactly, unless the
+    // buffers would exceed the budget
+    std::unordered_map<std::string, size_t> exact_bytes;
+    size_t exact_total_bytes = 0;
+    if (dense_cells) {
+        for (auto& name : columns_) {
+            if (auto cell_bytes = fixed_cell_bytes(name)) {
+                exact_bytes[name] = *dense_cells * *cell_bytes;
+                exact_total_bytes += exact_bytes[name];
+            }
+        }
+        if (budget_bytes_ && exact_total_bytes > *budget_bytes_) {
+            exact_bytes.clear();
+        }
+        LOG_DEBUG(
+            "[ManagedQuery] [{}] Dense subarray cells={} exact columns={} "
+            "bytes={}",
+            name_,
+            *dense_cells,
+            exact_bytes.size(),
+            exact_total_bytes);
+    }
+
+    // Release the buffers of the previous submit, unless they are still
+    // used by the caller, before reserving memory for the new buffers. If
+    // the caller holds them (for example, while the next batch is
+    // prefetched), waiting for memory could wait on this query itself.
+    buffers_.reset();
+    bool wait = !reservation_ || reservation_.use_count() == 1;
+    reservation_.reset();
+
+    // Split the budget across the columns once per query, since the size
+    // estimates depend only on the subarray. Plan again if the reservation
+    // changes the budget of this submit.
+    auto plan = [&](size_t budget_bytes) {
+        if (!is_empty_query() &&
+            (buffer_plan_.empty() || planned_bytes_ != budget_bytes)) {
+            plan_buffers(budget_bytes);
+        }
+    };
+    if (budget_bytes_) {
+        plan(*budget_bytes_);
+    }
+
+    // Size the buffer of each column: (data bytes, cells, small offsets).
+    // With the memory governor, also compute the bytes the buffers allocate.
+    auto& governor = MemoryGovernor::instance();
+    bool governed = governor.enabled() && !is_empty_query();
+    std::vector<std::tuple<std::optional<size_t>, std::optional<size_t>, bool>>
+        sizes;
+    size_t total_bytes = 0;
+    auto size_columns = [&]() {
+        sizes.clear();
+        total_bytes = 0;
+        for (auto& name : columns_) {
+            std::optional<size_t> num_bytes;
+            std::optional<size_t> num_cells;
+            if (auto it = buffer_plan_.find(name); it != buffer_plan_.end()) {
+                num_cells = it->second.first;
+                num_bytes = it->second.second;
+            }
+            if (auto it = column_bytes_.find(name); it != column_bytes_.end()) {
+                num_bytes = std::max(num_bytes.value_or(0), it->second);
+            }
+            if (auto it = exact_bytes.find(name); it != exact_bytes.end()) {
+                num_cells = *dense_cells;
+                num_bytes = it->second;
+            }
+            // Cap the data of columns exported with 32-bit offsets
+            bool small_offsets = small_offsets_ && !fixed_cell_bytes(name);
+            if (small_offsets) {
+                num_bytes = std::min(
+                    num_bytes.value_or(init_bytes_),
+                    ColumnBuffer::MAX_SMALL_OFFSETS_BYTES);
+            }
+            sizes.emplace_back(num_bytes, num_cells, small_offsets);
+            if (governed) {
+                total_bytes += ColumnBuffer::alloc_bytes(
+                    array_, name, num_bytes.value_or(init_bytes_), num_cells);
+            }
+        }
+    };
+    size_columns();
+
+    // Reserve memory for the data, offsets and validity of the buffers from
+    // the memory governor before allocating them. If the governor grants
+    // fewer bytes than requested, the buffers are planned to fit the
+    // reservation, so the submit reads fewer cells.
+    if (governed) {
+        reservation_ = governor.reserve(
+            total_bytes,
+            std::min(total_bytes, MemoryGovernor::MIN_RESERVATION_BYTES),
+            wait);
+        if (reservation_->bytes() < total_bytes) {
+            exact_bytes.clear();
+            plan(reservation_->bytes());
+            size_columns();
+            std::lock_guard<std::mutex> lock(metrics_mtx_);
+            metrics_.num_memory_shrinks++;
+        }
+        // Buffers grown for large cells may still exceed the reservation.
+        // A submit that must not wait over-commits the budget for them.
+        reservation_->resize(total_bytes, wait);
+    }
+
     // Allocate and attach buffers
     LOG_TRACE("[ManagedQuery] allocate new buffers");
     buffers_ = std::make_shared<ArrayBuffers>();
-    for (auto& name : columns_) {
-        LOG_DEBUG(fmt::format(
-            "[ManagedQuery] [{}] Adding buffer for column '{}'", name_, name));
-        buffers_->emplace(name, ColumnBuffer::create(array_, name));
+    for (size_t i = 0; i < columns_.size(); i++) {
+        auto& name = columns_[i];
+        auto [num_bytes, num_cells, small_offsets] = sizes[i];
+        LOG_DEBUG(
+            "[ManagedQuery] [{}] Adding buffer for column '{}'", name_, name);
+        buffers_->emplace(
+            name,
+            ColumnBuffer::create(array_, name, num_bytes, num_cells, pool_));
         buffers_->at(name)->attach(*query_);
+        buffers_->at(name)->set_reservation(reservation_);
+        if (dictionary_columns_.count(name)) {
+            buffers_->at(name)->set_dictionary_encoded(true);
+        }
+        if (small_offsets) {
+            buffers_->at(name)->set_small_offsets(true);
+        }
     }
+    update_reservation(wait);
 
     // Submit query
-    LOG_DEBUG(fmt::format("[ManagedQuery] [{}] Submit query", name_));
+    LOG_DEBUG("[ManagedQuery] [{}] Submit query", name_);
 
     // Do not submit if the query contains only empty ranges
     if (!is_empty_query()) {
-        query_->submit();
+        {
+            std::lock_guard<std::mutex> lock(metrics_mtx_);
+            metrics_.num_submits++;
+        }
+        submit_seconds_ = 0;
+
+        // Submit the query in the background. The future is used to wait for
+        // the query to complete, without polling the query status. The submit
+        // time is measured inside the task, so time the caller spends before
+        // calling results() (e.g. with a prefetched query) is not counted.
+        query_future_ = submit_pool().execute([this]() {
+            TraceSpan span("submit", "{}", name_);
+            auto start = std::chrono::steady_clock::now();
+            query_->submit();
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+            submit_seconds_ = elapsed.count();
+            return Status::Ok();
+        });
     }
     query_submitted_ = true;
 }
 
+uint64_t ManagedQuery::read_into(
+    const std::string& name, void* data, uint64_t num_bytes) {
+    if (query_submitted_ ||
+        query_->query_status() != Query::Status::UNINITIALIZED) {
+        throw TileDBSOMAError(fmt::format(
+            "[ManagedQuery][{}] read_into must be the only read of the query",
+            name_));
+    }
+    if (array_->schema().array_type() != TILEDB_DENSE) {
+        throw TileDBSOMAError(fmt::format(
+            "[ManagedQuery][{}] read_into requires a dense array", name_));
+    }
+
+    auto cell_bytes = fixed_cell_bytes(name);
+    bool nullable = schema_->has_attribute(name) &&
+                    schema_->attribute(name).nullable();
+    if (!cell_bytes || nullable) {
+        throw TileDBSOMAError(fmt::format(
+            "[ManagedQuery][{}] read_into requires a fixed size, non-nullable "
+            "column: '{}'",
+            name_,
+            name));
+    }
+
+    set_dense_default_range();
+    query_->set_subarray(*subarray_);
+
+    if (is_empty_query()) {
+        return 0;
+    }
+
+    // Check the buffer holds all cells, rather than reading some of them
+    auto num_cells = dense_num_cells();
+    if (num_cells && *num_cells * *cell_bytes > num_bytes) {
+        throw TileDBSOMAError(fmt::format(
+            "[ManagedQuery][{}] read_into: buffer of {} bytes cannot hold {} "
+            "cells of column '{}'",
+            name_,
+            num_bytes,
+            *num_cells,
+            name));
+    }
+
+    auto type_bytes = tiledb::impl::type_size(
+        schema_->has_attribute(name) ?
+            schema_->attribute(name).type() :
+            schema_->domain().dimension(name).type());
+    query_->set_data_buffer(name, data, num_bytes / type_bytes);
+
+    LOG_DEBUG(
+        "[ManagedQuery] [{}] Submit query into caller buffer for column '{}'",
+        name_,
+        name);
+    auto start = std::chrono::steady_clock::now();
+    query_->submit();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() -
+                                            start;
+
+    auto status = query_->query_status();
+    if (status == Query::Status::FAILED) {
+        throw TileDBSOMAError(
+            fmt::format("[ManagedQuery] [{}] Query FAILED", name_));
+    }
+    if (status == Query::Status::INCOMPLETE) {
+        throw TileDBSOMAError(fmt::format(
+            "[ManagedQuery] [{}] read_into: buffer of {} bytes is too small",
+            name_,
+            num_bytes));
+    }
+
+    auto elements = query_->result_buffer_elements()[name].second;
+    auto cells = elements * type_bytes / *cell_bytes;
+    total_num_cells_ += cells;
+
+    std::lock_guard<std::mutex> lock(metrics_mtx_);
+    metrics_.num_submits++;
+    metrics_.num_batches++;
+    metrics_.num_cells += cells;
+    metrics_.submit_seconds += elapsed.count();
+    auto& column = metrics_.columns[name];
+    column.cells += cells;
+    column.bytes += elements * type_bytes;
+    column.capacity_cells += num_bytes / *cell_bytes;
+    column.capacity_bytes += num_bytes;
+    return cells;
+}
+
+std::optional<uint64_t> ManagedQuery::dense_num_cells() {
+    if (array_->schema().array_type() != TILEDB_DENSE) {
+        return std::nullopt;
+    }
+
+    set_dense_default_range();
+
+    uint64_t num_cells = 1;
+    auto domain = schema_->domain();
+    for (unsigned i = 0; i < domain.ndim(); i++) {
+        // Sum the widths of the ranges on the dimension, which default to
+        // the dimension domain
+        std::optional<uint64_t> width = 0;
+        auto sum_widths = [&](auto tag) {
+            using T = decltype(tag);
+            for (uint64_t r = 0; r < subarray_->range_num(i); r++) {
+                auto range = subarray_->range<T>(i, r);
+                uint64_t w = (uint64_t)range[1] - (uint64_t)range[0] + 1;
+                if (w == 0 || *width + w < *width) {
+                    width = std::nullopt;
+                    return;
+                }
+                *width += w;
+            }
+        };
+        switch (domain.dimension(i).type()) {
+            case TILEDB_INT8:
+                sum_widths(int8_t{});
+                break;
+            case TILEDB_UINT8:
+                sum_widths(uint8_t{});
+                break;
+            case TILEDB_INT16:
+                sum_widths(int16_t{});
+                break;
+            case TILEDB_UINT16:
+                sum_widths(uint16_t{});
+                break;
+            case TILEDB_INT32:
+                sum_widths(int32_t{});
+                break;
+            case TILEDB_UINT32:
+                sum_widths(uint32_t{});
+                break;
+            case TILEDB_INT64:
+                sum_widths(int64_t{});
+                break;
+            case TILEDB_UINT64:
+                sum_widths(uint64_t{});
+                break;
+            default:
+                return std::nullopt;
+        }
+
+        // Give up if the number of cells overflows
+        if (!width || (*width && num_cells > UINT64_MAX / *width)) {
+            return std::nullopt;
+        }
+        num_cells *= *width;
+    }
+    return num_cells;
+}
+
 std::shared_ptr<ArrayBuffers> ManagedQuery::results() {
     if (is_empty_query()) {
         query_submitted_ = false;
@@ -170,14 +572,20 @@ std::shared_ptr<ArrayBuffers> ManagedQuery::results() {
     }
     query_submitted_ = false;
 
-    // Poll status until query is not INPROGRESS
-    Query::Status status;
-    do {
-        status = query_->query_status();
-    } while (status == Query::Status::INPROGRESS);
+    // Block until the query completes, rethrowing any error from the query
+    if (query_future_.valid()) {
+        TraceSpan span("wait", "{}", name_);
+        try {
+            query_future_.get();
+        } catch (const std::exception& e) {
+            throw TileDBSOMAError(fmt::format(
+                "[ManagedQuery] [{}] Query error: {}", name_, e.what()));
+        }
+    }
+
+    auto status = query_->query_status();
 
-    LOG_DEBUG(fmt::format(
-        "[ManagedQuery] [{}] Query status = {}", name_, (int)status));
+    LOG_DEBUG("[ManagedQuery] [{}] Query status = {}", name_, (int)status);
 
     if (status == Query::Status::FAILED) {
         throw TileDBSOMAError(
@@ -188,24 +596,269 @@ std::shared_ptr<ArrayBuffers> ManagedQuery::results() {
     // complete.
     if (status == Query::Status::INCOMPLETE) {
         results_complete_ = false;
+        std::lock_guard<std::mutex> lock(metrics_mtx_);
+        metrics_.num_incomplete++;
     }
 
     // Update ColumnBuffer size to match query results
+    size_t num_cells = update_buffer_sizes();
+
+    // If the query is incomplete and no cells were read, the buffers are too
+    // small to hold a single cell. Grow the buffers and resubmit the query.
+    for (int retry = 0; status == Query::Status::INCOMPLETE && !num_cells;
+         retry++) {
+        if (retry == MAX_BUFFER_GROWTH_RETRIES) {
+            throw TileDBSOMAError(fmt::format(
+                "[ManagedQuery] [{}] Buffers are too small.", name_));
+        }
+
+        grow_buffers();
+
+        LOG_DEBUG(
+            "[ManagedQuery] [{}] Resubmit query with larger buffers", name_);
+        {
+            TraceSpan span("submit", "{}", name_);
+            auto start = std::chrono::steady_clock::now();
+            query_->submit();
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+            submit_seconds_ += elapsed.count();
+        }
+        status = query_->query_status();
+        {
+            std::lock_guard<std::mutex> lock(metrics_mtx_);
+            metrics_.num_submits++;
+            metrics_.num_resubmits++;
+            if (status == Query::Status::INCOMPLETE) {
+                metrics_.num_incomplete++;
+            }
+        }
+
+        if (status == Query::Status::FAILED) {
+            throw TileDBSOMAError(
+                fmt::format("[ManagedQuery] [{}] Query FAILED", name_));
+        }
+
+        num_cells = update_buffer_sizes();
+    }
+    total_num_cells_ += num_cells;
+
+    record_metrics(num_cells, submit_seconds_);
+
+    return buffers_;
+}
+
+//===================================================================
+//= private static
+//===================================================================
+
+ThreadPool& ManagedQuery::submit_pool() {
+    // A query has at most one submit in flight, so the submits of up to one
+    // query per hardware thread run concurrently
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+//===================================================================
+//= private non-static
+//===================================================================
+
+void ManagedQuery::set_dense_default_range() {
+    if (array_->schema().array_type() == TILEDB_DENSE &&
+        !subarray_range_set_) {
+        auto non_empty_domain = array_->non_empty_domain<int64_t>(0);
+        subarray_->add_range(
+            0, non_empty_domain.first, non_empty_domain.second);
+        subarray_range_set_ = true;
+        subarray_range_empty_ = false;
+
+        LOG_DEBUG(
+            "[ManagedQuery] Add full NED range to dense subarray = (0, {}, "
+            "{})",
+            non_empty_domain.first,
+            non_empty_domain.second);
+    }
+}
+
+std::optional<size_t> ManagedQuery::fixed_cell_bytes(const std::string& name) {
+    // As in ColumnBuffer::create, string dimensions are variable length
+    tiledb_datatype_t type;
+    uint32_t cell_val_num;
+    bool is_var;
+    if (schema_->has_attribute(name)) {
+        auto attr = schema_->attribute(name);
+        type = attr.type();
+        cell_val_num = attr.cell_val_num();
+        is_var = cell_val_num == TILEDB_VAR_NUM;
+    } else {
+        auto dim = schema_->domain().dimension(name);
+        type = dim.type();
+        cell_val_num = dim.cell_val_num();
+        is_var = cell_val_num == TILEDB_VAR_NUM ||
+                 type == TILEDB_STRING_ASCII || type == TILEDB_STRING_UTF8;
+    }
+    if (is_var) {
+        return std::nullopt;
+    }
+    return tiledb::impl::type_size(type) * cell_val_num;
+}
+
+void ManagedQuery::plan_buffers(size_t budget_bytes) {
+    // Compute the number of bytes per cell for each column
+    std::vector<std::pair<size_t, size_t>> sizes;  // (data bytes, total bytes)
+    size_t cell_bytes = 0;
+    size_t extra_bytes = 0;
+    for (auto& name : columns_) {
+        auto fixed_bytes = fixed_cell_bytes(name);
+        bool is_var = !fixed_bytes;
+        bool is_nullable = schema_->has_attribute(name) &&
+                           schema_->attribute(name).nullable();
+
+        size_t data_bytes = fixed_bytes.value_or(0);
+        if (is_var) {
+            // Estimate the average cell size from the fragment metadata
+            uint64_t offsets_bytes, var_bytes;
+            if (is_nullable) {
+                auto est = query_->est_result_size_var_nullable(name);
+                offsets_bytes = est[0];
+                var_bytes = est[1];
+            } else {
+                auto est = query_->est_result_size_var(name);
+                offsets_bytes = est[0];
+                var_bytes = est[1];
+            }
+            auto est_cells = offsets_bytes / sizeof(uint64_t);
+            data_bytes = est_cells ?
+                             std::max<size_t>(
+                                 (var_bytes + est_cells - 1) / est_cells, 1) :
+                             DEFAULT_VAR_CELL_BYTES;
+        }
+
+        size_t total_bytes = data_bytes + (is_var ? sizeof(uint64_t) : 0) +
+                             (is_nullable ? sizeof(uint8_t) : 0);
+        sizes.emplace_back(data_bytes, total_bytes);
+        cell_bytes += total_bytes;
+        if (is_var) {
+            // Extra offset for Arrow
+            extra_bytes += sizeof(uint64_t);
+        }
+    }
+
+    // Allocate the same number of cells for each column
+    planned_bytes_ = budget_bytes;
+    size_t num_cells = std::max<size_t>(
+        (budget_bytes > extra_bytes ? budget_bytes - extra_bytes : 0) /
+            cell_bytes,
+        1);
+    for (size_t i = 0; i < columns_.size(); i++) {
+        auto num_bytes = num_cells * sizes[i].first;
+        buffer_plan_[columns_[i]] = {num_cells, num_bytes};
+        LOG_DEBUG(
+            "[ManagedQuery] [{}] Plan buffer {} cells={} bytes={}",
+            name_,
+            columns_[i],
+            num_cells,
+            num_bytes);
+    }
+}
+
+void ManagedQuery::record_metrics(size_t num_cells, double seconds) {
+    std::lock_guard<std::mutex> lock(metrics_mtx_);
+    metrics_.num_batches++;
+    metrics_.num_cells += num_cells;
+    metrics_.submit_seconds += seconds;
+    for (auto& name : buffers_->names()) {
+        auto buffer = buffers_->at(name);
+        auto& column = metrics_.columns[name];
+        column.cells += buffer->size();
+        column.bytes += buffer->data_size();
+        column.capacity_cells += buffer->max_num_cells();
+        column.capacity_bytes += buffer->capacity();
+    }
+}
+
+size_t ManagedQuery::update_buffer_sizes() {
     size_t num_cells = 0;
     for (auto& name : buffers_->names()) {
         num_cells = buffers_->at(name)->update_size(*query_);
-        LOG_DEBUG(fmt::format(
-            "[ManagedQuery] [{}] Buffer {} cells={}", name_, name, num_cells));
+        LOG_DEBUG(
+            "[ManagedQuery] [{}] Buffer {} cells={}", name_, name, num_cells);
     }
-    total_num_cells_ += num_cells;
+    return num_cells;
+}
 
-    // TODO: retry the query with larger buffers
-    if (status == Query::Status::INCOMPLETE && !num_cells) {
-        throw TileDBSOMAError(
-            fmt::format("[ManagedQuery] [{}] Buffers are too small.", name_));
+std::pair<uint32_t, tiledb_datatype_t> ManagedQuery::dimension_info(
+    const std::string& dim) {
+    auto dimensions = schema_->domain().dimensions();
+    for (uint32_t i = 0; i < dimensions.size(); i++) {
+        if (dimensions[i].name() == dim) {
+            return {i, dimensions[i].type()};
+        }
     }
+    throw TileDBSOMAError(fmt::format(
+        "[ManagedQuery] [{}] Dimension '{}' not found", name_, dim));
+}
 
-    return buffers_;
+void ManagedQuery::grow_buffers() {
+    std::vector<std::string> names;
+    for (auto& name : buffers_->names()) {
+        if (buffers_->at(name)->is_var()) {
+            names.push_back(name);
+        }
+    }
+    if (names.empty()) {
+        names = buffers_->names();
+    }
+
+    // Columns exported with 32-bit offsets, which cannot grow further
+    std::vector<std::string> capped;
+    for (auto& name : names) {
+        auto buffer = buffers_->at(name);
+        auto num_bytes = std::max<size_t>(buffer->capacity(), 1) * 2;
+        if (buffer->has_small_offsets()) {
+            num_bytes = std::min(
+                num_bytes, ColumnBuffer::MAX_SMALL_OFFSETS_BYTES);
+            if (num_bytes <= buffer->capacity()) {
+                capped.push_back(name);
+                continue;
+            }
+        }
+        LOG_DEBUG(
+            "[ManagedQuery] [{}] Grow buffer {} to {} bytes",
+            name_,
+            name,
+            num_bytes);
+        // Reserve the grown buffer before allocating it
+        if (reservation_) {
+            reservation_->resize(
+                reservation_->bytes() - buffer->allocated_bytes() +
+                ColumnBuffer::alloc_bytes(array_, name, num_bytes));
+        }
+        buffer->grow(num_bytes);
+        buffer->attach(*query_);
+        column_bytes_[name] = num_bytes;
+    }
+    if (!capped.empty() && capped.size() == names.size()) {
+        throw TileDBSOMAError(fmt::format(
+            "[ManagedQuery] [{}] A cell of column '{}' does not fit in {} "
+            "bytes; unset {} to read it",
+            name_,
+            capped[0],
+            ColumnBuffer::MAX_SMALL_OFFSETS_BYTES,
+            CONFIG_KEY_SMALL_OFFSETS));
+    }
+    update_reservation();
+}
+
+void ManagedQuery::update_reservation(bool wait) {
+    if (!reservation_) {
+        return;
+    }
+    size_t num_bytes = 0;
+    for (auto& name : buffers_->names()) {
+        num_bytes += buffers_->at(name)->allocated_bytes();
+    }
+    reservation_->resize(num_bytes, wait);
 }
 
 };  // namespace tiledbsoma
@@ -0,0 +1,235 @@
+/**
+ * @file   memory_governor.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines the process-wide memory governor.
+ */
+
+#include <chrono>
+
+#include "tiledbsoma/common.h"
+#include "tiledbsoma/logger_public.h"
+#include "tiledbsoma/memory_governor.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+//===================================================================
+//= public static
+//===================================================================
+
+MemoryGovernor& MemoryGovernor::instance() {
+    // The governor is intentionally leaked, so buffers released after the
+    // static objects are destroyed (for example, by Python finalization)
+    // can still return their reservations.
+    static MemoryGovernor* governor = new MemoryGovernor();
+    return *governor;
+}
+
+//===================================================================
+//= public non-static
+//===================================================================
+
+void MemoryGovernor::Reservation::resize(size_t num_bytes, bool wait) {
+    if (num_bytes > num_bytes_) {
+        governor_.add(num_bytes - num_bytes_, wait);
+    } else if (num_bytes < num_bytes_) {
+        governor_.release(num_bytes_ - num_bytes);
+    }
+    num_bytes_ = num_bytes;
+}
+
+void MemoryGovernor::configure(const Config& config) {
+    auto parse = [&](const std::string& key) {
+        auto value_str = config.get(key);
+        try {
+            return std::stoull(value_str);
+        } catch (const std::exception& e) {
+            throw TileDBSOMAError(fmt::format(
+                "[MemoryGovernor] Error parsing {}: '{}' ({})",
+                key,
+                value_str,
+                e.what()));
+        }
+    };
+
+    if (config.contains(CONFIG_KEY_WAIT_MS)) {
+        set_wait_ms(parse(CONFIG_KEY_WAIT_MS));
+    }
+    if (config.contains(CONFIG_KEY_TOTAL_BUDGET)) {
+        set_budget(parse(CONFIG_KEY_TOTAL_BUDGET));
+    }
+}
+
+void MemoryGovernor::set_budget(size_t budget) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (budget == budget_) {
+            return;
+        }
+        budget_ = budget;
+    }
+    LOG_DEBUG("[MemoryGovernor] budget = {} bytes", budget);
+    cv_.notify_all();
+}
+
+void MemoryGovernor::set_wait_ms(uint64_t wait_ms) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    wait_ms_ = wait_ms;
+}
+
+bool MemoryGovernor::enabled() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return budget_ > 0;
+}
+
+std::shared_ptr<MemoryGovernor::Reservation> MemoryGovernor::reserve(
+    size_t num_bytes, size_t min_bytes, bool wait) {
+    min_bytes = std::min(min_bytes, num_bytes);
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    auto available = [&]() {
+        return budget_ > stats_.reserved_bytes ?
+                   budget_ - stats_.reserved_bytes :
+                   0;
+    };
+    auto grant = [&](size_t bytes) {
+        stats_.reserved_bytes += bytes;
+        stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.reserved_bytes);
+        return std::make_shared<Reservation>(*this, bytes);
+    };
+
+    if (budget_ == 0 || available() >= num_bytes) {
+        return grant(num_bytes);
+    }
+
+    if (available() < min_bytes && !wait) {
+        stats_.num_overcommits++;
+        LOG_DEBUG(
+            "[MemoryGovernor] over-commit {} bytes, reserved {} of {} bytes",
+            min_bytes,
+            stats_.reserved_bytes,
+            budget_);
+        return grant(min_bytes);
+    }
+
+    // Wait until the remaining budget holds the smallest reservation
+    if (available() < min_bytes) {
+        stats_.num_waits++;
+        LOG_DEBUG(
+            "[MemoryGovernor] wait for {} bytes, reserved {} of {} bytes",
+            min_bytes,
+            stats_.reserved_bytes,
+            budget_);
+        bool ready = cv_.wait_for(
+            lock, std::chrono::milliseconds(wait_ms_), [&]() {
+                return budget_ == 0 || available() >= min_bytes;
+            });
+        if (!ready) {
+            stats_.num_overcommits++;
+            LOG_WARN(
+                "[MemoryGovernor] over-commit {} bytes after waiting {} ms, "
+                "reserved {} of {} bytes",
+                min_bytes,
+                wait_ms_,
+                stats_.reserved_bytes,
+                budget_);
+            return grant(min_bytes);
+        }
+        if (budget_ == 0 || available() >= num_bytes) {
+            return grant(num_bytes);
+        }
+    }
+
+    // Shrink the reservation to the remaining budget
+    stats_.num_shrinks++;
+    auto bytes = available();
+    LOG_DEBUG(
+        "[MemoryGovernor] shrink reservation from {} to {} bytes",
+        num_bytes,
+        bytes);
+    return grant(bytes);
+}
+
+MemoryGovernor::Stats MemoryGovernor::stats() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto stats = stats_;
+    stats.budget = budget_;
+    return stats;
+}
+
+//===================================================================
+//= private non-static
+//===================================================================
+
+void MemoryGovernor::add(size_t num_bytes, bool wait) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    auto fits = [&]() {
+        return budget_ == 0 || stats_.reserved_bytes + num_bytes <= budget_;
+    };
+    if (!fits() && !wait) {
+        stats_.num_overcommits++;
+        LOG_DEBUG(
+            "[MemoryGovernor] over-commit growth by {} bytes, reserved {} of "
+            "{} bytes",
+            num_bytes,
+            stats_.reserved_bytes,
+            budget_);
+    } else if (!fits()) {
+        stats_.num_waits++;
+        LOG_DEBUG(
+            "[MemoryGovernor] wait to grow by {} bytes, reserved {} of {} "
+            "bytes",
+            num_bytes,
+            stats_.reserved_bytes,
+            budget_);
+        if (!cv_.wait_for(lock, std::chrono::milliseconds(wait_ms_), fits)) {
+            throw TileDBSOMAError(fmt::format(
+                "[MemoryGovernor] Cannot grow a reservation by {} bytes "
+                "within {} ms: reserved {} of {} bytes; increase {}",
+                num_bytes,
+                wait_ms_,
+                stats_.reserved_bytes,
+                budget_,
+                CONFIG_KEY_TOTAL_BUDGET));
+        }
+    }
+    stats_.reserved_bytes += num_bytes;
+    stats_.peak_bytes = std::max(stats_.peak_bytes, stats_.reserved_bytes);
+}
+
+void MemoryGovernor::release(size_t num_bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stats_.reserved_bytes -= std::min(num_bytes, stats_.reserved_bytes);
+    }
+    cv_.notify_all();
+}
+
+}  // namespace tiledbsoma
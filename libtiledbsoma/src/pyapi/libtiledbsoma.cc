@@ -55,6 +55,20 @@ using namespace py::literals;
 
 namespace tiledbsoma {
 
+/**
+ * @brief pyarrow callables, imported once when the module is initialized.
+ * The instance is intentionally leaked, so the Python objects are not
+ * released after the interpreter is finalized.
+ */
+struct PyArrow {
+    py::object array_import;
+    py::object record_batch_import;
+    py::object record_batch_reader_import;
+    py::object table_from_batches;
+};
+
+PyArrow* pyarrow = nullptr;
+
 /**
  * @brief Convert ColumnBuffer to Arrow array.
  *
@@ -62,33 +76,247 @@ namespace tiledbsoma {
  * @return py::object Arrow array
  */
 py::object to_array(std::shared_ptr<ColumnBuffer> column_buffer) {
-    auto pa = py::module::import("pyarrow");
-    auto pa_array_import = pa.attr("Array").attr("_import_from_c");
-
     auto [array, schema] = ArrowAdapter::to_arrow(column_buffer);
-    return pa_array_import(py::capsule(array.get()), py::capsule(schema.get()));
+    return pyarrow->array_import(
+        py::capsule(array.get()), py::capsule(schema.get()));
 }
 
 /**
- * @brief Convert ArrayBuffers to Arrow table.
+ * @brief Convert ArrayBuffers to Arrow table. The columns are exported as
+ * one struct array and imported with a single call into pyarrow. The schema
+ * template is reused from the previous batch if the columns match.
  *
  * @param cbs ArrayBuffers
+ * @param schema_template Template of the previous batch, updated to the
+ * template of this batch
+ * @param reader If set, the reader recording the Arrow export time
  * @return py::object
  */
-py::object to_table(std::shared_ptr<ArrayBuffers> array_buffers) {
-    auto pa = py::module::import("pyarrow");
-    auto pa_table_from_arrays = pa.attr("Table").attr("from_arrays");
+py::object to_table(
+    std::shared_ptr<ArrayBuffers> array_buffers,
+    std::shared_ptr<const ArrowSchemaTemplate>& schema_template,
+    SOMAReader* reader = nullptr) {
+    ArrowArray array;
+    ArrowSchema schema;
+    auto start = std::chrono::steady_clock::now();
+    ArrowAdapter::to_arrow_struct(array_buffers, &array);
+    schema_template = ArrowAdapter::schema_template(
+        array_buffers, schema_template);
+    ArrowAdapter::to_arrow_schema(schema_template, &schema);
+    if (reader != nullptr) {
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        reader->record_arrow_export(elapsed.count());
+    }
+
+    py::object batch;
+    try {
+        batch = pyarrow->record_batch_import(
+            (uintptr_t)&array, (uintptr_t)&schema);
+    } catch (...) {
+        // Release the array and schema if they were not moved by pyarrow
+        if (array.release != nullptr) {
+            array.release(&array);
+        }
+        if (schema.release != nullptr) {
+            schema.release(&schema);
+        }
+        throw;
+    }
+    return pyarrow->table_from_batches(py::make_tuple(batch));
+}
+
+/**
+ * @brief Convert QueryMetrics to a python dict.
+ *
+ * @param metrics QueryMetrics
+ * @return py::dict
+ */
+py::dict to_dict(const QueryMetrics& metrics) {
+    py::dict columns;
+    for (const auto& [name, column] : metrics.columns) {
+        columns[py::str(name)] = py::dict(
+            "cells"_a = column.cells,
+            "bytes"_a = column.bytes,
+            "capacity_cells"_a = column.capacity_cells,
+            "capacity_bytes"_a = column.capacity_bytes,
+            "utilization"_a = column.utilization());
+    }
+    return py::dict(
+        "num_submits"_a = metrics.num_submits,
+        "num_incomplete"_a = metrics.num_incomplete,
+        "num_resubmits"_a = metrics.num_resubmits,
+        "num_memory_shrinks"_a = metrics.num_memory_shrinks,
+        "num_batches"_a = metrics.num_batches,
+        "num_cells"_a = metrics.num_cells,
+        "submit_seconds"_a = metrics.submit_seconds,
+        "arrow_export_seconds"_a = metrics.arrow_export_seconds,
+        "gil_seconds"_a = metrics.gil_seconds,
+        "columns"_a = columns);
+}
+
+/**
+ * @brief Return the numpy dtype of a TileDB datatype.
+ *
+ * @param type TileDB datatype
+ * @return py::dtype
+ */
+py::dtype to_dtype(tiledb_datatype_t type) {
+    switch (type) {
+        case TILEDB_INT8:
+            return py::dtype::of<int8_t>();
+        case TILEDB_UINT8:
+            return py::dtype::of<uint8_t>();
+        case TILEDB_INT16:
+            return py::dtype::of<int16_t>();
+        case TILEDB_UINT16:
+            return py::dtype::of<uint16_t>();
+        case TILEDB_INT32:
+            return py::dtype::of<int32_t>();
+        case TILEDB_UINT32:
+            return py::dtype::of<uint32_t>();
+        case TILEDB_INT64:
+            return py::dtype::of<int64_t>();
+        case TILEDB_UINT64:
+            return py::dtype::of<uint64_t>();
+        case TILEDB_FLOAT32:
+            return py::dtype::of<float>();
+        case TILEDB_FLOAT64:
+            return py::dtype::of<double>();
+        case TILEDB_BOOL:
+            return py::dtype::of<bool>();
+        default:
+            throw TileDBSOMAError(fmt::format(
+                "[libtiledbsoma] to_dtype: type={} not supported",
+                tiledb::impl::type_to_str(type)));
+    }
+}
+
+/**
+ * @brief Convert a CompressedMatrix to numpy arrays (data, indices, indptr).
+ * The arrays share the buffers of the matrix, which is deleted when all
+ * arrays are deleted.
+ *
+ * @param matrix CompressedMatrix
+ * @return py::tuple
+ */
+py::tuple to_numpy(std::shared_ptr<CompressedMatrix> matrix) {
+    py::capsule owner(
+        new std::shared_ptr<CompressedMatrix>(matrix), [](void* p) {
+            delete static_cast<std::shared_ptr<CompressedMatrix>*>(p);
+        });
+
+    auto data = py::array(
+        to_dtype(matrix->type),
+        {(py::ssize_t)matrix->nnz()},
+        matrix->data.data(),
+        owner);
+    auto indices = py::array_t<int64_t>(
+        matrix->indices.size(), matrix->indices.data(), owner);
+    auto indptr = py::array_t<int64_t>(
+        matrix->indptr.size(), matrix->indptr.data(), owner);
+    return py::make_tuple(data, indices, indptr);
+}
+
+/**
+ * @brief Call `fn` with the values of a numpy array, pyarrow Array or pyarrow
+ * ChunkedArray of int64, one span per chunk. pyarrow arrays are read through
+ * the Arrow C data interface without copying.
+ *
+ * @param values Values
+ * @param fn Function called with the values of each chunk
+ */
+void for_each_int64_chunk(
+    py::handle values,
+    const std::function<void(tcb::span<const int64_t>)>& fn) {
+    if (py::hasattr(values, "chunks")) {
+        for (auto chunk : values.attr("chunks")) {
+            for_each_int64_chunk(chunk, fn);
+        }
+        return;
+    }
+
+    if (py::hasattr(values, "_export_to_c")) {
+        ArrowArray array;
+        ArrowSchema schema;
+        values.attr("_export_to_c")((uintptr_t)&array, (uintptr_t)&schema);
+        auto release = [&]() {
+            array.release(&array);
+            schema.release(&schema);
+        };
+
+        if (std::string_view(schema.format) != "l" ||
+            (array.null_count != 0 && array.buffers[0] != nullptr)) {
+            release();
+            throw TileDBSOMAError(
+                "[libtiledbsoma] expected an int64 array without nulls");
+        }
+        try {
+            fn(tcb::span<const int64_t>(
+                (const int64_t*)array.buffers[1] + array.offset,
+                array.length));
+        } catch (...) {
+            release();
+            throw;
+        }
+        release();
+        return;
+    }
 
-    py::list names;
-    py::list arrays;
+    using Int64Array =
+        py::array_t<int64_t, py::array::c_style | py::array::forcecast>;
+    auto array = Int64Array::ensure(values);
+    if (!array) {
+        throw TileDBSOMAError("[libtiledbsoma] expected an int64 array");
+    }
+    fn(tcb::span<const int64_t>(array.data(), array.size()));
+}
+
+/**
+ * @brief Initialize a Python QueryCondition for the array schema and return
+ * the TileDB QueryCondition it holds, based on
+ * TileDB-Py::PyQuery::set_attr_cond().
+ *
+ * The columns referenced only by the condition are not added to the selected
+ * columns. TileDB loads the condition attributes itself to filter the cells,
+ * then copies the selected columns of the surviving cells only, so the
+ * predicate-only columns get no buffers and are not exported to Arrow.
+ *
+ * @param py_query_condition Python QueryCondition
+ * @param py_schema Python ArraySchema
+ * @param column_names Selected columns, empty to select all columns
+ * @return QueryCondition*
+ */
+QueryCondition* init_query_condition(
+    py::object py_query_condition,
+    py::object py_schema,
+    const std::vector<std::string>& column_names) {
+    py::object init_pyqc = py_query_condition.attr("init_query_condition");
 
-    for (auto& name : array_buffers->names()) {
-        auto column = array_buffers->at(name);
-        names.append(name);
-        arrays.append(to_array(column));
+    try {
+        // The returned column names include the columns in the condition
+        auto condition_names = init_pyqc(py_schema, column_names)
+                                   .cast<std::vector<std::string>>();
+        if (!column_names.empty()) {
+            for (auto& name : condition_names) {
+                if (std::find(
+                        column_names.begin(), column_names.end(), name) ==
+                    column_names.end()) {
+                    LOG_DEBUG(
+                        "[libtiledbsoma] predicate-only column '{}' is not "
+                        "fetched",
+                        name);
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        throw TileDBSOMAError(e.what());
     }
 
-    return pa_table_from_arrays(arrays, names);
+    return py_query_condition.attr("c_obj")
+        .cast<tiledbpy::PyQueryCondition>()
+        .ptr()
+        .get();
 }
 
 std::string version() {
@@ -107,6 +335,13 @@ PYBIND11_MODULE(libtiledbsoma, m) {
 
     m.doc() = "SOMA acceleration library";
 
+    auto pa = py::module::import("pyarrow");
+    pyarrow = new PyArrow{
+        pa.attr("Array").attr("_import_from_c"),
+        pa.attr("RecordBatch").attr("_import_from_c"),
+        pa.attr("RecordBatchReader").attr("_import_from_c"),
+        pa.attr("Table").attr("from_batches")};
+
     m.def("version", []() { return version(); });
 
     m.def(
@@ -117,8 +352,23 @@ PYBIND11_MODULE(libtiledbsoma, m) {
         "level"_a,
         "logfile"_a = "");
 
-    m.def("info", &LOG_INFO, "message"_a = "");
-    m.def("debug", &LOG_DEBUG, "message"_a = "");
+    m.def(
+        "info",
+        static_cast<void (*)(const std::string&)>(&LOG_INFO),
+        "message"_a = "");
+    m.def(
+        "debug",
+        static_cast<void (*)(const std::string&)>(&LOG_DEBUG),
+        "message"_a = "");
+
+    m.def(
+        "trace_start",
+        &TRACE_START,
+        "Record spans of opening arrays, submitting and waiting for queries, "
+        "and exporting and releasing Arrow arrays to a Chrome trace file, "
+        "viewed with Perfetto.",
+        "tracefile"_a);
+    m.def("trace_stop", &TRACE_STOP, "Stop recording spans to the trace file.");
 
     m.def(
         "tiledbsoma_stats_enable",
@@ -142,6 +392,58 @@ PYBIND11_MODULE(libtiledbsoma, m) {
         },
         "Print TileDB internal statistics.");
 
+    m.def(
+        "clear_stats_cache",
+        []() { StatsCache::instance().clear(); },
+        "Remove all cached array statistics (nnz and non-empty domains).");
+
+    m.def(
+        "clear_result_cache",
+        []() { ResultCache::instance().clear(); },
+        "Remove all cached read results.");
+
+    m.def(
+        "set_result_cache_capacity",
+        [](size_t capacity_bytes) {
+            ResultCache::instance().set_capacity(capacity_bytes);
+        },
+        "Set the number of bytes the cached read results of all readers may "
+        "hold.",
+        "capacity_bytes"_a);
+
+    m.def(
+        "result_cache_bytes",
+        []() { return ResultCache::instance().bytes(); },
+        "Return the number of bytes held by the cached read results.");
+
+    m.def(
+        "set_memory_budget",
+        [](size_t total_budget, uint64_t wait_ms) {
+            auto& governor = MemoryGovernor::instance();
+            governor.set_wait_ms(wait_ms);
+            governor.set_budget(total_budget);
+        },
+        "Set the number of bytes the buffers of all readers may hold, and the "
+        "maximum time (milliseconds) a read waits for memory. A budget of 0 "
+        "disables the memory governor.",
+        "total_budget"_a,
+        "wait_ms"_a = MemoryGovernor::DEFAULT_WAIT_MS);
+
+    m.def(
+        "memory_governor_stats",
+        []() {
+            auto stats = MemoryGovernor::instance().stats();
+            return py::dict(
+                "budget"_a = stats.budget,
+                "reserved_bytes"_a = stats.reserved_bytes,
+                "peak_bytes"_a = stats.peak_bytes,
+                "num_shrinks"_a = stats.num_shrinks,
+                "num_waits"_a = stats.num_waits,
+                "num_overcommits"_a = stats.num_overcommits);
+        },
+        "Return the budget and reservations of the process-wide memory "
+        "governor configured by set_memory_budget.");
+
     py::class_<SOMAReader>(m, "SOMAReader")
         .def(
             py::init(
@@ -160,34 +462,11 @@ PYBIND11_MODULE(libtiledbsoma, m) {
                         column_names = *column_names_in;
                     }
 
-                    // Handle query condition based on
-                    // TileDB-Py::PyQuery::set_attr_cond()
+                    // Handle query condition
                     QueryCondition* qc = nullptr;
                     if (!py_query_condition.is(py::none())) {
-                        py::object init_pyqc = py_query_condition.attr(
-                            "init_query_condition");
-
-                        try {
-                            // Column names will be updated with columns present
-                            // in the query condition
-                            auto new_column_names =
-                                init_pyqc(py_schema, column_names)
-                                    .cast<std::vector<std::string>>();
-
-                            // Update the column_names list if it was not empty,
-                            // otherwise continue selecting all columns with an
-                            // empty column_names list
-                            if (!column_names.empty()) {
-                                column_names = new_column_names;
-                            }
-                        } catch (const std::exception& e) {
-                            throw TileDBSOMAError(e.what());
-                        }
-
-                        qc = py_query_condition.attr("c_obj")
-                                 .cast<tiledbpy::PyQueryCondition>()
-                                 .ptr()
-                                 .get();
+                        qc = init_query_condition(
+                            py_query_condition, py_schema, column_names);
                     }
 
                     // Release python GIL after we're done accessing python
@@ -235,34 +514,11 @@ PYBIND11_MODULE(libtiledbsoma, m) {
                     column_names = *column_names_in;
                 }
 
-                // Handle query condition based on
-                // TileDB-Py::PyQuery::set_attr_cond()
+                // Handle query condition
                 QueryCondition* qc = nullptr;
                 if (!py_query_condition.is(py::none())) {
-                    py::object init_pyqc = py_query_condition.attr(
-                        "init_query_condition");
-
-                    try {
-                        // Column names will be updated with columns present in
-                        // the query condition
-                        auto new_column_names =
-                            init_pyqc(py_schema, column_names)
-                                .cast<std::vector<std::string>>();
-
-                        // Update the column_names list if it was not empty,
-                        // otherwise continue selecting all columns with an
-                        // empty column_names list
-                        if (!column_names.empty()) {
-                            column_names = new_column_names;
-                        }
-                    } catch (const std::exception& e) {
-                        throw TileDBSOMAError(e.what());
-                    }
-
-                    qc = py_query_condition.attr("c_obj")
-                             .cast<tiledbpy::PyQueryCondition>()
-                             .ptr()
-                             .get();
+                    qc = init_query_condition(
+                        py_query_condition, py_schema, column_names);
                 }
 
                 // Release python GIL after we're done accessing python objects
@@ -283,6 +539,48 @@ PYBIND11_MODULE(libtiledbsoma, m) {
             "batch_size"_a = "auto",
             "result_order"_a = "auto")
 
+        .def(
+            "reopen_at",
+            [](SOMAReader& reader,
+               std::optional<std::pair<uint64_t, uint64_t>> timestamp,
+               std::optional<std::vector<std::string>> column_names_in,
+               py::object py_query_condition,
+               py::object py_schema,
+               std::string_view batch_size,
+               std::string_view result_order) {
+                // Handle optional args
+                std::vector<std::string> column_names;
+                if (column_names_in) {
+                    column_names = *column_names_in;
+                }
+
+                // Handle query condition
+                QueryCondition* qc = nullptr;
+                if (!py_query_condition.is(py::none())) {
+                    qc = init_query_condition(
+                        py_query_condition, py_schema, column_names);
+                }
+
+                // Release python GIL after we're done accessing python objects
+                py::gil_scoped_release release;
+
+                // Reopen the array of the existing SOMAReader object
+                reader.reopen_at(
+                    timestamp, column_names, batch_size, result_order);
+
+                // Set query condition if present
+                if (qc) {
+                    reader.set_condition(*qc);
+                }
+            },
+            "timestamp"_a,
+            py::kw_only(),
+            "column_names"_a = py::none(),
+            "query_condition"_a = py::none(),
+            "schema"_a = py::none(),
+            "batch_size"_a = "auto",
+            "result_order"_a = "auto")
+
         // Binding overloaded methods to templated member functions requires
         // more effort, see:
         // https://pybind11.readthedocs.io/en/stable/classes.html#overloaded-methods
@@ -328,22 +626,37 @@ PYBIND11_MODULE(libtiledbsoma, m) {
                     // 'l' = arrow data type int64
                     if (!strcmp(arrow_schema.format, "l")) {
                         tcb::span<int64_t> data{
-                            (int64_t*)arrow_array.buffers[1],
+                            (int64_t*)arrow_array.buffers[1] +
+                                arrow_array.offset,
                             (uint64_t)arrow_array.length};
                         reader.set_dim_points(
                             dim, data, partition_index, partition_count);
-                    } else if (!strcmp(arrow_schema.format, "U")) {
-                        // TODO: partitioning is not supported for string dims
+                    } else if (
+                        !strcmp(arrow_schema.format, "U") ||
+                        !strcmp(arrow_schema.format, "u")) {
+                        // View the strings in the arrow buffers, without
+                        // copying them. 'U' (large string) has 64-bit offsets
+                        // and 'u' (string) has 32-bit offsets.
                         const char* data = (const char*)(arrow_array
                                                              .buffers[2]);
-                        const uint64_t*
-                            offsets = (const uint64_t*)(arrow_array.buffers[1]);
-
-                        for (int64_t i = 0; i < arrow_array.length; i++) {
-                            auto value = std::string{
-                                data + offsets[i], offsets[i + 1] - offsets[i]};
-                            reader.set_dim_point(dim, value);
+                        std::vector<std::string_view> points(
+                            arrow_array.length);
+                        auto to_points = [&](auto offsets) {
+                            offsets += arrow_array.offset;
+                            for (int64_t i = 0; i < arrow_array.length; i++) {
+                                points[i] = std::string_view(
+                                    data + offsets[i],
+                                    offsets[i + 1] - offsets[i]);
+                            }
+                        };
+                        if (arrow_schema.format[0] == 'U') {
+                            to_points((const uint64_t*)arrow_array.buffers[1]);
+                        } else {
+                            to_points((const int32_t*)arrow_array.buffers[1]);
                         }
+
+                        reader.set_dim_points(
+                            dim, points, partition_index, partition_count);
                     } else {
                         throw TileDBSOMAError(fmt::format(
                             "[libtiledbsoma] set_dim_points: type={} not "
@@ -351,8 +664,9 @@ PYBIND11_MODULE(libtiledbsoma, m) {
                             arrow_schema.format));
                     }
 
-                    // Release arrow schema
+                    // Release arrow schema and array
                     arrow_schema.release(&arrow_schema);
+                    arrow_array.release(&arrow_array);
                 }
             },
             "dim"_a,
@@ -360,6 +674,30 @@ PYBIND11_MODULE(libtiledbsoma, m) {
             "partition_index"_a = 0,
             "partition_count"_a = 1)
 
+        .def(
+            "set_dim_ranges",
+            [](SOMAReader& reader,
+               const std::string& dim,
+               py::array_t<int64_t> ranges) {
+                if (ranges.ndim() != 2 || ranges.shape(1) != 2) {
+                    throw TileDBSOMAError(
+                        "[libtiledbsoma] set_dim_ranges: expected an (N, 2) "
+                        "array of range starts and ends");
+                }
+                auto values = ranges.unchecked<2>();
+                std::vector<std::pair<int64_t, int64_t>> pairs(
+                    values.shape(0));
+                for (py::ssize_t i = 0; i < values.shape(0); i++) {
+                    pairs[i] = {values(i, 0), values(i, 1)};
+                }
+                py::gil_scoped_release release;
+                reader.set_dim_ranges(dim, pairs);
+            },
+            "Select the ranges in the rows of an (N, 2) int64 numpy array, "
+            "without converting each range to a Python object.",
+            "dim"_a,
+            py::arg("ranges").noconvert())
+
         .def(
             "set_dim_ranges",
             static_cast<void (SOMAReader::*)(
@@ -367,6 +705,32 @@ PYBIND11_MODULE(libtiledbsoma, m) {
                 const std::vector<std::pair<int64_t, int64_t>>&)>(
                 &SOMAReader::set_dim_ranges))
 
+        .def(
+            "set_dim_ranges",
+            [](SOMAReader& reader,
+               const std::string& dim,
+               py::handle starts,
+               py::handle ends) {
+                // Copy the chunks of the arrays, without converting each
+                // value to a Python object
+                auto to_vector = [](py::handle values) {
+                    std::vector<int64_t> result;
+                    for_each_int64_chunk(values, [&](auto chunk) {
+                        result.insert(result.end(), chunk.begin(), chunk.end());
+                    });
+                    return result;
+                };
+                auto start_values = to_vector(starts);
+                auto end_values = to_vector(ends);
+                py::gil_scoped_release release;
+                reader.set_dim_ranges<int64_t>(dim, start_values, end_values);
+            },
+            "Select the ranges [starts[i], ends[i]] from numpy arrays, pyarrow "
+            "Arrays or pyarrow ChunkedArrays of int64 starts and ends.",
+            "dim"_a,
+            "starts"_a,
+            "ends"_a)
+
         .def(
             "set_dim_ranges",
             static_cast<void (SOMAReader::*)(
@@ -395,13 +759,592 @@ PYBIND11_MODULE(libtiledbsoma, m) {
                 if (buffers.has_value()) {
                     // Acquire python GIL before accessing python objects
                     py::gil_scoped_acquire acquire;
-                    return to_table(*buffers);
+                    auto start = std::chrono::steady_clock::now();
+                    auto schema_template = reader.arrow_schema();
+                    auto table = to_table(*buffers, schema_template, &reader);
+                    reader.set_arrow_schema(schema_template);
+                    std::chrono::duration<double> elapsed =
+                        std::chrono::steady_clock::now() - start;
+                    reader.record_gil(elapsed.count());
+                    return table;
                 }
 
                 // No data was read, the query is complete, return nullopt
                 return std::nullopt;
             })
 
-        .def("nnz", &SOMAReader::nnz, py::call_guard<py::gil_scoped_release>());
+        .def(
+            "read_arrow_stream",
+            [](py::object py_reader) {
+                // The stream holds a reference to the python reader, so the
+                // reader outlives the stream. The reference is dropped with
+                // the GIL held when the stream is released.
+                auto& reader = py_reader.cast<SOMAReader&>();
+                std::shared_ptr<SOMAReader> shared_reader(
+                    &reader, [py_reader](SOMAReader*) mutable {
+                        py::gil_scoped_acquire acquire;
+                        py_reader = py::object();
+                    });
+
+                ArrowArrayStream stream;
+                ArrowAdapter::to_arrow_stream(shared_reader, &stream);
+
+                try {
+                    return pyarrow->record_batch_reader_import(
+                        (uintptr_t)&stream);
+                } catch (...) {
+                    if (stream.release != nullptr) {
+                        stream.release(&stream);
+                    }
+                    throw;
+                }
+            },
+            "Return a pyarrow.RecordBatchReader reading the results in "
+            "batches. The query must be submitted first.")
+
+        .def(
+            "read_into",
+            [](SOMAReader& reader, const std::string& name, py::array array) {
+                auto schema = reader.schema();
+                auto type = schema->has_attribute(name) ?
+                                schema->attribute(name).type() :
+                                schema->domain().dimension(name).type();
+                if (!array.dtype().equal(to_dtype(type))) {
+                    throw TileDBSOMAError(fmt::format(
+                        "[libtiledbsoma] read_into: array dtype does not "
+                        "match column '{}'",
+                        name));
+                }
+                if (!(array.flags() & py::array::c_style) ||
+                    !array.writeable()) {
+                    throw TileDBSOMAError(
+                        "[libtiledbsoma] read_into: array must be "
+                        "C-contiguous and writeable");
+                }
+
+                auto data = array.mutable_data();
+                uint64_t num_bytes = array.nbytes();
+                py::gil_scoped_release release;
+                return reader.read_into(name, data, num_bytes);
+            },
+            "Read a column of a dense array into a numpy array holding all "
+            "cells of the subarray, instead of calling submit and read_next. "
+            "Return the number of cells read.",
+            "name"_a,
+            "array"_a)
+
+        .def("dense_num_cells", &SOMAReader::dense_num_cells)
+
+        .def("nnz", &SOMAReader::nnz, py::call_guard<py::gil_scoped_release>())
+
+        .def(
+            "metrics",
+            [](SOMAReader& reader) { return to_dict(reader.metrics()); },
+            "Return the latency and throughput metrics of the reader as a "
+            "dict.")
+
+        .def(
+            "metrics_json",
+            [](SOMAReader& reader) { return reader.metrics().to_json(); },
+            "Return the latency and throughput metrics of the reader as a "
+            "JSON string.")
+
+        .def(
+            "nnz_bounds",
+            &SOMAReader::nnz_bounds,
+            py::call_guard<py::gil_scoped_release>())
+
+        .def(
+            "plan_chunks",
+            [](SOMAReader& reader,
+               uint64_t target_cells,
+               std::optional<std::vector<std::pair<int64_t, int64_t>>>
+                   ranges) {
+                std::vector<SOMAReader::Chunk> chunks;
+                {
+                    py::gil_scoped_release release;
+                    chunks = reader.plan_chunks(target_cells, ranges);
+                }
+                py::list result;
+                for (auto& chunk : chunks) {
+                    result.append(py::make_tuple(
+                        py::cast(chunk.ranges), chunk.num_cells));
+                }
+                return result;
+            },
+            "Partition dimension 0 into chunks of about `target_cells` cells, "
+            "estimated from the fragment metadata, and return a list of "
+            "(ranges, num_cells) tuples covering `ranges` or the non-empty "
+            "domain.",
+            "target_cells"_a,
+            "ranges"_a = py::none())
+
+        .def(
+            "select_chunk",
+            [](SOMAReader& reader,
+               std::vector<std::pair<int64_t, int64_t>> ranges) {
+                reader.select_chunk({std::move(ranges), 0});
+            },
+            "Select the ranges of a chunk returned by `plan_chunks`.",
+            "ranges"_a)
+
+        .def(
+            "non_empty_domain",
+            [](SOMAReader& reader, const std::string& dim) -> py::tuple {
+                auto type =
+                    reader.schema()->domain().dimension(dim).type();
+                switch (type) {
+                    case TILEDB_INT64:
+                        return py::cast(
+                            reader.non_empty_domain<int64_t>(dim));
+                    case TILEDB_UINT64:
+                        return py::cast(
+                            reader.non_empty_domain<uint64_t>(dim));
+                    case TILEDB_INT32:
+                        return py::cast(
+                            reader.non_empty_domain<int32_t>(dim));
+                    case TILEDB_FLOAT64:
+                        return py::cast(reader.non_empty_domain<double>(dim));
+                    case TILEDB_FLOAT32:
+                        return py::cast(reader.non_empty_domain<float>(dim));
+                    case TILEDB_STRING_ASCII:
+                        return py::cast(reader.non_empty_domain_var(dim));
+                    default:
+                        throw TileDBSOMAError(fmt::format(
+                            "[libtiledbsoma] non_empty_domain: type={} not "
+                            "supported",
+                            tiledb::impl::type_to_str(type)));
+                }
+            },
+            "dim"_a)
+
+        .def(
+            "set_predicate",
+            &SOMAReader::set_predicate,
+            "Set a value filter, compiled against the schema and context of "
+            "the reader. Replaces a previous query condition.",
+            "predicate"_a)
+
+        .def(
+            "set_dictionary_columns",
+            &SOMAReader::set_dictionary_columns,
+            "Return the variable length columns as Arrow dictionary arrays, "
+            "with int32 indices into the distinct values of each batch.",
+            "names"_a);
+
+    py::class_<QueryPredicate>(m, "QueryPredicate")
+        .def_static(
+            "compare",
+            [](const std::string& name,
+               std::string_view op,
+               QueryPredicate::Value value) {
+                return QueryPredicate::compare(
+                    name, QueryPredicate::to_op(op), value);
+            },
+            "Compare an attribute to a value with one of the operators ==, "
+            "!=, <, <=, > or >=.",
+            "name"_a,
+            "op"_a,
+            "value"_a)
+
+        .def_static(
+            "is_in",
+            &QueryPredicate::is_in,
+            "Select the cells where the attribute equals one of the values.",
+            "name"_a,
+            "values"_a)
+
+        .def_static(
+            "is_null",
+            &QueryPredicate::is_null,
+            "Select the null (or non-null) cells of a nullable attribute.",
+            "name"_a,
+            "is_null"_a = true)
+
+        .def(
+            "combine",
+            [](const QueryPredicate& predicate,
+               const QueryPredicate& rhs,
+               std::string_view op) {
+                return predicate.combine(
+                    rhs, QueryPredicate::to_combination_op(op));
+            },
+            "Combine with another predicate with 'and' or 'or'.",
+            "rhs"_a,
+            "op"_a)
+
+        .def(
+            "__and__",
+            [](const QueryPredicate& predicate, const QueryPredicate& rhs) {
+                return predicate.combine(rhs, TILEDB_AND);
+            })
+
+        .def(
+            "__or__",
+            [](const QueryPredicate& predicate, const QueryPredicate& rhs) {
+                return predicate.combine(rhs, TILEDB_OR);
+            })
+
+        .def("__invert__", &QueryPredicate::negate)
+
+        .def("__repr__", [](const QueryPredicate& predicate) {
+            return fmt::format("QueryPredicate({})", predicate.to_string());
+        });
+
+    py::class_<IntIndexer>(m, "IntIndexer")
+        .def(
+            py::init([](py::object keys, unsigned num_threads) {
+                // Chunked keys are combined, so the keys are mapped at once
+                if (py::hasattr(keys, "chunks") &&
+                    py::len(keys.attr("chunks")) != 1) {
+                    keys = keys.attr("combine_chunks")();
+                }
+                auto indexer = std::make_unique<IntIndexer>(num_threads);
+                for_each_int64_chunk(keys, [&](auto chunk) {
+                    py::gil_scoped_release release;
+                    indexer->map_locations(chunk);
+                });
+                return indexer;
+            }),
+            "Map the unique int64 keys, a numpy array or pyarrow array, to "
+            "their positions.",
+            "keys"_a,
+            "num_threads"_a = 0)
+
+        .def(
+            "get_indexer",
+            [](IntIndexer& indexer, py::object keys) {
+                py::array_t<int64_t> positions(py::len(keys));
+                auto data = positions.mutable_data();
+                size_t offset = 0;
+                for_each_int64_chunk(keys, [&](auto chunk) {
+                    if (offset + chunk.size() > (size_t)positions.size()) {
+                        throw TileDBSOMAError(
+                            "[libtiledbsoma] get_indexer: keys must be 1-D");
+                    }
+                    py::gil_scoped_release release;
+                    indexer.get_indexer(
+                        chunk, tcb::span<int64_t>(data + offset, chunk.size()));
+                    offset += chunk.size();
+                });
+                return positions;
+            },
+            "Return the position of each key, a numpy array or pyarrow "
+            "array, or -1 for keys that are not mapped.",
+            "keys"_a)
+
+        .def("__len__", &IntIndexer::size);
+
+    py::class_<CompressedMatrixBuilder>(m, "CompressedMatrixBuilder")
+        .def(
+            py::init([](const std::string& format,
+                        std::pair<uint64_t, uint64_t> shape,
+                        unsigned num_threads) {
+                if (format != "csr" && format != "csc") {
+                    throw TileDBSOMAError(fmt::format(
+                        "[libtiledbsoma] CompressedMatrixBuilder: format "
+                        "'{}' must be 'csr' or 'csc'",
+                        format));
+                }
+                return std::make_unique<CompressedMatrixBuilder>(
+                    format == "csr" ? CompressedFormat::CSR :
+                                      CompressedFormat::CSC,
+                    shape.first,
+                    shape.second,
+                    num_threads);
+            }),
+            "format"_a,
+            "shape"_a,
+            "num_threads"_a = 0)
+
+        .def(
+            "set_joinids",
+            [](CompressedMatrixBuilder& builder,
+               int dim,
+               py::array_t<int64_t, py::array::c_style | py::array::forcecast>
+                   joinids) {
+                builder.set_joinids(
+                    dim,
+                    tcb::span<const int64_t>(joinids.data(), joinids.size()));
+            },
+            "Remap the joinids of dimension `dim` to their positions in "
+            "`joinids`.",
+            "dim"_a,
+            "joinids"_a)
+
+        .def(
+            "read",
+            &CompressedMatrixBuilder::read,
+            py::call_guard<py::gil_scoped_release>(),
+            "Read up to `max_batches` batches from a submitted reader, or all "
+            "remaining batches if 0, and return the number of batches read.",
+            "reader"_a,
+            "max_batches"_a = 0)
+
+        .def("nnz", &CompressedMatrixBuilder::nnz)
+
+        .def(
+            "finish",
+            [](CompressedMatrixBuilder& builder) {
+                std::shared_ptr<CompressedMatrix> matrix;
+                {
+                    py::gil_scoped_release release;
+                    matrix = builder.finish();
+                }
+                return to_numpy(matrix);
+            },
+            "Assemble the matrix and return the (data, indices, indptr) "
+            "numpy arrays.");
+
+    py::class_<AxisAggregator>(m, "AxisAggregator")
+        .def(
+            py::init<int, uint64_t, unsigned>(),
+            "axis"_a,
+            "size"_a,
+            "num_threads"_a = 0)
+
+        .def(
+            "set_joinids",
+            [](AxisAggregator& aggregator,
+               py::array_t<int64_t, py::array::c_style | py::array::forcecast>
+                   joinids) {
+                aggregator.set_joinids(
+                    tcb::span<const int64_t>(joinids.data(), joinids.size()));
+            },
+            "Remap the joinids of the axis to their positions in `joinids`.",
+            "joinids"_a)
+
+        .def(
+            "read",
+            &AxisAggregator::read,
+            py::call_guard<py::gil_scoped_release>(),
+            "Read up to `max_batches` batches from a submitted reader, or all "
+            "remaining batches if 0, and return the number of batches read.",
+            "reader"_a,
+            "max_batches"_a = 0)
+
+        .def("num_cells", &AxisAggregator::num_cells)
+
+        .def(
+            "nnz",
+            [](AxisAggregator& aggregator) {
+                auto& nnz = aggregator.aggregates().nnz;
+                return py::array_t<uint64_t>(nnz.size(), nnz.data());
+            })
+
+        .def(
+            "sum",
+            [](AxisAggregator& aggregator) {
+                auto& sum = aggregator.aggregates().sum;
+                return py::array_t<double>(sum.size(), sum.data());
+            })
+
+        .def(
+            "m2",
+            [](AxisAggregator& aggregator) {
+                auto& m2 = aggregator.aggregates().m2;
+                return py::array_t<double>(m2.size(), m2.data());
+            },
+            "Return the sums of squared deviations of the stored values from "
+            "their mean per position.")
+
+        .def(
+            "mean",
+            [](AxisAggregator& aggregator, uint64_t n) {
+                auto mean = aggregator.aggregates().mean(n);
+                return py::array_t<double>(mean.size(), mean.data());
+            },
+            "Return the means over `n` values per position, counting the "
+            "implicit zeros.",
+            "n"_a)
+
+        .def(
+            "variance",
+            [](AxisAggregator& aggregator, uint64_t n, uint64_t ddof) {
+                auto variance = aggregator.aggregates().variance(n, ddof);
+                return py::array_t<double>(variance.size(), variance.data());
+            },
+            "Return the variances over `n` values per position, counting the "
+            "implicit zeros, with `ddof` delta degrees of freedom.",
+            "n"_a,
+            "ddof"_a = 1);
+
+    py::class_<ExperimentQuery>(m, "ExperimentQuery")
+        .def(
+            py::init([](std::string_view uri,
+                        std::string_view measurement_name,
+                        std::string_view X_layer,
+                        std::map<std::string, std::string> platform_config,
+                        std::optional<std::pair<uint64_t, uint64_t>>
+                            timestamp) {
+                // Release python GIL while the arrays are opened
+                py::gil_scoped_release release;
+                return ExperimentQuery::open(
+                    uri, measurement_name, X_layer, platform_config, timestamp);
+            }),
+            "uri"_a,
+            py::kw_only(),
+            "measurement_name"_a = "RNA",
+            "X_layer"_a = "data",
+            "platform_config"_a = py::dict(),
+            "timestamp"_a = py::none())
+
+        .def(
+            "obs",
+            &ExperimentQuery::obs,
+            py::return_value_policy::reference_internal,
+            "Return the SOMAReader of the obs dataframe, to set its "
+            "coordinates, value filter and columns before submit.")
+
+        .def(
+            "var",
+            &ExperimentQuery::var,
+            py::return_value_policy::reference_internal,
+            "Return the SOMAReader of the var dataframe, to set its "
+            "coordinates, value filter and columns before submit.")
+
+        .def(
+            "X",
+            &ExperimentQuery::X,
+            py::return_value_policy::reference_internal,
+            "Return the SOMAReader of the X layer, which reads the X results "
+            "after submit.")
+
+        .def(
+            "submit",
+            &ExperimentQuery::submit,
+            py::call_guard<py::gil_scoped_release>(),
+            "Read the obs and var dataframes concurrently, then select their "
+            "joinids on the X layer and submit the X query.")
+
+        .def(
+            "obs_tables",
+            [](ExperimentQuery& query) {
+                py::list tables;
+                std::shared_ptr<const ArrowSchemaTemplate> schema_template;
+                for (auto& results : query.obs_results()) {
+                    tables.append(to_table(results, schema_template));
+                }
+                return tables;
+            },
+            "Return the obs results as a list of pyarrow Tables.")
+
+        .def(
+            "var_tables",
+            [](ExperimentQuery& query) {
+                py::list tables;
+                std::shared_ptr<const ArrowSchemaTemplate> schema_template;
+                for (auto& results : query.var_results()) {
+                    tables.append(to_table(results, schema_template));
+                }
+                return tables;
+            },
+            "Return the var results as a list of pyarrow Tables.")
+
+        .def(
+            "obs_joinids",
+            [](ExperimentQuery& query) {
+                auto& joinids = query.obs_joinids();
+                return py::array_t<int64_t>(joinids.size(), joinids.data());
+            },
+            "Return the joinids of the obs results as a numpy array.")
+
+        .def(
+            "var_joinids",
+            [](ExperimentQuery& query) {
+                auto& joinids = query.var_joinids();
+                return py::array_t<int64_t>(joinids.size(), joinids.data());
+            },
+            "Return the joinids of the var results as a numpy array.")
+
+        .def(
+            "read_X",
+            [](ExperimentQuery& query,
+               const std::string& format,
+               unsigned num_threads) {
+                if (format != "csr" && format != "csc") {
+                    throw TileDBSOMAError(fmt::format(
+                        "[libtiledbsoma] ExperimentQuery: format '{}' must be "
+                        "'csr' or 'csc'",
+                        format));
+                }
+                std::shared_ptr<CompressedMatrix> matrix;
+                {
+                    py::gil_scoped_release release;
+                    matrix = query.read_X(
+                        format == "csr" ? CompressedFormat::CSR :
+                                          CompressedFormat::CSC,
+                        num_threads);
+                }
+                return to_numpy(matrix);
+            },
+            "Read the X results into a CSR or CSC matrix with one row per obs "
+            "joinid and one column per var joinid, and return the (data, "
+            "indices, indptr) numpy arrays.",
+            "format"_a = "csr",
+            "num_threads"_a = 0);
+
+    py::class_<SOMAWriter>(m, "SOMAWriter")
+        .def(
+            py::init([](std::string_view uri,
+                        std::map<std::string, std::string> platform_config,
+                        std::string_view layout,
+                        std::optional<uint64_t> timestamp) {
+                return SOMAWriter::open(
+                    uri, platform_config, layout, timestamp);
+            }),
+            "uri"_a,
+            py::kw_only(),
+            "platform_config"_a = py::dict(),
+            "layout"_a = "unordered",
+            "timestamp"_a = py::none())
+
+        .def(
+            "write",
+            [](SOMAWriter& writer, py::handle values) {
+                // Write each record batch of a pyarrow Table or RecordBatch
+                py::list batches;
+                if (py::hasattr(values, "to_batches")) {
+                    batches = values.attr("to_batches")().cast<py::list>();
+                } else {
+                    batches.append(values);
+                }
+
+                for (const py::handle batch : batches) {
+                    ArrowArray arrow_array;
+                    ArrowSchema arrow_schema;
+                    batch.attr("_export_to_c")(
+                        (uintptr_t)&arrow_array, (uintptr_t)&arrow_schema);
+
+                    // The writer takes ownership of the array, the schema is
+                    // released once the batch is bound
+                    try {
+                        py::gil_scoped_release release;
+                        writer.write(&arrow_array, &arrow_schema);
+                    } catch (...) {
+                        arrow_schema.release(&arrow_schema);
+                        throw;
+                    }
+                    arrow_schema.release(&arrow_schema);
+                }
+            },
+            "Write a pyarrow Table or RecordBatch with one column per "
+            "dimension and attribute of the array.",
+            "values"_a)
+
+        .def(
+            "flush",
+            &SOMAWriter::flush,
+            py::call_guard<py::gil_scoped_release>(),
+            "Wait for the batches written in the background.")
+
+        .def(
+            "close",
+            &SOMAWriter::close,
+            py::call_guard<py::gil_scoped_release>(),
+            "Flush the batches written in the background and close the "
+            "array.")
+
+        .def("num_cells", &SOMAWriter::num_cells);
 }
 }  // namespace tiledbsoma
@@ -0,0 +1,128 @@
+/**
+ * @file   query_metrics.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines the query metrics.
+ */
+
+#include "tiledbsoma/logger_public.h"
+
+#include "tiledbsoma/query_metrics.h"
+
+namespace tiledbsoma {
+
+namespace {
+
+/**
+ * @brief Return a string quoted and escaped as a JSON string.
+ */
+std::string json_string(const std::string& value) {
+    std::string result = "\"";
+    for (char c : value) {
+        switch (c) {
+            case '"':
+                result += "\\\"";
+                break;
+            case '\\':
+                result += "\\\\";
+                break;
+            case '\n':
+                result += "\\n";
+                break;
+            case '\t':
+                result += "\\t";
+                break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    result += fmt::format("\\u{:04x}", (int)c);
+                } else {
+                    result += c;
+                }
+        }
+    }
+    return result + "\"";
+}
+
+}  // namespace
+
+void QueryMetrics::merge(const QueryMetrics& other) {
+    num_submits += other.num_submits;
+    num_incomplete += other.num_incomplete;
+    num_resubmits += other.num_resubmits;
+    num_memory_shrinks += other.num_memory_shrinks;
+    num_batches += other.num_batches;
+    num_cells += other.num_cells;
+    submit_seconds += other.submit_seconds;
+    arrow_export_seconds += other.arrow_export_seconds;
+    gil_seconds += other.gil_seconds;
+    for (const auto& [name, column] : other.columns) {
+        auto& total = columns[name];
+        total.cells += column.cells;
+        total.bytes += column.bytes;
+        total.capacity_cells += column.capacity_cells;
+        total.capacity_bytes += column.capacity_bytes;
+    }
+}
+
+std::string QueryMetrics::to_json() const {
+    std::string columns_json;
+    for (const auto& [name, column] : columns) {
+        if (!columns_json.empty()) {
+            columns_json += ",";
+        }
+        columns_json += fmt::format(
+            "{}:{{\"cells\":{},\"bytes\":{},\"capacity_cells\":{},"
+            "\"capacity_bytes\":{},\"utilization\":{}}}",
+            json_string(name),
+            column.cells,
+            column.bytes,
+            column.capacity_cells,
+            column.capacity_bytes,
+            column.utilization());
+    }
+
+    double throughput = submit_seconds ? num_cells / submit_seconds : 0;
+    return fmt::format(
+        "{{\"num_submits\":{},\"num_incomplete\":{},\"num_resubmits\":{},"
+        "\"num_memory_shrinks\":{},\"num_batches\":{},\"num_cells\":{},"
+        "\"submit_seconds\":{},\"arrow_export_seconds\":{},\"gil_seconds\":{},"
+        "\"cells_per_second\":{},\"columns\":{{{}}}}}",
+        num_submits,
+        num_incomplete,
+        num_resubmits,
+        num_memory_shrinks,
+        num_batches,
+        num_cells,
+        submit_seconds,
+        arrow_export_seconds,
+        gil_seconds,
+        throughput,
+        columns_json);
+}
+
+}  // namespace tiledbsoma
@@ -0,0 +1,426 @@
+/**
+ * @file   query_predicate.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines the query predicate API.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+
+#include "tiledbsoma/logger_public.h"
+#include "tiledbsoma/query_predicate.h"
+
+namespace tiledbsoma {
+
+namespace {
+
+/**
+ * @brief Return true if the datatype is a string type.
+ */
+bool is_string_type(tiledb_datatype_t type) {
+    return type == TILEDB_STRING_ASCII || type == TILEDB_STRING_UTF8 ||
+           type == TILEDB_CHAR;
+}
+
+/**
+ * @brief Convert a value to the type of an attribute, checking that the
+ * value is representable in that type.
+ */
+template <typename T>
+T cast_value(const QueryPredicate::Value& value, const std::string& name) {
+    auto error = [&]() {
+        return TileDBSOMAError(fmt::format(
+            "[QueryPredicate] Value is not valid for the type of column '{}'",
+            name));
+    };
+
+    if (std::holds_alternative<std::string>(value)) {
+        throw error();
+    }
+    if (auto v = std::get_if<bool>(&value)) {
+        return static_cast<T>(*v);
+    }
+
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::visit(
+            [](auto v) -> T {
+                if constexpr (std::is_arithmetic_v<decltype(v)>) {
+                    return static_cast<T>(v);
+                } else {
+                    return T{};
+                }
+            },
+            value);
+    } else {
+        // Integral attributes accept integral values in range, including
+        // doubles with an integral value
+        if (auto v = std::get_if<double>(&value)) {
+            if (std::trunc(*v) != *v ||
+                *v < (double)std::numeric_limits<T>::lowest() ||
+                *v > (double)std::numeric_limits<T>::max()) {
+                throw error();
+            }
+            return static_cast<T>(*v);
+        }
+        if (auto v = std::get_if<int64_t>(&value)) {
+            if constexpr (std::is_signed_v<T>) {
+                if (*v < std::numeric_limits<T>::lowest() ||
+                    *v > std::numeric_limits<T>::max()) {
+                    throw error();
+                }
+            } else {
+                if (*v < 0 || (uint64_t)*v > std::numeric_limits<T>::max()) {
+                    throw error();
+                }
+            }
+            return static_cast<T>(*v);
+        }
+        auto v = std::get<uint64_t>(value);
+        if (v > (uint64_t)std::numeric_limits<T>::max()) {
+            throw error();
+        }
+        return static_cast<T>(v);
+    }
+}
+
+/**
+ * @brief Return a comparison operator as a string.
+ */
+std::string_view op_string(tiledb_query_condition_op_t op) {
+    switch (op) {
+        case TILEDB_LT:
+            return "<";
+        case TILEDB_LE:
+            return "<=";
+        case TILEDB_GT:
+            return ">";
+        case TILEDB_GE:
+            return ">=";
+        case TILEDB_EQ:
+            return "==";
+        case TILEDB_NE:
+            return "!=";
+        default:
+            return "?";
+    }
+}
+
+/**
+ * @brief Return a value as a string, quoting strings.
+ */
+std::string value_string(const QueryPredicate::Value& value) {
+    if (auto v = std::get_if<std::string>(&value)) {
+        std::string quoted = "'";
+        for (char c : *v) {
+            if (c == '\'' || c == '\\') {
+                quoted += '\\';
+            }
+            quoted += c;
+        }
+        return quoted + "'";
+    }
+    if (auto v = std::get_if<bool>(&value)) {
+        return *v ? "True" : "False";
+    }
+    return std::visit(
+        [](auto v) -> std::string {
+            if constexpr (std::is_arithmetic_v<decltype(v)>) {
+                return fmt::format("{}", v);
+            } else {
+                return "";
+            }
+        },
+        value);
+}
+
+}  // namespace
+
+//===================================================================
+//= public static
+//===================================================================
+
+QueryPredicate QueryPredicate::compare(
+    const std::string& name, tiledb_query_condition_op_t op, Value value) {
+    auto node = std::make_shared<Node>();
+    node->kind = Kind::COMPARE;
+    node->name = name;
+    node->op = op;
+    node->values.push_back(std::move(value));
+    return QueryPredicate(node);
+}
+
+QueryPredicate QueryPredicate::is_in(
+    const std::string& name, std::vector<Value> values) {
+    auto node = std::make_shared<Node>();
+    node->kind = Kind::IN;
+    node->name = name;
+    node->values = std::move(values);
+    return QueryPredicate(node);
+}
+
+QueryPredicate QueryPredicate::is_null(const std::string& name, bool is_null) {
+    auto node = std::make_shared<Node>();
+    node->kind = Kind::NULL_CHECK;
+    node->name = name;
+    node->op = is_null ? TILEDB_EQ : TILEDB_NE;
+    return QueryPredicate(node);
+}
+
+tiledb_query_condition_op_t QueryPredicate::to_op(std::string_view op) {
+    if (op == "==") {
+        return TILEDB_EQ;
+    } else if (op == "!=") {
+        return TILEDB_NE;
+    } else if (op == "<") {
+        return TILEDB_LT;
+    } else if (op == "<=") {
+        return TILEDB_LE;
+    } else if (op == ">") {
+        return TILEDB_GT;
+    } else if (op == ">=") {
+        return TILEDB_GE;
+    }
+    throw TileDBSOMAError(
+        fmt::format("[QueryPredicate] Invalid comparison operator: '{}'", op));
+}
+
+tiledb_query_condition_combination_op_t QueryPredicate::to_combination_op(
+    std::string_view op) {
+    std::string lower(op);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](char c) {
+        return std::tolower(c);
+    });
+    if (lower == "and") {
+        return TILEDB_AND;
+    } else if (lower == "or") {
+        return TILEDB_OR;
+    }
+    throw TileDBSOMAError(fmt::format(
+        "[QueryPredicate] Invalid combination operator: '{}'", op));
+}
+
+//===================================================================
+//= public non-static
+//===================================================================
+
+QueryPredicate QueryPredicate::combine(
+    const QueryPredicate& rhs,
+    tiledb_query_condition_combination_op_t op) const {
+    if (op != TILEDB_AND && op != TILEDB_OR) {
+        throw TileDBSOMAError(
+            "[QueryPredicate] Predicates are combined with AND or OR");
+    }
+    auto node = std::make_shared<Node>();
+    node->kind = Kind::COMBINE;
+    node->combination_op = op;
+    node->children = {node_, rhs.node_};
+    return QueryPredicate(node);
+}
+
+QueryPredicate QueryPredicate::negate() const {
+    auto node = std::make_shared<Node>();
+    node->kind = Kind::NEGATE;
+    node->children = {node_};
+    return QueryPredicate(node);
+}
+
+QueryCondition QueryPredicate::to_condition(
+    const Context& ctx, const ArraySchema& schema) const {
+    return to_condition(*node_, ctx, schema);
+}
+
+std::string QueryPredicate::to_string() const {
+    return to_string(*node_);
+}
+
+//===================================================================
+//= private static
+//===================================================================
+
+QueryCondition QueryPredicate::compare_condition(
+    const Context& ctx,
+    const Attribute& attr,
+    tiledb_query_condition_op_t op,
+    const Value& value) {
+    auto name = attr.name();
+    auto type = attr.type();
+    if (is_string_type(type)) {
+        auto v = std::get_if<std::string>(&value);
+        if (v == nullptr) {
+            throw TileDBSOMAError(fmt::format(
+                "[QueryPredicate] Column '{}' is compared to a string", name));
+        }
+        return QueryCondition::create(ctx, name, *v, op);
+    }
+
+    switch (type) {
+        case TILEDB_BOOL:
+        case TILEDB_UINT8:
+            return QueryCondition::create(
+                ctx, name, cast_value<uint8_t>(value, name), op);
+        case TILEDB_INT8:
+            return QueryCondition::create(
+                ctx, name, cast_value<int8_t>(value, name), op);
+        case TILEDB_UINT16:
+            return QueryCondition::create(
+                ctx, name, cast_value<uint16_t>(value, name), op);
+        case TILEDB_INT16:
+            return QueryCondition::create(
+                ctx, name, cast_value<int16_t>(value, name), op);
+        case TILEDB_UINT32:
+            return QueryCondition::create(
+                ctx, name, cast_value<uint32_t>(value, name), op);
+        case TILEDB_INT32:
+            return QueryCondition::create(
+                ctx, name, cast_value<int32_t>(value, name), op);
+        case TILEDB_UINT64:
+            return QueryCondition::create(
+                ctx, name, cast_value<uint64_t>(value, name), op);
+        case TILEDB_FLOAT32:
+            return QueryCondition::create(
+                ctx, name, cast_value<float>(value, name), op);
+        case TILEDB_FLOAT64:
+            return QueryCondition::create(
+                ctx, name, cast_value<double>(value, name), op);
+        default:
+            // Remaining fixed size types, such as datetimes, are int64
+            if (tiledb::impl::type_size(type) != sizeof(int64_t)) {
+                throw TileDBSOMAError(fmt::format(
+                    "[QueryPredicate] Column '{}' of type {} is not supported",
+                    name,
+                    tiledb::impl::type_to_str(type)));
+            }
+            return QueryCondition::create(
+                ctx, name, cast_value<int64_t>(value, name), op);
+    }
+}
+
+QueryCondition QueryPredicate::to_condition(
+    const Node& node, const Context& ctx, const ArraySchema& schema) {
+    if (node.kind == Kind::COMBINE) {
+        return to_condition(*node.children[0], ctx, schema)
+            .combine(
+                to_condition(*node.children[1], ctx, schema),
+                node.combination_op);
+    }
+    if (node.kind == Kind::NEGATE) {
+        return to_condition(*node.children[0], ctx, schema).negate();
+    }
+
+    // Query conditions apply to attributes only
+    if (!schema.has_attribute(node.name)) {
+        throw TileDBSOMAError(fmt::format(
+            "[QueryPredicate] Column '{}' is not an attribute of the array",
+            node.name));
+    }
+    auto attr = schema.attribute(node.name);
+
+    switch (node.kind) {
+        case Kind::COMPARE:
+            return compare_condition(ctx, attr, node.op, node.values[0]);
+        case Kind::NULL_CHECK: {
+            if (!attr.nullable()) {
+                throw TileDBSOMAError(fmt::format(
+                    "[QueryPredicate] Column '{}' is not nullable",
+                    node.name));
+            }
+            QueryCondition qc(ctx);
+            qc.init(node.name, nullptr, 0, node.op);
+            return qc;
+        }
+        default:
+            break;
+    }
+
+    // An empty set selects no cells: no cell both equals and differs from a
+    // value
+    if (node.values.empty()) {
+        Value value = is_string_type(attr.type()) ? Value(std::string()) :
+                                                    Value(int64_t{0});
+        return compare_condition(ctx, attr, TILEDB_EQ, value)
+            .combine(
+                compare_condition(ctx, attr, TILEDB_NE, value), TILEDB_AND);
+    }
+
+    // Combine the equalities as a balanced tree, so large sets do not build
+    // a deep condition
+    std::vector<QueryCondition> conditions;
+    for (auto& value : node.values) {
+        conditions.push_back(compare_condition(ctx, attr, TILEDB_EQ, value));
+    }
+    while (conditions.size() > 1) {
+        std::vector<QueryCondition> combined;
+        for (size_t i = 0; i + 1 < conditions.size(); i += 2) {
+            combined.push_back(
+                conditions[i].combine(conditions[i + 1], TILEDB_OR));
+        }
+        if (conditions.size() % 2) {
+            combined.push_back(conditions.back());
+        }
+        conditions = std::move(combined);
+    }
+    return conditions[0];
+}
+
+std::string QueryPredicate::to_string(const Node& node) {
+    switch (node.kind) {
+        case Kind::COMPARE:
+            return fmt::format(
+                "{} {} {}",
+                node.name,
+                op_string(node.op),
+                value_string(node.values[0]));
+        case Kind::IN: {
+            std::string values;
+            for (auto& value : node.values) {
+                if (!values.empty()) {
+                    values += ", ";
+                }
+                values += value_string(value);
+            }
+            return fmt::format("{} IN ({})", node.name, values);
+        }
+        case Kind::NULL_CHECK:
+            return fmt::format(
+                "{} IS {}NULL", node.name, node.op == TILEDB_EQ ? "" : "NOT ");
+        case Kind::COMBINE:
+            return fmt::format(
+                "({} {} {})",
+                to_string(*node.children[0]),
+                node.combination_op == TILEDB_AND ? "AND" : "OR",
+                to_string(*node.children[1]));
+        case Kind::NEGATE:
+            return fmt::format("NOT {}", to_string(*node.children[0]));
+    }
+    return "";
+}
+
+}  // namespace tiledbsoma
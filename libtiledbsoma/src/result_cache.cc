@@ -0,0 +1,181 @@
+/**
+ * @file   result_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines the cache of read results.
+ */
+
+#include "tiledbsoma/result_cache.h"
+#include "tiledbsoma/common.h"
+#include "tiledbsoma/logger_public.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+//===================================================================
+//= public static
+//===================================================================
+
+ResultCache& ResultCache::instance() {
+    static ResultCache cache;
+    return cache;
+}
+
+ResultCache::Key ResultCache::key(
+    const Context& ctx,
+    const std::string& uri,
+    const Array& array,
+    const ArrayCache::Fingerprint& fingerprint,
+    const std::string& read) {
+    return {
+        &ctx,
+        uri,
+        array.open_timestamp_start(),
+        array.open_timestamp_end(),
+        fingerprint,
+        read};
+}
+
+size_t ResultCache::num_bytes(const Batches& batches) {
+    size_t result = 0;
+    for (auto& batch : batches) {
+        for (auto& name : batch->names()) {
+            result += batch->at(name)->allocated_bytes();
+        }
+    }
+    return result;
+}
+
+//===================================================================
+//= public non-static
+//===================================================================
+
+ResultCache::ResultCache(size_t capacity_bytes)
+    : capacity_bytes_(capacity_bytes) {
+}
+
+void ResultCache::configure(const Config& config) {
+    if (!config.contains(CONFIG_KEY_CAPACITY_BYTES)) {
+        return;
+    }
+    auto value_str = config.get(CONFIG_KEY_CAPACITY_BYTES);
+    try {
+        set_capacity(std::stoull(value_str));
+    } catch (const std::exception& e) {
+        throw TileDBSOMAError(fmt::format(
+            "[ResultCache] Error parsing {}: '{}' ({})",
+            CONFIG_KEY_CAPACITY_BYTES,
+            value_str,
+            e.what()));
+    }
+}
+
+std::optional<ResultCache::Batches> ResultCache::get(const Key& key) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return std::nullopt;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second.batches;
+}
+
+bool ResultCache::insert(
+    const Key& key, std::shared_ptr<Context> ctx, Batches batches) {
+    auto bytes = num_bytes(batches);
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (bytes > capacity_bytes_) {
+        LOG_DEBUG(
+            "[ResultCache] Not caching '{}': {} bytes exceed the capacity of "
+            "{} bytes",
+            std::get<1>(key),
+            bytes,
+            capacity_bytes_);
+        return false;
+    }
+
+    if (auto it = index_.find(key); it != index_.end()) {
+        num_bytes_ -= it->second->second.num_bytes;
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+    entries_.emplace_front(key, Entry{ctx, std::move(batches), bytes});
+    index_[key] = entries_.begin();
+    num_bytes_ += bytes;
+    evict();
+    return true;
+}
+
+void ResultCache::set_capacity(size_t capacity_bytes) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    capacity_bytes_ = capacity_bytes;
+    evict();
+}
+
+size_t ResultCache::capacity() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return capacity_bytes_;
+}
+
+void ResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    index_.clear();
+    entries_.clear();
+    num_bytes_ = 0;
+}
+
+size_t ResultCache::size() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return entries_.size();
+}
+
+size_t ResultCache::bytes() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return num_bytes_;
+}
+
+//===================================================================
+//= private non-static
+//===================================================================
+
+void ResultCache::evict() {
+    while (num_bytes_ > capacity_bytes_) {
+        auto& [key, entry] = entries_.back();
+        LOG_DEBUG(
+            "[ResultCache] Evict '{}' ({} bytes)",
+            std::get<1>(key),
+            entry.num_bytes);
+        num_bytes_ -= entry.num_bytes;
+        index_.erase(key);
+        entries_.pop_back();
+    }
+}
+
+}  // namespace tiledbsoma
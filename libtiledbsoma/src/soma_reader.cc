@@ -30,13 +30,149 @@
  *   This file defines the SOMAReader class.
  */
 
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+
 #include "tiledbsoma/soma_reader.h"
+#include "tiledbsoma/array_cache.h"
+#include "tiledbsoma/cell_sorter.h"
 #include "tiledbsoma/logger_public.h"
 #include "tiledbsoma/util.h"
 
 namespace tiledbsoma {
 using namespace tiledb;
 
+namespace {
+
+/**
+ * @brief Call `fn` with a value of the C++ type of an integral TileDB
+ * datatype. Datetime and time types are represented by int64_t.
+ *
+ * @return bool The datatype is integral and `fn` was called
+ */
+template <typename Fn>
+bool visit_integral(tiledb_datatype_t type, Fn&& fn) {
+    switch (type) {
+        case TILEDB_INT8:
+            fn(int8_t{});
+            return true;
+        case TILEDB_UINT8:
+            fn(uint8_t{});
+            return true;
+        case TILEDB_INT16:
+            fn(int16_t{});
+            return true;
+        case TILEDB_UINT16:
+            fn(uint16_t{});
+            return true;
+        case TILEDB_INT32:
+            fn(int32_t{});
+            return true;
+        case TILEDB_UINT32:
+            fn(uint32_t{});
+            return true;
+        case TILEDB_UINT64:
+            fn(uint64_t{});
+            return true;
+        case TILEDB_INT64:
+        case TILEDB_DATETIME_DAY:
+        case TILEDB_DATETIME_SEC:
+        case TILEDB_DATETIME_MS:
+        case TILEDB_DATETIME_US:
+        case TILEDB_DATETIME_NS:
+        case TILEDB_TIME_SEC:
+        case TILEDB_TIME_MS:
+        case TILEDB_TIME_US:
+        case TILEDB_TIME_NS:
+            fn(int64_t{});
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Range of a dimension that is not restricted
+const std::pair<int64_t, int64_t> FULL_RANGE = {
+    std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()};
+
+// Map an integral value to int64_t, preserving order
+template <typename T>
+int64_t to_ordered(T value) {
+    if constexpr (std::is_same_v<T, uint64_t>) {
+        return static_cast<int64_t>(value ^ (uint64_t{1} << 63));
+    } else {
+        return static_cast<int64_t>(value);
+    }
+}
+
+// Inverse of `to_ordered`
+template <typename T>
+T from_ordered(int64_t value) {
+    if constexpr (std::is_same_v<T, uint64_t>) {
+        return static_cast<uint64_t>(value) ^ (uint64_t{1} << 63);
+    } else {
+        return static_cast<T>(value);
+    }
+}
+
+// Return true if the boxes intersect on every dimension
+template <typename Box>
+bool intersects(const Box& a, const Box& b) {
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].second < b[i].first || b[i].second < a[i].first) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Extend box `a` to also cover box `b`
+template <typename Box>
+void extend(Box& a, const Box& b) {
+    for (size_t i = 0; i < a.size(); i++) {
+        a[i].first = std::min(a[i].first, b[i].first);
+        a[i].second = std::max(a[i].second, b[i].second);
+    }
+}
+
+// Sort ranges and merge the ranges that overlap or are adjacent
+std::vector<std::pair<int64_t, int64_t>> merge_ranges(
+    std::vector<std::pair<int64_t, int64_t>> ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<int64_t, int64_t>> merged;
+    for (auto& range : ranges) {
+        if (range.second < range.first) {
+            continue;
+        }
+        if (!merged.empty() &&
+            (merged.back().second == std::numeric_limits<int64_t>::max() ||
+             range.first <= merged.back().second + 1)) {
+            merged.back().second = std::max(merged.back().second, range.second);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    return merged;
+}
+
+// Number of values covered by disjoint ranges, saturated at UINT64_MAX
+uint64_t num_values(const std::vector<std::pair<int64_t, int64_t>>& ranges) {
+    uint64_t total = 0;
+    for (auto& [start, end] : ranges) {
+        uint64_t width = (uint64_t)end - (uint64_t)start + 1;
+        if (width == 0 || total + width < total) {
+            return std::numeric_limits<uint64_t>::max();
+        }
+        total += width;
+    }
+    return total;
+}
+
+};  // namespace
+
 //===================================================================
 //= public static
 //===================================================================
@@ -49,10 +185,12 @@ std::unique_ptr<SOMAReader> SOMAReader::open(
     std::string_view batch_size,
     std::string_view result_order,
     std::optional<std::pair<uint64_t, uint64_t>> timestamp) {
+    // Share the Context with other readers using the same config, if arrays
+    // are cached
     return std::make_unique<SOMAReader>(
         uri,
         name,
-        std::make_shared<Context>(Config(platform_config)),
+        ArrayCache::open_context(platform_config),
         column_names,
         batch_size,
         result_order,
@@ -84,30 +222,130 @@ SOMAReader::SOMAReader(
     std::string_view result_order,
     std::optional<std::pair<uint64_t, uint64_t>> timestamp)
     : ctx_(ctx)
+    , name_(name)
     , uri_(util::rstrip_uri(uri))
     , timestamp_(timestamp) {
+    auto config = ctx_->config();
+    if (config.contains(StatsCache::CONFIG_KEY_CACHE_STATS)) {
+        auto value = config.get(StatsCache::CONFIG_KEY_CACHE_STATS);
+        if (value == "false") {
+            cache_stats_ = false;
+        } else if (value != "true") {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] Error parsing {}: '{}' (expected 'true' or "
+                "'false')",
+                StatsCache::CONFIG_KEY_CACHE_STATS,
+                value));
+        }
+    }
+    if (config.contains(ResultCache::CONFIG_KEY_CACHE_RESULTS)) {
+        auto value = config.get(ResultCache::CONFIG_KEY_CACHE_RESULTS);
+        if (value == "true") {
+            cache_results_ = true;
+        } else if (value != "false") {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] Error parsing {}: '{}' (expected 'true' or "
+                "'false')",
+                ResultCache::CONFIG_KEY_CACHE_RESULTS,
+                value));
+        }
+    }
+    if (config.contains(ArrayCache::CONFIG_KEY_CACHE_ARRAYS)) {
+        auto value = config.get(ArrayCache::CONFIG_KEY_CACHE_ARRAYS);
+        if (value == "true") {
+            cache_arrays_ = true;
+        } else if (value != "false") {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] Error parsing {}: '{}' (expected 'true' or "
+                "'false')",
+                ArrayCache::CONFIG_KEY_CACHE_ARRAYS,
+                value));
+        }
+    }
+
     // Validate parameters
     try {
-        LOG_DEBUG(fmt::format("[SOMAReader] opening array '{}'", uri_));
-        auto array = std::make_shared<Array>(*ctx_, uri_, TILEDB_READ);
-        if (timestamp) {
-            if (timestamp->first > timestamp->second) {
-                throw std::invalid_argument("timestamp start > end");
-            }
-            array->set_open_timestamp_start(timestamp->first);
-            array->set_open_timestamp_end(timestamp->second);
-            array->reopen();
+        TraceSpan span("open", "{}", uri_);
+        LOG_DEBUG("[SOMAReader] opening array '{}'", uri_);
+        if (timestamp && timestamp->first > timestamp->second) {
+            throw std::invalid_argument("timestamp start > end");
         }
+        auto array = cache_arrays_ ?
+                         ArrayCache::instance().array(ctx_, uri_, timestamp) :
+                         ArrayCache::open_array(ctx_, uri_, timestamp);
         mq_ = std::make_unique<ManagedQuery>(array, name);
-        LOG_DEBUG(
-            fmt::format("timestamp_start = {}", array->open_timestamp_start()));
-        LOG_DEBUG(
-            fmt::format("timestamp_end = {}", array->open_timestamp_end()));
+        array_ = array;
+        LOG_DEBUG("timestamp_start = {}", array->open_timestamp_start());
+        LOG_DEBUG("timestamp_end = {}", array->open_timestamp_end());
     } catch (const std::exception& e) {
         throw TileDBSOMAError(
             fmt::format("Error opening array: '{}'\n  {}", uri_, e.what()));
     }
 
+    if (config.contains(CONFIG_KEY_PREFETCH)) {
+        auto value = config.get(CONFIG_KEY_PREFETCH);
+        if (value == "true") {
+            prefetch_ = true;
+        } else if (value != "false") {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] Error parsing {}: '{}' (expected 'true' or "
+                "'false')",
+                CONFIG_KEY_PREFETCH,
+                value));
+        }
+    }
+
+    if (config.contains(CONFIG_KEY_PARTITIONS)) {
+        auto value_str = config.get(CONFIG_KEY_PARTITIONS);
+        try {
+            num_partitions_ = std::stoi(value_str);
+        } catch (const std::exception& e) {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] Error parsing {}: '{}' ({})",
+                CONFIG_KEY_PARTITIONS,
+                value_str,
+                e.what()));
+        }
+        if (num_partitions_ < 1) {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] {} must be >= 1: '{}'",
+                CONFIG_KEY_PARTITIONS,
+                value_str));
+        }
+    }
+
+    if (config.contains(CONFIG_KEY_PARTITIONS_ORDERED)) {
+        auto value = config.get(CONFIG_KEY_PARTITIONS_ORDERED);
+        if (value == "true") {
+            partitions_ordered_ = true;
+        } else if (value != "false") {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] Error parsing {}: '{}' (expected 'true' or "
+                "'false')",
+                CONFIG_KEY_PARTITIONS_ORDERED,
+                value));
+        }
+    }
+
+    if (config.contains(CONFIG_KEY_SORT_MAX_CELLS)) {
+        auto value_str = config.get(CONFIG_KEY_SORT_MAX_CELLS);
+        try {
+            sort_max_cells_ = std::stoull(value_str);
+        } catch (const std::exception& e) {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] Error parsing {}: '{}' ({})",
+                CONFIG_KEY_SORT_MAX_CELLS,
+                value_str,
+                e.what()));
+        }
+        if (sort_max_cells_ < 1) {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] {} must be >= 1: '{}'",
+                CONFIG_KEY_SORT_MAX_CELLS,
+                value_str));
+        }
+    }
+
     reset(column_names, batch_size, result_order);
 }
 
@@ -115,37 +353,174 @@ void SOMAReader::reset(
     std::vector<std::string> column_names,
     std::string_view batch_size,
     std::string_view result_order) {
-    // Reset managed query
+    // Reset managed query, discarding the results of a prefetched query
     mq_->reset();
+    prefetched_ = false;
 
-    if (!column_names.empty()) {
-        mq_->select_columns(column_names);
-    }
+    // Discard the partitions and their recorded selections
+    reset_partitions();
+    selections_.clear();
+    partition_dim_selected_ = false;
 
-    batch_size_ = batch_size;
+    // Discard the results collected for, or read from, the result cache
+    cacheable_ = true;
+    predicate_.clear();
+    dictionary_columns_.clear();
+    result_key_.reset();
+    result_batches_.clear();
+    result_bytes_ = 0;
+    cached_ = false;
+    cached_batches_.clear();
+    next_cached_batch_ = 0;
 
+    // Discard the slabs of a sorted read
+    sorted_ = false;
+    sorted_ranges_.reset();
+    slabs_.clear();
+    num_sorted_batches_ = 0;
+
+    // Set the result order first, since a sorted read records the selections
     result_order_ = "auto";
     if (result_order != "auto") {  // default "auto" is set in soma_reader.h
+        bool sparse = mq_->schema()->array_type() == TILEDB_SPARSE;
         tiledb_layout_t layout;
         if (result_order == "row-major") {
             layout = TILEDB_ROW_MAJOR;
         } else if (result_order == "column-major") {
             layout = TILEDB_COL_MAJOR;
+        } else if (result_order == "sorted") {
+            // Dense arrays are read sorted in row-major order
+            sorted_ = sparse;
+            layout = TILEDB_ROW_MAJOR;
         } else {
             throw TileDBSOMAError(
                 fmt::format("Unknown result_order '{}'", result_order));
         }
-        mq_->set_layout(layout);
+        if (!sorted_) {
+            mq_->set_layout(layout);
+            add_selection([layout](ManagedQuery& mq, int, int) {
+                mq.set_layout(layout);
+            });
+        }
         result_order_ = result_order;
     }
 
+    if (!column_names.empty()) {
+        select_columns(column_names);
+    }
+
+    batch_size_ = batch_size;
+
     first_read_next_ = true;
     submitted_ = false;
 }
 
+void SOMAReader::reopen_at(
+    std::optional<std::pair<uint64_t, uint64_t>> timestamp,
+    std::vector<std::string> column_names,
+    std::string_view batch_size,
+    std::string_view result_order) {
+    // Complete the in-flight queries before the array is reopened
+    mq_->reset();
+    prefetched_ = false;
+    reset_partitions();
+    fingerprint_.reset();
+
+    try {
+        TraceSpan span("open", "{}", uri_);
+        LOG_DEBUG("[SOMAReader] reopening array '{}'", uri_);
+        if (timestamp && timestamp->first > timestamp->second) {
+            throw std::invalid_argument("timestamp start > end");
+        }
+        if (cache_arrays_) {
+            // A cached array is shared with other readers, so it is not
+            // reopened in place
+            array_ = ArrayCache::instance().array(ctx_, uri_, timestamp);
+        } else {
+            array_->set_open_timestamp_start(timestamp ? timestamp->first : 0);
+            array_->set_open_timestamp_end(
+                timestamp ? timestamp->second :
+                            std::numeric_limits<uint64_t>::max());
+            array_->reopen();
+        }
+        mq_->set_array(array_);
+        LOG_DEBUG("timestamp_start = {}", array_->open_timestamp_start());
+        LOG_DEBUG("timestamp_end = {}", array_->open_timestamp_end());
+    } catch (const std::exception& e) {
+        throw TileDBSOMAError(
+            fmt::format("Error reopening array: '{}'\n  {}", uri_, e.what()));
+    }
+
+    timestamp_ = timestamp;
+
+    reset(column_names, batch_size, result_order);
+}
+
+void SOMAReader::set_dim_points(
+    const std::string& dim,
+    std::vector<std::string_view>& points,
+    int partition_index,
+    int partition_count) {
+    check_partition(partition_index, partition_count);
+
+    // Sort and remove duplicate points. Sorted points also keep each
+    // partition in a contiguous region of the dimension. Note: the points are
+    // not coalesced into ranges, because a string range also selects values
+    // that are not in the points.
+    std::sort(points.begin(), points.end());
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+
+    auto partition = partition_values(
+        tcb::span<const std::string_view>(points),
+        partition_index,
+        partition_count);
+
+    LOG_DEBUG(
+        "[SOMAReader] set_dim_points: dim={} index={} count={} {} of {} "
+        "unique points",
+        dim,
+        partition_index,
+        partition_count,
+        partition.size(),
+        points.size());
+
+    mq_->select_points(dim, partition);
+
+    // Copy the points if they are applied to the internal partitions or to
+    // the slabs of a sorted read later
+    if (records_selections()) {
+        add_partition_points(
+            dim, std::vector<std::string>(partition.begin(), partition.end()));
+    }
+}
+
 void SOMAReader::submit() {
-    // Submit the query
-    mq_->submit();
+    // Read the results from the result cache, if present, or collect the
+    // results to cache them
+    result_key_ = result_cache_key();
+    if (result_key_) {
+        if (auto batches = ResultCache::instance().get(*result_key_)) {
+            LOG_DEBUG("[SOMAReader] Read '{}' from the result cache", uri_);
+            result_key_.reset();
+            cached_ = true;
+            cached_batches_ = std::move(*batches);
+            next_cached_batch_ = 0;
+            submitted_ = true;
+            return;
+        }
+    }
+
+    // Split a sorted read into slabs, which are read by `read_next`
+    if (sorted_) {
+        submit_sorted();
+        submitted_ = true;
+        return;
+    }
+
+    // Submit the partitions, or the query if it is not partitioned
+    if (num_partitions_ <= 1 || !submit_partitions()) {
+        mq_->submit();
+    }
     submitted_ = true;
 }
 
@@ -155,10 +530,64 @@ std::optional<std::shared_ptr<ArrayBuffers>> SOMAReader::read_next() {
             "[SOMAReader] submit must be called before read_next");
     }
 
+    // Cached results are shared, not copied
+    if (cached_) {
+        if (next_cached_batch_ == cached_batches_.size()) {
+            return std::nullopt;
+        }
+        return cached_batches_[next_cached_batch_++];
+    }
+
+    auto results = read_next_uncached();
+    if (!result_key_) {
+        return results;
+    }
+
+    // Collect the results until the read is complete, unless they exceed the
+    // capacity of the result cache
+    if (results) {
+        result_batches_.push_back(*results);
+        result_bytes_ += ResultCache::num_bytes({*results});
+        if (result_bytes_ > ResultCache::instance().capacity()) {
+            LOG_DEBUG(
+                "[SOMAReader] Not caching '{}': results exceed the result "
+                "cache capacity",
+                uri_);
+            result_key_.reset();
+            result_batches_.clear();
+        }
+    } else {
+        ResultCache::instance().insert(
+            *result_key_, ctx_, std::move(result_batches_));
+        result_key_.reset();
+        result_batches_.clear();
+    }
+    return results;
+}
+
+std::optional<std::shared_ptr<ArrayBuffers>> SOMAReader::read_next_uncached() {
+    if (sorted_) {
+        return read_next_sorted();
+    }
+
+    if (!partitions_.empty()) {
+        return read_next_partition();
+    }
+
+    // Return the prefetched results, if present
+    if (prefetched_) {
+        prefetched_ = false;
+        auto results = mq_->results();
+        prefetch_next();
+        return results;
+    }
+
     // Always return results from the first call to read_next()
     if (first_read_next_) {
         first_read_next_ = false;
-        return mq_->results();
+        auto results = mq_->results();
+        prefetch_next();
+        return results;
     }
 
     // If the query is complete, return `std::nullopt`.
@@ -173,107 +602,684 @@ std::optional<std::shared_ptr<ArrayBuffers>> SOMAReader::read_next() {
     return mq_->results();
 }
 
+void SOMAReader::prefetch_next() {
+    if (!prefetch_ || mq_->is_complete()) {
+        return;
+    }
+
+    // The managed query runs in the background until `results` is called
+    LOG_DEBUG("[SOMAReader] prefetch next batch for '{}'", uri_);
+    mq_->submit();
+    prefetched_ = true;
+}
+
+bool SOMAReader::submit_partitions() {
+    // If the first dimension has no selection, split its non-empty domain
+    std::optional<Selection> domain_selection;
+    if (!partition_dim_selected_) {
+        auto dim = mq_->schema()->domain().dimension(0);
+        if (dim.type() != TILEDB_INT64) {
+            LOG_DEBUG(
+                "[SOMAReader] Not partitioning '{}': no selection on dimension "
+                "'{}'",
+                uri_,
+                dim.name());
+            return false;
+        }
+        std::vector<std::pair<int64_t, int64_t>> ranges = {
+            array_->non_empty_domain<int64_t>(0)};
+        domain_selection = [name = dim.name(), ranges](
+                               ManagedQuery& mq, int index, int count) {
+            mq.select_ranges(name, partition_ranges(ranges, index, count));
+        };
+    }
+
+    LOG_DEBUG(
+        "[SOMAReader] Reading '{}' in {} partitions", uri_, num_partitions_);
+
+    if (!pool_) {
+        pool_ = std::make_unique<ThreadPool>(num_partitions_);
+    }
+    completed_ = std::make_unique<ProducerConsumerQueue<size_t>>();
+    next_partition_ = 0;
+    num_partition_batches_ = 0;
+
+    // Create a managed query for each partition, sharing the open array
+    partitions_.resize(num_partitions_);
+    for (int i = 0; i < num_partitions_; i++) {
+        auto& partition = partitions_[i];
+        partition.mq = std::make_unique<ManagedQuery>(
+            array_, fmt::format("{}[{}]", name_, i));
+        for (auto& selection : selections_) {
+            selection(*partition.mq, i, num_partitions_);
+        }
+        if (domain_selection) {
+            (*domain_selection)(*partition.mq, i, num_partitions_);
+        }
+    }
+
+    for (size_t i = 0; i < partitions_.size(); i++) {
+        schedule_partition(i);
+    }
+    return true;
+}
+
+void SOMAReader::schedule_partition(size_t index) {
+    num_in_flight_++;
+    partitions_[index].task = pool_->execute([this, index]() {
+        auto& partition = partitions_[index];
+        try {
+            partition.mq->submit();
+            partition.results = partition.mq->results();
+        } catch (...) {
+            partition.error = std::current_exception();
+        }
+
+        if (!partitions_ordered_) {
+            completed_->push(index);
+        }
+        return Status::Ok();
+    });
+}
+
+std::optional<std::shared_ptr<ArrayBuffers>> SOMAReader::read_next_partition() {
+    if (num_in_flight_ == 0) {
+        return std::nullopt;
+    }
+
+    // Wait for the current partition if ordered, otherwise for the first
+    // partition to complete a chunk
+    size_t index;
+    if (partitions_ordered_) {
+        while (!partitions_[next_partition_].task.valid()) {
+            next_partition_++;
+        }
+        index = next_partition_;
+    } else {
+        index = *completed_->pop();
+    }
+
+    auto& partition = partitions_[index];
+    partition.task.get();
+    num_in_flight_--;
+
+    if (partition.error) {
+        std::rethrow_exception(std::exchange(partition.error, nullptr));
+    }
+
+    // Read ahead in the partition while the caller processes these results
+    auto results = std::move(partition.results);
+    if (!partition.mq->is_complete()) {
+        schedule_partition(index);
+    }
+
+    num_partition_batches_++;
+    return results;
+}
+
+void SOMAReader::submit_sorted() {
+    auto domain = mq_->schema()->domain();
+    for (auto& dim : domain.dimensions()) {
+        if (dim.type() != TILEDB_INT64) {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAReader] Sorted reads require int64 dimensions: '{}'",
+                dim.name()));
+        }
+    }
+    auto dim = domain.dimension(0).name();
+
+    slabs_.clear();
+    num_sorted_batches_ = 0;
+    auto ned = non_empty_domain<int64_t>(dim);
+    std::vector<std::pair<int64_t, int64_t>> ranges = {ned};
+    if (sorted_ranges_) {
+        ranges = merge_ranges(*sorted_ranges_);
+    }
+    if (ranges.empty()) {
+        return;
+    }
+
+    // Estimate the cells in the selection from the cells of the array,
+    // assuming they are uniformly distributed over the non-empty domain
+    auto covered = num_values(ranges);
+    auto ned_values = num_values({ned});
+    double fraction = std::min(1.0, (double)covered / ned_values);
+    auto num_cells = (double)nnz_bounds().second * fraction;
+    auto count = std::clamp<double>(
+        std::ceil(num_cells / sort_max_cells_),
+        1,
+        std::min<double>(covered, std::numeric_limits<int>::max()));
+
+    LOG_DEBUG(
+        "[SOMAReader] [{}] Sorted read of ~{} cells in {} slabs",
+        name_,
+        (uint64_t)num_cells,
+        (int)count);
+
+    for (int i = (int)count - 1; i >= 0; i--) {
+        slabs_.push_back(partition_ranges(ranges, i, (int)count));
+    }
+}
+
+std::optional<std::shared_ptr<ArrayBuffers>> SOMAReader::read_next_sorted() {
+    std::vector<std::string> dims;
+    for (auto& dim : mq_->schema()->domain().dimensions()) {
+        dims.push_back(dim.name());
+    }
+
+    while (!slabs_.empty()) {
+        auto slab = std::move(slabs_.back());
+        slabs_.pop_back();
+
+        // Read the slab with the recorded selections, adding the dimensions
+        // to sort by if a subset of the columns is selected
+        ManagedQuery mq(array_, fmt::format("{}[sorted]", name_));
+        for (auto& selection : selections_) {
+            selection(mq, 0, 1);
+        }
+        auto names = mq.column_names();
+        mq.select_columns(dims, true);
+        mq.select_ranges(dims[0], slab);
+
+        std::vector<std::shared_ptr<ArrayBuffers>> batches;
+        uint64_t num_cells = 0;
+        // Data of the columns exported with 32-bit offsets, which must fit
+        // in one sorted batch
+        std::unordered_map<std::string, size_t> small_offsets_bytes;
+        bool too_large = false;
+        bool can_split = num_values(slab) > 1;
+        bool split = false;
+        do {
+            mq.submit();
+            auto results = mq.results();
+            if (results->num_rows() > 0) {
+                num_cells += results->num_rows();
+                for (auto& name : results->names()) {
+                    auto buffer = results->at(name);
+                    if (buffer->has_small_offsets()) {
+                        auto& num_bytes = small_offsets_bytes[name];
+                        num_bytes += buffer->data_size();
+                        too_large |= num_bytes >
+                                     ColumnBuffer::MAX_SMALL_OFFSETS_BYTES;
+                    }
+                }
+                batches.push_back(results);
+            }
+            if (can_split && (too_large || (num_cells > sort_max_cells_ &&
+                                            !mq.is_complete()))) {
+                split = true;
+                break;
+            }
+        } while (!mq.is_complete());
+
+        {
+            std::lock_guard<std::mutex> lock(metrics_mtx_);
+            metrics_.merge(mq.metrics());
+        }
+
+        // Read the halves of a slab larger than the limits instead
+        if (split) {
+            LOG_DEBUG(
+                "[SOMAReader] [{}] Split sorted slab of more than {} cells or "
+                "{} bytes of a column with 32-bit offsets",
+                name_,
+                sort_max_cells_,
+                ColumnBuffer::MAX_SMALL_OFFSETS_BYTES);
+            slabs_.push_back(partition_ranges(slab, 1, 2));
+            slabs_.push_back(partition_ranges(slab, 0, 2));
+            continue;
+        }
+        if (num_cells == 0) {
+            continue;
+        }
+        if (num_cells > sort_max_cells_) {
+            LOG_WARN(
+                "[SOMAReader] [{}] Sorting {} cells with one value of '{}', "
+                "more than {} = {}",
+                name_,
+                num_cells,
+                dims[0],
+                CONFIG_KEY_SORT_MAX_CELLS,
+                sort_max_cells_);
+        }
+
+        first_read_next_ = false;
+        num_sorted_batches_++;
+        return CellSorter::sort(batches, dims, names);
+    }
+
+    // Always return results from the first call, empty if no cell matched
+    if (first_read_next_) {
+        first_read_next_ = false;
+        mq_->submit();
+        return mq_->results();
+    }
+    return std::nullopt;
+}
+
+void SOMAReader::set_predicate(const QueryPredicate& predicate) {
+    LOG_DEBUG(
+        "[SOMAReader] [{}] Set predicate: {}", name_, predicate.to_string());
+    auto qc = predicate.to_condition(*ctx_, *mq_->schema());
+
+    // Unlike an opaque condition, the predicate is part of the result cache
+    // key
+    auto cacheable = cacheable_;
+    set_condition(qc);
+    cacheable_ = cacheable;
+    predicate_ = predicate.to_string();
+}
+
+std::optional<ResultCache::Key> SOMAReader::result_cache_key() {
+    if (!cache_results_ || !cacheable_ || mq_->has_ranges()) {
+        return std::nullopt;
+    }
+
+    // Describe the read by the selected columns, in order, the dictionary
+    // columns, the result order and the predicate
+    std::string read;
+    for (auto& name : mq_->column_names()) {
+        read += fmt::format("{}:{},", name.size(), name);
+    }
+    read += ";";
+    for (auto& name : dictionary_columns_) {
+        read += fmt::format("{}:{},", name.size(), name);
+    }
+    read += fmt::format(";{};{}", result_order_, predicate_);
+    return ResultCache::key(*ctx_, uri_, *array_, fingerprint(), read);
+}
+
+QueryMetrics SOMAReader::metrics() const {
+    QueryMetrics metrics;
+    {
+        std::lock_guard<std::mutex> lock(metrics_mtx_);
+        metrics = metrics_;
+    }
+    metrics.merge(mq_->metrics());
+    for (auto& partition : partitions_) {
+        metrics.merge(partition.mq->metrics());
+    }
+    return metrics;
+}
+
+void SOMAReader::reset_partitions() {
+    for (auto& partition : partitions_) {
+        if (partition.task.valid()) {
+            partition.task.wait();
+        }
+    }
+
+    // Keep the metrics of the partitions
+    std::lock_guard<std::mutex> lock(metrics_mtx_);
+    for (auto& partition : partitions_) {
+        metrics_.merge(partition.mq->metrics());
+    }
+    partitions_.clear();
+    num_in_flight_ = 0;
+}
+
 uint64_t SOMAReader::nnz() {
-    // Verify array is sparse
+    return cached_stat<uint64_t>(
+        &ArrayStats::nnz, [&]() { return nnz_metadata(true).first; });
+}
+
+std::pair<uint64_t, uint64_t> SOMAReader::nnz_bounds() {
+    // An exact nnz is the tightest bound
+    if (cache_stats_) {
+        auto key = stats_key();
+        if (auto nnz = StatsCache::instance().get(key).nnz) {
+            return {*nnz, *nnz};
+        }
+    }
+    return cached_stat<std::pair<uint64_t, uint64_t>>(
+        &ArrayStats::nnz_bounds, [&]() { return nnz_metadata(false); });
+}
+
+std::vector<SOMAReader::Chunk> SOMAReader::plan_chunks(
+    uint64_t target_cells,
+    std::optional<std::vector<std::pair<int64_t, int64_t>>> ranges) {
     if (mq_->schema()->array_type() != TILEDB_SPARSE) {
         throw TileDBSOMAError(
-            "[SOMAReader] nnz is only supported for sparse arrays");
+            "[SOMAReader] Chunk plans are only supported for sparse arrays");
+    }
+    auto dim = mq_->schema()->domain().dimension(0);
+    if (dim.type() != TILEDB_INT64) {
+        throw TileDBSOMAError(fmt::format(
+            "[SOMAReader] Chunk plans require an int64 dimension 0: '{}'",
+            dim.name()));
+    }
+    if (target_cells == 0) {
+        throw TileDBSOMAError(
+            "[SOMAReader] Chunk plans require a positive target_cells");
+    }
+
+    auto fragment_info_ptr = load_fragment_info();
+    auto& fragment_info = *fragment_info_ptr;
+    auto fragments = find_relevant_fragments(fragment_info);
+    if (fragments.empty()) {
+        return {};
+    }
+    if (ranges) {
+        ranges = merge_ranges(*ranges);
+    } else {
+        ranges = std::vector<std::pair<int64_t, int64_t>>{
+            non_empty_domain<int64_t>(dim.name())};
     }
 
-    // Load fragment info
-    FragmentInfo fragment_info(*ctx_, uri_);
-    fragment_info.load();
+    // Spread the cells of each tile uniformly over its range of dimension 0,
+    // giving a piecewise constant density of cells per value
+    std::vector<tiledb_datatype_t> types;
+    for (auto& d : mq_->schema()->domain().dimensions()) {
+        types.push_back(d.type());
+    }
+    auto capacity = mq_->schema()->capacity();
+    std::map<int64_t, double> deltas;
+    for (auto [fid, unique] : fragments) {
+        for (auto& tile : load_tiles(
+                 fragment_info, fid, unique, types, capacity, true)) {
+            auto [start, end] = tile.mbr[0];
+            auto density = (double)tile.num_cells / num_values({{start, end}});
+            deltas[start] += density;
+            if (end < std::numeric_limits<int64_t>::max()) {
+                deltas[end + 1] -= density;
+            }
+        }
+    }
+    std::vector<std::pair<int64_t, double>> steps;
+    double density = 0;
+    for (auto& [start, delta] : deltas) {
+        density = std::max(0.0, density + delta);
+        steps.emplace_back(start, density);
+    }
+
+    // Walk the ranges through the steps of the density, cutting a chunk
+    // where its estimated cells reach the target
+    std::vector<Chunk> chunks;
+    Chunk chunk{{}, 0};
+    double chunk_cells = 0;
+    auto add_range = [&](int64_t start, int64_t end) {
+        if (!chunk.ranges.empty() && chunk.ranges.back().second + 1 == start) {
+            chunk.ranges.back().second = end;
+        } else {
+            chunk.ranges.emplace_back(start, end);
+        }
+    };
+    auto step = steps.begin();
+    density = 0;
+    for (auto [start, end] : *ranges) {
+        auto pos = start;
+        while (true) {
+            // Find the density at `pos` and the end of its step
+            while (step != steps.end() && step->first <= pos) {
+                density = step->second;
+                step++;
+            }
+            auto step_end = step == steps.end() ?
+                                end :
+                                std::min(end, step->first - 1);
+
+            for (auto first = pos;;) {
+                double available = num_values({{first, step_end}});
+                double remaining = target_cells - chunk_cells;
+                if (density * available < remaining) {
+                    add_range(first, step_end);
+                    chunk_cells += density * available;
+                    break;
+                }
+                auto needed = std::clamp(
+                    std::ceil(remaining / density), 1.0, available);
+                auto cut = std::min(step_end, first + (int64_t)needed - 1);
+                add_range(first, cut);
+                chunk.num_cells = std::llround(chunk_cells + needed * density);
+                chunks.push_back(std::move(chunk));
+                chunk = {{}, 0};
+                chunk_cells = 0;
+                if (cut == step_end) {
+                    break;
+                }
+                first = cut + 1;
+            }
+
+            if (step_end == end) {
+                break;
+            }
+            pos = step_end + 1;
+        }
+    }
+    if (!chunk.ranges.empty()) {
+        chunk.num_cells = std::llround(chunk_cells);
+        chunks.push_back(std::move(chunk));
+    }
+
+    LOG_DEBUG(
+        "[SOMAReader] [{}] Planned {} chunks of ~{} cells",
+        name_,
+        chunks.size(),
+        target_cells);
+    return chunks;
+}
+
+//===================================================================
+//= private non-static
+//===================================================================
+
+std::pair<std::string, std::string> SOMAReader::cached_non_empty_domain(
+    const std::string& dim,
+    const std::function<std::pair<std::string, std::string>()>& compute) {
+    if (!cache_stats_) {
+        return compute();
+    }
+    auto key = stats_key();
+    auto stats = StatsCache::instance().get(key);
+    if (auto it = stats.non_empty_domains.find(dim);
+        it != stats.non_empty_domains.end()) {
+        return it->second;
+    }
+    auto domain = compute();
+    StatsCache::instance().update(key, [&](ArrayStats& stats) {
+        stats.non_empty_domains[dim] = domain;
+    });
+    return domain;
+}
+
+const ArrayCache::Fingerprint& SOMAReader::fingerprint() {
+    if (!fingerprint_) {
+        fingerprint_ = ArrayCache::fingerprint(*array_, *load_fragment_info());
+    }
+    return *fingerprint_;
+}
+
+StatsCache::Key SOMAReader::stats_key() {
+    return StatsCache::key(uri_, *array_, fingerprint());
+}
 
-    LOG_DEBUG(fmt::format("[SOMAReader] Fragment info for array '{}'", uri_));
+std::shared_ptr<FragmentInfo> SOMAReader::load_fragment_info() {
+    // Load fragment info, or share the cached fragment info
+    std::shared_ptr<FragmentInfo> fragment_info;
+    if (cache_arrays_) {
+        fragment_info = ArrayCache::instance().fragment_info(
+            ctx_, uri_, *array_);
+    } else {
+        fragment_info = std::make_shared<FragmentInfo>(*ctx_, uri_);
+        fragment_info->load();
+    }
+
+    LOG_DEBUG("[SOMAReader] Fragment info for array '{}'", uri_);
     if (LOG_DEBUG_ENABLED()) {
-        fragment_info.dump();
+        fragment_info->dump();
     }
+    return fragment_info;
+}
 
-    // Find the subset of fragments contained within the read timestamp range
-    // [if any]
-    std::vector<uint32_t> relevant_fragments;
+std::vector<std::pair<uint32_t, bool>> SOMAReader::find_relevant_fragments(
+    const FragmentInfo& fragment_info) {
+    // Find the subset of fragments within the timestamp range the array was
+    // opened at, which excludes the fragments written after an array opened
+    // without a timestamp. A fragment has unique cells if it is fully
+    // contained within the timestamp range and is not a consolidated
+    // fragment, which may contain duplicates.
+    auto open_start = array_->open_timestamp_start();
+    auto open_end = array_->open_timestamp_end();
+    std::vector<std::pair<uint32_t, bool>> relevant_fragments;
     for (uint32_t fid = 0; fid < fragment_info.fragment_num(); fid++) {
         auto frag_ts = fragment_info.timestamp_range(fid);
         assert(frag_ts.first <= frag_ts.second);
-        if (timestamp_) {
-            if (frag_ts.first > timestamp_->second ||
-                frag_ts.second < timestamp_->first) {
-                // fragment is fully outside the read timestamp range: skip it
-                continue;
-            } else if (!(frag_ts.first >= timestamp_->first &&
-                         frag_ts.second <= timestamp_->second)) {
-                // fragment overlaps read timestamp range, but isn't fully
-                // contained within: fall back to count_cells to sort that out.
-                return nnz_slow();
-            }
+        bool unique = frag_ts.first == frag_ts.second;
+        if (frag_ts.first > open_end || frag_ts.second < open_start) {
+            // fragment is fully outside the read timestamp range: skip it
+            continue;
+        } else if (!(frag_ts.first >= open_start &&
+                     frag_ts.second <= open_end)) {
+            // fragment overlaps read timestamp range, but isn't fully
+            // contained within: some of its cells may not be read
+            unique = false;
         }
-        // fall through: fragment is fully contained within the read timestamp
-        // range
-        relevant_fragments.push_back(fid);
+        relevant_fragments.emplace_back(fid, unique);
+    }
+    return relevant_fragments;
+}
 
-        // If any relevant fragment is a consolidated fragment, fall back to
-        // counting cells, because the fragment may contain duplicates.
-        if (frag_ts.first != frag_ts.second) {
-            return nnz_slow();
-        }
+std::pair<uint64_t, uint64_t> SOMAReader::nnz_metadata(bool exact) {
+    // Verify array is sparse
+    if (mq_->schema()->array_type() != TILEDB_SPARSE) {
+        throw TileDBSOMAError(
+            "[SOMAReader] nnz is only supported for sparse arrays");
     }
 
-    auto fragment_count = relevant_fragments.size();
+    auto fragment_info_ptr = load_fragment_info();
+    auto& fragment_info = *fragment_info_ptr;
+    auto relevant_fragments = find_relevant_fragments(fragment_info);
 
-    if (fragment_count == 0) {
+    if (relevant_fragments.empty()) {
         // No data have been written [in the read timestamp range]
-        return 0;
+        return {0, 0};
     }
 
-    if (fragment_count == 1) {
+    if (relevant_fragments.size() == 1 && relevant_fragments[0].second) {
         // Only one fragment; return its cell_num
-        return fragment_info.cell_num(relevant_fragments[0]);
+        auto cell_num = fragment_info.cell_num(relevant_fragments[0].first);
+        return {cell_num, cell_num};
+    }
+
+    auto dimensions = mq_->schema()->domain().dimensions();
+    std::vector<std::string> names;
+    std::vector<tiledb_datatype_t> types;
+    for (auto& dim : dimensions) {
+        names.push_back(dim.name());
+        types.push_back(dim.type());
+    }
+    auto capacity = mq_->schema()->capacity();
+
+    // Find the fragments with overlapping non-empty domains, then replace
+    // those fragments with the tiles of their MBRs to narrow the overlap
+    // regions. The MBRs of all fragments are loaded in parallel.
+    std::vector<NnzTile> tiles;
+    for (auto [fid, unique] : relevant_fragments) {
+        auto ned = load_tiles(fragment_info, fid, unique, types, 0, false);
+        tiles.push_back(std::move(ned[0]));
+    }
+    auto [ned_regions, ned_boxes] = overlap_regions(tiles);
+
+    uint64_t certain_cells = 0;
+    std::vector<std::pair<uint32_t, bool>> overlapping_fragments;
+    for (size_t i = 0; i < tiles.size(); i++) {
+        if (ned_regions[i] < 0) {
+            certain_cells += tiles[i].num_cells;
+        } else {
+            overlapping_fragments.emplace_back(
+                tiles[i].fragment, tiles[i].unique);
+        }
+    }
+
+    LOG_DEBUG(
+        "[SOMAReader] nnz: {} of {} fragments have overlapping non-empty "
+        "domains",
+        overlapping_fragments.size(),
+        tiles.size());
+
+    if (overlapping_fragments.empty()) {
+        return {certain_cells, certain_cells};
+    }
+
+    auto num_threads = std::min<size_t>(
+        overlapping_fragments.size(),
+        std::max(1u, std::thread::hardware_concurrency()));
+    ThreadPool pool(num_threads);
+
+    std::vector<std::vector<NnzTile>> fragment_tiles(
+        overlapping_fragments.size());
+    std::vector<std::exception_ptr> errors(overlapping_fragments.size());
+    std::vector<ThreadPool::Task> tasks;
+    for (size_t i = 0; i < overlapping_fragments.size(); i++) {
+        tasks.push_back(pool.execute([&, i]() {
+            try {
+                auto [fid, unique] = overlapping_fragments[i];
+                // Fragments without unique cells are read over their
+                // non-empty domain, so their tiles are not loaded
+                fragment_tiles[i] = load_tiles(
+                    fragment_info, fid, unique, types, capacity, unique);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            return Status::Ok();
+        }));
+    }
+    pool.wait_all(tasks);
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    tiles.clear();
+    for (auto& ftiles : fragment_tiles) {
+        tiles.insert(
+            tiles.end(),
+            std::make_move_iterator(ftiles.begin()),
+            std::make_move_iterator(ftiles.end()));
+    }
+    fragment_tiles.clear();
+
+    auto [regions, boxes] = overlap_regions(tiles);
+
+    // Bound the number of cells in each region. The cells of a region are
+    // at least the cells of any one fragment with unique cells, and at most
+    // the cells of all fragments.
+    std::vector<std::unordered_map<uint32_t, uint64_t>> region_cells(
+        boxes.size());
+    uint64_t lower = 0;
+    uint64_t upper = 0;
+    for (size_t i = 0; i < tiles.size(); i++) {
+        auto& tile = tiles[i];
+        if (regions[i] < 0) {
+            certain_cells += tile.num_cells;
+            continue;
+        }
+        upper += tile.num_cells;
+        if (tile.unique) {
+            region_cells[regions[i]][tile.fragment] += tile.num_cells;
+        }
+    }
+    for (auto& cells : region_cells) {
+        uint64_t max_cells = 0;
+        for (auto& [fid, num_cells] : cells) {
+            max_cells = std::max(max_cells, num_cells);
+        }
+        lower += max_cells;
+    }
+
+    LOG_DEBUG(
+        "[SOMAReader] nnz: {} cells outside of {} overlap regions, {} to {} "
+        "cells inside",
+        certain_cells,
+        boxes.size(),
+        lower,
+        upper);
+
+    if (!exact || boxes.empty()) {
+        return {certain_cells + lower, certain_cells + upper};
     }
 
-    // Check for overlapping fragments on the first dimension and
-    // compute total_cell_num while going through the loop
-    uint64_t total_cell_num = 0;
-    std::vector<std::array<uint64_t, 2>> non_empty_domains(fragment_count);
-    for (uint32_t i = 0; i < fragment_count; i++) {
-        // TODO[perf]: Reading fragment info is not supported on TileDB Cloud
-        // yet, but reading one fragment at a time will be slow. Is there
-        // another way?
-        total_cell_num += fragment_info.cell_num(relevant_fragments[i]);
-        fragment_info.get_non_empty_domain(
-            relevant_fragments[i], 0, &non_empty_domains[i]);
-        LOG_DEBUG(fmt::format(
-            "[SOMAReader] fragment {} non-empty domain = [{}, {}]",
-            i,
-            non_empty_domains[i][0],
-            non_empty_domains[i][1]));
-    }
-
-    // Sort non-empty domains by the start of their ranges
-    std::sort(non_empty_domains.begin(), non_empty_domains.end());
-
-    // After sorting, if the end of a non-empty domain is >= the beginning of
-    // the next non-empty domain, there is an overlap
-    bool overlap = false;
-    for (uint32_t i = 0; i < fragment_count - 1; i++) {
-        LOG_DEBUG(fmt::format(
-            "[SOMAReader] Checking {} < {}",
-            non_empty_domains[i][1],
-            non_empty_domains[i + 1][0]));
-        if (non_empty_domains[i][1] >= non_empty_domains[i + 1][0]) {
-            overlap = true;
-            break;
-        }
-    }
-
-    // If relevant fragments do not overlap, return the total cell_num
-    if (!overlap) {
-        return total_cell_num;
-    }
-    // Found relevant fragments with overlap, count cells
-    return nnz_slow();
-}
-
-uint64_t SOMAReader::nnz_slow() {
     // If duplicates are allowed, we cannot count simply count cells.
     if (mq_->schema()->allows_dups()) {
         throw TileDBSOMAError(
@@ -282,16 +1288,218 @@ uint64_t SOMAReader::nnz_slow() {
 
     LOG_WARN(
         "[SOMAReader] nnz() found consolidated or overlapping fragments, "
-        "counting cells...");
+        "counting cells in {} regions...",
+        boxes.size());
 
+    // With too many regions, count all cells with one query
+    if (boxes.size() > MAX_NNZ_REGIONS) {
+        certain_cells = 0;
+        boxes = {Box(names.size(), FULL_RANGE)};
+    }
+
+    // Count the cells of each region in parallel
+    std::vector<uint64_t> counts(boxes.size());
+    errors.assign(boxes.size(), nullptr);
+    tasks.clear();
+    for (size_t i = 0; i < boxes.size(); i++) {
+        tasks.push_back(pool.execute([&, i]() {
+            try {
+                counts[i] = count_cells(boxes[i], names, types);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            return Status::Ok();
+        }));
+    }
+    pool.wait_all(tasks);
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    uint64_t total_cell_num = certain_cells;
+    for (auto count : counts) {
+        total_cell_num += count;
+    }
+    return {total_cell_num, total_cell_num};
+}
+
+std::vector<SOMAReader::NnzTile> SOMAReader::load_tiles(
+    const FragmentInfo& fragment_info,
+    uint32_t fid,
+    bool unique,
+    const std::vector<tiledb_datatype_t>& types,
+    uint64_t capacity,
+    bool use_mbrs) {
+    // Read the range of each integral dimension with `get_range`
+    auto read_box = [&](auto get_range) {
+        Box box;
+        for (uint32_t did = 0; did < types.size(); did++) {
+            auto range = FULL_RANGE;
+            visit_integral(types[did], [&](auto value) {
+                using T = decltype(value);
+                T bounds[2];
+                get_range(did, bounds);
+                range = {to_ordered(bounds[0]), to_ordered(bounds[1])};
+            });
+            box.push_back(range);
+        }
+        return box;
+    };
+
+    auto num_cells = fragment_info.cell_num(fid);
+    std::vector<NnzTile> tiles;
+    if (use_mbrs) {
+        try {
+            uint64_t num_mbrs = fragment_info.mbr_num(fid);
+
+            // Each tile holds `capacity` cells, except for the last tile.
+            // Otherwise, fall back to the non-empty domain.
+            if (num_mbrs > 0 && (num_mbrs - 1) * capacity < num_cells &&
+                num_cells <= num_mbrs * capacity) {
+                tiles.reserve(num_mbrs);
+                for (uint32_t mid = 0; mid < num_mbrs; mid++) {
+                    auto mbr = read_box([&](uint32_t did, void* bounds) {
+                        fragment_info.get_mbr(fid, mid, did, bounds);
+                    });
+                    uint64_t tile_cells = mid + 1 < num_mbrs ?
+                                              capacity :
+                                              num_cells - mid * capacity;
+                    tiles.push_back({fid, tile_cells, std::move(mbr), unique});
+                }
+                return tiles;
+            }
+        } catch (const TileDBError& e) {
+            LOG_DEBUG(
+                "[SOMAReader] MBRs of fragment {} not available: {}",
+                fid,
+                e.what());
+            tiles.clear();
+        }
+    }
+
+    auto ned = read_box([&](uint32_t did, void* bounds) {
+        fragment_info.get_non_empty_domain(fid, did, bounds);
+    });
+    tiles.push_back({fid, num_cells, std::move(ned), unique});
+    return tiles;
+}
+
+std::pair<std::vector<int64_t>, std::vector<SOMAReader::Box>>
+SOMAReader::overlap_regions(const std::vector<NnzTile>& tiles) {
+    // Each region is a set of tiles, tracked with a disjoint-set forest.
+    // The bounding box of a region is stored at its root tile.
+    std::vector<size_t> parent(tiles.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&](size_t i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+
+    std::vector<Box> boxes;
+    std::vector<bool> in_region;
+    for (auto& tile : tiles) {
+        boxes.push_back(tile.mbr);
+        in_region.push_back(!tile.unique);
+    }
+
+    // Merge intersecting regions and tiles until the regions are disjoint
+    // and do not intersect the remaining tiles. Each pass sweeps the regions
+    // and tiles in order of their start on dimension 0.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        std::vector<size_t> roots;
+        for (size_t i = 0; i < tiles.size(); i++) {
+            if (find(i) == i) {
+                roots.push_back(i);
+            }
+        }
+        std::sort(roots.begin(), roots.end(), [&](size_t a, size_t b) {
+            return boxes[a][0].first < boxes[b][0].first;
+        });
+
+        for (size_t a = 0; a < roots.size(); a++) {
+            auto i = roots[a];
+            for (size_t b = a + 1; b < roots.size(); b++) {
+                auto j = roots[b];
+
+                // The following roots start after the end of root `i`
+                if (boxes[j][0].first > boxes[i][0].second) {
+                    break;
+                }
+
+                // Tiles of the same fragment with unique cells do not
+                // contain the same cells
+                if (!in_region[i] && !in_region[j] &&
+                    tiles[i].fragment == tiles[j].fragment) {
+                    continue;
+                }
+                if (!intersects(boxes[i], boxes[j])) {
+                    continue;
+                }
+
+                auto root_i = find(i);
+                auto root_j = find(j);
+                if (root_i == root_j) {
+                    continue;
+                }
+                parent[root_j] = root_i;
+                extend(boxes[root_i], boxes[root_j]);
+                in_region[root_i] = true;
+                changed = true;
+            }
+        }
+    }
+
+    // Number the regions
+    std::vector<int64_t> regions(tiles.size(), -1);
+    std::vector<Box> region_boxes;
+    for (size_t i = 0; i < tiles.size(); i++) {
+        auto root = find(i);
+        if (!in_region[root]) {
+            continue;
+        }
+        if (regions[root] < 0) {
+            regions[root] = region_boxes.size();
+            region_boxes.push_back(boxes[root]);
+        }
+        regions[i] = regions[root];
+    }
+    return {regions, region_boxes};
+}
+
+uint64_t SOMAReader::count_cells(
+    const Box& region,
+    const std::vector<std::string>& names,
+    const std::vector<tiledb_datatype_t>& types) {
+    // Count the cells with an unordered read, even for a sorted reader,
+    // which would read all dimensions and sort the cells
     auto sr = SOMAReader::open(
         ctx_,
         uri_,
         "count_cells",
-        {mq_->schema()->domain().dimension(0).name()},
+        {names[0]},
         batch_size_,
-        result_order_,
+        "auto",
         timestamp_);
+
+    for (size_t did = 0; did < names.size(); did++) {
+        if (region[did] == FULL_RANGE) {
+            continue;
+        }
+        auto [start, stop] = region[did];
+        visit_integral(types[did], [&](auto value) {
+            using T = decltype(value);
+            sr->set_dim_ranges<T>(
+                names[did],
+                {{from_ordered<T>(start), from_ordered<T>(stop)}});
+        });
+    }
     sr->submit();
 
     uint64_t total_cell_num = 0;
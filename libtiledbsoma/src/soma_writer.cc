@@ -0,0 +1,481 @@
+/**
+ * @file   soma_writer.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines the SOMAWriter class.
+ */
+
+#include <set>
+
+#include "tiledbsoma/soma_writer.h"
+#include "tiledbsoma/array_cache.h"
+#include "tiledbsoma/arrow_adapter.h"
+#include "tiledbsoma/logger_public.h"
+#include "tiledbsoma/util.h"
+
+namespace tiledbsoma {
+using namespace tiledb;
+
+namespace {
+
+// Data of empty buffers, which TileDB does not accept as a null pointer
+uint8_t EMPTY_DATA[1] = {0};
+
+// Expand `length` bits of an Arrow bitmap, starting at bit `offset`, to a
+// bytemap of zeros and ones
+void to_bytemap(
+    const uint8_t* bitmap, int64_t offset, int64_t length, uint8_t* bytemap) {
+    for (int64_t i = 0; i < length; i++) {
+        auto bit = offset + i;
+        bytemap[i] = (bitmap[bit >> 3] >> (bit & 7)) & 1;
+    }
+}
+
+// Return true if any of `length` bits of an Arrow bitmap, starting at bit
+// `offset`, is not set
+bool has_unset_bit(const uint8_t* bitmap, int64_t offset, int64_t length) {
+    for (int64_t i = 0; i < length; i++) {
+        auto bit = offset + i;
+        if (((bitmap[bit >> 3] >> (bit & 7)) & 1) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+};  // namespace
+
+//===================================================================
+//= public static
+//===================================================================
+
+std::unique_ptr<SOMAWriter> SOMAWriter::open(
+    std::string_view uri,
+    std::map<std::string, std::string> platform_config,
+    std::string_view layout,
+    std::optional<uint64_t> timestamp) {
+    // Share the Context with readers and writers using the same config, if
+    // arrays are cached
+    return std::make_unique<SOMAWriter>(
+        uri,
+        ArrayCache::open_context(platform_config),
+        layout,
+        timestamp);
+}
+
+std::unique_ptr<SOMAWriter> SOMAWriter::open(
+    std::shared_ptr<Context> ctx,
+    std::string_view uri,
+    std::string_view layout,
+    std::optional<uint64_t> timestamp) {
+    return std::make_unique<SOMAWriter>(uri, ctx, layout, timestamp);
+}
+
+//===================================================================
+//= public non-static
+//===================================================================
+
+SOMAWriter::SOMAWriter(
+    std::string_view uri,
+    std::shared_ptr<Context> ctx,
+    std::string_view layout,
+    std::optional<uint64_t> timestamp)
+    : ctx_(ctx)
+    , uri_(util::rstrip_uri(uri)) {
+    if (layout == "global-order") {
+        layout_ = TILEDB_GLOBAL_ORDER;
+    } else if (layout != "unordered") {
+        throw TileDBSOMAError(fmt::format(
+            "[SOMAWriter] Invalid layout '{}' (expected 'unordered' or "
+            "'global-order')",
+            layout));
+    }
+
+    auto config = ctx_->config();
+    if (config.contains(CONFIG_KEY_IN_FLIGHT)) {
+        auto value_str = config.get(CONFIG_KEY_IN_FLIGHT);
+        int value;
+        try {
+            value = std::stoi(value_str);
+        } catch (const std::exception& e) {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAWriter] Error parsing {}: '{}' ({})",
+                CONFIG_KEY_IN_FLIGHT,
+                value_str,
+                e.what()));
+        }
+        if (value < 0) {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAWriter] Error parsing {}: '{}' (expected a value >= 0)",
+                CONFIG_KEY_IN_FLIGHT,
+                value_str));
+        }
+        max_in_flight_ = value;
+    }
+
+    try {
+        LOG_DEBUG("[SOMAWriter] opening array '{}'", uri_);
+        array_ = timestamp ? std::make_shared<Array>(
+                                 *ctx_, uri_, TILEDB_WRITE, *timestamp) :
+                             std::make_shared<Array>(*ctx_, uri_, TILEDB_WRITE);
+    } catch (const std::exception& e) {
+        throw TileDBSOMAError(
+            fmt::format("Error opening array: '{}'\n  {}", uri_, e.what()));
+    }
+
+    auto schema = array_->schema();
+    if (schema.array_type() != TILEDB_SPARSE) {
+        throw TileDBSOMAError(fmt::format(
+            "[SOMAWriter] Array '{}' is dense, only sparse arrays are "
+            "supported",
+            uri_));
+    }
+    for (auto& dim : schema.domain().dimensions()) {
+        columns_[dim.name()] = {
+            dim.type(), dim.cell_val_num() == TILEDB_VAR_NUM, false};
+    }
+    for (auto& [name, attr] : schema.attributes()) {
+        columns_[name] = {attr.type(), attr.variable_sized(), attr.nullable()};
+    }
+
+    // Batches written in global order are submitted to the same query, one
+    // at a time
+    if (layout_ == TILEDB_GLOBAL_ORDER) {
+        query_ = std::make_unique<Query>(*ctx_, *array_, TILEDB_WRITE);
+        query_->set_layout(TILEDB_GLOBAL_ORDER);
+        max_in_flight_ = std::min<size_t>(max_in_flight_, 1);
+    }
+
+    if (max_in_flight_ > 0) {
+        pool_ = std::make_unique<ThreadPool>(max_in_flight_);
+    }
+}
+
+SOMAWriter::~SOMAWriter() {
+    try {
+        close();
+    } catch (const std::exception& e) {
+        LOG_WARN("[SOMAWriter] Error closing array '{}': {}", uri_, e.what());
+    }
+}
+
+void SOMAWriter::write(ArrowArray* array, const ArrowSchema* schema) {
+    // Take ownership of the array, reusing the buffers of a written batch
+    std::unique_ptr<Batch> batch;
+    if (free_.empty()) {
+        batch = std::make_unique<Batch>();
+    } else {
+        batch = std::move(free_.back());
+        free_.pop_back();
+    }
+    batch->array = *array;
+    array->release = nullptr;
+
+    if (closed_) {
+        throw TileDBSOMAError(
+            fmt::format("[SOMAWriter] Array '{}' is closed", uri_));
+    }
+
+    // Bind the batch while the batches in flight are written
+    bind(*batch, *schema);
+    if (batch->num_cells == 0) {
+        recycle(std::move(batch));
+        return;
+    }
+
+    while (in_flight_.size() >= std::max<size_t>(max_in_flight_, 1)) {
+        complete_oldest();
+    }
+
+    auto& b = *batch;
+    in_flight_.push_back(std::move(batch));
+    if (pool_) {
+        b.task = pool_->execute([this, &b]() {
+            try {
+                submit(b);
+            } catch (...) {
+                b.error = std::current_exception();
+            }
+            return Status::Ok();
+        });
+    } else {
+        try {
+            submit(b);
+        } catch (...) {
+            b.error = std::current_exception();
+        }
+        complete_oldest();
+    }
+}
+
+void SOMAWriter::flush() {
+    // Wait for all batches before raising the first error
+    std::exception_ptr error;
+    while (!in_flight_.empty()) {
+        try {
+            complete_oldest();
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void SOMAWriter::close() {
+    if (closed_) {
+        return;
+    }
+    closed_ = true;
+
+    flush();
+    if (query_ && num_cells_ > 0) {
+        query_->finalize();
+    }
+    query_.reset();
+    array_->close();
+    LOG_DEBUG(
+        "[SOMAWriter] closed '{}' after writing {} cells", uri_, num_cells_);
+}
+
+//===================================================================
+//= private non-static
+//===================================================================
+
+void SOMAWriter::WriteBuffer::attach(Query& query) {
+    query.set_data_buffer(name, data, data_size);
+    if (offsets != nullptr) {
+        query.set_offsets_buffer(name, offsets, num_cells);
+    }
+    if (validity != nullptr) {
+        query.set_validity_buffer(name, validity, num_cells);
+    }
+}
+
+void SOMAWriter::bind(Batch& batch, const ArrowSchema& schema) {
+    auto& array = batch.array;
+    if (std::string_view(schema.format) != "+s" ||
+        schema.n_children != array.n_children) {
+        throw TileDBSOMAError(fmt::format(
+            "[SOMAWriter] Expected a struct array, got Arrow format '{}'",
+            schema.format));
+    }
+    if (array.null_count > 0) {
+        throw TileDBSOMAError(
+            "[SOMAWriter] Struct array must not contain null values");
+    }
+    if ((size_t)array.n_children != columns_.size()) {
+        throw TileDBSOMAError(fmt::format(
+            "[SOMAWriter] Batch has {} columns, array '{}' has {} dimensions "
+            "and attributes",
+            array.n_children,
+            uri_,
+            columns_.size()));
+    }
+
+    batch.num_cells = array.length;
+    batch.buffers.resize(array.n_children);
+    std::set<std::string_view> names;
+    for (int64_t i = 0; i < array.n_children; i++) {
+        auto& child_schema = *schema.children[i];
+        if (!names.insert(child_schema.name).second) {
+            throw TileDBSOMAError(fmt::format(
+                "[SOMAWriter] Column '{}' is repeated", child_schema.name));
+        }
+        bind_column(
+            batch.buffers[i],
+            child_schema,
+            *array.children[i],
+            array.offset,
+            array.length);
+    }
+}
+
+void SOMAWriter::bind_column(
+    WriteBuffer& buffer,
+    const ArrowSchema& schema,
+    const ArrowArray& array,
+    int64_t offset,
+    int64_t length) {
+    std::string name = schema.name;
+    auto it = columns_.find(name);
+    if (it == columns_.end()) {
+        throw TileDBSOMAError(fmt::format(
+            "[SOMAWriter] Column '{}' is not a dimension or attribute of '{}'",
+            name,
+            uri_));
+    }
+    auto& column = it->second;
+    if (array.dictionary != nullptr) {
+        throw TileDBSOMAError(fmt::format(
+            "[SOMAWriter] Dictionary-encoded column '{}' is not supported",
+            name));
+    }
+
+    std::string_view format = schema.format;
+    auto format_error = [&](std::string_view expected) {
+        return TileDBSOMAError(fmt::format(
+            "[SOMAWriter] Column '{}' has Arrow format '{}', expected '{}'",
+            name,
+            format,
+            expected));
+    };
+
+    auto base = offset + array.offset;
+    buffer.name = name;
+    buffer.num_cells = length;
+    buffer.offsets = nullptr;
+    buffer.validity = nullptr;
+
+    // Expand the validity bitmap to the bytemap expected by TileDB
+    auto bitmap = (const uint8_t*)array.buffers[0];
+    if (column.is_nullable) {
+        buffer.validity_buffer.resize(length);
+        if (bitmap != nullptr) {
+            to_bytemap(bitmap, base, length, buffer.validity_buffer.data());
+        } else {
+            std::fill(
+                buffer.validity_buffer.begin(),
+                buffer.validity_buffer.end(),
+                1);
+        }
+        buffer.validity = buffer.validity_buffer.data();
+    } else if (
+        bitmap != nullptr && array.null_count != 0 &&
+        (array.null_count > 0 || has_unset_bit(bitmap, base, length))) {
+        throw TileDBSOMAError(fmt::format(
+            "[SOMAWriter] Column '{}' is not nullable and contains null "
+            "values",
+            name));
+    }
+
+    if (column.is_var) {
+        if (format != "u" && format != "z" && format != "U" && format != "Z") {
+            throw format_error("U");
+        }
+        auto data = (uint8_t*)array.buffers[2];
+
+        // Point at the data of the cells and rebase the offsets to the first
+        // cell, using the Arrow offsets when they are already 64-bit and
+        // start at 0
+        auto bind_offsets = [&](auto* offsets) {
+            using Offset = std::remove_const_t<
+                std::remove_pointer_t<decltype(offsets)>>;
+            auto start = offsets[base];
+            buffer.data = data + start;
+            buffer.data_size = offsets[base + length] - start;
+            if (std::is_same_v<Offset, int64_t> && start == 0) {
+                buffer.offsets = (uint64_t*)(offsets + base);
+            } else {
+                buffer.offsets_buffer.resize(length);
+                for (int64_t i = 0; i < length; i++) {
+                    buffer.offsets_buffer[i] = offsets[base + i] - start;
+                }
+                buffer.offsets = buffer.offsets_buffer.data();
+            }
+        };
+        if (format == "U" || format == "Z") {
+            bind_offsets((const int64_t*)array.buffers[1]);
+        } else {
+            bind_offsets((const int32_t*)array.buffers[1]);
+        }
+    } else if (column.type == TILEDB_BOOL) {
+        // Expand the Arrow bitmap to the bytes expected by TileDB
+        if (format != "b") {
+            throw format_error("b");
+        }
+        buffer.data_buffer.resize(length);
+        to_bytemap(
+            (const uint8_t*)array.buffers[1],
+            base,
+            length,
+            buffer.data_buffer.data());
+        buffer.data = buffer.data_buffer.data();
+        buffer.data_size = length;
+    } else {
+        // Accept timestamps with a timezone, which are written as UTC
+        auto expected = ArrowAdapter::to_arrow_format(column.type);
+        if (format.substr(0, expected.size()) != expected ||
+            (format.size() != expected.size() && expected.back() != ':')) {
+            throw format_error(expected);
+        }
+        auto type_size = tiledb::impl::type_size(column.type);
+        buffer.data = (uint8_t*)array.buffers[1] + base * type_size;
+        buffer.data_size = length;
+    }
+
+    if (buffer.data == nullptr || length == 0) {
+        buffer.data = EMPTY_DATA;
+    }
+}
+
+void SOMAWriter::submit(Batch& batch) {
+    // Write each unordered batch to a new fragment
+    std::unique_ptr<Query> unordered;
+    auto query = query_.get();
+    if (query == nullptr) {
+        unordered = std::make_unique<Query>(*ctx_, *array_, TILEDB_WRITE);
+        unordered->set_layout(TILEDB_UNORDERED);
+        query = unordered.get();
+    }
+
+    for (auto& buffer : batch.buffers) {
+        buffer.attach(*query);
+    }
+    if (query->submit() == Query::Status::FAILED) {
+        throw TileDBSOMAError(
+            fmt::format("[SOMAWriter] [{}] Write query FAILED", uri_));
+    }
+    LOG_DEBUG("[SOMAWriter] wrote {} cells to '{}'", batch.num_cells, uri_);
+}
+
+void SOMAWriter::complete_oldest() {
+    auto batch = std::move(in_flight_.front());
+    in_flight_.pop_front();
+    if (batch->task.valid()) {
+        batch->task.get();
+    }
+    if (!batch->error) {
+        num_cells_ += batch->num_cells;
+    }
+    recycle(std::move(batch));
+}
+
+void SOMAWriter::recycle(std::unique_ptr<Batch> batch) {
+    batch->release();
+    auto error = std::exchange(batch->error, nullptr);
+    free_.push_back(std::move(batch));
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace tiledbsoma
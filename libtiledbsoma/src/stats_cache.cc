@@ -0,0 +1,109 @@
+/**
+ * @file   stats_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file defines the array statistics cache.
+ */
+
+#include <functional>
+
+#include "tiledbsoma/common.h"
+#include "tiledbsoma/logger_public.h"
+#include "tiledbsoma/stats_cache.h"
+
+namespace tiledbsoma {
+
+using namespace tiledb;
+
+//===================================================================
+//= public static
+//===================================================================
+
+StatsCache& StatsCache::instance() {
+    static StatsCache cache;
+    return cache;
+}
+
+StatsCache::Key StatsCache::key(
+    const std::string& uri,
+    uint64_t timestamp_start,
+    uint64_t timestamp_end,
+    const Fingerprint& fingerprint) {
+    return {uri, timestamp_start, timestamp_end, fingerprint};
+}
+
+StatsCache::Key StatsCache::key(
+    const std::string& uri,
+    const Array& array,
+    const Fingerprint& fingerprint) {
+    return key(
+        uri,
+        array.open_timestamp_start(),
+        array.open_timestamp_end(),
+        fingerprint);
+}
+
+//===================================================================
+//= public non-static
+//===================================================================
+
+StatsCache::StatsCache(size_t capacity)
+    : stats_(capacity) {
+}
+
+ArrayStats StatsCache::get(const Key& key) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (auto stats = stats_.get(key)) {
+        return **stats;
+    }
+    return {};
+}
+
+void StatsCache::update(
+    const Key& key, const std::function<void(ArrayStats&)>& update) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto stats = stats_.insert(key, std::make_shared<ArrayStats>());
+    update(*stats);
+}
+
+void StatsCache::set_capacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stats_.set_capacity(capacity);
+}
+
+void StatsCache::clear() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stats_.clear();
+}
+
+size_t StatsCache::size() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stats_.size();
+}
+
+}  // namespace tiledbsoma
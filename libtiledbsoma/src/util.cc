@@ -73,4 +73,31 @@ std::string rstrip_uri(std::string_view uri) {
     return std::regex_replace(std::string(uri), std::regex("/+$"), "");
 }
 
+void parallel_for(
+    ThreadPool& pool, size_t n, const std::function<void(size_t)>& fn) {
+    if (n == 1) {
+        fn(0);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(n);
+    std::vector<ThreadPool::Task> tasks;
+    for (size_t i = 0; i < n; i++) {
+        tasks.push_back(pool.execute([&, i]() {
+            try {
+                fn(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            return Status::Ok();
+        }));
+    }
+    pool.wait_all(tasks);
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
 };  // namespace tiledbsoma::util
@@ -0,0 +1,94 @@
+/**
+ * @file   test_arrays.h
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * This file defines the test arrays shared by the cache unit tests
+ */
+
+#ifndef TEST_ARRAYS_H
+#define TEST_ARRAYS_H
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <tiledb/tiledb>
+
+namespace test_arrays {
+
+using namespace tiledb;
+
+/**
+ * @brief Create a sparse array with an int64 dimension "d0" over [0, 1000]
+ * and an int32 attribute "a0", removing an existing array at the URI.
+ *
+ * @param uri Array URI
+ * @param ctx TileDB context
+ */
+inline void create_array(const std::string& uri, Context& ctx) {
+    auto vfs = VFS(ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+
+    ArraySchema schema(ctx, TILEDB_SPARSE);
+    auto dim = Dimension::create<int64_t>(ctx, "d0", {0, 1000});
+    Domain domain(ctx);
+    domain.add_dimension(dim);
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<int32_t>(ctx, "a0"));
+    Array::create(uri, schema);
+}
+
+/**
+ * @brief Write a fragment with the coordinates to an array created by
+ * `create_array`. The "a0" value of each cell is its coordinate.
+ *
+ * @param uri Array URI
+ * @param ctx TileDB context
+ * @param d0 Coordinates
+ * @param timestamp Optional write timestamp
+ */
+inline void write_array(
+    const std::string& uri,
+    Context& ctx,
+    std::vector<int64_t> d0,
+    std::optional<uint64_t> timestamp = std::nullopt) {
+    std::vector<int32_t> a0(d0.begin(), d0.end());
+    Array array = timestamp ? Array(ctx, uri, TILEDB_WRITE, *timestamp) :
+                              Array(ctx, uri, TILEDB_WRITE);
+    Query query(ctx, array);
+    query.set_layout(TILEDB_UNORDERED)
+        .set_data_buffer("d0", d0)
+        .set_data_buffer("a0", a0);
+    query.submit();
+    array.close();
+}
+
+}  // namespace test_arrays
+
+#endif
@@ -1,8 +1,11 @@
 #!/usr/bin/env python
 
+import json
 import os
 
+import numpy as np
 import pyarrow as pa
+import pytest
 
 import tiledbsoma.libtiledbsoma as clib
 
@@ -67,6 +70,161 @@ def test_soma_reader_var_x_data():
     assert total_num_rows == 4848644
 
 
+def test_soma_reader_reopen_at():
+    """Reuse a reader to read the obs array at several timestamps."""
+
+    name = "obs"
+    uri = os.path.join(SOMA_URI, name)
+    sr = clib.SOMAReader(uri)
+    sr.set_dim_points("soma_joinid", [0, 1, 2])
+    sr.submit()
+    expected = sr.read_next()
+
+    # Reopen at a timestamp range including all fragments
+    sr.reopen_at((0, 2**63 - 1))
+    sr.set_dim_points("soma_joinid", [0, 1, 2])
+    sr.submit()
+    assert sr.read_next() == expected
+
+    # Reopen at the latest fragments, selecting columns as by reset
+    sr.reopen_at(None, column_names=["soma_joinid"])
+    sr.set_dim_points("soma_joinid", [0, 1, 2])
+    sr.submit()
+    arrow_table = sr.read_next()
+    assert arrow_table.column_names == ["soma_joinid"]
+    assert arrow_table.num_rows == 3
+
+    with pytest.raises(RuntimeError):
+        sr.reopen_at((2, 1))
+
+
+def test_soma_reader_trace(tmp_path):
+    """Record trace spans of a read to a Chrome trace file."""
+
+    name = "obs"
+    uri = os.path.join(SOMA_URI, name)
+    tracefile = str(tmp_path / "trace.json")
+
+    clib.trace_start(tracefile)
+    try:
+        sr = clib.SOMAReader(uri)
+        sr.submit()
+        while True:
+            arrow_table = sr.read_next()
+            if not arrow_table:
+                break
+    finally:
+        clib.trace_stop()
+
+    with open(tracefile) as f:
+        events = json.load(f)
+    names = {event["name"] for event in events}
+    assert {"open", "submit", "wait", "export"} <= names
+    assert all(event["ph"] == "X" and event["dur"] >= 0 for event in events)
+
+
+def test_soma_reader_metrics():
+    """Read metrics count the submits, cells and bytes of a read."""
+
+    name = "obs"
+    uri = os.path.join(SOMA_URI, name)
+    sr = clib.SOMAReader(uri, column_names=["soma_joinid"])
+    assert sr.metrics()["num_submits"] == 0
+    sr.submit()
+    while True:
+        arrow_table = sr.read_next()
+        if not arrow_table:
+            break
+
+    metrics = sr.metrics()
+    assert metrics["num_submits"] >= 1
+    assert metrics["num_cells"] == 2638
+    assert metrics["columns"]["soma_joinid"]["cells"] == 2638
+    assert metrics["columns"]["soma_joinid"]["bytes"] == 2638 * 8
+    assert 0 < metrics["columns"]["soma_joinid"]["utilization"] <= 1
+    assert metrics["submit_seconds"] >= 0
+    assert metrics["gil_seconds"] >= metrics["arrow_export_seconds"] > 0
+
+    assert json.loads(sr.metrics_json())["num_cells"] == 2638
+
+
+def test_soma_reader_memory_budget():
+    """Reads shrink their buffers to fit the memory budget."""
+
+    name = "obs"
+    uri = os.path.join(SOMA_URI, name)
+
+    # The config of a reader does not configure the memory governor
+    config = {"soma.mem.total_budget": str(1 << 21)}
+    clib.SOMAReader(uri, platform_config=config)
+    assert clib.memory_governor_stats()["budget"] == 0
+
+    # The default buffers exceed the budget, so they are shrunk to fit it
+    budget = 1 << 21
+    clib.set_memory_budget(budget)
+    try:
+        sr = clib.SOMAReader(uri)
+        sr.submit()
+        num_rows = 0
+        while True:
+            batch = sr.read_next()
+            if batch is None:
+                break
+            num_rows += batch.num_rows
+            del batch
+        assert num_rows == 2638
+        assert sr.metrics()["num_memory_shrinks"] >= 1
+
+        stats = clib.memory_governor_stats()
+        assert stats["budget"] == budget
+        assert 0 < stats["peak_bytes"] <= budget
+        del sr
+        assert clib.memory_governor_stats()["reserved_bytes"] == 0
+    finally:
+        # A budget of 0 disables the governor
+        clib.set_memory_budget(0)
+    assert clib.memory_governor_stats()["budget"] == 0
+
+
+def test_soma_reader_result_cache():
+    """Repeated reads of obs are served from the result cache."""
+
+    name = "obs"
+    uri = os.path.join(SOMA_URI, name)
+    # Readers share the array, so they read at the same timestamp range
+    platform_config = {"soma.cache_results": "true", "soma.cache_arrays": "true"}
+    clib.clear_result_cache()
+
+    def read():
+        sr = clib.SOMAReader(
+            uri,
+            column_names=["soma_joinid", "louvain"],
+            platform_config=platform_config,
+        )
+        sr.submit()
+        tables = []
+        while True:
+            arrow_table = sr.read_next()
+            if not arrow_table:
+                break
+            tables.append(arrow_table)
+        return pa.concat_tables(tables)
+
+    first = read()
+    cached_bytes = clib.result_cache_bytes()
+    assert cached_bytes > 0
+
+    assert read() == first
+    assert clib.result_cache_bytes() == cached_bytes
+
+    # Results beyond the capacity are not cached
+    clib.clear_result_cache()
+    clib.set_result_cache_capacity(0)
+    assert read() == first
+    assert clib.result_cache_bytes() == 0
+    clib.set_result_cache_capacity(1 << 30)
+
+
 def test_soma_reader_dim_points():
     """Read scalar dimension slice from obs array into an arrow table."""
 
@@ -146,6 +304,38 @@ def test_soma_reader_dim_ranges():
     assert arrow_table.num_rows == 10
 
 
+def test_soma_reader_dim_ranges_bulk():
+    """Read many ranges given as numpy and pyarrow arrays."""
+
+    name = "obs"
+    uri = os.path.join(SOMA_URI, name)
+
+    starts = np.arange(0, 2000, 10, dtype=np.int64)
+    ends = starts + 4
+
+    def read(*args):
+        sr = clib.SOMAReader(uri)
+        sr.set_dim_ranges("soma_joinid", *args)
+        sr.submit()
+        joinids = []
+        while True:
+            batch = sr.read_next()
+            if batch is None:
+                break
+            joinids.extend(batch.column("soma_joinid").to_pylist())
+        return sorted(joinids)
+
+    expected = read(list(zip(starts.tolist(), ends.tolist())))
+    assert len(expected) == 5 * len(starts)
+
+    assert read(starts, ends) == expected
+    assert read(pa.array(starts), pa.chunked_array([ends[:50], ends[50:]])) == expected
+    assert read(np.stack([starts, ends], axis=1)) == expected
+
+    with pytest.raises(RuntimeError):
+        read(starts, ends[1:])
+
+
 def test_soma_reader_dim_mixed():
     """Read scalar and range dimension slice from obs array into an arrow table."""
 
@@ -236,6 +426,160 @@ def test_soma_reader_column_names():
     assert arrow_table.num_columns == 2
 
 
+def test_soma_reader_dictionary_columns():
+    """Read a string column of obs as an arrow dictionary array."""
+
+    name = "obs"
+    uri = os.path.join(SOMA_URI, name)
+    sr = clib.SOMAReader(uri, column_names=["soma_joinid", "louvain"])
+    sr.submit()
+    expected = sr.read_next()
+
+    sr.reset(column_names=["soma_joinid", "louvain"])
+    sr.set_dictionary_columns(["louvain"])
+    sr.submit()
+    arrow_table = sr.read_next()
+
+    assert sr.results_complete()
+    assert pa.types.is_dictionary(arrow_table["louvain"].type)
+    assert pa.types.is_dictionary(arrow_table.schema.field("louvain").type)
+    assert arrow_table["louvain"].combine_chunks().dictionary_decode().equals(
+        expected["louvain"].combine_chunks()
+    )
+    assert arrow_table["soma_joinid"].equals(expected["soma_joinid"])
+
+    # names that are missing or fixed-length are rejected
+    sr.reset()
+    with pytest.raises(RuntimeError):
+        sr.set_dictionary_columns(["soma_joinid"])
+
+
+def test_soma_reader_small_offsets():
+    """Read the string columns of obs with 32-bit offsets."""
+
+    name = "obs"
+    uri = os.path.join(SOMA_URI, name)
+    sr = clib.SOMAReader(uri, column_names=["soma_joinid", "louvain"])
+    sr.submit()
+    expected = sr.read_next()
+    assert pa.types.is_large_string(expected["louvain"].type)
+
+    sr = clib.SOMAReader(
+        uri,
+        column_names=["soma_joinid", "louvain"],
+        platform_config={"soma.arrow_small_offsets": "true"},
+    )
+    sr.submit()
+    arrow_table = sr.read_next()
+
+    assert sr.results_complete()
+    assert pa.types.is_string(arrow_table["louvain"].type)
+    assert arrow_table.num_rows == expected.num_rows
+    assert arrow_table["louvain"].to_pylist() == expected["louvain"].to_pylist()
+    assert arrow_table["soma_joinid"].equals(expected["soma_joinid"])
+
+
+def test_soma_reader_sorted():
+    """Read a slice of X/data sorted by its coordinates."""
+
+    name = "X/data"
+    uri = os.path.join(SOMA_URI, "ms/RNA", name)
+    sr = clib.SOMAReader(
+        uri,
+        result_order="sorted",
+        platform_config={"soma.read_sort_max_cells": "10000"},
+    )
+    sr.set_dim_ranges("soma_dim_0", [[100, 199]])
+    sr.submit()
+
+    tables = []
+    while True:
+        arrow_table = sr.read_next()
+        if not arrow_table:
+            break
+        tables.append(arrow_table)
+    assert len(tables) > 1
+    result = pa.concat_tables(tables)
+
+    dim_0 = result["soma_dim_0"].to_numpy()
+    dim_1 = result["soma_dim_1"].to_numpy()
+    assert dim_0.min() >= 100 and dim_0.max() <= 199
+    keys = list(zip(dim_0, dim_1))
+    assert keys == sorted(keys)
+
+    # the same cells as an unordered read
+    sr = clib.SOMAReader(uri)
+    sr.set_dim_ranges("soma_dim_0", [[100, 199]])
+    sr.submit()
+    expected = sr.read_next()
+    assert sr.results_complete()
+    assert result.num_rows == expected.num_rows
+
+
+def test_axis_aggregator():
+    """Aggregate the rows of X/data while reading it."""
+
+    name = "X/data"
+    uri = os.path.join(SOMA_URI, "ms/RNA", name)
+    sr = clib.SOMAReader(uri)
+    sr.set_dim_ranges("soma_dim_0", [[0, 99]])
+    sr.submit()
+    aggregator = clib.AxisAggregator(0, 100)
+    assert aggregator.read(sr) > 0
+
+    sr.reset()
+    sr.set_dim_ranges("soma_dim_0", [[0, 99]])
+    sr.submit()
+    tables = []
+    while True:
+        arrow_table = sr.read_next()
+        if not arrow_table:
+            break
+        tables.append(arrow_table)
+    result = pa.concat_tables(tables)
+    dim_0 = result["soma_dim_0"].to_numpy()
+    data = result["soma_data"].to_numpy().astype(np.float64)
+
+    assert aggregator.num_cells() == result.num_rows
+    assert np.array_equal(aggregator.nnz(), np.bincount(dim_0, minlength=100))
+    expected = np.bincount(dim_0, weights=data, minlength=100)
+    assert np.allclose(aggregator.sum(), expected)
+    assert np.allclose(aggregator.mean(1838), expected / 1838)
+    squares = np.bincount(dim_0, weights=data * data, minlength=100)
+    variance = (squares - expected * expected / 1838) / 1837
+    assert np.allclose(aggregator.variance(1838), variance)
+
+
+def test_soma_reader_chunk_plan():
+    """Read X/data in chunks planned from the fragment metadata."""
+
+    name = "X/data"
+    uri = os.path.join(SOMA_URI, "ms/RNA", name)
+    sr = clib.SOMAReader(uri)
+    chunks = sr.plan_chunks(1000000)
+    assert len(chunks) > 1
+    assert chunks[0][0][0][0] == sr.non_empty_domain("soma_dim_0")[0]
+
+    total_num_rows = 0
+    for ranges, num_cells in reversed(chunks):
+        assert num_cells > 0
+        sr.reset()
+        sr.select_chunk(ranges)
+        sr.submit()
+        while True:
+            arrow_table = sr.read_next()
+            if not arrow_table:
+                break
+            if arrow_table.num_rows == 0:
+                continue
+            dim_0 = arrow_table["soma_dim_0"].to_numpy()
+            assert dim_0.min() >= ranges[0][0]
+            assert dim_0.max() <= ranges[-1][1]
+            total_num_rows += arrow_table.num_rows
+
+    assert total_num_rows == 4848644
+
+
 def test_nnz():
     name = "obs"
     uri = os.path.join(SOMA_URI, name)
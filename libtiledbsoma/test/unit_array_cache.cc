@@ -0,0 +1,153 @@
+/**
+ * @file   unit_array_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ * This file manages unit tests for the array cache
+ */
+
+#include <limits>
+
+#include <catch2/catch_test_macros.hpp>
+#include <tiledb/tiledb>
+#include <tiledbsoma/tiledbsoma>
+
+#include "test_arrays.h"
+
+using namespace tiledb;
+using namespace tiledbsoma;
+using namespace test_arrays;
+
+TEST_CASE("ArrayCache: LRU eviction") {
+    LRUCache<int, std::string> cache(2);
+    REQUIRE(cache.insert(1, "one") == "one");
+    REQUIRE(cache.insert(2, "two") == "two");
+
+    // Inserting a cached key returns the cached value
+    REQUIRE(cache.insert(1, "uno") == "one");
+
+    // Key 2 is the least recently used, because key 1 was accessed
+    cache.insert(3, "three");
+    REQUIRE(cache.size() == 2);
+    REQUIRE(!cache.get(2).has_value());
+    REQUIRE(cache.get(1) == "one");
+    REQUIRE(cache.get(3) == "three");
+
+    cache.set_capacity(1);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.get(3) == "three");
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+}
+
+TEST_CASE("ArrayCache: Shared contexts and arrays") {
+    ArrayCache cache;
+
+    // Contexts with the same config are shared
+    auto ctx = cache.context({{"soma.init_buffer_bytes", "1024"}});
+    REQUIRE(ctx == cache.context({{"soma.init_buffer_bytes", "1024"}}));
+    REQUIRE(ctx != cache.context({{"soma.init_buffer_bytes", "2048"}}));
+    REQUIRE(ctx->config().get("soma.init_buffer_bytes") == "1024");
+
+    std::string uri = "mem://unit-test-array-cache";
+    create_array(uri, *ctx);
+
+    // Arrays are shared for the same context, uri and timestamp range
+    auto array = cache.array(ctx, uri);
+    REQUIRE(array->is_open());
+    REQUIRE(array == cache.array(ctx, uri));
+    auto timestamp = std::pair<uint64_t, uint64_t>(0, 1);
+    REQUIRE(array != cache.array(ctx, uri, timestamp));
+
+    // Fragment info is shared for the same open timestamp range
+    auto fragment_info = cache.fragment_info(ctx, uri, *array);
+    REQUIRE(fragment_info->fragment_num() == 0);
+    REQUIRE(fragment_info == cache.fragment_info(ctx, uri, *array));
+    auto other_array = cache.array(ctx, uri, timestamp);
+    REQUIRE(fragment_info != cache.fragment_info(ctx, uri, *other_array));
+
+    // 2 contexts, 2 arrays, 2 fragment info
+    REQUIRE(cache.size() == 6);
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+
+    // Arrays held by callers remain open after they are evicted
+    REQUIRE(array->is_open());
+}
+
+TEST_CASE("ArrayCache: Contexts are shared if arrays are cached") {
+    ArrayCache::instance().clear();
+
+    std::map<std::string, std::string> config = {
+        {"soma.init_buffer_bytes", "1024"}};
+    auto ctx = ArrayCache::open_context(config);
+    REQUIRE(ctx != ArrayCache::open_context(config));
+    REQUIRE(ArrayCache::instance().size() == 0);
+
+    config["soma.cache_arrays"] = "true";
+    ctx = ArrayCache::open_context(config);
+    REQUIRE(ctx == ArrayCache::open_context(config));
+    REQUIRE(ArrayCache::instance().size() == 1);
+
+    ArrayCache::instance().clear();
+}
+
+TEST_CASE("ArrayCache: SOMAReader with cached arrays") {
+    ArrayCache::instance().clear();
+
+    std::map<std::string, std::string> config = {
+        {"soma.cache_arrays", "true"}};
+    std::string uri = "mem://unit-test-array-cache-reader";
+    create_array(uri, *ArrayCache::instance().context(config));
+
+    auto sr1 = SOMAReader::open(uri, "sr1", config);
+    auto sr2 = SOMAReader::open(uri, "sr2", config);
+
+    // The context, array and fragment info are cached for both readers
+    REQUIRE(sr1->schema()->array_type() == TILEDB_SPARSE);
+    REQUIRE(sr1->nnz() == 0);
+    REQUIRE(sr2->nnz() == 0);
+    REQUIRE(ArrayCache::instance().size() == 3);
+
+    sr1->submit();
+    auto batch = sr1->read_next();
+    REQUIRE(batch.has_value());
+    REQUIRE((*batch)->num_rows() == 0);
+
+    // A reader of the array at a new timestamp range loads the fragment info
+    // again, so the nnz includes the fragments written since the first load
+    write_array(uri, *ArrayCache::instance().context(config), {1, 2, 3});
+    auto timestamp = std::pair<uint64_t, uint64_t>(
+        0, std::numeric_limits<uint64_t>::max() - 1);
+    auto sr3 = SOMAReader::open(
+        uri, "sr3", config, {}, "auto", "auto", timestamp);
+    REQUIRE(sr3->nnz() == 3);
+    REQUIRE(sr1->nnz() == 0);
+
+    ArrayCache::instance().clear();
+}
@@ -0,0 +1,265 @@
+/**
+ * @file   unit_axis_aggregator.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file manages unit tests for the AxisAggregator class
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+#include <tiledb/tiledb>
+#include <tiledbsoma/tiledbsoma>
+
+using namespace tiledb;
+using namespace tiledbsoma;
+using namespace Catch::Matchers;
+
+namespace {
+
+// Create a 2D sparse array with the cells (row, col) where (row + col) % 3 is
+// not 0, with value row + col, written in random order
+std::string create_array(
+    const std::string& uri, Context& ctx, int num_rows, int num_cols) {
+    auto vfs = VFS(ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+
+    ArraySchema schema(ctx, TILEDB_SPARSE);
+    Domain domain(ctx);
+    for (auto& name : {"soma_dim_0", "soma_dim_1"}) {
+        domain.add_dimension(
+            Dimension::create<int64_t>(ctx, name, {0, 9999}, 100));
+    }
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<float>(ctx, "soma_data"));
+    schema.check();
+    Array::create(uri, schema);
+
+    std::vector<int64_t> d0, d1;
+    std::vector<float> a0;
+    for (int64_t row = 0; row < num_rows; row++) {
+        for (int64_t col = 0; col < num_cols; col++) {
+            if ((row + col) % 3 != 0) {
+                d0.push_back(row);
+                d1.push_back(col);
+                a0.push_back(row + col);
+            }
+        }
+    }
+    std::vector<size_t> order(d0.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937{0});
+    std::vector<int64_t> s0, s1;
+    std::vector<float> sa;
+    for (auto i : order) {
+        s0.push_back(d0[i]);
+        s1.push_back(d1[i]);
+        sa.push_back(a0[i]);
+    }
+
+    Array array(ctx, uri, TILEDB_WRITE);
+    Query query(ctx, array);
+    query.set_layout(TILEDB_UNORDERED)
+        .set_data_buffer("soma_dim_0", s0)
+        .set_data_buffer("soma_dim_1", s1)
+        .set_data_buffer("soma_data", sa);
+    query.submit();
+    array.close();
+
+    return uri;
+}
+
+};  // namespace
+
+TEST_CASE("AxisAggregator: row and column aggregates") {
+    // Use small buffers to read the array in multiple batches
+    std::map<std::string, std::string> config = {
+        {"soma.init_buffer_bytes", "1048576"}};
+    auto ctx = std::make_shared<Context>(Config(config));
+    int num_rows = 600;
+    int num_cols = 500;
+    auto uri = create_array(
+        "mem://unit-test-axis-aggregator", *ctx, num_rows, num_cols);
+
+    auto axis = GENERATE(0, 1);
+    auto num_threads = GENERATE(1u, 4u);
+    int size = axis == 0 ? num_rows : num_cols;
+    int other = axis == 0 ? num_cols : num_rows;
+
+    auto sr = SOMAReader::open(ctx, uri);
+    sr->submit();
+
+    AxisAggregator aggregator(axis, size, num_threads);
+    REQUIRE(aggregator.read(*sr) > 1);
+
+    uint64_t num_cells = 0;
+    auto& aggregates = aggregator.aggregates();
+    REQUIRE(aggregates.nnz.size() == (uint64_t)size);
+    for (int64_t i = 0; i < size; i++) {
+        uint64_t nnz = 0;
+        double sum = 0;
+        for (int64_t j = 0; j < other; j++) {
+            if ((i + j) % 3 != 0) {
+                nnz++;
+                sum += i + j;
+            }
+        }
+        double m2 = 0;
+        for (int64_t j = 0; j < other; j++) {
+            if ((i + j) % 3 != 0) {
+                m2 += (i + j - sum / nnz) * (i + j - sum / nnz);
+            }
+        }
+        REQUIRE(aggregates.nnz[i] == nnz);
+        REQUIRE(aggregates.sum[i] == sum);
+        REQUIRE_THAT(aggregates.m2[i], WithinRel(m2, 1e-9));
+        num_cells += nnz;
+    }
+    REQUIRE(aggregator.num_cells() == num_cells);
+
+    // The means and variances count the implicit zeros
+    auto mean = aggregates.mean(other);
+    auto variance = aggregates.variance(other);
+    for (int64_t i = 0; i < size; i++) {
+        double expected_mean = aggregates.sum[i] / other;
+        double squares = 0;
+        for (int64_t j = 0; j < other; j++) {
+            double value = (i + j) % 3 != 0 ? i + j : 0;
+            squares += (value - expected_mean) * (value - expected_mean);
+        }
+        REQUIRE_THAT(mean[i], WithinRel(expected_mean, 1e-12));
+        REQUIRE_THAT(variance[i], WithinRel(squares / (other - 1), 1e-9));
+    }
+    REQUIRE(std::isnan(aggregates.mean(0)[0]));
+    REQUIRE(std::isnan(aggregates.variance(1)[0]));
+}
+
+TEST_CASE("AxisAggregator: variance of values with a large mean") {
+    std::string uri = "mem://unit-test-axis-aggregator-large-mean";
+    auto ctx = std::make_shared<Context>();
+    auto vfs = VFS(*ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+
+    ArraySchema schema(*ctx, TILEDB_SPARSE);
+    Domain domain(*ctx);
+    for (auto& name : {"soma_dim_0", "soma_dim_1"}) {
+        domain.add_dimension(
+            Dimension::create<int64_t>(*ctx, name, {0, 999999}, 1000));
+    }
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<double>(*ctx, "soma_data"));
+    schema.check();
+    Array::create(uri, schema);
+
+    // Two rows of 1e9 + (0, 1, 2, 3) repeated, with enough cells to be
+    // reduced in several chunks, and one implicit zero in the second row
+    int64_t num_cols = 1 << 18;
+    std::vector<int64_t> d0, d1;
+    std::vector<double> a0;
+    for (int64_t row = 0; row < 2; row++) {
+        for (int64_t col = row; col < num_cols; col++) {
+            d0.push_back(row);
+            d1.push_back(col);
+            a0.push_back(1e9 + col % 4);
+        }
+    }
+    {
+        Array array(*ctx, uri, TILEDB_WRITE);
+        Query query(*ctx, array);
+        query.set_layout(TILEDB_UNORDERED)
+            .set_data_buffer("soma_dim_0", d0)
+            .set_data_buffer("soma_dim_1", d1)
+            .set_data_buffer("soma_data", a0);
+        query.submit();
+        array.close();
+    }
+
+    auto num_threads = GENERATE(1u, 4u);
+    auto sr = SOMAReader::open(ctx, uri);
+    sr->submit();
+    AxisAggregator aggregator(0, 2, num_threads);
+    aggregator.read(*sr);
+
+    // The one-pass sum of squares cancels catastrophically for these values
+    auto variance = aggregator.aggregates().variance(num_cols, 0);
+    REQUIRE_THAT(variance[0], WithinRel(1.25, 1e-9));
+
+    double mean = 0;
+    for (int64_t col = 1; col < num_cols; col++) {
+        mean += (1e9 + col % 4) / num_cols;
+    }
+    double squares = mean * mean;
+    for (int64_t col = 1; col < num_cols; col++) {
+        double deviation = 1e9 + col % 4 - mean;
+        squares += deviation * deviation;
+    }
+    REQUIRE(variance[1] > 0);
+    REQUIRE_THAT(variance[1], WithinRel(squares / num_cols, 1e-6));
+}
+
+TEST_CASE("AxisAggregator: joinid remap") {
+    auto ctx = std::make_shared<Context>();
+    auto uri =
+        create_array("mem://unit-test-axis-aggregator-remap", *ctx, 20, 30);
+
+    std::vector<int64_t> rows = {7, 2, 11};
+    auto sr = SOMAReader::open(ctx, uri);
+    sr->set_dim_points("soma_dim_0", rows);
+    sr->submit();
+
+    AxisAggregator aggregator(0, 20);
+    aggregator.set_joinids(rows);
+    aggregator.read(*sr);
+
+    auto& aggregates = aggregator.aggregates();
+    REQUIRE(aggregates.nnz.size() == rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        uint64_t nnz = 0;
+        for (int64_t col = 0; col < 30; col++) {
+            nnz += (rows[i] + col) % 3 != 0;
+        }
+        REQUIRE(aggregates.nnz[i] == nnz);
+    }
+
+    // Invalid axes are errors
+    REQUIRE_THROWS_AS(AxisAggregator(2, 20), TileDBSOMAError);
+
+    // Cells outside the remapped joinids are errors
+    sr->reset();
+    sr->submit();
+    aggregator.set_joinids(std::vector<int64_t>{7});
+    REQUIRE_THROWS_AS(aggregator.read(*sr), TileDBSOMAError);
+}
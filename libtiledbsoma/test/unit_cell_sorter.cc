@@ -0,0 +1,126 @@
+/**
+ * @file   unit_cell_sorter.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file manages unit tests for the CellSorter class
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_vector.hpp>
+
+#include <tiledb/tiledb>
+#include <tiledbsoma/tiledbsoma>
+#include <tiledbsoma/util.h>
+
+using namespace tiledb;
+using namespace tiledbsoma;
+using namespace Catch::Matchers;
+
+TEST_CASE("CellSorter: Sort batches") {
+    std::string uri = "mem://unit-test-cell-sorter";
+    auto ctx = Context();
+    auto vfs = VFS(ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+
+    ArraySchema schema(ctx, TILEDB_SPARSE);
+    Domain domain(ctx);
+    domain.add_dimension(Dimension::create<int64_t>(ctx, "d0", {0, 99}, 10));
+    domain.add_dimension(Dimension::create<int64_t>(ctx, "d1", {0, 99}, 10));
+    schema.set_domain(domain);
+    auto attr = Attribute::create<std::string>(ctx, "label");
+    attr.set_nullable(true);
+    schema.add_attribute(attr);
+    schema.set_allows_dups(true);
+    Array::create(uri, schema);
+
+    std::vector<int64_t> d0 = {3, 1, 1, 3, 0};
+    std::vector<int64_t> d1 = {1, 2, 1, 1, 7};
+    std::vector<std::string> label = {"c", "b", "", "dup", "a"};
+    std::vector<uint8_t> label_valids = {1, 1, 0, 1, 1};
+    auto [label_data, label_offsets] = util::to_varlen_buffers(label, false);
+    {
+        Array array(ctx, uri, TILEDB_WRITE);
+        Query query(ctx, array);
+        query.set_layout(TILEDB_UNORDERED)
+            .set_data_buffer("d0", d0)
+            .set_data_buffer("d1", d1)
+            .set_data_buffer("label", label_data)
+            .set_offsets_buffer("label", label_offsets)
+            .set_validity_buffer("label", label_valids);
+        query.submit();
+        array.close();
+    }
+
+    // Read the upper half of d0 first, so the batches are out of order
+    auto array = std::make_shared<Array>(ctx, uri, TILEDB_READ);
+    std::vector<std::shared_ptr<ArrayBuffers>> batches;
+    for (auto range : {std::pair<int64_t, int64_t>{2, 9}, {0, 1}}) {
+        ManagedQuery mq(array);
+        mq.select_ranges<int64_t>("d0", {range});
+        mq.submit();
+        batches.push_back(mq.results());
+    }
+    REQUIRE(batches[0]->num_rows() == 2);
+    REQUIRE(batches[1]->num_rows() == 3);
+
+    // Cells with equal coordinates keep their order in the batch
+    auto dups = batches[0]->at("label")->strings();
+
+    auto sorted = CellSorter::sort(batches, {"d0", "d1"});
+    REQUIRE(sorted->names() == batches[0]->names());
+    REQUIRE_THAT(
+        std::vector<int64_t>(
+            sorted->at("d0")->data<int64_t>().begin(),
+            sorted->at("d0")->data<int64_t>().end()),
+        Equals(std::vector<int64_t>{0, 1, 1, 3, 3}));
+    REQUIRE_THAT(
+        std::vector<int64_t>(
+            sorted->at("d1")->data<int64_t>().begin(),
+            sorted->at("d1")->data<int64_t>().end()),
+        Equals(std::vector<int64_t>{7, 1, 2, 1, 1}));
+    auto labels = sorted->at("label");
+    REQUIRE_THAT(
+        labels->strings(),
+        Equals(std::vector<std::string>{"a", "", "b", dups[0], dups[1]}));
+    auto validity = labels->validity();
+    REQUIRE_THAT(
+        std::vector<uint8_t>(validity.begin(), validity.end()),
+        Equals(std::vector<uint8_t>{1, 0, 1, 1, 1}));
+    REQUIRE(labels->data_size() == 6);
+
+    // Only the requested columns are returned
+    sorted = CellSorter::sort(batches, {"d0", "d1"}, {"label"});
+    REQUIRE(sorted->names() == std::vector<std::string>{"label"});
+    REQUIRE(sorted->num_rows() == 5);
+
+    // Sorting requires int64 dimensions
+    REQUIRE_THROWS_AS(CellSorter::sort(batches, {"label"}), TileDBSOMAError);
+    REQUIRE_THROWS_AS(CellSorter::sort({}, {"d0"}), TileDBSOMAError);
+}
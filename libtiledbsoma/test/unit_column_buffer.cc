@@ -99,3 +99,157 @@ TEST_CASE("ColumnBuffer: Create from array") {
         REQUIRE(buffers->is_nullable() == true);
     }
 }
+
+TEST_CASE("ColumnBuffer: Allocated bytes") {
+    std::string uri = "mem://unit-test-array";
+    auto ctx = Context();
+    auto array = create_array(uri, ctx);
+
+    // The estimate includes the offsets and validity of the buffers
+    std::vector<std::optional<size_t>> cells = {std::nullopt, 10};
+    for (auto name : {"d1", "a1"}) {
+        for (auto num_cells : cells) {
+            auto buffers = ColumnBuffer::create(array, name, 1024, num_cells);
+            REQUIRE(
+                ColumnBuffer::alloc_bytes(array, name, 1024, num_cells) ==
+                buffers->allocated_bytes());
+        }
+    }
+    REQUIRE(
+        ColumnBuffer::alloc_bytes(array, "a1", 1024) ==
+        1024 + (1024 / 8 + 1) * 8 + 1024 / 8);
+    REQUIRE_THROWS_AS(
+        ColumnBuffer::alloc_bytes(array, "missing", 1024), TileDBSOMAError);
+}
+
+TEST_CASE("ColumnBuffer: Buffer pool") {
+    std::string uri = "mem://unit-test-array";
+    auto ctx = Context();
+    auto array = create_array(uri, ctx);
+
+    auto pool = std::make_shared<BufferPool>();
+    size_t num_bytes = 1 << 20;
+
+    {
+        // Data, offsets and validity buffers are allocated from the pool
+        auto buffers = ColumnBuffer::create(
+            array, "a1", num_bytes, std::nullopt, pool);
+        REQUIRE(buffers->capacity() == num_bytes);
+        REQUIRE(pool->num_new_blocks() == 3);
+        REQUIRE(pool->retained_bytes() == 0);
+    }
+
+    // Deleting the ColumnBuffer returns the buffers to the pool
+    REQUIRE(pool->retained_bytes() > 0);
+
+    {
+        // A new ColumnBuffer of the same size reuses the buffers
+        auto buffers = ColumnBuffer::create(
+            array, "a1", num_bytes, std::nullopt, pool);
+        REQUIRE(pool->num_new_blocks() == 3);
+        REQUIRE(pool->num_reused_blocks() == 3);
+        REQUIRE(pool->retained_bytes() == 0);
+    }
+
+    pool->clear();
+    REQUIRE(pool->retained_bytes() == 0);
+
+    // Size classes are finer than powers of two, so an offsets buffer of
+    // (2^n + 1) cells is not rounded up to (2^(n+1)) cells
+    size_t offsets_bytes = ((1 << 17) + 1) * sizeof(uint64_t);
+    pool->deallocate(pool->allocate(offsets_bytes), offsets_bytes);
+    REQUIRE(pool->retained_bytes() >= offsets_bytes);
+    REQUIRE(pool->retained_bytes() <= offsets_bytes * 5 / 4);
+    pool->clear();
+
+    // Blocks are freed instead of retained beyond the maximum size
+    auto small_pool = std::make_shared<BufferPool>(BufferPool::MIN_BLOCK_BYTES);
+    {
+        auto buffers = ColumnBuffer::create(
+            array, "d1", num_bytes, std::nullopt, small_pool);
+    }
+    REQUIRE(small_pool->retained_bytes() == 0);
+
+    // Blocks are freed instead of retained beyond the limit of all pools
+    BufferPool::set_total_max_bytes(BufferPool::total_retained_bytes());
+    pool->deallocate(pool->allocate(num_bytes), num_bytes);
+    REQUIRE(pool->retained_bytes() == 0);
+    BufferPool::set_total_max_bytes(BufferPool::DEFAULT_TOTAL_MAX_BYTES);
+}
+
+TEST_CASE("ColumnBuffer: Shared buffer pool") {
+    auto ctx = Context();
+    auto other_ctx = Context();
+
+    // The queries of a Context share its pool while they hold it
+    auto pool = BufferPool::shared(ctx);
+    REQUIRE(pool != nullptr);
+    REQUIRE(BufferPool::shared(ctx) == pool);
+    REQUIRE(BufferPool::shared(other_ctx) != pool);
+
+    // Copies of a Context share its pool
+    auto ctx_copy = ctx;
+    REQUIRE(BufferPool::shared(ctx_copy) == pool);
+
+    // A pool that outlives its Context is not returned for another Context,
+    // which gets a pool sized by its own config
+    {
+        Config small_config;
+        small_config.set("soma.buffer_pool_bytes", "4096");
+        auto small_ctx = std::make_unique<Context>(small_config);
+        auto small_pool = BufferPool::shared(*small_ctx);
+        REQUIRE(small_pool->max_bytes() == 4096);
+        small_ctx.reset();
+        auto new_ctx = Context();
+        auto new_pool = BufferPool::shared(new_ctx);
+        REQUIRE(new_pool != small_pool);
+        REQUIRE(new_pool->max_bytes() != 4096);
+    }
+
+    // Retained blocks count toward the limit of all pools
+    auto total = BufferPool::total_retained_bytes();
+    pool->deallocate(pool->allocate(1 << 20), 1 << 20);
+    REQUIRE(BufferPool::total_retained_bytes() == total + (1 << 20));
+    pool.reset();
+    REQUIRE(BufferPool::total_retained_bytes() == total);
+
+    // By default, a pool retains several initial column buffers
+    Config init_config;
+    init_config.set("soma.init_buffer_bytes", std::to_string(64 << 20));
+    REQUIRE(
+        BufferPool::create(init_config)->max_bytes() ==
+        BufferPool::DEFAULT_NUM_BUFFERS * (64 << 20));
+    REQUIRE(
+        BufferPool::create(Config())->max_bytes() >=
+        BufferPool::DEFAULT_MAX_BYTES);
+
+    // The pool is disabled by the config of the Context
+    Config config;
+    config.set("soma.buffer_pool_bytes", "0");
+    REQUIRE(BufferPool::shared(Context(config)) == nullptr);
+}
+
+TEST_CASE("ColumnBuffer: Bytemap to bitmap") {
+    // Cover the vectorized and scalar code paths
+    auto size = GENERATE(0, 1, 7, 8, 9, 15, 16, 17, 31, 32, 33, 100, 1000);
+
+    std::vector<uint8_t> bytemap(size);
+    size_t expected_count = 0;
+    for (int i = 0; i < size; i++) {
+        bytemap[i] = (i % 3 == 0) ? 0 : static_cast<uint8_t>(i % 7 + 1);
+        expected_count += bytemap[i] != 0;
+    }
+
+    std::vector<uint8_t> bitmap((size + 7) / 8);
+    auto count = ColumnBuffer::to_bitmap(bytemap, bitmap.data());
+    REQUIRE(count == expected_count);
+    for (int i = 0; i < size; i++) {
+        REQUIRE(((bitmap[i / 8] >> (i % 8)) & 1) == (bytemap[i] != 0));
+    }
+
+    // The in-place conversion matches the separate bitmap
+    ColumnBuffer::to_bitmap(tcb::span<uint8_t>(bytemap));
+    for (size_t i = 0; i < bitmap.size(); i++) {
+        REQUIRE(bytemap[i] == bitmap[i]);
+    }
+}
@@ -0,0 +1,204 @@
+/**
+ * @file   unit_compressed_matrix.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file manages unit tests for the CompressedMatrixBuilder class
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+#include <catch2/matchers/catch_matchers_exception.hpp>
+#include <catch2/matchers/catch_matchers_vector.hpp>
+#include <numeric>
+#include <random>
+
+#include <tiledb/tiledb>
+#include <tiledbsoma/tiledbsoma>
+
+using namespace tiledb;
+using namespace tiledbsoma;
+using namespace Catch::Matchers;
+
+namespace {
+
+// Create a 2D sparse array with one cell per (row, col), with value
+// row * 1000 + col, written in random order
+std::string create_array(
+    const std::string& uri, Context& ctx, int num_rows, int num_cols) {
+    auto vfs = VFS(ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+
+    ArraySchema schema(ctx, TILEDB_SPARSE);
+    Domain domain(ctx);
+    for (auto& name : {"soma_dim_0", "soma_dim_1"}) {
+        domain.add_dimension(
+            Dimension::create<int64_t>(ctx, name, {0, 9999}, 100));
+    }
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<double>(ctx, "soma_data"));
+    schema.check();
+    Array::create(uri, schema);
+
+    std::vector<int64_t> cells(num_rows * num_cols);
+    std::iota(cells.begin(), cells.end(), 0);
+    std::shuffle(cells.begin(), cells.end(), std::mt19937{0});
+
+    std::vector<int64_t> d0, d1;
+    std::vector<double> a0;
+    for (auto cell : cells) {
+        d0.push_back(cell / num_cols);
+        d1.push_back(cell % num_cols);
+        a0.push_back(d0.back() * 1000 + d1.back());
+    }
+
+    Array array(ctx, uri, TILEDB_WRITE);
+    Query query(ctx, array);
+    query.set_layout(TILEDB_UNORDERED)
+        .set_data_buffer("soma_dim_0", d0)
+        .set_data_buffer("soma_dim_1", d1)
+        .set_data_buffer("soma_data", a0);
+    query.submit();
+    array.close();
+
+    return uri;
+}
+
+// Check the matrix holds `value(row, col)` in each (row, col) of `cells`
+template <typename Fn>
+void check_matrix(
+    CompressedMatrix& matrix,
+    const std::vector<std::pair<int64_t, int64_t>>& cells,
+    Fn&& value) {
+    bool csr = matrix.format == CompressedFormat::CSR;
+    auto num_major = csr ? matrix.num_rows : matrix.num_cols;
+    REQUIRE(matrix.indptr.size() == num_major + 1);
+    REQUIRE(matrix.nnz() == cells.size());
+    REQUIRE(matrix.indptr.back() == (int64_t)cells.size());
+
+    auto values = matrix.values<double>();
+    std::vector<std::pair<int64_t, int64_t>> found;
+    for (uint64_t m = 0; m < num_major; m++) {
+        auto begin = matrix.indices.begin() + matrix.indptr[m];
+        auto end = matrix.indices.begin() + matrix.indptr[m + 1];
+        REQUIRE(std::is_sorted(begin, end));
+        for (auto i = matrix.indptr[m]; i < matrix.indptr[m + 1]; i++) {
+            auto row = csr ? (int64_t)m : matrix.indices[i];
+            auto col = csr ? matrix.indices[i] : (int64_t)m;
+            REQUIRE(values[i] == value(row, col));
+            found.emplace_back(row, col);
+        }
+    }
+    std::sort(found.begin(), found.end());
+    REQUIRE(found == cells);
+}
+
+};  // namespace
+
+TEST_CASE("CompressedMatrixBuilder: CSR and CSC") {
+    // Use small buffers to read the array in multiple batches
+    std::map<std::string, std::string> config = {
+        {"soma.init_buffer_bytes", "1048576"}};
+    auto ctx = std::make_shared<Context>(Config(config));
+    int num_rows = 500;
+    int num_cols = 400;
+    auto uri = create_array(
+        "mem://unit-test-compressed-matrix", *ctx, num_rows, num_cols);
+
+    std::vector<std::pair<int64_t, int64_t>> cells;
+    for (int64_t row = 0; row < num_rows; row++) {
+        for (int64_t col = 0; col < num_cols; col++) {
+            cells.emplace_back(row, col);
+        }
+    }
+    auto value = [](int64_t row, int64_t col) { return row * 1000 + col; };
+
+    auto format = GENERATE(CompressedFormat::CSR, CompressedFormat::CSC);
+    auto num_threads = GENERATE(1u, 4u);
+
+    auto sr = SOMAReader::open(ctx, uri);
+    sr->submit();
+
+    CompressedMatrixBuilder builder(format, num_rows, num_cols, num_threads);
+    REQUIRE(builder.read(*sr) > 1);
+    REQUIRE(builder.nnz() == cells.size());
+
+    auto matrix = builder.finish();
+    REQUIRE(matrix->num_rows == (uint64_t)num_rows);
+    REQUIRE(matrix->num_cols == (uint64_t)num_cols);
+    check_matrix(*matrix, cells, value);
+
+    // The builder is empty after finish
+    REQUIRE(builder.nnz() == 0);
+    REQUIRE(builder.finish()->nnz() == 0);
+}
+
+TEST_CASE("CompressedMatrixBuilder: joinid remap") {
+    auto ctx = std::make_shared<Context>();
+    auto uri =
+        create_array("mem://unit-test-compressed-matrix-remap", *ctx, 20, 30);
+
+    // Select rows and columns in an arbitrary order, with the columns sparse
+    // in their range to remap with a hash map
+    std::vector<int64_t> rows = {7, 2, 11};
+    std::vector<int64_t> cols = {29, 0};
+    auto sr = SOMAReader::open(ctx, uri);
+    sr->set_dim_points("soma_dim_0", rows);
+    sr->set_dim_points("soma_dim_1", cols);
+    sr->submit();
+
+    CompressedMatrixBuilder builder(CompressedFormat::CSR, 20, 30);
+    builder.set_joinids(0, rows);
+    builder.set_joinids(1, cols);
+    builder.read(*sr);
+    auto matrix = builder.finish();
+
+    REQUIRE(matrix->num_rows == rows.size());
+    REQUIRE(matrix->num_cols == cols.size());
+    std::vector<std::pair<int64_t, int64_t>> cells;
+    for (int64_t row = 0; row < (int64_t)rows.size(); row++) {
+        for (int64_t col = 0; col < (int64_t)cols.size(); col++) {
+            cells.emplace_back(row, col);
+        }
+    }
+    check_matrix(*matrix, cells, [&](int64_t row, int64_t col) {
+        return rows[row] * 1000 + cols[col];
+    });
+
+    // Joinids must be unique
+    REQUIRE_THROWS_AS(
+        builder.set_joinids(0, std::vector<int64_t>{1, 1}), TileDBSOMAError);
+
+    // Cells outside the remapped joinids are errors
+    sr->reset();
+    sr->submit();
+    builder.set_joinids(0, std::vector<int64_t>{7});
+    builder.read(*sr);
+    REQUIRE_THROWS_AS(builder.finish(), TileDBSOMAError);
+}
@@ -0,0 +1,200 @@
+/**
+ * @file   unit_experiment_query.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file manages unit tests for the ExperimentQuery class
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <numeric>
+
+#include <tiledb/tiledb>
+#include <tiledbsoma/tiledbsoma>
+
+using namespace tiledb;
+using namespace tiledbsoma;
+
+namespace {
+
+// Create an experiment with `num_obs` obs, `num_var` var, and an X layer
+// "data" with value row * 1000 + col in every cell. The obs and var
+// dataframes have an int32 attribute "a0" with joinid % 4 and joinid % 2.
+std::string create_experiment(
+    const std::string& uri, Context& ctx, int num_obs, int num_var) {
+    auto vfs = VFS(ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+    for (auto& dir : {uri, uri + "/ms", uri + "/ms/RNA", uri + "/ms/RNA/X"}) {
+        vfs.create_dir(dir);
+    }
+
+    auto create_dataframe = [&](const std::string& df_uri, int n, int mod) {
+        ArraySchema schema(ctx, TILEDB_SPARSE);
+        Domain domain(ctx);
+        domain.add_dimension(Dimension::create<int64_t>(
+            ctx, ExperimentQuery::SOMA_JOINID, {0, 9999}, 100));
+        schema.set_domain(domain);
+        schema.add_attribute(Attribute::create<int32_t>(ctx, "a0"));
+        schema.check();
+        Array::create(df_uri, schema);
+
+        std::vector<int64_t> joinids(n);
+        std::iota(joinids.begin(), joinids.end(), 0);
+        std::vector<int32_t> a0;
+        for (auto joinid : joinids) {
+            a0.push_back(joinid % mod);
+        }
+        Array array(ctx, df_uri, TILEDB_WRITE);
+        Query query(ctx, array);
+        query.set_layout(TILEDB_UNORDERED)
+            .set_data_buffer(ExperimentQuery::SOMA_JOINID, joinids)
+            .set_data_buffer("a0", a0);
+        query.submit();
+        array.close();
+    };
+    create_dataframe(uri + "/obs", num_obs, 4);
+    create_dataframe(uri + "/ms/RNA/var", num_var, 2);
+
+    ArraySchema schema(ctx, TILEDB_SPARSE);
+    Domain domain(ctx);
+    for (auto& name : {"soma_dim_0", "soma_dim_1"}) {
+        domain.add_dimension(
+            Dimension::create<int64_t>(ctx, name, {0, 9999}, 100));
+    }
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<double>(ctx, "soma_data"));
+    schema.check();
+    Array::create(uri + "/ms/RNA/X/data", schema);
+
+    std::vector<int64_t> d0, d1;
+    std::vector<double> data;
+    for (int row = 0; row < num_obs; row++) {
+        for (int col = 0; col < num_var; col++) {
+            d0.push_back(row);
+            d1.push_back(col);
+            data.push_back(row * 1000 + col);
+        }
+    }
+    Array array(ctx, uri + "/ms/RNA/X/data", TILEDB_WRITE);
+    Query query(ctx, array);
+    query.set_layout(TILEDB_UNORDERED)
+        .set_data_buffer("soma_dim_0", d0)
+        .set_data_buffer("soma_dim_1", d1)
+        .set_data_buffer("soma_data", data);
+    query.submit();
+    array.close();
+
+    return uri;
+}
+
+// Check that the matrix holds the value of each selected (obs, var) cell
+void check_matrix(ExperimentQuery& query, CompressedMatrix& matrix) {
+    auto& obs = query.obs_joinids();
+    auto& var = query.var_joinids();
+    REQUIRE(matrix.num_rows == obs.size());
+    REQUIRE(matrix.num_cols == var.size());
+    REQUIRE(matrix.nnz() == obs.size() * var.size());
+
+    auto values = matrix.values<double>();
+    for (uint64_t row = 0; row < matrix.num_rows; row++) {
+        REQUIRE(
+            matrix.indptr[row + 1] - matrix.indptr[row] == (int64_t)var.size());
+        for (auto i = matrix.indptr[row]; i < matrix.indptr[row + 1]; i++) {
+            REQUIRE(values[i] == obs[row] * 1000 + var[matrix.indices[i]]);
+        }
+    }
+}
+
+};  // namespace
+
+TEST_CASE("ExperimentQuery: all obs and var") {
+    auto ctx = std::make_shared<Context>();
+    auto uri = create_experiment("mem://unit-test-experiment", *ctx, 20, 10);
+
+    auto query = ExperimentQuery::open(ctx, uri);
+    query->submit();
+    REQUIRE(query->obs_joinids().size() == 20);
+    REQUIRE(query->var_joinids().size() == 10);
+    REQUIRE(!query->obs_results().empty());
+    REQUIRE(query->obs_results()[0]->names().size() == 2);
+
+    auto matrix = query->read_X();
+    check_matrix(*query, *matrix);
+    REQUIRE_THROWS_AS(query->submit(), TileDBSOMAError);
+}
+
+TEST_CASE("ExperimentQuery: obs value filter and var coords") {
+    auto ctx = std::make_shared<Context>();
+    auto uri = create_experiment("mem://unit-test-experiment", *ctx, 20, 10);
+
+    auto query = ExperimentQuery::open(ctx, uri);
+    auto qc = QueryCondition::create<int32_t>(*ctx, "a0", 1, TILEDB_EQ);
+    query->obs().set_condition(qc);
+    query->var().set_dim_points<int64_t>(
+        ExperimentQuery::SOMA_JOINID, {2, 5, 7});
+    query->obs().select_columns({"a0"});
+    query->submit();
+
+    // Only the joinids are added to the selected columns
+    REQUIRE(query->obs_joinids().size() == 5);
+    REQUIRE(query->obs_results()[0]->names().size() == 2);
+    for (auto joinid : query->obs_joinids()) {
+        REQUIRE(joinid % 4 == 1);
+    }
+    REQUIRE(query->var_joinids().size() == 3);
+
+    uint64_t num_cells = 0;
+    while (auto batch = query->X().read_next()) {
+        auto d0 = (*batch)->at("soma_dim_0")->data<int64_t>();
+        auto d1 = (*batch)->at("soma_dim_1")->data<int64_t>();
+        for (size_t i = 0; i < d0.size(); i++) {
+            REQUIRE(d0[i] % 4 == 1);
+            REQUIRE((d1[i] == 2 || d1[i] == 5 || d1[i] == 7));
+        }
+        num_cells += d0.size();
+    }
+    REQUIRE(num_cells == 15);
+}
+
+TEST_CASE("ExperimentQuery: empty selection") {
+    auto ctx = std::make_shared<Context>();
+    auto uri = create_experiment("mem://unit-test-experiment", *ctx, 20, 10);
+
+    auto query = ExperimentQuery::open(ctx, uri);
+    auto qc = QueryCondition::create<int32_t>(*ctx, "a0", 9, TILEDB_EQ);
+    query->obs().set_condition(qc);
+    query->submit();
+    REQUIRE(query->obs_joinids().empty());
+    REQUIRE(query->var_joinids().size() == 10);
+
+    auto matrix = query->read_X(CompressedFormat::CSC);
+    REQUIRE(matrix->num_rows == 0);
+    REQUIRE(matrix->num_cols == 10);
+    REQUIRE(matrix->nnz() == 0);
+}
@@ -0,0 +1,104 @@
+/**
+ * @file   unit_int_indexer.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file manages unit tests for the IntIndexer class
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+#include <catch2/matchers/catch_matchers_vector.hpp>
+#include <numeric>
+#include <random>
+
+#include <tiledbsoma/tiledbsoma>
+
+using namespace tiledbsoma;
+using namespace Catch::Matchers;
+
+TEST_CASE("IntIndexer: lookup") {
+    std::vector<int64_t> keys = {
+        10, -3, 0, std::numeric_limits<int64_t>::max(), 7, 1 << 20};
+    IntIndexer indexer(keys);
+    REQUIRE(indexer.size() == keys.size());
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        REQUIRE(indexer.lookup(keys[i]) == (int64_t)i);
+    }
+    REQUIRE(indexer.lookup(1) == IntIndexer::NOT_FOUND);
+    REQUIRE(indexer.lookup(-10) == IntIndexer::NOT_FOUND);
+
+    std::vector<int64_t> lookups = {7, 8, 10, 10, -3};
+    REQUIRE_THAT(
+        indexer.get_indexer(lookups),
+        Equals(std::vector<int64_t>{4, IntIndexer::NOT_FOUND, 0, 0, 1}));
+
+    // An empty indexer finds no keys
+    IntIndexer empty;
+    REQUIRE(empty.size() == 0);
+    REQUIRE(empty.lookup(0) == IntIndexer::NOT_FOUND);
+
+    // Duplicate keys are an error, and leave the indexer empty
+    REQUIRE_THROWS_AS(
+        indexer.map_locations(std::vector<int64_t>{1, 2, 1}),
+        TileDBSOMAError);
+    REQUIRE(indexer.size() == 0);
+    REQUIRE(indexer.lookup(1) == IntIndexer::NOT_FOUND);
+}
+
+TEST_CASE("IntIndexer: bulk lookup") {
+    auto num_threads = GENERATE(1u, 4u);
+
+    // Keys in random order, spaced out so half of the lookups miss
+    size_t num_keys = 300000;
+    std::vector<int64_t> keys(num_keys);
+    for (size_t i = 0; i < num_keys; i++) {
+        keys[i] = 2 * i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937{0});
+
+    IntIndexer indexer(keys, num_threads);
+
+    std::vector<int64_t> lookups(2 * num_keys);
+    std::iota(lookups.begin(), lookups.end(), 0);
+    auto positions = indexer.get_indexer(lookups);
+
+    size_t num_wrong = 0;
+    for (size_t i = 0; i < lookups.size(); i++) {
+        if (lookups[i] & 1) {
+            num_wrong += positions[i] != IntIndexer::NOT_FOUND;
+        } else {
+            num_wrong += positions[i] == IntIndexer::NOT_FOUND ||
+                         keys[positions[i]] != lookups[i];
+        }
+    }
+    REQUIRE(num_wrong == 0);
+
+    // Repeated lookups reuse the thread pool of the indexer
+    REQUIRE(indexer.get_indexer(lookups) == positions);
+}
@@ -0,0 +1,123 @@
+/**
+ * @file   unit_logger.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * This file manages unit tests for lazy logging and trace spans
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <tiledbsoma/tiledbsoma>
+
+using namespace tiledbsoma;
+
+namespace {
+
+// Counts the number of times a value is formatted
+struct Counted {
+    inline static int num_formats = 0;
+};
+
+}  // namespace
+
+template <>
+struct fmt::formatter<Counted> : fmt::formatter<int> {
+    template <typename FormatContext>
+    auto format(const Counted&, FormatContext& ctx) const {
+        Counted::num_formats++;
+        return fmt::formatter<int>::format(Counted::num_formats, ctx);
+    }
+};
+
+TEST_CASE("Logger: lazy formatting") {
+    Counted::num_formats = 0;
+
+    // Messages are not formatted below the log level
+    LOG_SET_LEVEL("info");
+    REQUIRE_FALSE(LOG_ENABLED(spdlog::level::debug));
+    LOG_TRACE("trace {}", Counted{});
+    LOG_DEBUG("debug {}", Counted{});
+    REQUIRE(Counted::num_formats == 0);
+
+    LOG_SET_LEVEL("debug");
+    REQUIRE(LOG_ENABLED(spdlog::level::debug));
+    LOG_DEBUG("debug {}", Counted{});
+    REQUIRE(Counted::num_formats == 1);
+
+    // Messages without arguments are logged as before
+    LOG_DEBUG("debug message");
+    LOG_DEBUG(std::string("debug string"));
+    LOG_SET_LEVEL("info");
+}
+
+TEST_CASE("Logger: trace spans") {
+    auto tracefile =
+        (std::filesystem::temp_directory_path() / "unit-test-trace.json")
+            .string();
+
+    // Spans are not timed or formatted unless tracing is started
+    Counted::num_formats = 0;
+    REQUIRE_FALSE(TRACE_ENABLED());
+    {
+        TraceSpan span("unrecorded", "{}", Counted{});
+    }
+    REQUIRE(Counted::num_formats == 0);
+
+    TRACE_START(tracefile);
+    REQUIRE(TRACE_ENABLED());
+    {
+        TraceSpan outer("submit", "array \"{}\"", "mem://a");
+        TraceSpan inner("wait");
+        TraceSpan quoted("read \"obs\"");
+    }
+    TRACE_STOP();
+    REQUIRE_FALSE(TRACE_ENABLED());
+
+    // Spans ending after the trace is stopped are dropped
+    {
+        TraceSpan span("export");
+    }
+
+    std::ifstream file(tracefile);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    auto trace = contents.str();
+
+    REQUIRE(trace.front() == '[');
+    REQUIRE(trace.find("]") != std::string::npos);
+    REQUIRE(trace.find(R"("name":"wait")") != std::string::npos);
+    REQUIRE(trace.find(R"("name":"submit")") != std::string::npos);
+    REQUIRE(trace.find(R"("name":"read \"obs\"")") != std::string::npos);
+    REQUIRE(
+        trace.find(R"("detail":"array \"mem://a\"")") != std::string::npos);
+    REQUIRE(trace.find(R"("ph":"X")") != std::string::npos);
+    REQUIRE(trace.find("unrecorded") == std::string::npos);
+    REQUIRE(trace.find("export") == std::string::npos);
+    std::filesystem::remove(tracefile);
+}
@@ -38,6 +38,7 @@
 #include <catch2/matchers/catch_matchers_string.hpp>
 #include <catch2/matchers/catch_matchers_templated.hpp>
 #include <catch2/matchers/catch_matchers_vector.hpp>
+#include <algorithm>
 #include <random>
 
 #include <tiledbsoma/util.h>
@@ -110,6 +111,44 @@ auto create_array(const std::string& uri, Context& ctx) {
         std::make_shared<Array>(ctx, uri, TILEDB_READ), d0, a0, a0_valids);
 }
 
+// Create a 10x5 dense array with int64 dimensions d0 and d1 and an int32
+// attribute a0 with value d0 * 10 + d1
+std::shared_ptr<Array> create_dense_array(
+    const std::string& uri, Context& ctx) {
+    auto vfs = VFS(ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+
+    ArraySchema schema(ctx, TILEDB_DENSE);
+    Domain domain(ctx);
+    domain.add_dimension(Dimension::create<int64_t>(ctx, "d0", {0, 9}, 4));
+    domain.add_dimension(Dimension::create<int64_t>(ctx, "d1", {0, 4}, 5));
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<int32_t>(ctx, "a0"));
+    schema.check();
+    Array::create(uri, schema);
+
+    std::vector<int32_t> a0;
+    for (int d0 = 0; d0 < 10; d0++) {
+        for (int d1 = 0; d1 < 5; d1++) {
+            a0.push_back(d0 * 10 + d1);
+        }
+    }
+
+    Array array(ctx, uri, TILEDB_WRITE);
+    Query query(ctx, array);
+    Subarray subarray(ctx, array);
+    subarray.add_range<int64_t>(0, 0, 9).add_range<int64_t>(1, 0, 4);
+    query.set_layout(TILEDB_ROW_MAJOR)
+        .set_subarray(subarray)
+        .set_data_buffer("a0", a0);
+    query.submit();
+    array.close();
+
+    return std::make_shared<Array>(ctx, uri, TILEDB_READ);
+}
+
 };  // namespace
 
 TEST_CASE("ManagedQuery: Basic execution test") {
@@ -181,3 +220,589 @@ TEST_CASE("ManagedQuery: Validity test") {
     REQUIRE_THAT(a0, Equals(mq.strings("a0")));
     REQUIRE_THAT(a0_valids, Equals(a0_valids_actual));
 }
+
+TEST_CASE("ManagedQuery: Arrow export test") {
+    std::string uri = "mem://unit-test-array";
+    auto ctx = Context();
+    auto [array, d0, a0, a0_valids] = create_array(uri, ctx);
+
+    auto mq = ManagedQuery(array);
+    mq.submit();
+    auto results = mq.results();
+
+    // Exporting does not modify the validity, so a column can be exported
+    // more than once
+    for (int i = 0; i < 2; i++) {
+        auto [arrow_array, arrow_schema] =
+            ArrowAdapter::to_arrow(results->at("a0"));
+        REQUIRE(arrow_array->length == (int64_t)a0.size());
+        REQUIRE(arrow_array->null_count == 2);
+
+        auto bitmap = static_cast<const uint8_t*>(arrow_array->buffers[0]);
+        REQUIRE(bitmap[0] == 0b001111);
+
+        arrow_array->release(arrow_array.get());
+        arrow_schema->release(arrow_schema.get());
+    }
+
+    auto valids = mq.validity("a0");
+    REQUIRE_THAT(
+        a0_valids, Equals(std::vector<uint8_t>(valids.begin(), valids.end())));
+}
+
+TEST_CASE("ManagedQuery: Arrow struct export test") {
+    std::string uri = "mem://unit-test-array";
+    auto ctx = Context();
+    auto [array, d0, a0, a0_valids] = create_array(uri, ctx);
+
+    auto mq = ManagedQuery(array);
+    mq.submit();
+    auto results = mq.results();
+
+    ArrowArray arrow_array;
+    ArrowSchema arrow_schema;
+    ArrowAdapter::to_arrow_struct(results, &arrow_array);
+    ArrowAdapter::to_arrow_schema(results, &arrow_schema);
+
+    REQUIRE(std::string(arrow_schema.format) == "+s");
+    REQUIRE(arrow_schema.n_children == 2);
+    REQUIRE(std::string(arrow_schema.children[0]->name) == "d0");
+    REQUIRE(std::string(arrow_schema.children[0]->format) == "U");
+    REQUIRE(std::string(arrow_schema.children[1]->name) == "a0");
+    REQUIRE(arrow_schema.children[1]->flags == ARROW_FLAG_NULLABLE);
+
+    REQUIRE(arrow_array.length == (int64_t)d0.size());
+    REQUIRE(arrow_array.n_children == 2);
+    REQUIRE(arrow_array.children[1]->null_count == 2);
+
+    // A consumer may move a child out of the struct before releasing it
+    ArrowArray child = *arrow_array.children[0];
+    arrow_array.children[0]->release = nullptr;
+    arrow_array.release(&arrow_array);
+    REQUIRE(arrow_array.release == nullptr);
+    child.release(&child);
+
+    // A child schema moved out remains valid after the struct is released
+    ArrowSchema child_schema = *arrow_schema.children[1];
+    arrow_schema.children[1]->release = nullptr;
+    arrow_schema.release(&arrow_schema);
+    REQUIRE(arrow_schema.release == nullptr);
+    REQUIRE(std::string(child_schema.name) == "a0");
+    child_schema.release(&child_schema);
+}
+
+TEST_CASE("ManagedQuery: Arrow schema template test") {
+    std::string uri = "mem://unit-test-array";
+    auto ctx = Context();
+    auto [array, d0, a0, a0_valids] = create_array(uri, ctx);
+
+    auto mq = ManagedQuery(array);
+    mq.submit();
+    auto results = mq.results();
+
+    // Schemas exported from one template share its strings
+    auto schema_template = ArrowAdapter::schema_template(results);
+    ArrowSchema schema1;
+    ArrowSchema schema2;
+    ArrowAdapter::to_arrow_schema(schema_template, &schema1);
+    ArrowAdapter::to_arrow_schema(schema_template, &schema2);
+    REQUIRE(schema1.children[0]->name == schema2.children[0]->name);
+    REQUIRE(schema1.children[0]->name == schema_template->children[0].name);
+
+    // A batch with the same columns reuses the template of a previous batch
+    REQUIRE(
+        ArrowAdapter::schema_template(results, schema_template) ==
+        schema_template);
+    REQUIRE(
+        ArrowAdapter::schema_template(results, nullptr) != schema_template);
+
+    // A batch with other columns does not
+    auto mq_a0 = ManagedQuery(array);
+    mq_a0.select_columns({"a0"});
+    mq_a0.submit();
+    auto results_a0 = mq_a0.results();
+    auto template_a0 = ArrowAdapter::schema_template(
+        results_a0, schema_template);
+    REQUIRE(template_a0 != schema_template);
+    REQUIRE(template_a0->children.size() == 1);
+    REQUIRE(template_a0->children[0].name == "a0");
+
+    // The exported strings outlive the ColumnBuffers
+    results.reset();
+    mq.reset();
+    schema_template.reset();
+    REQUIRE(std::string(schema1.children[1]->name) == "a0");
+    REQUIRE(std::string(schema2.children[1]->format) == "U");
+
+    schema1.release(&schema1);
+    schema2.release(&schema2);
+}
+
+TEST_CASE("ManagedQuery: Arrow dictionary export test") {
+    std::string uri = "mem://unit-test-array-dictionary";
+    auto ctx = Context();
+    auto vfs = VFS(ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+
+    ArraySchema schema(ctx, TILEDB_SPARSE);
+    Domain domain(ctx);
+    domain.add_dimension(Dimension::create<int64_t>(ctx, "d0", {0, 99}, 10));
+    schema.set_domain(domain);
+    auto attr = Attribute::create<std::string>(ctx, "label");
+    attr.set_nullable(true);
+    schema.add_attribute(attr);
+    schema.add_attribute(Attribute::create<int32_t>(ctx, "a0"));
+    Array::create(uri, schema);
+
+    std::vector<int64_t> d0 = {0, 1, 2, 3, 4, 5};
+    std::vector<std::string> label = {"x", "yy", "x", "", "zzz", "yy"};
+    std::vector<uint8_t> label_valids = {1, 1, 1, 0, 1, 1};
+    std::vector<int32_t> a0(d0.size());
+    auto [label_data, label_offsets] = util::to_varlen_buffers(label, false);
+    {
+        Array array(ctx, uri, TILEDB_WRITE);
+        Query query(ctx, array);
+        query.set_layout(TILEDB_UNORDERED)
+            .set_data_buffer("d0", d0)
+            .set_data_buffer("label", label_data)
+            .set_offsets_buffer("label", label_offsets)
+            .set_validity_buffer("label", label_valids)
+            .set_data_buffer("a0", a0);
+        query.submit();
+        array.close();
+    }
+
+    auto mq = ManagedQuery(std::make_shared<Array>(ctx, uri, TILEDB_READ));
+    mq.select_columns({"d0", "label"});
+    mq.set_layout(TILEDB_GLOBAL_ORDER);
+    REQUIRE_THROWS_AS(mq.set_dictionary_columns({"a0"}), TileDBSOMAError);
+    REQUIRE_THROWS_AS(mq.set_dictionary_columns({"nope"}), TileDBSOMAError);
+    mq.set_dictionary_columns({"label"});
+    mq.submit();
+    auto results = mq.results();
+    REQUIRE(results->at("label")->is_dictionary_encoded());
+    REQUIRE_FALSE(results->at("d0")->is_dictionary_encoded());
+
+    ArrowArray arrow_array;
+    ArrowSchema arrow_schema;
+    ArrowAdapter::to_arrow_struct(results, &arrow_array);
+    ArrowAdapter::to_arrow_schema(results, &arrow_schema);
+
+    // The schema has int32 indices and a large_string dictionary
+    auto child_schema = arrow_schema.children[1];
+    REQUIRE(std::string(child_schema->format) == "i");
+    REQUIRE(child_schema->flags == ARROW_FLAG_NULLABLE);
+    REQUIRE(child_schema->dictionary != nullptr);
+    REQUIRE(std::string(child_schema->dictionary->format) == "U");
+    REQUIRE(std::string(arrow_schema.children[0]->format) == "l");
+    REQUIRE(arrow_schema.children[0]->dictionary == nullptr);
+
+    // The distinct values are stored in the order of their first cell
+    auto child = arrow_array.children[1];
+    REQUIRE(child->length == (int64_t)d0.size());
+    REQUIRE(child->n_buffers == 2);
+    REQUIRE(child->null_count == 1);
+    auto indices = static_cast<const int32_t*>(child->buffers[1]);
+    REQUIRE_THAT(
+        std::vector<int32_t>(indices, indices + child->length),
+        Equals(std::vector<int32_t>{0, 1, 0, 0, 2, 1}));
+
+    auto dictionary = child->dictionary;
+    REQUIRE(dictionary != nullptr);
+    REQUIRE(dictionary->length == 3);
+    auto offsets = static_cast<const int64_t*>(dictionary->buffers[1]);
+    auto data = static_cast<const char*>(dictionary->buffers[2]);
+    REQUIRE(std::string(data, offsets[3]) == "xyyzzz");
+    REQUIRE_THAT(
+        std::vector<int64_t>(offsets, offsets + 4),
+        Equals(std::vector<int64_t>{0, 1, 3, 6}));
+
+    // Releasing the parent releases the dictionary
+    arrow_array.release(&arrow_array);
+    REQUIRE(arrow_array.release == nullptr);
+    arrow_schema.release(&arrow_schema);
+    REQUIRE(arrow_schema.release == nullptr);
+}
+
+TEST_CASE("ManagedQuery: Arrow small offsets export test") {
+    std::string uri = "mem://unit-test-array-small-offsets";
+    std::map<std::string, std::string> config = {
+        {"soma.arrow_small_offsets", "true"}};
+    auto ctx = Context(Config(config));
+    auto vfs = VFS(ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+
+    ArraySchema schema(ctx, TILEDB_SPARSE);
+    Domain domain(ctx);
+    domain.add_dimension(Dimension::create<int64_t>(ctx, "d0", {0, 99}, 10));
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<std::string>(ctx, "label"));
+    Array::create(uri, schema);
+
+    std::vector<int64_t> d0 = {0, 1, 2, 3};
+    std::vector<std::string> label = {"x", "yy", "", "zzz"};
+    auto [label_data, label_offsets] = util::to_varlen_buffers(label, false);
+    {
+        Array array(ctx, uri, TILEDB_WRITE);
+        Query query(ctx, array);
+        query.set_layout(TILEDB_UNORDERED)
+            .set_data_buffer("d0", d0)
+            .set_data_buffer("label", label_data)
+            .set_offsets_buffer("label", label_offsets);
+        query.submit();
+        array.close();
+    }
+
+    auto mq = ManagedQuery(std::make_shared<Array>(ctx, uri, TILEDB_READ));
+    mq.set_layout(TILEDB_GLOBAL_ORDER);
+    mq.submit();
+    auto results = mq.results();
+    REQUIRE(results->at("label")->has_small_offsets());
+    REQUIRE_FALSE(results->at("d0")->has_small_offsets());
+    REQUIRE_THAT(label, Equals(mq.strings("label")));
+
+    ArrowArray arrow_array;
+    ArrowSchema arrow_schema;
+    ArrowAdapter::to_arrow_struct(results, &arrow_array);
+    ArrowAdapter::to_arrow_schema(results, &arrow_schema);
+
+    // The string column is a regular string array with int32 offsets
+    REQUIRE(std::string(arrow_schema.children[0]->format) == "l");
+    REQUIRE(std::string(arrow_schema.children[1]->format) == "u");
+    auto child = arrow_array.children[1];
+    REQUIRE(child->length == (int64_t)label.size());
+    REQUIRE(child->n_buffers == 3);
+    auto offsets = static_cast<const int32_t*>(child->buffers[1]);
+    auto data = static_cast<const char*>(child->buffers[2]);
+    REQUIRE_THAT(
+        std::vector<int32_t>(offsets, offsets + label.size() + 1),
+        Equals(std::vector<int32_t>{0, 1, 3, 3, 6}));
+    REQUIRE(std::string(data, offsets[4]) == "xyyzzz");
+
+    arrow_array.release(&arrow_array);
+    arrow_schema.release(&arrow_schema);
+}
+
+TEST_CASE("ManagedQuery: Asynchronous submit test") {
+    std::string uri = "mem://unit-test-array";
+    auto ctx = Context();
+    auto [array, d0, a0, _] = create_array(uri, ctx);
+
+    auto mq = ManagedQuery(array);
+
+    // Reset while the query is in flight discards the query
+    mq.submit();
+    REQUIRE(mq.is_submitted());
+    mq.reset();
+    REQUIRE(!mq.is_submitted());
+
+    // Submitting again before reading the results is an error
+    mq.submit();
+    REQUIRE_THROWS(mq.submit());
+
+    // Reading the results waits for the query to complete
+    auto results = mq.results();
+    REQUIRE(!mq.is_submitted());
+    REQUIRE(mq.is_complete());
+    REQUIRE(mq.results_complete());
+    REQUIRE(mq.total_num_cells() == d0.size());
+    REQUIRE_THAT(d0, Equals(mq.strings("d0")));
+}
+
+TEST_CASE("ManagedQuery: Buffer growth test") {
+    std::string uri = "mem://unit-test-array-growth";
+
+    // Allocate buffers smaller than the longest strings in the array
+    std::map<std::string, std::string> config = {
+        {"soma.init_buffer_bytes", "64"}};
+    auto ctx = Context(Config(config));
+
+    // Create schema
+    ArraySchema schema(ctx, TILEDB_SPARSE);
+    auto dim = Dimension::create<int64_t>(ctx, "d0", {0, 999}, 10);
+    Domain domain(ctx);
+    domain.add_dimension(dim);
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<std::string>(ctx, "a0"));
+    schema.check();
+    Array::create(uri, schema);
+
+    // Write strings with lengths from 1 to 10000 bytes
+    std::vector<int64_t> d0 = {0, 1, 2, 3, 4};
+    std::vector<std::string> a0;
+    for (size_t len = 1; len <= 10000; len *= 10) {
+        a0.push_back(std::string(len, 'a' + a0.size()));
+    }
+    auto [a0_data, a0_offsets] = util::to_varlen_buffers(a0, false);
+
+    {
+        Array array(ctx, uri, TILEDB_WRITE);
+        Query query(ctx, array);
+        query.set_layout(TILEDB_UNORDERED)
+            .set_data_buffer("d0", d0)
+            .set_data_buffer("a0", a0_data)
+            .set_offsets_buffer("a0", a0_offsets);
+        query.submit();
+        array.close();
+    }
+
+    // Read all cells, growing the buffers when a string does not fit
+    auto mq = ManagedQuery(std::make_shared<Array>(ctx, uri, TILEDB_READ));
+    std::vector<std::string> a0_actual;
+    do {
+        mq.submit();
+        mq.results();
+        for (auto& s : mq.strings("a0")) {
+            a0_actual.push_back(s);
+        }
+    } while (!mq.is_complete());
+
+    REQUIRE(mq.total_num_cells() == a0.size());
+    REQUIRE_THAT(a0, Equals(a0_actual));
+
+    // The resubmits with larger buffers are counted in the metrics
+    auto metrics = mq.metrics();
+    REQUIRE(metrics.num_resubmits > 0);
+    REQUIRE(metrics.num_incomplete > 0);
+    REQUIRE(metrics.num_submits > metrics.num_batches);
+    REQUIRE(metrics.num_cells == a0.size());
+}
+
+TEST_CASE("ManagedQuery: Buffer budget test") {
+    std::string uri = "mem://unit-test-array";
+
+    // Split a small budget across the columns to read in multiple batches
+    std::map<std::string, std::string> config = {
+        {"soma.read_budget_bytes", "64"}};
+    auto ctx = Context(Config(config));
+    auto [array, d0, a0, _] = create_array(uri, ctx);
+
+    auto mq = ManagedQuery(array);
+    std::vector<std::string> d0_actual;
+    std::vector<std::string> a0_actual;
+    int num_batches = 0;
+    do {
+        mq.submit();
+        auto results = mq.results();
+        num_batches++;
+
+        // Each column holds the same number of cells
+        REQUIRE(results->at("d0")->size() == results->at("a0")->size());
+
+        for (auto& s : mq.strings("d0")) {
+            d0_actual.push_back(s);
+        }
+        for (auto& s : mq.strings("a0")) {
+            a0_actual.push_back(s);
+        }
+    } while (!mq.is_complete());
+
+    REQUIRE(num_batches > 1);
+    REQUIRE(mq.total_num_cells() == d0.size());
+    REQUIRE_THAT(d0, Equals(d0_actual));
+    REQUIRE_THAT(a0, Equals(a0_actual));
+}
+
+TEST_CASE("ManagedQuery: Coalesce points test") {
+    std::vector<int64_t> points = {9, 3, 1, 2, 3, 7, 12, 0, 11};
+
+    // Adjacent and duplicate points are merged
+    using Ranges = std::vector<std::pair<int64_t, int64_t>>;
+    auto ranges = ManagedQuery::coalesce_points<int64_t>(points);
+    REQUIRE(ranges == Ranges{{0, 3}, {7, 7}, {9, 9}, {11, 12}});
+
+    // Distances are computed without overflow at the type limits
+    std::vector<int8_t> limits = {127, -128, 126, -127};
+    auto int8_ranges = ManagedQuery::coalesce_points<int8_t>(limits);
+    REQUIRE(
+        int8_ranges ==
+        std::vector<std::pair<int8_t, int8_t>>{{-128, -127}, {126, 127}});
+
+    // Points with unselected values between them are never merged
+    std::vector<int64_t> sparse_points = {0, 2, 4};
+    REQUIRE(
+        ManagedQuery::coalesce_points<int64_t>(sparse_points) ==
+        Ranges{{0, 0}, {2, 2}, {4, 4}});
+
+    REQUIRE(ManagedQuery::coalesce_points<int64_t>({}).empty());
+}
+
+TEST_CASE("ManagedQuery: Dense exact read test") {
+    // Small buffers would read the dense array in many batches, unless the
+    // buffers are sized from the subarray
+    std::map<std::string, std::string> config = {
+        {"soma.init_buffer_bytes", "16"}};
+    auto ctx = Context(Config(config));
+    auto array = create_dense_array("mem://unit-test-dense-array", ctx);
+
+    auto mq = ManagedQuery(array);
+    mq.select_ranges<int64_t>("d0", {{1, 2}, {5, 7}});
+    mq.select_points<int64_t>("d1", std::vector<int64_t>{0, 4});
+    REQUIRE(mq.dense_num_cells() == 10);
+
+    mq.submit();
+    auto results = mq.results();
+    REQUIRE(mq.results_complete());
+    REQUIRE(results->num_rows() == 10);
+
+    auto d0 = mq.data<int64_t>("d0");
+    auto d1 = mq.data<int64_t>("d1");
+    auto a0 = mq.data<int32_t>("a0");
+    for (size_t i = 0; i < a0.size(); i++) {
+        REQUIRE(a0[i] == d0[i] * 10 + d1[i]);
+    }
+
+    // Without a selection, the non-empty domain of d0 and the domain of d1
+    // are read
+    auto mq_all = ManagedQuery(array);
+    REQUIRE(mq_all.dense_num_cells() == 50);
+    mq_all.submit();
+    mq_all.results();
+    REQUIRE(mq_all.results_complete());
+    REQUIRE(mq_all.total_num_cells() == 50);
+
+    // Sparse arrays have no dense cell count
+    auto [sparse, _d0, _a0, _valids] =
+        create_array("mem://unit-test-array", ctx);
+    REQUIRE(ManagedQuery(sparse).dense_num_cells() == std::nullopt);
+}
+
+TEST_CASE("ManagedQuery: Bulk ranges test") {
+    auto coalesce = GENERATE("true", "false");
+    std::map<std::string, std::string> config = {
+        {"soma.coalesce_points", coalesce}};
+    auto ctx = Context(Config(config));
+    auto array = create_dense_array("mem://unit-test-dense-array-bulk", ctx);
+
+    // Many ranges and points are added with one lookup of the dimension
+    std::vector<std::pair<int64_t, int64_t>> ranges;
+    for (int64_t i = 0; i < 10; i += 3) {
+        ranges.emplace_back(i, i);
+    }
+    std::vector<int64_t> points = {3, 1};
+
+    auto mq = ManagedQuery(array);
+    mq.select_ranges("d0", ranges);
+    mq.select_points("d1", points);
+    REQUIRE(mq.dense_num_cells() == ranges.size() * points.size());
+    mq.submit();
+    mq.results();
+    REQUIRE(mq.results_complete());
+
+    auto d0 = mq.data<int64_t>("d0");
+    auto d1 = mq.data<int64_t>("d1");
+    auto a0 = mq.data<int32_t>("a0");
+    REQUIRE(a0.size() == ranges.size() * points.size());
+    for (size_t i = 0; i < a0.size(); i++) {
+        REQUIRE(d0[i] % 3 == 0);
+        REQUIRE((d1[i] == 1 || d1[i] == 3));
+        REQUIRE(a0[i] == d0[i] * 10 + d1[i]);
+    }
+
+    // The dimension and its type are checked once for all ranges
+    auto mq_bad = ManagedQuery(array);
+    REQUIRE_THROWS_AS(
+        mq_bad.select_ranges<int64_t>("d2", {{0, 1}}), TileDBSOMAError);
+    REQUIRE_THROWS_AS(
+        mq_bad.select_ranges<int32_t>("d0", {{0, 1}}), TileDBError);
+}
+
+TEST_CASE("ManagedQuery: Point ranges fallback test") {
+    auto ctx = Context();
+    auto array = create_dense_array("mem://unit-test-dense-array-points", ctx);
+
+    // Before TileDB 2.15 there is no bulk point ranges API, so points are
+    // added one range at a time, reading each point from the span
+    std::vector<int64_t> points = {9, 8, 2, 5, 0};
+    auto mq = ManagedQuery(array);
+    mq.select_points("d0", tcb::span<const int64_t>(points.data() + 1, 3));
+    mq.select_points<int64_t>("d1", std::vector<int64_t>{4});
+    REQUIRE(mq.dense_num_cells() == 3);
+    mq.submit();
+    mq.results();
+    REQUIRE(mq.results_complete());
+
+    auto d0 = mq.data<int64_t>("d0");
+    auto a0 = mq.data<int32_t>("a0");
+    REQUIRE(a0.size() == 3);
+    std::vector<int64_t> d0_sorted(d0.begin(), d0.end());
+    std::sort(d0_sorted.begin(), d0_sorted.end());
+    REQUIRE_THAT(d0_sorted, Equals(std::vector<int64_t>{2, 5, 8}));
+    for (size_t i = 0; i < a0.size(); i++) {
+        REQUIRE(a0[i] == d0[i] * 10 + 4);
+    }
+}
+
+TEST_CASE("ManagedQuery: Dense read into buffer test") {
+    auto ctx = Context();
+    auto array = create_dense_array("mem://unit-test-dense-array", ctx);
+
+    auto mq = ManagedQuery(array);
+    mq.select_ranges<int64_t>("d0", {{3, 4}});
+    mq.select_ranges<int64_t>("d1", {{1, 3}});
+
+    std::vector<int32_t> a0(6);
+    REQUIRE(mq.read_into("a0", a0.data(), a0.size() * sizeof(int32_t)) == 6);
+    REQUIRE_THAT(a0, Equals(std::vector<int32_t>{31, 32, 33, 41, 42, 43}));
+    REQUIRE(mq.is_complete());
+
+    // The query can be read only once
+    REQUIRE_THROWS_AS(
+        mq.read_into("a0", a0.data(), a0.size() * sizeof(int32_t)),
+        TileDBSOMAError);
+
+    // The buffer must hold all cells of the subarray
+    mq.reset();
+    mq.select_ranges<int64_t>("d0", {{3, 4}});
+    REQUIRE_THROWS_AS(
+        mq.read_into("a0", a0.data(), a0.size() * sizeof(int32_t)),
+        TileDBSOMAError);
+}
+
+TEST_CASE("ManagedQuery: Metrics test") {
+    auto ctx = std::make_shared<Context>();
+    auto [array, d0, a0, _] = create_array("mem://unit-test-array", *ctx);
+
+    auto mq = ManagedQuery(array);
+    REQUIRE(mq.metrics().num_submits == 0);
+    mq.submit();
+    mq.results();
+
+    auto metrics = mq.metrics();
+    REQUIRE(metrics.num_submits == 1);
+    REQUIRE(metrics.num_incomplete == 0);
+    REQUIRE(metrics.num_resubmits == 0);
+    REQUIRE(metrics.num_batches == 1);
+    REQUIRE(metrics.num_cells == d0.size());
+    REQUIRE(metrics.submit_seconds > 0);
+    REQUIRE(metrics.columns.size() == 2);
+
+    // Cells and data bytes of the variable length columns
+    auto& column = metrics.columns.at("a0");
+    REQUIRE(column.cells == a0.size());
+    REQUIRE(column.bytes == 22);
+    REQUIRE(column.capacity_cells >= column.cells);
+    REQUIRE(column.capacity_bytes >= column.bytes);
+    REQUIRE(column.utilization() > 0);
+    REQUIRE(column.utilization() <= 1);
+
+    auto json = metrics.to_json();
+    REQUIRE(json.find("\"num_cells\":6") != std::string::npos);
+    REQUIRE(
+        json.find("\"a0\":{\"cells\":6,\"bytes\":22") != std::string::npos);
+
+    // Metrics are cumulative across resets
+    mq.reset();
+    mq.select_points<std::string>("d0", {"a", "bb"});
+    mq.submit();
+    mq.results();
+    metrics = mq.metrics();
+    REQUIRE(metrics.num_submits == 2);
+    REQUIRE(metrics.num_batches == 2);
+    REQUIRE(metrics.num_cells == d0.size() + 2);
+    REQUIRE(metrics.columns.at("d0").bytes == 22 + 3);
+}
@@ -0,0 +1,229 @@
+/**
+ * @file   unit_memory_governor.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file manages unit tests for the MemoryGovernor class
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <thread>
+
+#include <tiledb/tiledb>
+#include <tiledbsoma/tiledbsoma>
+
+using namespace tiledb;
+using namespace tiledbsoma;
+
+namespace {
+
+void create_array(const std::string& uri, Context& ctx, int num_cells) {
+    auto vfs = VFS(ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+
+    ArraySchema schema(ctx, TILEDB_SPARSE);
+    auto dim = Dimension::create<int64_t>(ctx, "d0", {0, 1 << 30});
+    Domain domain(ctx);
+    domain.add_dimension(dim);
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<int32_t>(ctx, "a0"));
+    Array::create(uri, schema);
+
+    std::vector<int64_t> d0(num_cells);
+    std::vector<int32_t> a0(num_cells);
+    for (int i = 0; i < num_cells; i++) {
+        d0[i] = i;
+        a0[i] = i;
+    }
+    Array array(ctx, uri, TILEDB_WRITE);
+    Query query(ctx, array);
+    query.set_layout(TILEDB_UNORDERED)
+        .set_data_buffer("d0", d0)
+        .set_data_buffer("a0", a0);
+    query.submit();
+    array.close();
+}
+
+};  // namespace
+
+TEST_CASE("MemoryGovernor: Reservations") {
+    MemoryGovernor governor(1000, 10);
+
+    // Within the budget
+    auto r1 = governor.reserve(600, 100);
+    REQUIRE(r1->bytes() == 600);
+
+    // Shrunk to the remaining budget
+    auto r2 = governor.reserve(600, 100);
+    REQUIRE(r2->bytes() == 400);
+    REQUIRE(governor.stats().reserved_bytes == 1000);
+    REQUIRE(governor.stats().num_shrinks == 1);
+
+    // Over-committed after waiting
+    {
+        auto r3 = governor.reserve(600, 100);
+        REQUIRE(r3->bytes() == 100);
+        auto stats = governor.stats();
+        REQUIRE(stats.num_waits == 1);
+        REQUIRE(stats.num_overcommits == 1);
+        REQUIRE(stats.peak_bytes == 1100);
+    }
+    REQUIRE(governor.stats().reserved_bytes == 1000);
+
+    // Shrinking does not wait, and growing within the budget does not wait
+    r2->resize(200);
+    REQUIRE(governor.stats().reserved_bytes == 800);
+    r2->resize(400);
+    REQUIRE(governor.stats().reserved_bytes == 1000);
+
+    // Growing past the budget waits, then fails
+    REQUIRE_THROWS_AS(r2->resize(500), TileDBSOMAError);
+    REQUIRE(r2->bytes() == 400);
+    REQUIRE(governor.stats().reserved_bytes == 1000);
+
+    // Growing without waiting over-commits the budget
+    r2->resize(500, false);
+    REQUIRE(r2->bytes() == 500);
+    REQUIRE(governor.stats().reserved_bytes == 1100);
+    REQUIRE(governor.stats().num_overcommits == 2);
+    r2->resize(400);
+
+    r1.reset();
+    r2.reset();
+    REQUIRE(governor.stats().reserved_bytes == 0);
+
+    // A disabled governor grants the requested bytes
+    governor.set_budget(0);
+    REQUIRE_FALSE(governor.enabled());
+    REQUIRE(governor.reserve(5000, 100)->bytes() == 5000);
+}
+
+TEST_CASE("MemoryGovernor: Wait for a release") {
+    MemoryGovernor governor(1000, 60000);
+    auto r1 = governor.reserve(1000, 1000);
+
+    std::thread release([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        r1.reset();
+    });
+    auto r2 = governor.reserve(800, 500);
+    release.join();
+
+    REQUIRE(r2->bytes() == 800);
+    auto stats = governor.stats();
+    REQUIRE(stats.num_waits == 1);
+    REQUIRE(stats.num_overcommits == 0);
+    REQUIRE(stats.reserved_bytes == 800);
+}
+
+TEST_CASE("MemoryGovernor: Config") {
+    MemoryGovernor governor;
+    REQUIRE_FALSE(governor.enabled());
+
+    Config config;
+    config.set("soma.mem.total_budget", "4096");
+    config.set("soma.mem.wait_ms", "5");
+    governor.configure(config);
+    REQUIRE(governor.enabled());
+    REQUIRE(governor.stats().budget == 4096);
+
+    // A config without the parameters leaves the governor unchanged
+    governor.configure(Config());
+    REQUIRE(governor.stats().budget == 4096);
+
+    config.set("soma.mem.total_budget", "lots");
+    REQUIRE_THROWS_AS(governor.configure(config), TileDBSOMAError);
+}
+
+TEST_CASE("MemoryGovernor: Budgeted SOMAReader") {
+    int num_cells = 1 << 20;
+    size_t budget = 4 << 20;
+    auto& governor = MemoryGovernor::instance();
+    auto baseline = governor.stats().reserved_bytes;
+
+    // The config of a reader does not configure the process-wide governor
+    std::map<std::string, std::string> config = {
+        {"soma.mem.total_budget", std::to_string(budget)}};
+    auto ctx = std::make_shared<Context>(Config(config));
+    std::string uri = "mem://unit-test-memory-governor";
+    create_array(uri, *ctx, num_cells);
+    SOMAReader::open(ctx, uri);
+    REQUIRE_FALSE(governor.enabled());
+
+    // The default buffers (16 MiB per column) exceed the budget, so the
+    // buffers are shrunk and the array is read in several batches
+    governor.configure(ctx->config());
+    {
+        auto sr = SOMAReader::open(ctx, uri);
+        REQUIRE(governor.enabled());
+        sr->submit();
+
+        size_t total_cells = 0;
+        int64_t sum = 0;
+        while (auto batch = sr->read_next()) {
+            for (auto value : (*batch)->at("a0")->data<int32_t>()) {
+                sum += value;
+            }
+            total_cells += (*batch)->num_rows();
+            REQUIRE(
+                governor.stats().reserved_bytes <= baseline + 2 * budget);
+        }
+        REQUIRE(total_cells == (size_t)num_cells);
+        REQUIRE(sum == (int64_t)num_cells * (num_cells - 1) / 2);
+
+        auto metrics = sr->metrics();
+        REQUIRE(metrics.num_memory_shrinks > 0);
+        REQUIRE(metrics.num_batches > 1);
+
+        // The reservations cover all bytes of the buffers within the budget
+        REQUIRE(governor.stats().peak_bytes <= baseline + budget);
+    }
+
+    // A reader whose caller holds all its batches over-commits the budget
+    // instead of waiting for memory that only the caller can release
+    governor.set_wait_ms(10);
+    {
+        auto sr = SOMAReader::open(ctx, uri);
+        sr->submit();
+        std::vector<std::shared_ptr<ArrayBuffers>> batches;
+        size_t total_cells = 0;
+        while (auto batch = sr->read_next()) {
+            total_cells += (*batch)->num_rows();
+            batches.push_back(*batch);
+        }
+        REQUIRE(total_cells == (size_t)num_cells);
+        REQUIRE(batches.size() > 1);
+        REQUIRE(governor.stats().num_overcommits > 0);
+    }
+    governor.set_wait_ms(MemoryGovernor::DEFAULT_WAIT_MS);
+
+    // The reservations are released with the reader and its batches
+    REQUIRE(governor.stats().reserved_bytes == baseline);
+    governor.set_budget(0);
+}
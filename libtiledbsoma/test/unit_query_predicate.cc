@@ -0,0 +1,226 @@
+/**
+ * @file   unit_query_predicate.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file manages unit tests for the QueryPredicate class
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_vector.hpp>
+
+#include <tiledb/tiledb>
+#include <tiledbsoma/tiledbsoma>
+#include <tiledbsoma/util.h>
+
+using namespace tiledb;
+using namespace tiledbsoma;
+using namespace Catch::Matchers;
+
+namespace {
+
+// Create a sparse array of 10 cells with d0 = 0..9 and attributes:
+//   a_int = d0 * 10, a_float = d0 * 0.5, a_str = "c{d0 % 3}",
+//   a_null = d0 if d0 is even, else null
+std::string create_array(const std::string& uri, Context& ctx) {
+    auto vfs = VFS(ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+
+    ArraySchema schema(ctx, TILEDB_SPARSE);
+    Domain domain(ctx);
+    domain.add_dimension(Dimension::create<int64_t>(ctx, "d0", {0, 99}, 10));
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<int32_t>(ctx, "a_int"));
+    schema.add_attribute(Attribute::create<double>(ctx, "a_float"));
+    schema.add_attribute(Attribute::create<std::string>(ctx, "a_str"));
+    auto a_null = Attribute::create<int32_t>(ctx, "a_null");
+    a_null.set_nullable(true);
+    schema.add_attribute(a_null);
+    schema.check();
+    Array::create(uri, schema);
+
+    std::vector<int64_t> d0(10);
+    std::vector<int32_t> a_int(10);
+    std::vector<double> a_float(10);
+    std::vector<std::string> a_str(10);
+    std::vector<int32_t> a_null_data(10);
+    std::vector<uint8_t> a_null_valid(10);
+    for (int i = 0; i < 10; i++) {
+        d0[i] = i;
+        a_int[i] = i * 10;
+        a_float[i] = i * 0.5;
+        a_str[i] = "c" + std::to_string(i % 3);
+        a_null_data[i] = i;
+        a_null_valid[i] = i % 2 == 0;
+    }
+    auto [str_data, str_offsets] = util::to_varlen_buffers(a_str, false);
+
+    Array array(ctx, uri, TILEDB_WRITE);
+    Query query(ctx, array);
+    query.set_layout(TILEDB_UNORDERED)
+        .set_data_buffer("d0", d0)
+        .set_data_buffer("a_int", a_int)
+        .set_data_buffer("a_float", a_float)
+        .set_data_buffer("a_str", str_data)
+        .set_offsets_buffer("a_str", str_offsets)
+        .set_data_buffer("a_null", a_null_data)
+        .set_validity_buffer("a_null", a_null_valid);
+    query.submit();
+    array.close();
+    return uri;
+}
+
+// Return the sorted d0 values of the cells selected by the predicate
+std::vector<int64_t> read_d0(
+    std::shared_ptr<Context> ctx,
+    const std::string& uri,
+    const QueryPredicate& predicate) {
+    auto sr = SOMAReader::open(ctx, uri, "unnamed", {"d0"});
+    sr->set_predicate(predicate);
+    sr->submit();
+    std::vector<int64_t> d0;
+    while (auto batch = sr->read_next()) {
+        for (auto value : (*batch)->at("d0")->data<int64_t>()) {
+            d0.push_back(value);
+        }
+    }
+    std::sort(d0.begin(), d0.end());
+    return d0;
+}
+
+}  // namespace
+
+TEST_CASE("QueryPredicate: comparisons") {
+    auto ctx = std::make_shared<Context>();
+    auto uri = create_array("mem://unit-test-predicate", *ctx);
+
+    using V = std::vector<int64_t>;
+    REQUIRE_THAT(
+        read_d0(ctx, uri, QueryPredicate::compare("a_int", TILEDB_GE, 70)),
+        Equals(V{7, 8, 9}));
+    REQUIRE_THAT(
+        read_d0(ctx, uri, QueryPredicate::compare("a_int", TILEDB_LT, 20.0)),
+        Equals(V{0, 1}));
+    REQUIRE_THAT(
+        read_d0(ctx, uri, QueryPredicate::compare("a_float", TILEDB_LE, 1)),
+        Equals(V{0, 1, 2}));
+    REQUIRE_THAT(
+        read_d0(
+            ctx,
+            uri,
+            QueryPredicate::compare(
+                "a_str", TILEDB_EQ, std::string("c1"))),
+        Equals(V{1, 4, 7}));
+    REQUIRE_THAT(
+        read_d0(ctx, uri, QueryPredicate::compare("a_null", TILEDB_GT, 3)),
+        Equals(V{4, 6, 8}));
+}
+
+TEST_CASE("QueryPredicate: sets, nulls and combinations") {
+    auto ctx = std::make_shared<Context>();
+    auto uri = create_array("mem://unit-test-predicate", *ctx);
+
+    using V = std::vector<int64_t>;
+    REQUIRE_THAT(
+        read_d0(ctx, uri, QueryPredicate::is_in("a_int", {10, 30, 50, 999})),
+        Equals(V{1, 3, 5}));
+    REQUIRE_THAT(
+        read_d0(
+            ctx,
+            uri,
+            QueryPredicate::is_in(
+                "a_str", {std::string("c0"), std::string("c2")})),
+        Equals(V{0, 2, 3, 5, 6, 8, 9}));
+    REQUIRE(read_d0(ctx, uri, QueryPredicate::is_in("a_int", {})).empty());
+    REQUIRE(read_d0(ctx, uri, QueryPredicate::is_in("a_str", {})).empty());
+
+    REQUIRE_THAT(
+        read_d0(ctx, uri, QueryPredicate::is_null("a_null")),
+        Equals(V{1, 3, 5, 7, 9}));
+    REQUIRE_THAT(
+        read_d0(ctx, uri, QueryPredicate::is_null("a_null", false)),
+        Equals(V{0, 2, 4, 6, 8}));
+
+    auto low = QueryPredicate::compare("a_int", TILEDB_LT, 30);
+    auto high = QueryPredicate::compare("a_float", TILEDB_GT, 3.5);
+    auto c1 = QueryPredicate::compare("a_str", TILEDB_EQ, std::string("c1"));
+    REQUIRE_THAT(
+        read_d0(ctx, uri, low.combine(high, TILEDB_OR)),
+        Equals(V{0, 1, 2, 8, 9}));
+    REQUIRE_THAT(
+        read_d0(ctx, uri, low.combine(high, TILEDB_OR).combine(c1, TILEDB_AND)),
+        Equals(V{1}));
+    REQUIRE_THAT(
+        read_d0(ctx, uri, c1.negate()), Equals(V{0, 2, 3, 5, 6, 8, 9}));
+
+    REQUIRE(
+        low.combine(c1.negate(), TILEDB_AND).to_string() ==
+        "(a_int < 30 AND NOT a_str == 'c1')");
+    REQUIRE(
+        QueryPredicate::is_in("a_str", {std::string("it's"), int64_t{1}})
+            .to_string() == "a_str IN ('it\\'s', 1)");
+    REQUIRE(QueryPredicate::is_null("a_null").to_string() == "a_null IS NULL");
+}
+
+TEST_CASE("QueryPredicate: errors") {
+    auto ctx = std::make_shared<Context>();
+    auto uri = create_array("mem://unit-test-predicate", *ctx);
+    auto sr = SOMAReader::open(ctx, uri);
+
+    // Dimensions, unknown columns and values of the wrong type
+    REQUIRE_THROWS_AS(
+        sr->set_predicate(QueryPredicate::compare("d0", TILEDB_EQ, 1)),
+        TileDBSOMAError);
+    REQUIRE_THROWS_AS(
+        sr->set_predicate(QueryPredicate::compare("nope", TILEDB_EQ, 1)),
+        TileDBSOMAError);
+    REQUIRE_THROWS_AS(
+        sr->set_predicate(
+            QueryPredicate::compare("a_int", TILEDB_EQ, std::string("1"))),
+        TileDBSOMAError);
+    REQUIRE_THROWS_AS(
+        sr->set_predicate(QueryPredicate::compare("a_str", TILEDB_EQ, 1)),
+        TileDBSOMAError);
+    REQUIRE_THROWS_AS(
+        sr->set_predicate(QueryPredicate::compare("a_int", TILEDB_EQ, 1.5)),
+        TileDBSOMAError);
+    REQUIRE_THROWS_AS(
+        sr->set_predicate(
+            QueryPredicate::compare("a_int", TILEDB_EQ, int64_t{1} << 40)),
+        TileDBSOMAError);
+    REQUIRE_THROWS_AS(
+        sr->set_predicate(QueryPredicate::is_null("a_int")), TileDBSOMAError);
+
+    // Operators
+    REQUIRE(QueryPredicate::to_op(">=") == TILEDB_GE);
+    REQUIRE(QueryPredicate::to_combination_op("OR") == TILEDB_OR);
+    REQUIRE_THROWS_AS(QueryPredicate::to_op("=>"), TileDBSOMAError);
+    REQUIRE_THROWS_AS(
+        QueryPredicate::to_combination_op("xor"), TileDBSOMAError);
+}
@@ -0,0 +1,189 @@
+/**
+ * @file   unit_result_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * This file manages unit tests for the cache of read results
+ */
+
+#include <chrono>
+#include <thread>
+
+#include <catch2/catch_test_macros.hpp>
+#include <tiledb/tiledb>
+#include <tiledbsoma/tiledbsoma>
+
+#include "test_arrays.h"
+
+using namespace tiledb;
+using namespace tiledbsoma;
+using namespace test_arrays;
+
+namespace {
+
+ResultCache::Batches read_all(SOMAReader& sr) {
+    ResultCache::Batches batches;
+    sr.submit();
+    while (auto batch = sr.read_next()) {
+        batches.push_back(*batch);
+    }
+    return batches;
+}
+
+uint64_t num_rows(const ResultCache::Batches& batches) {
+    uint64_t result = 0;
+    for (auto& batch : batches) {
+        result += batch->num_rows();
+    }
+    return result;
+}
+
+};  // namespace
+
+TEST_CASE("ResultCache: SOMAReader results") {
+    auto& cache = ResultCache::instance();
+    cache.clear();
+    cache.set_capacity(ResultCache::DEFAULT_CAPACITY_BYTES);
+
+    // Readers share the array, so they read at the same timestamp range
+    std::map<std::string, std::string> config = {
+        {"soma.cache_results", "true"}, {"soma.cache_arrays", "true"}};
+    auto ctx = std::make_shared<Context>(Config(config));
+    std::string uri = "mem://unit-test-result-cache-reader";
+    create_array(uri, *ctx);
+    write_array(uri, *ctx, {10, 20, 30});
+
+    auto first = read_all(*SOMAReader::open(ctx, uri));
+    REQUIRE(num_rows(first) == 3);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.bytes() == ResultCache::num_bytes(first));
+
+    // A repeated read shares the cached batches
+    auto sr = SOMAReader::open(ctx, uri);
+    auto second = read_all(*sr);
+    REQUIRE(second == first);
+    REQUIRE(sr->results_complete());
+
+    // Reads of other columns and value filters are cached separately
+    sr->reset({"a0"});
+    auto column = read_all(*sr);
+    REQUIRE(column != first);
+    REQUIRE(column[0]->names() == std::vector<std::string>{"a0"});
+    REQUIRE(cache.size() == 2);
+
+    auto predicate = QueryPredicate::compare("a0", TILEDB_GT, int64_t{15});
+    sr->reset();
+    sr->set_predicate(predicate);
+    auto filtered = read_all(*sr);
+    REQUIRE(num_rows(filtered) == 2);
+    REQUIRE(cache.size() == 3);
+    sr->reset();
+    sr->set_predicate(predicate);
+    REQUIRE(read_all(*sr) == filtered);
+
+    // Reads with coordinate selections are not cached
+    sr->reset();
+    sr->set_dim_points<int64_t>("d0", {10});
+    REQUIRE(num_rows(read_all(*sr)) == 1);
+    REQUIRE(cache.size() == 3);
+
+    // A write between open and submit is not visible to the reader. Its
+    // results are keyed by the timestamp range the array was opened at, so
+    // they are not returned to readers opened after the write.
+    std::map<std::string, std::string> unshared_config = {
+        {"soma.cache_results", "true"}};
+    auto unshared_ctx = std::make_shared<Context>(Config(unshared_config));
+    auto sr_before = SOMAReader::open(unshared_ctx, uri);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    write_array(uri, *ctx, {40});
+    REQUIRE(num_rows(read_all(*sr_before)) == 3);
+    REQUIRE(cache.size() == 4);
+    auto written = read_all(*SOMAReader::open(unshared_ctx, uri));
+    REQUIRE(num_rows(written) == 4);
+    REQUIRE(cache.size() == 5);
+
+    // Results are evicted beyond the capacity
+    cache.set_capacity(ResultCache::num_bytes(written));
+    REQUIRE(cache.size() == 1);
+    cache.set_capacity(0);
+    REQUIRE(cache.size() == 0);
+    read_all(*SOMAReader::open(ctx, uri));
+    REQUIRE(cache.size() == 0);
+
+    // Results are not cached unless the cache is enabled
+    cache.set_capacity(ResultCache::DEFAULT_CAPACITY_BYTES);
+    read_all(*SOMAReader::open(std::make_shared<Context>(), uri));
+    REQUIRE(cache.size() == 0);
+}
+
+TEST_CASE("ResultCache: Writes in a pinned timestamp range") {
+    auto& cache = ResultCache::instance();
+    cache.clear();
+    cache.set_capacity(ResultCache::DEFAULT_CAPACITY_BYTES);
+
+    std::map<std::string, std::string> config = {
+        {"soma.cache_results", "true"}};
+    auto ctx = std::make_shared<Context>(Config(config));
+    std::string uri = "mem://unit-test-result-cache-pinned";
+    create_array(uri, *ctx);
+    write_array(uri, *ctx, {10, 20}, 10);
+
+    std::pair<uint64_t, uint64_t> timestamp = {0, 100};
+    auto open = [&]() {
+        return SOMAReader::open(
+            ctx, uri, "unnamed", {}, "auto", "auto", timestamp);
+    };
+    REQUIRE(num_rows(read_all(*open())) == 2);
+    REQUIRE(cache.size() == 1);
+
+    // A fragment written inside the range changes the key of later readers
+    write_array(uri, *ctx, {30}, 10);
+    REQUIRE(num_rows(read_all(*open())) == 3);
+    REQUIRE(cache.size() == 2);
+}
+
+TEST_CASE("ResultCache: Capacity is configured explicitly") {
+    auto& cache = ResultCache::instance();
+    cache.set_capacity(ResultCache::DEFAULT_CAPACITY_BYTES);
+
+    std::map<std::string, std::string> config = {
+        {"soma.cache_results", "true"}, {"soma.result_cache_bytes", "1024"}};
+    auto ctx = std::make_shared<Context>(Config(config));
+    std::string uri = "mem://unit-test-result-cache-capacity";
+    create_array(uri, *ctx);
+
+    // The config of a reader does not resize the process-wide cache
+    SOMAReader::open(ctx, uri);
+    REQUIRE(cache.capacity() == ResultCache::DEFAULT_CAPACITY_BYTES);
+
+    cache.configure(ctx->config());
+    REQUIRE(cache.capacity() == 1024);
+
+    std::map<std::string, std::string> bad_config = {
+        {"soma.result_cache_bytes", "many"}};
+    REQUIRE_THROWS_AS(cache.configure(Config(bad_config)), TileDBSOMAError);
+    cache.set_capacity(ResultCache::DEFAULT_CAPACITY_BYTES);
+}
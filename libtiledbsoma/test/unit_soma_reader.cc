@@ -149,13 +149,16 @@ TEST_CASE("SOMAReader: nnz") {
     auto num_fragments = GENERATE(1, 10);
     auto overlap = GENERATE(false, true);
     auto allow_duplicates = GENERATE(false, true);
+    // The cells of a sorted reader are counted by unordered reads
+    auto result_order = GENERATE("auto", "sorted");
     int num_cells_per_fragment = 128;
 
     SECTION(fmt::format(
-        " - fragments={}, overlap={}, allow_duplicates={}",
+        " - fragments={}, overlap={}, allow_duplicates={}, order={}",
         num_fragments,
         overlap,
-        allow_duplicates)) {
+        allow_duplicates,
+        result_order)) {
         auto ctx = std::make_shared<Context>();
 
         // Create array at timestamp 10
@@ -170,7 +173,7 @@ TEST_CASE("SOMAReader: nnz") {
             10);
 
         // Get total cell num
-        auto sr = SOMAReader::open(ctx, uri);
+        auto sr = SOMAReader::open(ctx, uri, "nnz", {}, "auto", result_order);
 
         uint64_t nnz;
         if (num_fragments > 1 && overlap && allow_duplicates) {
@@ -235,6 +238,65 @@ TEST_CASE("SOMAReader: nnz with timestamp") {
     }
 }
 
+TEST_CASE("SOMAReader: reopen at timestamp") {
+    auto cache_arrays = GENERATE("false", "true");
+    std::map<std::string, std::string> config = {
+        {"soma.cache_arrays", cache_arrays}};
+    auto ctx = std::make_shared<Context>(Config(config));
+
+    // Create array with 10 cells at timestamp 10
+    const auto& [uri, expected_nnz] =
+        create_array("mem://unit-test-reopen", *ctx, 10, 1, false, false, 10);
+
+    // Write 5 more cells at timestamp 20
+    {
+        Array array(*ctx, uri, TILEDB_WRITE, 20);
+        std::vector<int64_t> d0 = {100, 101, 102, 103, 104};
+        std::vector<int> a0(d0.size(), 1);
+        Query query(*ctx, array);
+        query.set_layout(TILEDB_UNORDERED)
+            .set_data_buffer("d0", d0)
+            .set_data_buffer("a0", a0);
+        query.submit();
+        array.close();
+    }
+
+    auto num_rows = [](SOMAReader& sr) {
+        sr.submit();
+        uint64_t total = 0;
+        while (auto batch = sr.read_next()) {
+            total += (*batch)->num_rows();
+        }
+        return total;
+    };
+
+    std::pair<uint64_t, uint64_t> before{0, 15};
+    std::pair<uint64_t, uint64_t> after{0, 25};
+    auto sr = SOMAReader::open(ctx, uri, "reopen", {}, "auto", "auto", before);
+    REQUIRE(sr->nnz() == expected_nnz);
+    REQUIRE(num_rows(*sr) == expected_nnz);
+
+    // The nnz is not the cached nnz of the previous timestamp range
+    sr->reopen_at(after);
+    REQUIRE(sr->nnz() == expected_nnz + 5);
+    REQUIRE(num_rows(*sr) == expected_nnz + 5);
+
+    // Columns are selected as by reset
+    sr->reopen_at(std::nullopt, {"a0"});
+    REQUIRE(sr->nnz() == expected_nnz + 5);
+    sr->submit();
+    auto batch = sr->read_next();
+    REQUIRE(batch);
+    REQUIRE((*batch)->names() == std::vector<std::string>{"a0"});
+
+    sr->reopen_at(before);
+    REQUIRE(sr->nnz() == expected_nnz);
+    REQUIRE(num_rows(*sr) == expected_nnz);
+
+    std::pair<uint64_t, uint64_t> invalid{20, 10};
+    REQUIRE_THROWS_AS(sr->reopen_at(invalid), TileDBSOMAError);
+}
+
 TEST_CASE("SOMAReader: nnz with consolidation") {
     auto num_fragments = GENERATE(1, 10);
     auto overlap = GENERATE(false, true);
@@ -293,3 +355,577 @@ TEST_CASE("SOMAReader: nnz with consolidation") {
         }
     }
 }
+
+TEST_CASE("SOMAReader: nnz bounds") {
+    auto num_fragments = GENERATE(1, 10);
+    auto overlap = GENERATE(false, true);
+    int num_cells_per_fragment = 128;
+
+    SECTION(fmt::format(
+        " - fragments={}, overlap={}", num_fragments, overlap)) {
+        auto ctx = std::make_shared<Context>();
+
+        std::string base_uri = "mem://unit-test-array";
+        const auto& [uri, expected_nnz] = create_array(
+            base_uri, *ctx, num_cells_per_fragment, num_fragments, overlap);
+
+        auto sr = SOMAReader::open(ctx, uri, "nnz", {}, "auto", "auto");
+        auto [lower, upper] = sr->nnz_bounds();
+        REQUIRE(lower <= expected_nnz);
+        REQUIRE(upper >= expected_nnz);
+        REQUIRE(upper == (uint64_t)num_cells_per_fragment * num_fragments);
+        if (overlap && num_fragments > 1) {
+            // Each overlap region holds the cells of at least one fragment
+            REQUIRE(lower == expected_nnz);
+        } else {
+            REQUIRE(lower == upper);
+        }
+        REQUIRE(sr->nnz() == expected_nnz);
+    }
+}
+
+TEST_CASE("SOMAReader: prefetch") {
+    auto prefetch = GENERATE(false, true);
+    int num_cells_per_fragment = 1000;
+    int num_fragments = 4;
+
+    SECTION(fmt::format(" - prefetch={}", prefetch)) {
+        // Use small buffers to read the array in multiple batches
+        std::map<std::string, std::string> config = {
+            {"soma.init_buffer_bytes", "1024"},
+            {"soma.read_prefetch", prefetch ? "true" : "false"}};
+        auto ctx = std::make_shared<Context>(Config(config));
+
+        std::string base_uri = "mem://unit-test-array";
+        auto [uri, expected_nnz] = create_array(
+            base_uri, *ctx, num_cells_per_fragment, num_fragments);
+
+        auto sr = SOMAReader::open(ctx, uri);
+        sr->submit();
+
+        int batches = 0;
+        uint64_t total_num_rows = 0;
+        int64_t d0_sum = 0;
+        std::vector<std::shared_ptr<ArrayBuffers>> results;
+        while (auto batch = sr->read_next()) {
+            batches++;
+            total_num_rows += (*batch)->num_rows();
+            results.push_back(*batch);
+        }
+
+        // Results held by the caller are not modified by the prefetched reads
+        for (auto& batch : results) {
+            for (auto d0 : batch->at("d0")->data<int64_t>()) {
+                d0_sum += d0;
+            }
+        }
+
+        REQUIRE(batches > 1);
+        REQUIRE(sr->is_complete());
+        REQUIRE(!sr->results_complete());
+        REQUIRE(total_num_rows == expected_nnz);
+        REQUIRE(
+            d0_sum == (int64_t)expected_nnz * ((int64_t)expected_nnz - 1) / 2);
+    }
+}
+
+TEST_CASE("SOMAReader: partition ranges") {
+    using Ranges = std::vector<std::pair<int64_t, int64_t>>;
+
+    // Integral ranges are split by the number of values covered
+    Ranges ranges = {{0, 9}, {20, 24}};
+    REQUIRE(SOMAReader::partition_ranges(ranges, 0, 3) == Ranges{{0, 4}});
+    REQUIRE(SOMAReader::partition_ranges(ranges, 1, 3) == Ranges{{5, 9}});
+    REQUIRE(SOMAReader::partition_ranges(ranges, 2, 3) == Ranges{{20, 24}});
+
+    // Uneven splits cover all values
+    ranges = {{-5, 4}};
+    REQUIRE(SOMAReader::partition_ranges(ranges, 0, 3) == Ranges{{-5, -2}});
+    REQUIRE(SOMAReader::partition_ranges(ranges, 1, 3) == Ranges{{-1, 1}});
+    REQUIRE(SOMAReader::partition_ranges(ranges, 2, 3) == Ranges{{2, 4}});
+
+    // More partitions than values leaves some partitions empty
+    ranges = {{7, 7}};
+    REQUIRE(SOMAReader::partition_ranges(ranges, 0, 2) == Ranges{{7, 7}});
+    REQUIRE(SOMAReader::partition_ranges(ranges, 1, 2).empty());
+
+    // Other ranges are split by the number of ranges
+    std::vector<std::pair<double, double>> float_ranges = {
+        {0.0, 1.0}, {2.0, 3.0}, {4.0, 5.0}};
+    REQUIRE(SOMAReader::partition_ranges(float_ranges, 0, 2).size() == 1);
+    REQUIRE(SOMAReader::partition_ranges(float_ranges, 1, 2).size() == 2);
+}
+
+TEST_CASE("SOMAReader: partitioned read") {
+    auto ordered = GENERATE(false, true);
+    auto selection = GENERATE("none", "ranges", "points");
+    int num_cells_per_fragment = 1000;
+    int num_fragments = 4;
+    int num_partitions = 3;
+
+    SECTION(fmt::format(" - ordered={} selection={}", ordered, selection)) {
+        // Use small buffers to read each partition in multiple batches
+        std::map<std::string, std::string> config = {
+            {"soma.init_buffer_bytes", "1024"},
+            {"soma.read_partitions", std::to_string(num_partitions)},
+            {"soma.read_partitions_ordered", ordered ? "true" : "false"}};
+        auto ctx = std::make_shared<Context>(Config(config));
+
+        std::string base_uri = "mem://unit-test-array";
+        auto [uri, nnz] = create_array(
+            base_uri, *ctx, num_cells_per_fragment, num_fragments);
+
+        // Expected d0 values, all cells unless selected
+        std::vector<int64_t> expected(nnz);
+        std::iota(expected.begin(), expected.end(), 0);
+
+        auto sr = SOMAReader::open(ctx, uri);
+        std::vector<std::pair<int64_t, int64_t>> ranges = {
+            {0, (int64_t)nnz - 1}};
+        if (selection == std::string("ranges")) {
+            ranges = {{100, 1099}, {2000, 3499}};
+            expected.clear();
+            for (auto& [start, stop] : ranges) {
+                for (auto i = start; i <= stop; i++) {
+                    expected.push_back(i);
+                }
+            }
+            sr->set_dim_ranges("d0", ranges);
+        } else if (selection == std::string("points")) {
+            expected.clear();
+            for (int64_t i = 0; i < (int64_t)nnz; i += 3) {
+                expected.push_back(i);
+            }
+            sr->set_dim_points("d0", expected);
+        }
+        sr->submit();
+
+        std::vector<int64_t> d0;
+        int last_partition = 0;
+        while (auto batch = sr->read_next()) {
+            for (auto value : (*batch)->at("d0")->data<int64_t>()) {
+                d0.push_back(value);
+
+                // Find the partition of the value when ranges are split
+                if (ordered && selection != std::string("points")) {
+                    int partition = 0;
+                    while (partition < num_partitions) {
+                        auto split = SOMAReader::partition_ranges(
+                            ranges, partition, num_partitions);
+                        bool found = false;
+                        for (auto& [start, stop] : split) {
+                            found |= value >= start && value <= stop;
+                        }
+                        if (found) {
+                            break;
+                        }
+                        partition++;
+                    }
+                    REQUIRE(partition >= last_partition);
+                    last_partition = partition;
+                }
+            }
+        }
+
+        REQUIRE(sr->is_complete());
+        std::sort(d0.begin(), d0.end());
+        REQUIRE(d0 == expected);
+
+        // The metrics include the queries of all partitions
+        auto metrics = sr->metrics();
+        REQUIRE(metrics.num_cells == expected.size());
+        REQUIRE(metrics.columns.at("d0").cells == expected.size());
+    }
+}
+
+TEST_CASE("SOMAReader: string dimension points") {
+    int num_partitions = 2;
+    auto ctx = std::make_shared<Context>();
+    std::string uri = "mem://unit-test-string-points";
+
+    // Create a sparse array with a string dimension
+    ArraySchema schema(*ctx, TILEDB_SPARSE);
+    Domain domain(*ctx);
+    domain.add_dimension(
+        Dimension::create(*ctx, "d0", TILEDB_STRING_ASCII, nullptr, nullptr));
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<int>(*ctx, "a0"));
+    Array::create(uri, schema);
+
+    // Write cells "key-000" ... "key-099"
+    std::string d0;
+    std::vector<uint64_t> d0_offsets;
+    std::vector<int> a0;
+    for (int i = 0; i < 100; i++) {
+        d0_offsets.push_back(d0.size());
+        d0 += fmt::format("key-{:03}", i);
+        a0.push_back(i);
+    }
+    Array array(*ctx, uri, TILEDB_WRITE);
+    Query query(*ctx, array);
+    query.set_layout(TILEDB_UNORDERED)
+        .set_data_buffer("d0", d0)
+        .set_offsets_buffer("d0", d0_offsets)
+        .set_data_buffer("a0", a0);
+    query.submit();
+    array.close();
+
+    // Select unsorted points with duplicates and a missing key
+    std::vector<std::string> keys = {
+        "key-042", "key-007", "key-042", "key-099", "missing", "key-007"};
+    std::vector<std::string> expected = {"key-007", "key-042", "key-099"};
+
+    std::vector<std::string> results;
+    for (int partition = 0; partition < num_partitions; partition++) {
+        std::vector<std::string_view> points(keys.begin(), keys.end());
+        auto sr = SOMAReader::open(ctx, uri);
+        sr->set_dim_points("d0", points, partition, num_partitions);
+        sr->submit();
+        while (auto batch = sr->read_next()) {
+            for (auto& value : (*batch)->at("d0")->strings()) {
+                results.push_back(value);
+            }
+        }
+    }
+
+    // Each point is read once, across the partitions
+    std::sort(results.begin(), results.end());
+    REQUIRE(results == expected);
+}
+
+TEST_CASE("SOMAReader: coalesced points") {
+    auto coalesce = GENERATE(false, true);
+    int num_cells_per_fragment = 1000;
+
+    SECTION(fmt::format(" - coalesce={}", coalesce)) {
+        std::map<std::string, std::string> config = {
+            {"soma.coalesce_points", coalesce ? "true" : "false"}};
+        auto ctx = std::make_shared<Context>(Config(config));
+
+        std::string base_uri = "mem://unit-test-array";
+        auto [uri, nnz] = create_array(base_uri, *ctx, num_cells_per_fragment);
+
+        // Runs of points with gaps, in descending order with duplicates
+        std::vector<int64_t> points;
+        for (int64_t i = nnz - 1; i >= 0; i--) {
+            if (i % 100 < 90) {
+                points.push_back(i);
+            }
+            if (i % 250 == 0) {
+                points.push_back(i);
+            }
+        }
+        std::vector<int64_t> expected(points);
+        std::sort(expected.begin(), expected.end());
+        expected.erase(
+            std::unique(expected.begin(), expected.end()), expected.end());
+
+        auto sr = SOMAReader::open(ctx, uri);
+        sr->set_dim_points("d0", points);
+        sr->submit();
+
+        std::vector<int64_t> d0;
+        while (auto batch = sr->read_next()) {
+            auto data = (*batch)->at("d0")->data<int64_t>();
+            d0.insert(d0.end(), data.begin(), data.end());
+        }
+        std::sort(d0.begin(), d0.end());
+        REQUIRE(d0 == expected);
+    }
+}
+
+TEST_CASE("SOMAReader: Arrow stream") {
+    int num_cells_per_fragment = 1000;
+    int num_fragments = 4;
+
+    // Use small buffers to read the results in multiple batches
+    std::map<std::string, std::string> config = {
+        {"soma.init_buffer_bytes", "1024"}};
+    auto ctx = std::make_shared<Context>(Config(config));
+
+    std::string base_uri = "mem://unit-test-array";
+    auto [uri, nnz] =
+        create_array(base_uri, *ctx, num_cells_per_fragment, num_fragments);
+
+    std::shared_ptr<SOMAReader> sr = SOMAReader::open(ctx, uri);
+    sr->submit();
+
+    ArrowArrayStream stream;
+    ArrowAdapter::to_arrow_stream(sr, &stream);
+
+    // The schema is a struct with one child per column
+    ArrowSchema schema;
+    REQUIRE(stream.get_schema(&stream, &schema) == 0);
+    REQUIRE(std::string(schema.format) == "+s");
+    REQUIRE(schema.n_children == 2);
+    REQUIRE(std::string(schema.children[0]->name) == "d0");
+    REQUIRE(std::string(schema.children[0]->format) == "l");
+    REQUIRE(std::string(schema.children[1]->name) == "a0");
+    REQUIRE(std::string(schema.children[1]->format) == "i");
+    schema.release(&schema);
+    REQUIRE(schema.release == nullptr);
+
+    std::vector<int64_t> d0;
+    int num_batches = 0;
+    while (true) {
+        ArrowArray array;
+        REQUIRE(stream.get_next(&stream, &array) == 0);
+        if (array.release == nullptr) {
+            break;
+        }
+        num_batches++;
+        REQUIRE(array.n_children == 2);
+        auto child = array.children[0];
+        REQUIRE(child->length == array.length);
+        auto data = static_cast<const int64_t*>(child->buffers[1]);
+        d0.insert(d0.end(), data, data + child->length);
+        array.release(&array);
+    }
+    stream.release(&stream);
+
+    REQUIRE(num_batches > 1);
+    auto metrics = sr->metrics();
+    REQUIRE(metrics.num_batches >= (uint64_t)num_batches);
+    REQUIRE(metrics.num_cells == nnz);
+    REQUIRE(metrics.arrow_export_seconds > 0);
+
+    std::vector<int64_t> expected(nnz);
+    std::iota(expected.begin(), expected.end(), 0);
+    std::sort(d0.begin(), d0.end());
+    REQUIRE(d0 == expected);
+}
+
+TEST_CASE("SOMAReader: predicate-only columns") {
+    int num_cells_per_fragment = 10;
+    int num_fragments = 4;
+
+    auto ctx = std::make_shared<Context>();
+    std::string base_uri = "mem://unit-test-array";
+    auto [uri, nnz] =
+        create_array(base_uri, *ctx, num_cells_per_fragment, num_fragments);
+    (void)nnz;
+
+    // Filter on a0 while reading only d0: a0 is evaluated by TileDB and gets
+    // no buffer
+    auto sr = SOMAReader::open(ctx, uri, "unnamed", {"d0"});
+    auto qc = QueryCondition::create<int>(*ctx, "a0", 2, TILEDB_EQ);
+    sr->set_condition(qc);
+    sr->submit();
+
+    std::vector<int64_t> d0;
+    while (auto batch = sr->read_next()) {
+        REQUIRE((*batch)->names() == std::vector<std::string>{"d0"});
+        for (auto value : (*batch)->at("d0")->data<int64_t>()) {
+            d0.push_back(value);
+        }
+    }
+
+    std::vector<int64_t> expected(num_cells_per_fragment);
+    std::iota(expected.begin(), expected.end(), 2 * num_cells_per_fragment);
+    std::sort(d0.begin(), d0.end());
+    REQUIRE(d0 == expected);
+
+    auto metrics = sr->metrics();
+    REQUIRE(metrics.columns.count("d0") == 1);
+    REQUIRE(metrics.columns.count("a0") == 0);
+}
+
+TEST_CASE("SOMAReader: sorted read") {
+    auto selection = GENERATE("none", "ranges");
+    auto columns = GENERATE("all", "a0");
+
+    SECTION(fmt::format(" - selection={} columns={}", selection, columns)) {
+        // Sort few cells at a time, read with small buffers
+        std::map<std::string, std::string> config = {
+            {"soma.init_buffer_bytes", "1024"},
+            {"soma.read_sort_max_cells", "300"}};
+        auto ctx = std::make_shared<Context>(Config(config));
+
+        std::string uri = "mem://unit-test-array-sorted";
+        auto vfs = VFS(*ctx);
+        if (vfs.is_dir(uri)) {
+            vfs.remove_dir(uri);
+        }
+        ArraySchema schema(*ctx, TILEDB_SPARSE);
+        Domain domain(*ctx);
+        domain.add_dimension(
+            Dimension::create<int64_t>(*ctx, "d0", {0, 99}, 10));
+        domain.add_dimension(
+            Dimension::create<int64_t>(*ctx, "d1", {0, 99}, 10));
+        schema.set_domain(domain);
+        schema.add_attribute(Attribute::create<int64_t>(*ctx, "a0"));
+        Array::create(uri, schema);
+
+        // Fragment f holds the cells with d1 % 4 == f, written in a random
+        // order, and a0 increases with the coordinates
+        {
+            Array array(*ctx, uri, TILEDB_WRITE);
+            for (int64_t f = 0; f < 4; f++) {
+                std::vector<std::pair<int64_t, int64_t>> cells;
+                for (int64_t i = 0; i < 50; i++) {
+                    for (int64_t j = f; j < 100; j += 4) {
+                        cells.emplace_back(i, j);
+                    }
+                }
+                std::shuffle(cells.begin(), cells.end(), std::mt19937(f));
+                std::vector<int64_t> d0, d1, a0;
+                for (auto& [i, j] : cells) {
+                    d0.push_back(i);
+                    d1.push_back(j);
+                    a0.push_back(i * 100 + j);
+                }
+                Query query(*ctx, array);
+                query.set_layout(TILEDB_UNORDERED)
+                    .set_data_buffer("d0", d0)
+                    .set_data_buffer("d1", d1)
+                    .set_data_buffer("a0", a0);
+                query.submit();
+            }
+            array.close();
+        }
+
+        std::vector<std::string> column_names;
+        if (columns == std::string("a0")) {
+            column_names = {"a0"};
+        }
+        auto sr = SOMAReader::open(
+            ctx, uri, "unnamed", column_names, "auto", "sorted");
+
+        // Overlapping ranges are merged
+        std::vector<int64_t> expected;
+        int64_t first = 0, last = 49;
+        if (selection == std::string("ranges")) {
+            sr->set_dim_ranges<int64_t>("d0", {{10, 19}, {5, 12}});
+            first = 5;
+            last = 19;
+        }
+        for (int64_t i = first; i <= last; i++) {
+            for (int64_t j = 0; j < 100; j++) {
+                expected.push_back(i * 100 + j);
+            }
+        }
+        sr->submit();
+
+        std::vector<int64_t> a0;
+        int num_batches = 0;
+        while (auto batch = sr->read_next()) {
+            num_batches++;
+            if (columns == std::string("a0")) {
+                REQUIRE((*batch)->names() == std::vector<std::string>{"a0"});
+            } else {
+                REQUIRE(
+                    (*batch)->names() ==
+                    std::vector<std::string>{"d0", "d1", "a0"});
+                auto d0 = (*batch)->at("d0")->data<int64_t>();
+                auto d1 = (*batch)->at("d1")->data<int64_t>();
+                auto values = (*batch)->at("a0")->data<int64_t>();
+                for (size_t i = 0; i < values.size(); i++) {
+                    REQUIRE(values[i] == d0[i] * 100 + d1[i]);
+                }
+            }
+            for (auto value : (*batch)->at("a0")->data<int64_t>()) {
+                a0.push_back(value);
+            }
+        }
+
+        // The cells of all batches are sorted, without a client sort
+        REQUIRE(sr->is_complete());
+        REQUIRE(num_batches > 1);
+        REQUIRE_FALSE(sr->results_complete());
+        REQUIRE(a0 == expected);
+        REQUIRE(sr->metrics().num_cells >= expected.size());
+    }
+}
+
+TEST_CASE("SOMAReader: sorted read of an empty selection") {
+    auto ctx = std::make_shared<Context>();
+    std::string base_uri = "mem://unit-test-array";
+    auto [uri, nnz] = create_array(base_uri, *ctx, 10, 2);
+    (void)nnz;
+
+    auto sr = SOMAReader::open(ctx, uri, "unnamed", {}, "auto", "sorted");
+    sr->set_dim_points<int64_t>("d0", std::vector<int64_t>{});
+    sr->submit();
+
+    // The first call returns an empty batch, as for unsorted reads
+    auto batch = sr->read_next();
+    REQUIRE(batch);
+    REQUIRE((*batch)->num_rows() == 0);
+    REQUIRE_FALSE(sr->read_next());
+    REQUIRE(sr->is_complete());
+}
+
+TEST_CASE("SOMAReader: chunk plan") {
+    auto overlap = GENERATE(false, true);
+
+    SECTION(fmt::format(" - overlap={}", overlap)) {
+        auto ctx = std::make_shared<Context>();
+        std::string base_uri = "mem://unit-test-array-chunks";
+        auto [uri, nnz] = create_array(base_uri, *ctx, 128, 10, overlap);
+
+        auto sr = SOMAReader::open(ctx, uri);
+        REQUIRE_THROWS_AS(sr->plan_chunks(0), TileDBSOMAError);
+
+        // Read each chunk, in a shuffled order
+        auto read_chunks = [&](std::vector<SOMAReader::Chunk> chunks) {
+            std::shuffle(chunks.begin(), chunks.end(), std::mt19937{0});
+            std::vector<int64_t> d0;
+            for (auto& chunk : chunks) {
+                sr->reset();
+                sr->select_chunk(chunk);
+                sr->submit();
+                uint64_t num_cells = 0;
+                while (auto batch = sr->read_next()) {
+                    for (auto value : (*batch)->at("d0")->data<int64_t>()) {
+                        d0.push_back(value);
+                    }
+                    num_cells += (*batch)->num_rows();
+                }
+                if (!overlap) {
+                    REQUIRE(num_cells == chunk.num_cells);
+                }
+            }
+            std::sort(d0.begin(), d0.end());
+            return d0;
+        };
+
+        // The cells of the chunks are estimated from the fragment metadata,
+        // which counts overlapping cells more than once
+        auto chunks = sr->plan_chunks(100);
+        REQUIRE(chunks.size() == 13);
+        REQUIRE(
+            chunks[0].ranges ==
+            std::vector<std::pair<int64_t, int64_t>>{{0, overlap ? 49 : 99}});
+        for (size_t i = 1; i < chunks.size(); i++) {
+            REQUIRE(chunks[i - 1].ranges.back().second + 1 ==
+                    chunks[i].ranges.front().first);
+        }
+
+        // Plans are deterministic
+        auto again = sr->plan_chunks(100);
+        REQUIRE(again.size() == chunks.size());
+        for (size_t i = 0; i < chunks.size(); i++) {
+            REQUIRE(again[i].ranges == chunks[i].ranges);
+            REQUIRE(again[i].num_cells == chunks[i].num_cells);
+        }
+
+        // Each cell is read exactly once
+        auto d0 = read_chunks(chunks);
+        REQUIRE(d0.size() == nnz);
+        REQUIRE(std::adjacent_find(d0.begin(), d0.end()) == d0.end());
+
+        // Chunks of a selection cover only its ranges
+        if (!overlap) {
+            chunks = sr->plan_chunks(100, {{{1000, 1099}, {50, 349}}});
+            std::vector<std::vector<std::pair<int64_t, int64_t>>> ranges;
+            for (auto& chunk : chunks) {
+                ranges.push_back(chunk.ranges);
+            }
+            REQUIRE(
+                ranges ==
+                std::vector<std::vector<std::pair<int64_t, int64_t>>>{
+                    {{50, 149}}, {{150, 249}}, {{250, 349}}, {{1000, 1099}}});
+            REQUIRE(read_chunks(chunks).size() == 400);
+        }
+    }
+}
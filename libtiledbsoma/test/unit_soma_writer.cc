@@ -0,0 +1,324 @@
+/**
+ * @file   unit_soma_writer.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ *
+ *   This file manages unit tests for the SOMAWriter class
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators_all.hpp>
+
+#include <tiledb/tiledb>
+#include <tiledbsoma/tiledbsoma>
+
+using namespace tiledb;
+using namespace tiledbsoma;
+
+namespace {
+
+// Create a sparse array with an int64 dimension "d0", an int32 attribute
+// "a0" and a nullable string attribute "a1"
+std::string create_array(const std::string& uri, Context& ctx) {
+    auto vfs = VFS(ctx);
+    if (vfs.is_dir(uri)) {
+        vfs.remove_dir(uri);
+    }
+
+    ArraySchema schema(ctx, TILEDB_SPARSE);
+    auto dim = Dimension::create<int64_t>(ctx, "d0", {0, 1 << 20}, 64);
+    Domain domain(ctx);
+    domain.add_dimension(dim);
+    schema.set_domain(domain);
+    schema.add_attribute(Attribute::create<int32_t>(ctx, "a0"));
+    auto a1 = Attribute::create<std::string>(ctx, "a1");
+    a1.set_nullable(true);
+    schema.add_attribute(a1);
+    schema.check();
+    Array::create(uri, schema);
+    return uri;
+}
+
+// Value of "a1" for a cell, or nullopt if null
+std::optional<std::string> a1_value(int64_t d0) {
+    if (d0 % 3 == 0) {
+        return std::nullopt;
+    }
+    return std::to_string(d0);
+}
+
+// Arrow struct array with the columns of the test array, owning its buffers
+// until it is released
+struct TestBatch {
+    std::vector<int64_t> d0;
+    std::vector<int32_t> a0;
+    std::vector<int32_t> a1_offsets;
+    std::string a1_data;
+    std::vector<uint8_t> a1_validity;
+
+    const void* buffers[1] = {nullptr};
+    const void* d0_buffers[2];
+    const void* a0_buffers[2];
+    const void* a1_buffers[3];
+    ArrowArray children[3];
+    ArrowArray* child_ptrs[3];
+
+    // Incremented when the batch is released
+    int* num_released;
+};
+
+void release_child(ArrowArray* array) {
+    array->release = nullptr;
+}
+
+void release_batch(ArrowArray* array) {
+    auto batch = (TestBatch*)array->private_data;
+    for (auto& child : batch->children) {
+        child.release(&child);
+    }
+    (*batch->num_released)++;
+    delete batch;
+    array->release = nullptr;
+}
+
+// Return a batch with cells [start, start + length), preceded by `offset`
+// cells that are skipped by the offset of the struct array
+ArrowArray make_batch(
+    int64_t start, int64_t length, int* num_released, int64_t offset = 0) {
+    auto batch = new TestBatch();
+    batch->num_released = num_released;
+    batch->a1_offsets.push_back(0);
+    std::vector<bool> valid;
+    for (int64_t d0 = start - offset; d0 < start + length; d0++) {
+        batch->d0.push_back(d0);
+        batch->a0.push_back(d0 * 10);
+        auto a1 = a1_value(d0);
+        batch->a1_data += a1.value_or("");
+        batch->a1_offsets.push_back(batch->a1_data.size());
+        valid.push_back(a1.has_value());
+    }
+    batch->a1_validity.resize((valid.size() + 7) / 8);
+    for (size_t i = 0; i < valid.size(); i++) {
+        batch->a1_validity[i / 8] |= valid[i] << (i % 8);
+    }
+
+    batch->d0_buffers[0] = nullptr;
+    batch->d0_buffers[1] = batch->d0.data();
+    batch->a0_buffers[0] = nullptr;
+    batch->a0_buffers[1] = batch->a0.data();
+    batch->a1_buffers[0] = batch->a1_validity.data();
+    batch->a1_buffers[1] = batch->a1_offsets.data();
+    batch->a1_buffers[2] = batch->a1_data.data();
+    const void** child_buffers[3] = {
+        batch->d0_buffers, batch->a0_buffers, batch->a1_buffers};
+    int64_t n_buffers[3] = {2, 2, 3};
+    for (int i = 0; i < 3; i++) {
+        batch->children[i] = {
+            length + offset,
+            i == 2 ? -1 : 0,
+            0,
+            n_buffers[i],
+            0,
+            child_buffers[i],
+            nullptr,
+            nullptr,
+            &release_child,
+            nullptr};
+        batch->child_ptrs[i] = &batch->children[i];
+    }
+
+    return {
+        length,
+        0,
+        offset,
+        1,
+        3,
+        batch->buffers,
+        batch->child_ptrs,
+        nullptr,
+        &release_batch,
+        batch};
+}
+
+void release_schema(ArrowSchema* schema) {
+    schema->release = nullptr;
+}
+
+// Arrow schema of the test batches, with the Arrow format of "a0"
+struct TestSchema {
+    ArrowSchema children[3];
+    ArrowSchema* child_ptrs[3];
+    ArrowSchema schema;
+
+    TestSchema(const char* a0_format = "i") {
+        const char* formats[3] = {"l", a0_format, "u"};
+        const char* names[3] = {"d0", "a0", "a1"};
+        for (int i = 0; i < 3; i++) {
+            children[i] = {
+                formats[i],
+                names[i],
+                nullptr,
+                i == 2 ? ARROW_FLAG_NULLABLE : 0,
+                0,
+                nullptr,
+                nullptr,
+                &release_schema,
+                nullptr};
+            child_ptrs[i] = &children[i];
+        }
+        schema = {
+            "+s",
+            "",
+            nullptr,
+            0,
+            3,
+            child_ptrs,
+            nullptr,
+            &release_schema,
+            nullptr};
+    }
+};
+
+// Read the array and check that it holds cells [0, num_cells)
+void check_array(
+    std::shared_ptr<Context> ctx, const std::string& uri, size_t num_cells) {
+    auto sr = SOMAReader::open(ctx, uri);
+    sr->submit();
+
+    std::map<int64_t, std::pair<int32_t, std::optional<std::string>>> cells;
+    while (auto batch = sr->read_next()) {
+        auto d0 = (*batch)->at("d0")->data<int64_t>();
+        auto a0 = (*batch)->at("a0")->data<int32_t>();
+        auto a1 = (*batch)->at("a1");
+        for (size_t i = 0; i < d0.size(); i++) {
+            std::optional<std::string> value;
+            if (a1->validity()[i]) {
+                value = std::string(a1->string_view(i));
+            }
+            cells[d0[i]] = {a0[i], value};
+        }
+    }
+
+    REQUIRE(cells.size() == num_cells);
+    int64_t expected = 0;
+    for (auto& [d0, values] : cells) {
+        REQUIRE(d0 == expected++);
+        REQUIRE(values.first == d0 * 10);
+        REQUIRE(values.second == a1_value(d0));
+    }
+}
+
+};  // namespace
+
+TEST_CASE("SOMAWriter: unordered write") {
+    auto in_flight = GENERATE(0, 1, 2);
+    SECTION(fmt::format(" - in_flight={}", in_flight)) {
+        std::map<std::string, std::string> config = {
+            {"soma.write_in_flight", std::to_string(in_flight)}};
+        auto ctx = std::make_shared<Context>(Config(config));
+        auto uri = create_array("mem://unit-test-writer-unordered", *ctx);
+
+        // Write the batches out of order, with struct array offsets
+        int num_released = 0;
+        TestSchema schema;
+        auto writer = SOMAWriter::open(ctx, uri);
+        for (auto start : {200, 0, 100}) {
+            auto batch = make_batch(start, 100, &num_released, start % 7);
+            writer->write(&batch, &schema.schema);
+            REQUIRE(batch.release == nullptr);
+        }
+        writer->close();
+        REQUIRE(num_released == 3);
+        REQUIRE(writer->num_cells() == 300);
+
+        FragmentInfo fragment_info(*ctx, uri);
+        fragment_info.load();
+        REQUIRE(fragment_info.fragment_num() == 3);
+        check_array(ctx, uri, 300);
+    }
+}
+
+TEST_CASE("SOMAWriter: global order write") {
+    auto in_flight = GENERATE(0, 2);
+    SECTION(fmt::format(" - in_flight={}", in_flight)) {
+        std::map<std::string, std::string> config = {
+            {"soma.write_in_flight", std::to_string(in_flight)}};
+        auto ctx = std::make_shared<Context>(Config(config));
+        auto uri = create_array("mem://unit-test-writer-global", *ctx);
+
+        // Stream sorted batches into a single fragment
+        int num_released = 0;
+        TestSchema schema;
+        auto writer = SOMAWriter::open(ctx, uri, "global-order");
+        for (auto start : {0, 100, 200}) {
+            auto batch = make_batch(start, 100, &num_released);
+            writer->write(&batch, &schema.schema);
+        }
+        writer->close();
+        REQUIRE(num_released == 3);
+        REQUIRE(writer->num_cells() == 300);
+
+        FragmentInfo fragment_info(*ctx, uri);
+        fragment_info.load();
+        REQUIRE(fragment_info.fragment_num() == 1);
+        check_array(ctx, uri, 300);
+    }
+}
+
+TEST_CASE("SOMAWriter: invalid batches") {
+    auto ctx = std::make_shared<Context>();
+    auto uri = create_array("mem://unit-test-writer-invalid", *ctx);
+    REQUIRE_THROWS_AS(SOMAWriter::open(ctx, uri, "row-major"), TileDBSOMAError);
+
+    // Batches that are not written are released
+    int num_released = 0;
+    auto writer = SOMAWriter::open(ctx, uri);
+    TestSchema wrong_format("l");
+    auto batch = make_batch(0, 10, &num_released);
+    REQUIRE_THROWS_AS(
+        writer->write(&batch, &wrong_format.schema), TileDBSOMAError);
+    REQUIRE(num_released == 1);
+
+    TestSchema missing_column;
+    missing_column.schema.n_children = 2;
+    batch = make_batch(0, 10, &num_released);
+    batch.n_children = 2;
+    REQUIRE_THROWS_AS(
+        writer->write(&batch, &missing_column.schema), TileDBSOMAError);
+    REQUIRE(num_released == 2);
+
+    TestSchema schema;
+    batch = make_batch(0, 10, &num_released);
+    writer->write(&batch, &schema.schema);
+    writer->close();
+    REQUIRE(num_released == 3);
+    REQUIRE(writer->num_cells() == 10);
+
+    batch = make_batch(10, 10, &num_released);
+    REQUIRE_THROWS_AS(writer->write(&batch, &schema.schema), TileDBSOMAError);
+    REQUIRE(num_released == 4);
+}
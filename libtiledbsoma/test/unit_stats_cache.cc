@@ -0,0 +1,149 @@
+/**
+ * @file   unit_stats_cache.cc
+ *
+ * @section LICENSE
+ *
+ * The MIT License
+ *
+ * @copyright Copyright (c) 2022 TileDB, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * This file manages unit tests for the array statistics cache
+ */
+
+#include <chrono>
+#include <thread>
+
+#include <catch2/catch_test_macros.hpp>
+#include <tiledb/tiledb>
+#include <tiledbsoma/tiledbsoma>
+
+#include "test_arrays.h"
+
+using namespace tiledb;
+using namespace tiledbsoma;
+using namespace test_arrays;
+
+TEST_CASE("StatsCache: Keys depend on the open timestamp range") {
+    auto ctx = Context();
+    std::string uri = "mem://unit-test-stats-cache-key";
+    create_array(uri, ctx);
+    write_array(uri, ctx, {1, 2, 3});
+
+    Array array(ctx, uri, TILEDB_READ);
+    FragmentInfo fragment_info(ctx, uri);
+    fragment_info.load();
+    auto fingerprint = ArrayCache::fingerprint(array, fragment_info);
+    REQUIRE(fingerprint.first == 1);
+    REQUIRE(fingerprint.second == fragment_info.fragment_uri(0));
+    auto now = StatsCache::key(uri, array, fingerprint);
+    REQUIRE(std::get<2>(now) > 0);
+
+    array.set_open_timestamp_start(0);
+    array.set_open_timestamp_end(1);
+    array.reopen();
+    fingerprint = ArrayCache::fingerprint(array, fragment_info);
+    REQUIRE(fingerprint == ArrayCache::Fingerprint(0, ""));
+    REQUIRE(
+        StatsCache::key(uri, array, fingerprint) ==
+        StatsCache::key(uri, 0, 1, fingerprint));
+    REQUIRE(StatsCache::key(uri, array, fingerprint) != now);
+}
+
+TEST_CASE("StatsCache: Keys depend on the fragments in a pinned range") {
+    auto& cache = StatsCache::instance();
+    cache.clear();
+
+    auto ctx = std::make_shared<Context>();
+    std::string uri = "mem://unit-test-stats-cache-pinned";
+    create_array(uri, *ctx);
+    write_array(uri, *ctx, {10, 20}, 10);
+
+    std::pair<uint64_t, uint64_t> timestamp = {0, 100};
+    auto sr = SOMAReader::open(
+        ctx, uri, "unnamed", {}, "auto", "auto", timestamp);
+    REQUIRE(sr->nnz() == 2);
+    REQUIRE(cache.size() == 1);
+
+    // A write inside the pinned range is seen by readers opened after it
+    write_array(uri, *ctx, {30}, 10);
+    auto sr_after = SOMAReader::open(
+        ctx, uri, "unnamed", {}, "auto", "auto", timestamp);
+    REQUIRE(sr_after->nnz() == 3);
+    REQUIRE(
+        sr_after->non_empty_domain<int64_t>("d0") ==
+        std::pair<int64_t, int64_t>(10, 30));
+    REQUIRE(cache.size() == 2);
+    REQUIRE(sr->nnz() == 2);
+}
+
+TEST_CASE("StatsCache: SOMAReader statistics") {
+    auto& cache = StatsCache::instance();
+    cache.clear();
+
+    auto ctx = std::make_shared<Context>();
+    std::string uri = "mem://unit-test-stats-cache-reader";
+    create_array(uri, *ctx);
+    write_array(uri, *ctx, {10, 20, 30});
+    write_array(uri, *ctx, {20, 40});
+
+    auto sr = SOMAReader::open(ctx, uri);
+    REQUIRE(sr->nnz() == 4);
+    REQUIRE(cache.size() == 1);
+
+    // Cached values are returned for the same open timestamp range
+    REQUIRE(sr->nnz_bounds() == std::pair<uint64_t, uint64_t>(4, 4));
+    REQUIRE(
+        sr->non_empty_domain<int64_t>("d0") ==
+        std::pair<int64_t, int64_t>(10, 40));
+    REQUIRE(cache.size() == 1);
+    REQUIRE_THROWS(sr->non_empty_domain<int32_t>("d0"));
+
+    // A reader opened after a write computes new statistics
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    write_array(uri, *ctx, {50});
+    REQUIRE(SOMAReader::open(ctx, uri)->nnz() == 5);
+    REQUIRE(cache.size() == 2);
+
+    // Statistics computed after a write, by a reader opened before the
+    // write, describe the array the reader opened and are not returned to
+    // readers opened after the write
+    auto sr_before = SOMAReader::open(ctx, uri);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    write_array(uri, *ctx, {60});
+    REQUIRE(
+        sr_before->non_empty_domain<int64_t>("d0") ==
+        std::pair<int64_t, int64_t>(10, 50));
+    REQUIRE(sr_before->nnz() == 5);
+    auto sr_after = SOMAReader::open(ctx, uri);
+    REQUIRE(
+        sr_after->non_empty_domain<int64_t>("d0") ==
+        std::pair<int64_t, int64_t>(10, 60));
+    REQUIRE(sr_after->nnz() == 6);
+
+    // Statistics are not cached when the cache is disabled
+    std::map<std::string, std::string> config = {
+        {"soma.cache_stats", "false"}};
+    auto uncached_ctx = std::make_shared<Context>(Config(config));
+    cache.clear();
+    REQUIRE(SOMAReader::open(uncached_ctx, uri)->nnz() == 6);
+    REQUIRE(cache.size() == 0);
+}